@@ -341,12 +341,24 @@ namespace VAS
 			}
 		}
 
+		public string RenderCacheDir {
+			get {
+				return Path.Combine (configDirectory, "render-cache");
+			}
+		}
+
 		public string DBDir {
 			get {
 				return Path.Combine (homeDirectory, "db");
 			}
 		}
 
+		public string MediaIndexDir {
+			get {
+				return Path.Combine (DBDir, "indexes");
+			}
+		}
+
 		public string RelativeToPrefix (string relativePath)
 		{
 			return Path.Combine (baseDirectory, relativePath);
@@ -463,6 +475,14 @@ namespace VAS
 			set;
 		}
 
+		/// <summary>
+		/// Gets or sets the playback rate from which the player only decodes keyframes, 0 to use the player default.
+		/// </summary>
+		public double TrickModeRate {
+			get;
+			set;
+		}
+
 		/// <summary>
 		/// Gets or sets the step value list for the videoplayer.
 		/// </summary>
@@ -16,6 +16,8 @@
 //  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
 //
 
+using VAS.Core.Store;
+
 namespace VAS.Core.Common
 {
 	public class CaptureSettings
@@ -23,5 +25,14 @@ namespace VAS.Core.Common
 		public Device Device;
 		public DeviceVideoFormat Format;
 		public EncodingSettings EncodingSettings;
+		/// <summary>
+		/// Lower the encoding speed preset and resolution when the computer can't keep up with the capture.
+		/// </summary>
+		public bool AdaptiveQuality;
+		/// <summary>
+		/// Duration of the last part of the recording kept in memory to replay it while capturing,
+		/// <c>null</c> to disable it. Only the video is kept.
+		/// </summary>
+		public Time TimeshiftDuration;
 	}
 }
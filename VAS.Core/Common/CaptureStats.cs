@@ -0,0 +1,105 @@
+//
+//  Copyright (C) 2018 Fluendo S.A.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+using VAS.Core.Store;
+
+namespace VAS.Core.Common
+{
+	/// <summary>
+	/// Statistics of a live capture, used to check if the encoder is keeping up.
+	/// </summary>
+	public class CaptureStats
+	{
+		public CaptureStats ()
+		{
+			AudioQueueLevel = new Time (0);
+			AudioQueueMaxLevel = new Time (0);
+			AVDrift = new Time (0);
+			CpuTime = new Time (0);
+		}
+
+		public long VideoFramesIn { get; set; }
+
+		public long VideoFramesEncoded { get; set; }
+
+		public long VideoFramesDropped { get; set; }
+
+		public long AudioBuffersIn { get; set; }
+
+		public long AudioBuffersEncoded { get; set; }
+
+		public long AudioBuffersDropped { get; set; }
+
+		/// <summary>
+		/// Gets or sets the bytes waiting in the video encoder input queue.
+		/// </summary>
+		public long VideoQueueLevel { get; set; }
+
+		public long VideoQueueMaxLevel { get; set; }
+
+		/// <summary>
+		/// Gets or sets the duration of the audio waiting in the audio encoder input queue.
+		/// </summary>
+		public Time AudioQueueLevel { get; set; }
+
+		public Time AudioQueueMaxLevel { get; set; }
+
+		/// <summary>
+		/// Gets or sets the time a frame takes to be encoded, <c>null</c> if it's still unknown.
+		/// </summary>
+		public Time EncoderLatency { get; set; }
+
+		/// <summary>
+		/// Gets or sets the difference between the last video and audio timestamps recorded.
+		/// </summary>
+		public Time AVDrift { get; set; }
+
+		public long BytesWritten { get; set; }
+
+		/// <summary>
+		/// Gets or sets how many steps the quality was lowered by the adaptive quality, 0 for the configured one.
+		/// </summary>
+		public int AdaptationLevel { get; set; }
+
+		/// <summary>
+		/// Gets or sets the number of quality changes made by the adaptive quality.
+		/// </summary>
+		public long Adaptations { get; set; }
+
+		/// <summary>
+		/// Gets or sets the CPU time used by the process, the CPU load is its increase between two updates.
+		/// </summary>
+		public Time CpuTime { get; set; }
+
+		/// <summary>
+		/// Gets the fill level of the most loaded encoder input queue, from 0 to 1.
+		/// </summary>
+		public double Load {
+			get {
+				double video = 0, audio = 0;
+
+				if (VideoQueueMaxLevel > 0) {
+					video = (double)VideoQueueLevel / VideoQueueMaxLevel;
+				}
+				if (AudioQueueMaxLevel.NSeconds > 0) {
+					audio = (double)AudioQueueLevel.NSeconds / AudioQueueMaxLevel.NSeconds;
+				}
+				return System.Math.Min (1, System.Math.Max (video, audio));
+			}
+		}
+	}
+}
@@ -0,0 +1,59 @@
+//
+//  Copyright (C) 2018 Fluendo S.A.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+namespace VAS.Core.Common
+{
+	/// <summary>
+	/// A file to remux in a batch.
+	/// </summary>
+	public class RemuxJob
+	{
+		public RemuxJob (string inputFile, string outputFile, VideoMuxerType muxer)
+		{
+			InputFile = inputFile;
+			OutputFile = outputFile;
+			Muxer = muxer;
+		}
+
+		public string InputFile { get; private set; }
+
+		public string OutputFile { get; private set; }
+
+		public VideoMuxerType Muxer { get; private set; }
+
+		/// <summary>
+		/// Gets or sets the size of the input file, used to weight the progress of the batch.
+		/// </summary>
+		public long Size { get; set; }
+
+		/// <summary>
+		/// Gets or sets the progress of the remux, from 0 to 1.
+		/// </summary>
+		public float Progress { get; set; }
+
+		/// <summary>
+		/// Gets or sets the error that stopped the remux, <c>null</c> if there wasn't any.
+		/// </summary>
+		public string Error { get; set; }
+
+		public bool Finished {
+			get {
+				return Progress >= 1 || Error != null;
+			}
+		}
+	}
+}
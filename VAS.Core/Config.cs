@@ -153,6 +153,35 @@ namespace VAS
 			set;
 		} = true;
 
+		/// <summary>
+		/// Gets or sets if the encoded segments of the exports are kept in a cache, so that the
+		/// next exports of the same segments don't encode them again.
+		/// </summary>
+		/// <value><c>true</c> to use the render cache; otherwise, <c>false</c>.</value>
+		public bool UseRenderCache {
+			get;
+			set;
+		} = false;
+
+		/// <summary>
+		/// Gets or sets if the exports copy the segments that are not modified instead of
+		/// encoding them again, when their source already matches the output format.
+		/// </summary>
+		/// <value><c>true</c> to use the smart render; otherwise, <c>false</c>.</value>
+		public bool UseSmartRender {
+			get;
+			set;
+		} = false;
+
+		/// <summary>
+		/// Gets or sets the number of parts of an export encoded at the same time.
+		/// </summary>
+		/// <value>The number of parallel workers, 0 to choose it from the number of processors.</value>
+		public uint RenderParallelWorkers {
+			get;
+			set;
+		} = 0;
+
 		/// <summary>
 		/// Gets or sets the watermark.
 		/// </summary>
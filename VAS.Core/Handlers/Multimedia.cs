@@ -33,6 +33,7 @@ namespace VAS.Core.Handlers
 	public delegate void PrevButtonClickedHandler ();
 	public delegate void ProgressHandler (float progress);
 	public delegate void FramesProgressHandler (int actual, int total, Image frame);
+	public delegate bool FrameCapturedHandler (Image frame, Time time);
 	public delegate void DrawFrameHandler (TimelineEvent play, int drawingIndex, CameraConfig camConfig, bool current);
 	public delegate void ElapsedTimeHandler (Time ellapsedTime);
 	public delegate void PlaybackRateChangedHandler (float rate);
@@ -42,10 +43,12 @@ namespace VAS.Core.Handlers
 	public delegate void CaptureFinishedHandler (bool close, bool reopen);
 	public delegate void PercentCompletedHandler (float percent);
 	public delegate void TickHandler (Time currentTime);
+	public delegate void PositionChangedHandler (Time currentTime, Time runningTime);
 	public delegate void TimeChangedHandler (Time currentTime, Time duration, bool seekable);
 	public delegate void MediaInfoHandler (int width, int height, int parN, int parD);
 	public delegate void LoadDrawingsHandler (FrameDrawing frameDrawing);
 	public delegate void ElementLoadedHandler (object element, bool hasNext);
+	public delegate void SegmentChangedHandler (int index);
 	public delegate void MediaFileSetLoadedHandler (MediaFileSet fileset, RangeObservableCollection<CameraConfig> camerasConfig = null);
 	public delegate void ScopeStateChangedHandler (int index, bool visible);
 	public delegate void PrepareViewHandler ();
@@ -55,4 +58,6 @@ namespace VAS.Core.Handlers
 	public delegate void ReadyToSeekHandler (object sender);
 	public delegate void StateChangeHandler (PlaybackStateChangedEvent e);
 	public delegate void ReadyToCaptureHandler (object sender);
+	public delegate void CaptureStatsHandler (CaptureStats stats);
+	public delegate void RemuxJobHandler (RemuxJob job);
 }
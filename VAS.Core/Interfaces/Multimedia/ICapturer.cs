@@ -32,6 +32,7 @@ namespace VAS.Core.Interfaces.Multimedia
 		event ErrorHandler Error;
 		event DeviceChangeHandler DeviceChange;
 		event MediaInfoHandler MediaInfo;
+		event CaptureStatsHandler StatsUpdated;
 
 		void Configure (CaptureSettings settings, object window_handle);
 
@@ -43,6 +44,26 @@ namespace VAS.Core.Interfaces.Multimedia
 			get;
 		}
 
+		CaptureStats Stats {
+			get;
+		}
+
+		/// <summary>
+		/// Gets or sets the interval between <see cref="StatsUpdated"/> events, 0 to disable them.
+		/// </summary>
+		Time StatsInterval {
+			get;
+			set;
+		}
+
+		/// <summary>
+		/// Gets the recording range that can be replayed with <see cref="IVideoPlayer.OpenTimeshift"/>,
+		/// or <c>null</c> if the timeshift is disabled or nothing was recorded yet.
+		/// </summary>
+		TimeNode TimeshiftRange {
+			get;
+		}
+
 		void TogglePause ();
 
 		void Start ();
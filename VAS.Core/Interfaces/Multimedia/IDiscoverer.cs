@@ -23,5 +23,13 @@ namespace VAS.Core.Interfaces.Multimedia
 	public interface IDiscoverer: IDisposable
 	{
 		MediaFile DiscoverFile (string filePath, bool takeScreenshot = true);
+
+		/// <summary>
+		/// Creates the index of a media file with its keyframes and thumbnails every <paramref name="thumbnailsInterval"/>.
+		/// </summary>
+		/// <returns>The index.</returns>
+		/// <param name="file">Media file.</param>
+		/// <param name="thumbnailsInterval">Interval between thumbnails.</param>
+		MediaFileIndex CreateIndex (MediaFile file, Time thumbnailsInterval);
 	}
 }
@@ -17,7 +17,9 @@
 // Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
 //
 //
+using System.Collections.Generic;
 using VAS.Core.Common;
+using VAS.Core.Handlers;
 using VAS.Core.Store;
 
 namespace VAS.Core.Interfaces.Multimedia
@@ -29,5 +31,12 @@ namespace VAS.Core.Interfaces.Multimedia
 		void Dispose ();
 
 		Image GetFrame (Time pos, bool accurate, int outwidth = -1, int outheight = -1);
+
+		/// <summary>
+		/// Extracts the frames at the sorted list of positions in a single decoding pass.
+		/// The handler is called in order for each position, with a <c>null</c> frame if it could
+		/// not be extracted, and it can return <c>false</c> to stop.
+		/// </summary>
+		void GetFrames (IList<Time> positions, FrameCapturedHandler handler, int outwidth = -1, int outheight = -1);
 	}
 }
@@ -15,6 +15,7 @@
 //  along with this program; if not, write to the Free Software
 //  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
 // 
+using System;
 using System.Collections.Generic;
 using VAS.Core.Common;
 using VAS.Core.Store;
@@ -39,8 +40,24 @@ namespace VAS.Core.Interfaces.Multimedia
 
 		MediaFile DiscoverFile (string path, bool takeScreenshot = true);
 
+		/// <summary>
+		/// Gets the stored index of a media file, creating it in the background when it's not available.
+		/// </summary>
+		/// <returns>The index, or <c>null</c> if it's not available yet.</returns>
+		/// <param name="file">Media file.</param>
+		MediaFileIndex GetIndex (MediaFile file);
+
+		/// <summary>
+		/// Gets the video devices. They are listed from a cache and probed again in the background,
+		/// raising <see cref="VideoDevicesChanged"/> if they changed.
+		/// </summary>
 		List<Common.Device> VideoDevices { get; }
 
+		/// <summary>
+		/// Occurs from a background thread when the video devices changed.
+		/// </summary>
+		event EventHandler VideoDevicesChanged;
+
 		bool FileNeedsRemux (MediaFile file);
 
 		string RemuxFile (MediaFile file, object parent);
@@ -35,6 +35,48 @@ namespace VAS.Core.Interfaces.Multimedia
 			set;
 		}
 
+		/// <summary>
+		/// Sets if the segments that are not modified are copied without re-encoding when their source
+		/// already matches the output format. Only the partial GOPs at the cuts are re-encoded.
+		/// </summary>
+		/// <value><c>true</c> to enable the smart render; otherwise, <c>false</c>.</value>
+		bool SmartRender {
+			set;
+		}
+
+		/// <summary>
+		/// Sets the number of parts of the render encoded at the same time, which are concatenated
+		/// without re-encoding once all of them are done.
+		/// </summary>
+		/// <value>The number of parallel workers, 1 to encode all the segments in a single pipeline.</value>
+		uint ParallelWorkers {
+			set;
+		}
+
+		/// <summary>
+		/// Gets the number of segments of the last render that were found in the cache.
+		/// Smart renders don't use the cache, and report no hits nor misses.
+		/// </summary>
+		/// <value>The cache hits.</value>
+		int CacheHits {
+			get;
+		}
+
+		/// <summary>
+		/// Gets the number of segments of the last render that had to be encoded.
+		/// </summary>
+		/// <value>The cache misses.</value>
+		int CacheMisses {
+			get;
+		}
+
+		/// <summary>
+		/// Enables a persistent cache of encoded segments, reused in the next renders of the same segments.
+		/// </summary>
+		/// <param name="directory">The directory where the encoded segments are stored.</param>
+		/// <param name="maxSize">The maximum size of the cache in bytes.</param>
+		void SetCache (string directory, long maxSize);
+
 		void AddSegment (string filePath, long start, long duration, double rate, string title, bool hasAudio, Area roi);
 
 		void AddImageSegment (string filePath, long start, long duration, string title, Area roi);
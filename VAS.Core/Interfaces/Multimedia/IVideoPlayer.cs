@@ -103,6 +103,15 @@ namespace VAS.Core.Interfaces.Multimedia
 		event EosHandler Eos;
 		event StateChangeHandler StateChange;
 		event ReadyToSeekHandler ReadyToSeek;
+		/// <summary>
+		/// Raised with the position of the frame displayed when it changes, at most every 20ms.
+		/// Players raising it don't need to be polled for the <see cref="IPlayback.CurrentTime"/>.
+		/// </summary>
+		event PositionChangedHandler PositionChanged;
+		/// <summary>
+		/// Raised with the index of a segment added with <see cref="AddSegment"/> when it starts playing.
+		/// </summary>
+		event SegmentChangedHandler SegmentChanged;
 
 		/// <summary>
 		/// Sets the window handle in when the video sink can draw.
@@ -126,6 +135,14 @@ namespace VAS.Core.Interfaces.Multimedia
 		/// <param name="mf">A media file to open.</param>
 		bool Open (MediaFile mf);
 
+		/// <summary>
+		/// Open the recording kept in memory by a capturer configured with a
+		/// <see cref="CaptureSettings.TimeshiftDuration"/>, following it live when reaching its last frame.
+		/// </summary>
+		/// <returns><c>true</c>, if the recording was opened, <c>false</c> if the capturer has no timeshift.</returns>
+		/// <param name="capturer">The capturer recording.</param>
+		bool OpenTimeshift (ICapturer capturer);
+
 		/// <summary>
 		/// Gets the current frame, scalling it to the desired width and height.
 		/// If width and height are -1, the frame is returning with its original size.
@@ -134,6 +151,30 @@ namespace VAS.Core.Interfaces.Multimedia
 		/// <param name="width">Output width.</param>
 		/// <param name="height">Output height.</param>
 		Image GetCurrentFrame (int width = -1, int height = -1);
+
+		/// <summary>
+		/// Removes the segments added with <see cref="AddSegment"/>.
+		/// </summary>
+		void ClearSegments ();
+
+		/// <summary>
+		/// Adds a segment to the list of segments played without gaps by <see cref="PlaySegments"/>.
+		/// </summary>
+		/// <param name="file">The file of the segment.</param>
+		/// <param name="start">Start of the segment.</param>
+		/// <param name="stop">Stop of the segment.</param>
+		/// <param name="rate">Playback rate of the segment.</param>
+		void AddSegment (MediaFile file, Time start, Time stop, double rate);
+
+		/// <summary>
+		/// Plays the segments added with <see cref="AddSegment"/> from the first one, switching to
+		/// the next one in the player. <see cref="SegmentChanged"/> is raised for each one
+		/// and <see cref="Eos"/> after the last one.
+		/// </summary>
+		/// <returns><c>true</c>, if the segments are played, <c>false</c> if there are none or
+		/// the player can't play segments.</returns>
+		/// <param name="playing">If set to <c>true</c> start playing.</param>
+		bool PlaySegments (bool playing);
 	}
 
 	public interface IMultiVideoPlayer : IVideoPlayer
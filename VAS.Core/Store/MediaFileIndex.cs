@@ -0,0 +1,227 @@
+//
+//  Copyright (C) 2018 Fluendo S.A.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Security.Cryptography;
+using System.Text;
+using VAS.Core.Common;
+using VAS.Core.Serialization;
+
+namespace VAS.Core.Store
+{
+	/// <summary>
+	/// Index of a media file with its keyframes and a strip of small thumbnails taken at fixed intervals,
+	/// used to show previews and snap to keyframes without opening the file.
+	/// The index is stored in <see cref="App.MediaIndexDir"/> and is only valid while the size and the
+	/// modification time of the file don't change.
+	/// </summary>
+	[Serializable]
+	public class MediaFileIndex
+	{
+		const string EXTENSION = ".index";
+
+		public MediaFileIndex ()
+		{
+			Keyframes = new List<Time> ();
+			KeyframeOffsets = new List<long> ();
+			Thumbnails = new List<byte []> ();
+			ThumbnailsInterval = new Time (0);
+		}
+
+		/// <summary>
+		/// Gets or sets the size of the file when the index was created.
+		/// </summary>
+		public long FileSize {
+			get;
+			set;
+		}
+
+		/// <summary>
+		/// Gets or sets the modification time of the file when the index was created.
+		/// </summary>
+		public DateTime LastModified {
+			get;
+			set;
+		}
+
+		/// <summary>
+		/// Gets or sets the sorted timestamps of the keyframes.
+		/// </summary>
+		public List<Time> Keyframes {
+			get;
+			set;
+		}
+
+		/// <summary>
+		/// Gets or sets the byte offsets of the keyframes, -1 when the offset is unknown.
+		/// </summary>
+		public List<long> KeyframeOffsets {
+			get;
+			set;
+		}
+
+		/// <summary>
+		/// Gets or sets the interval between thumbnails.
+		/// </summary>
+		public Time ThumbnailsInterval {
+			get;
+			set;
+		}
+
+		/// <summary>
+		/// Gets or sets the thumbnails encoded in JPEG.
+		/// </summary>
+		public List<byte []> Thumbnails {
+			get;
+			set;
+		}
+
+		/// <summary>
+		/// Gets or sets the preview of the file encoded in JPEG, taken at the same position than the
+		/// preview of a discovered file.
+		/// </summary>
+		public byte [] Preview {
+			get;
+			set;
+		}
+
+		/// <summary>
+		/// Sets the size and the modification time of the file indexed.
+		/// </summary>
+		/// <param name="filePath">File path.</param>
+		public void SetFileInfo (string filePath)
+		{
+			FileInfo info = new FileInfo (filePath);
+			FileSize = info.Length;
+			LastModified = info.LastWriteTimeUtc;
+		}
+
+		/// <summary>
+		/// Checks if the index is still valid for the file.
+		/// </summary>
+		/// <returns><c>true</c>, if the file didn't change, <c>false</c> otherwise.</returns>
+		/// <param name="filePath">File path.</param>
+		public bool IsValid (string filePath)
+		{
+			FileInfo info = new FileInfo (filePath);
+			return info.Exists && info.Length == FileSize && info.LastWriteTimeUtc == LastModified;
+		}
+
+		/// <summary>
+		/// Gets the last keyframe at or before <paramref name="pos"/>.
+		/// </summary>
+		/// <returns>The keyframe position, or <c>null</c> if there are no keyframes before.</returns>
+		/// <param name="pos">Position.</param>
+		public Time GetKeyframe (Time pos)
+		{
+			int index = Keyframes.BinarySearch (pos);
+			if (index < 0) {
+				index = ~index - 1;
+			}
+			return index >= 0 ? Keyframes [index] : null;
+		}
+
+		/// <summary>
+		/// Gets the thumbnail closest to <paramref name="pos"/>.
+		/// </summary>
+		/// <returns>The thumbnail, or <c>null</c> if there are no thumbnails or the closest one is farther
+		/// than <paramref name="maxDistance"/>.</returns>
+		/// <param name="pos">Position.</param>
+		/// <param name="maxDistance">Maximum distance to the thumbnail, or <c>null</c> for no limit.</param>
+		public Image GetThumbnail (Time pos, Time maxDistance = null)
+		{
+			if (Thumbnails.Count == 0 || ThumbnailsInterval.MSeconds <= 0) {
+				return null;
+			}
+			int index = (int)Math.Round ((double)pos.MSeconds / ThumbnailsInterval.MSeconds);
+			index = Math.Max (0, Math.Min (index, Thumbnails.Count - 1));
+			if (maxDistance != null &&
+				Math.Abs (pos.MSeconds - (long)index * ThumbnailsInterval.MSeconds) > maxDistance.MSeconds) {
+				return null;
+			}
+			return LoadImage (Thumbnails [index]);
+		}
+
+		/// <summary>
+		/// Gets the preview of the file.
+		/// </summary>
+		/// <returns>The preview, or <c>null</c> if the index has no preview.</returns>
+		public Image GetPreview ()
+		{
+			return Preview == null ? null : LoadImage (Preview);
+		}
+
+		/// <summary>
+		/// Gets the path where the index of a file is stored.
+		/// </summary>
+		/// <returns>The index path.</returns>
+		/// <param name="filePath">Path of the media file.</param>
+		public static string GetPath (string filePath)
+		{
+			string hash;
+
+			using (SHA1 sha1 = SHA1.Create ()) {
+				hash = BitConverter.ToString (sha1.ComputeHash (Encoding.UTF8.GetBytes (filePath))).Replace ("-", "");
+			}
+			return Path.Combine (App.Current.MediaIndexDir, hash + EXTENSION);
+		}
+
+		/// <summary>
+		/// Loads the stored index of a file.
+		/// </summary>
+		/// <returns>The index, or <c>null</c> if it doesn't exist or the file changed.</returns>
+		/// <param name="filePath">Path of the media file.</param>
+		public static MediaFileIndex Load (string filePath)
+		{
+			MediaFileIndex index;
+			string path = GetPath (filePath);
+
+			if (!App.Current.FileSystemManager.FileExists (path)) {
+				return null;
+			}
+			try {
+				index = Serializer.Instance.Load<MediaFileIndex> (path);
+			} catch (Exception ex) {
+				Log.Exception (ex);
+				return null;
+			}
+			if (index == null || !index.IsValid (filePath)) {
+				return null;
+			}
+			return index;
+		}
+
+		static Image LoadImage (byte [] data)
+		{
+			using (MemoryStream stream = new MemoryStream (data)) {
+				return new Image (stream);
+			}
+		}
+
+		/// <summary>
+		/// Stores the index of a file.
+		/// </summary>
+		/// <param name="filePath">Path of the media file.</param>
+		public void Save (string filePath)
+		{
+			Directory.CreateDirectory (App.Current.MediaIndexDir);
+			Serializer.Instance.Save (this, GetPath (filePath));
+		}
+	}
+}
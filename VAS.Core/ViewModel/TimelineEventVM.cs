@@ -15,8 +15,9 @@
 //  along with this program; if not, write to the Free Software
 //  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
 //
-using System;
+using System;
 using System.Collections.ObjectModel;
+using System.Linq;
 using VAS.Core.Common;
 using VAS.Core.Interfaces;
 using VAS.Core.Interfaces.GUI;
@@ -31,6 +32,8 @@ namespace VAS.Core.ViewModel
 	/// </summary>
 	public class TimelineEventVM : TimeNodeVM, IComparable, IViewModel<TimelineEvent>, IPlayableEvent
 	{
+		Image indexMiniature;
+
 		public virtual new TimelineEvent Model {
 			get {
 				return (TimelineEvent)base.Model;
@@ -187,10 +190,21 @@ namespace VAS.Core.ViewModel
 		public string Description => Model.Description;
 
 		/// <summary>
-		/// Gets the miniature.
+		/// Gets the miniature. Events without a miniature use the thumbnail of their start from the index of
+		/// their file, once it's available.
 		/// </summary>
 		/// <value>The miniature.</value>
-		public Image Miniature => Model.Miniature;
+		public Image Miniature {
+			get {
+				if (Model.Miniature != null) {
+					return Model.Miniature;
+				}
+				if (indexMiniature == null) {
+					indexMiniature = LoadIndexMiniature ();
+				}
+				return indexMiniature;
+			}
+		}
 
 		/// <summary>
 		/// List of players tagged in this event.
@@ -250,6 +264,15 @@ namespace VAS.Core.ViewModel
 			}
 			return ret;
 		}
+
+		Image LoadIndexMiniature ()
+		{
+			MediaFile file = Model.FileSet?.FirstOrDefault ();
+			if (file == null || Model.Start == null || App.Current.MultimediaToolkit == null) {
+				return null;
+			}
+			return App.Current.MultimediaToolkit.GetIndex (file)?.GetThumbnail (Model.Start + file.Offset);
+		}
 	}
 }
 
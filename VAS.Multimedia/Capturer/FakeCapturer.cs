@@ -32,6 +32,7 @@ namespace VAS.Multimedia.Capturer
 		public event ErrorHandler Error;
 		public event DeviceChangeHandler DeviceChange;
 		public event MediaInfoHandler MediaInfo;
+		public event CaptureStatsHandler StatsUpdated;
 
 		LiveSourceTimer timer;
 
@@ -124,6 +125,23 @@ namespace VAS.Multimedia.Capturer
 			}
 		}
 
+		public CaptureStats Stats {
+			get {
+				return new CaptureStats ();
+			}
+		}
+
+		public Time StatsInterval {
+			get;
+			set;
+		}
+
+		public TimeNode TimeshiftRange {
+			get {
+				return null;
+			}
+		}
+
 		public string DeviceID {
 			get {
 				return "";
@@ -37,8 +37,31 @@ namespace VAS.Multimedia.Capturer
 		public event ErrorHandler Error;
 		public event DeviceChangeHandler DeviceChange;
 		public event MediaInfoHandler MediaInfo;
+		public event CaptureStatsHandler StatsUpdated;
 
 		private LiveSourceTimer timer;
+		private Time statsInterval;
+
+		[StructLayout (LayoutKind.Sequential)]
+		struct LgmCaptureStats
+		{
+			public ulong video_frames_in;
+			public ulong video_frames_encoded;
+			public ulong video_frames_dropped;
+			public ulong audio_buffers_in;
+			public ulong audio_buffers_encoded;
+			public ulong audio_buffers_dropped;
+			public ulong video_appsrc_level;
+			public ulong video_appsrc_max_level;
+			public ulong audio_queue_level;
+			public ulong audio_queue_max_level;
+			public ulong encoder_latency;
+			public long av_drift;
+			public ulong bytes_written;
+			public ulong adaptation_level;
+			public ulong adaptations;
+			public ulong cpu_time;
+		}
 
 		[DllImport ("libvas.dll")]
 		static extern unsafe IntPtr gst_camera_capturer_new (out IntPtr err);
@@ -85,6 +108,27 @@ namespace VAS.Multimedia.Capturer
 		[DllImport ("libvas.dll")]
 		static extern IntPtr gst_camera_capturer_unref_pixbuf (IntPtr raw);
 
+		[DllImport ("libvas.dll")]
+		static extern void gst_camera_capturer_set_adaptive_quality (IntPtr raw, bool enabled);
+
+		[DllImport ("libvas.dll")]
+		static extern void gst_camera_capturer_get_stats (IntPtr raw, out LgmCaptureStats stats);
+
+		[DllImport ("libvas.dll")]
+		static extern void gst_camera_capturer_set_stats_interval (IntPtr raw, uint interval);
+
+		[DllImport ("libvas.dll")]
+		static extern void gst_camera_capturer_set_timeshift_duration (IntPtr raw, uint duration);
+
+		[DllImport ("libvas.dll")]
+		static extern IntPtr gst_camera_capturer_get_timeshift_buffer (IntPtr raw);
+
+		[DllImport ("libvas.dll")]
+		static extern void lgm_timeshift_buffer_unref (IntPtr tsb);
+
+		[DllImport ("libvas.dll")]
+		static extern bool lgm_timeshift_buffer_get_range (IntPtr tsb, out ulong start, out ulong stop);
+
 		public unsafe GstCameraCapturer (string filename) : base (IntPtr.Zero)
 		{
 			if (GetType () != typeof(GstCameraCapturer)) {
@@ -96,6 +140,7 @@ namespace VAS.Multimedia.Capturer
 				throw new GLib.GException (error);
 
 			timer = new LiveSourceTimer ();
+			statsInterval = new Time (0);
 			timer.ElapsedTime += delegate(Time ellapsedTime) {
 				if (ElapsedTime != null)
 					ElapsedTime (ellapsedTime);
@@ -124,6 +169,12 @@ namespace VAS.Multimedia.Capturer
 					ReadyToCapture (this);
 				}
 			};
+
+			this.GlibStats += (o, args) => {
+				if (StatsUpdated != null) {
+					StatsUpdated (args.Stats);
+				}
+			};
 		}
 
 		#pragma warning disable 0169
@@ -414,8 +465,63 @@ namespace VAS.Multimedia.Capturer
 			}
 		}
 
+		[UnmanagedFunctionPointer (CallingConvention.Cdecl)]
+		delegate void StatsSignalDelegate (IntPtr arg0,IntPtr arg1,IntPtr gch);
+
+		static void StatsSignalCallback (IntPtr arg0, IntPtr arg1, IntPtr gch)
+		{
+			StatsArgs args = new StatsArgs ();
+			try {
+				GLib.Signal sig = ((GCHandle)gch).Target as GLib.Signal;
+				if (sig == null)
+					throw new Exception ("Unknown signal GC handle received " + gch);
+
+				args.Args = new object[1];
+				args.Args [0] = ToCaptureStats ((LgmCaptureStats)Marshal.PtrToStructure (arg1, typeof(LgmCaptureStats)));
+				GlibStatsHandler handler = (GlibStatsHandler)sig.Handler;
+				handler (GLib.Object.GetObject (arg0), args);
+			} catch (Exception e) {
+				GLib.ExceptionManager.RaiseUnhandledException (e, false);
+			}
+		}
+
+		[GLib.Signal ("stats")]
+		public event GlibStatsHandler GlibStats {
+			add {
+				GLib.Signal sig = GLib.Signal.Lookup (this, "stats", new StatsSignalDelegate (StatsSignalCallback));
+				sig.AddDelegate (value);
+			}
+			remove {
+				GLib.Signal sig = GLib.Signal.Lookup (this, "stats", new StatsSignalDelegate (StatsSignalCallback));
+				sig.RemoveDelegate (value);
+			}
+		}
+
 		#pragma warning restore 0169
 
+		static CaptureStats ToCaptureStats (LgmCaptureStats stats)
+		{
+			return new CaptureStats {
+				VideoFramesIn = (long)stats.video_frames_in,
+				VideoFramesEncoded = (long)stats.video_frames_encoded,
+				VideoFramesDropped = (long)stats.video_frames_dropped,
+				AudioBuffersIn = (long)stats.audio_buffers_in,
+				AudioBuffersEncoded = (long)stats.audio_buffers_encoded,
+				AudioBuffersDropped = (long)stats.audio_buffers_dropped,
+				VideoQueueLevel = (long)stats.video_appsrc_level,
+				VideoQueueMaxLevel = (long)stats.video_appsrc_max_level,
+				AudioQueueLevel = new Time { NSeconds = (long)stats.audio_queue_level },
+				AudioQueueMaxLevel = new Time { NSeconds = (long)stats.audio_queue_max_level },
+				EncoderLatency = stats.encoder_latency == ulong.MaxValue ?
+					null : new Time { NSeconds = (long)stats.encoder_latency },
+				AVDrift = new Time { NSeconds = stats.av_drift },
+				BytesWritten = (long)stats.bytes_written,
+				AdaptationLevel = (int)stats.adaptation_level,
+				Adaptations = (long)stats.adaptations,
+				CpuTime = new Time { NSeconds = (long)stats.cpu_time },
+			};
+		}
+
 		public void Configure (CaptureSettings settings, object window_handle)
 		{
 			IntPtr err = IntPtr.Zero;
@@ -433,6 +539,9 @@ namespace VAS.Multimedia.Capturer
 			sourceElement = Marshaller.StringToPtrGStrdup (device.SourceElement);
 			deviceID = Marshaller.StringToPtrGStrdup (device.ID);
 
+			gst_camera_capturer_set_adaptive_quality (Handle, settings.AdaptiveQuality);
+			gst_camera_capturer_set_timeshift_duration (Handle, settings.TimeshiftDuration == null ?
+				0 : (uint)Math.Max (0, settings.TimeshiftDuration.TotalSeconds));
 			gst_camera_capturer_configure (Handle, outFile, (int)settings.Device.DeviceType,
 				sourceElement, deviceID,
 				format.width, format.height, format.fps_n, format.fps_d,
@@ -467,6 +576,15 @@ namespace VAS.Multimedia.Capturer
 			}
 		}
 
+		/// <summary>
+		/// Gets the timer of the recorded time, driven by <see cref="GstCaptureGroup"/> for grouped capturers.
+		/// </summary>
+		internal LiveSourceTimer Timer {
+			get {
+				return timer;
+			}
+		}
+
 		public void Start ()
 		{
 			timer.Start ();
@@ -500,6 +618,58 @@ namespace VAS.Multimedia.Capturer
 			}
 		}
 
+		public CaptureStats Stats {
+			get {
+				LgmCaptureStats stats;
+
+				gst_camera_capturer_get_stats (Handle, out stats);
+				return ToCaptureStats (stats);
+			}
+		}
+
+		public Time StatsInterval {
+			get {
+				return statsInterval;
+			}
+			set {
+				statsInterval = value;
+				gst_camera_capturer_set_stats_interval (Handle, (uint)Math.Max (0, value.MSeconds));
+			}
+		}
+
+		public TimeNode TimeshiftRange {
+			get {
+				ulong start, stop;
+				TimeNode range = null;
+				IntPtr tsb = GetTimeshiftBuffer ();
+
+				if (tsb == IntPtr.Zero)
+					return null;
+				if (lgm_timeshift_buffer_get_range (tsb, out start, out stop)) {
+					range = new TimeNode {
+						Start = new Time { NSeconds = (long)start },
+						Stop = new Time { NSeconds = (long)stop },
+					};
+				}
+				ReleaseTimeshiftBuffer (tsb);
+				return range;
+			}
+		}
+
+		/// <summary>
+		/// Gets a new reference to the native timeshift buffer, to release with
+		/// <see cref="ReleaseTimeshiftBuffer"/>, or <c>IntPtr.Zero</c> if there is none.
+		/// </summary>
+		internal IntPtr GetTimeshiftBuffer ()
+		{
+			return gst_camera_capturer_get_timeshift_buffer (Handle);
+		}
+
+		internal static void ReleaseTimeshiftBuffer (IntPtr tsb)
+		{
+			lgm_timeshift_buffer_unref (tsb);
+		}
+
 		public static new GLib.GType GType {
 			get {
 				IntPtr raw_ret = gst_camera_capturer_get_type ();
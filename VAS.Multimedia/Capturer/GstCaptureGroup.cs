@@ -0,0 +1,97 @@
+//
+//  Copyright (C) 2018 Fluendo S.A.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+using System;
+using System.Collections.Generic;
+using System.Runtime.InteropServices;
+using VAS.Core.MVVMC;
+
+namespace VAS.Multimedia.Capturer
+{
+	/// <summary>
+	/// Group of capturers recording several angles of the same event. They share the same clock and
+	/// start, pause and stop on the same frame, so the recordings don't need to be synchronized afterwards.
+	/// </summary>
+	public class GstCaptureGroup : DisposableBase
+	{
+		IntPtr handle;
+		List<GstCameraCapturer> capturers = new List<GstCameraCapturer> ();
+
+		[DllImport ("libvas.dll")]
+		static extern IntPtr lgm_capture_group_new ();
+
+		[DllImport ("libvas.dll")]
+		static extern void lgm_capture_group_free (IntPtr raw);
+
+		[DllImport ("libvas.dll")]
+		static extern void lgm_capture_group_add (IntPtr raw, IntPtr gcc);
+
+		[DllImport ("libvas.dll")]
+		static extern void lgm_capture_group_start (IntPtr raw);
+
+		[DllImport ("libvas.dll")]
+		static extern void lgm_capture_group_toggle_pause (IntPtr raw);
+
+		[DllImport ("libvas.dll")]
+		static extern void lgm_capture_group_stop (IntPtr raw);
+
+		public GstCaptureGroup ()
+		{
+			handle = lgm_capture_group_new ();
+		}
+
+		protected override void DisposeUnmanagedResources ()
+		{
+			base.DisposeUnmanagedResources ();
+			lgm_capture_group_free (handle);
+			handle = IntPtr.Zero;
+		}
+
+		/// <summary>
+		/// Adds a capturer to the group, it must be done before calling <see cref="GstCameraCapturer.Run"/>.
+		/// </summary>
+		public void Add (GstCameraCapturer capturer)
+		{
+			lgm_capture_group_add (handle, capturer.Handle);
+			capturers.Add (capturer);
+		}
+
+		public void Start ()
+		{
+			lgm_capture_group_start (handle);
+			foreach (var capturer in capturers) {
+				capturer.Timer.Start ();
+			}
+		}
+
+		public void TogglePause ()
+		{
+			lgm_capture_group_toggle_pause (handle);
+			foreach (var capturer in capturers) {
+				capturer.Timer.TogglePause ();
+			}
+		}
+
+		public void Stop ()
+		{
+			lgm_capture_group_stop (handle);
+			foreach (var capturer in capturers) {
+				capturer.Timer.Stop ();
+			}
+		}
+	}
+}
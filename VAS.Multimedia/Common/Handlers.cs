@@ -29,6 +29,9 @@ namespace VAS.Multimedia.Common
 	public delegate void GlibTickHandler (object o,TickArgs args);
 	public delegate void GlibMediaInfoHandler (object o,MediaInfoArgs args);
 	public delegate void GlibDeviceChangeHandler (object o,DeviceChangeArgs args);
+	public delegate void GlibStatsHandler (object o,StatsArgs args);
+	public delegate void GlibElementChangedHandler (object o,ElementChangedArgs args);
+	public delegate void GlibPositionChangedHandler (object o,PositionChangedArgs args);
 	public class ErrorArgs : GLib.SignalArgs
 	{
 		public string Message {
@@ -56,6 +59,15 @@ namespace VAS.Multimedia.Common
 		}
 	}
 
+	public class ElementChangedArgs : GLib.SignalArgs
+	{
+		public int Index {
+			get {
+				return (int)Args [0];
+			}
+		}
+	}
+
 	public class TickArgs : GLib.SignalArgs
 	{
 		public Time CurrentTime {
@@ -77,6 +89,21 @@ namespace VAS.Multimedia.Common
 		}
 	}
 
+	public class PositionChangedArgs : GLib.SignalArgs
+	{
+		public Time RunningTime {
+			get {
+				return new Time { NSeconds = (long)Args [0] };
+			}
+		}
+
+		public Time StreamTime {
+			get {
+				return new Time { NSeconds = (long)Args [1] };
+			}
+		}
+	}
+
 	public class DeviceChangeArgs : GLib.SignalArgs
 	{
 		public int DeviceChange {
@@ -112,4 +139,13 @@ namespace VAS.Multimedia.Common
 			}
 		}
 	}
+
+	public class StatsArgs : GLib.SignalArgs
+	{
+		public CaptureStats Stats {
+			get {
+				return (CaptureStats)Args [0];
+			}
+		}
+	}
 }
@@ -277,9 +277,57 @@ namespace VAS.Multimedia.Editor
 			gst_video_editor_set_watermark (Handle, watermark.Value.Handle, x, y, height);
 		}
 
+		[DllImport ("libvas.dll")]
+		static extern void gst_video_editor_set_temp_dir (IntPtr raw, string temp_dir);
+
 		public string TempDir {
 			set {
-				;
+				gst_video_editor_set_temp_dir (Handle, value);
+			}
+		}
+
+		[DllImport ("libvas.dll")]
+		static extern void gst_video_editor_set_parallel_workers (IntPtr raw, uint workers);
+
+		public uint ParallelWorkers {
+			set {
+				gst_video_editor_set_parallel_workers (Handle, value);
+			}
+		}
+
+		[DllImport ("libvas.dll")]
+		static extern void gst_video_editor_set_cache (IntPtr raw, string cache_dir, ulong max_size);
+
+		public void SetCache (string directory, long maxSize)
+		{
+			gst_video_editor_set_cache (Handle, directory, (ulong)maxSize);
+		}
+
+		[DllImport ("libvas.dll")]
+		static extern void gst_video_editor_get_cache_stats (IntPtr raw, out uint hits, out uint misses);
+
+		public int CacheHits {
+			get {
+				uint hits, misses;
+				gst_video_editor_get_cache_stats (Handle, out hits, out misses);
+				return (int)hits;
+			}
+		}
+
+		public int CacheMisses {
+			get {
+				uint hits, misses;
+				gst_video_editor_get_cache_stats (Handle, out hits, out misses);
+				return (int)misses;
+			}
+		}
+
+		[DllImport ("libvas.dll")]
+		static extern void gst_video_editor_set_smart_render (IntPtr raw, bool enabled);
+
+		public bool SmartRender {
+			set {
+				gst_video_editor_set_smart_render (Handle, value);
 			}
 		}
 
@@ -0,0 +1,433 @@
+//
+//  Copyright (C) 2018 Fluendo S.A.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Runtime.InteropServices;
+using VAS.Core.Common;
+using VAS.Core.Events;
+using VAS.Core.Handlers;
+using VAS.Core.Interfaces.Multimedia;
+using VAS.Core.Store;
+using VAS.Multimedia.Common;
+
+namespace VAS.Multimedia.Player
+{
+	/// <summary>
+	/// A player for all the cameras of a <see cref="MediaFileSet"/>, decoded in a single pipeline sharing the clock.
+	/// Seeks and frame steps are applied to all the cameras, shifted by their <see cref="MediaFile.Offset"/>, and
+	/// completed once all of them have the new frame.
+	/// It's not registered as the default <see cref="IMultiVideoPlayer"/>, since it doesn't support yet regions
+	/// of interest, timeshift, segment queues, backward stepping from the frame cache or trick modes.
+	/// Applications can register it with <see cref="MultimediaFactory.Register"/>.
+	/// </summary>
+	public class GstMultiVideoPlayer : GLib.Object, IMultiVideoPlayer
+	{
+		public event ErrorHandler Error;
+		public event StateChangeHandler StateChange;
+		public event ReadyToSeekHandler ReadyToSeek;
+		public event EosHandler Eos;
+		public event PositionChangedHandler PositionChanged;
+		public event SegmentChangedHandler SegmentChanged;
+#pragma warning disable 0067
+		public event ScopeStateChangedHandler ScopeChangedEvent;
+#pragma warning restore 0067
+
+		RangeObservableCollection<CameraConfig> camerasConfig;
+		double rate;
+
+		[DllImport ("libvas.dll")]
+		static extern IntPtr lgm_multi_video_player_get_type ();
+
+		[DllImport ("libvas.dll")]
+		static extern IntPtr lgm_multi_video_player_new (out IntPtr error);
+
+		[DllImport ("libvas.dll")]
+		static extern bool lgm_multi_video_player_open (IntPtr raw, IntPtr[] uris, long[] offsets, uint n_files,
+			out IntPtr error);
+
+		[DllImport ("libvas.dll")]
+		static extern void lgm_multi_video_player_set_views (IntPtr raw, int[] files, uint n_views);
+
+		[DllImport ("libvas.dll")]
+		static extern void lgm_multi_video_player_set_window_handle (IntPtr raw, uint view, IntPtr window_handle);
+
+		[DllImport ("libvas.dll")]
+		static extern bool lgm_multi_video_player_play (IntPtr raw, bool synchronous);
+
+		[DllImport ("libvas.dll")]
+		static extern void lgm_multi_video_player_pause (IntPtr raw, bool synchronous);
+
+		[DllImport ("libvas.dll")]
+		static extern void lgm_multi_video_player_stop (IntPtr raw, bool synchronous);
+
+		[DllImport ("libvas.dll")]
+		static extern void lgm_multi_video_player_close (IntPtr raw);
+
+		[DllImport ("libvas.dll")]
+		static extern bool lgm_multi_video_player_is_playing (IntPtr raw);
+
+		[DllImport ("libvas.dll")]
+		static extern bool lgm_multi_video_player_seek_time (IntPtr raw, long time, bool accurate, bool synchronous);
+
+		[DllImport ("libvas.dll")]
+		static extern bool lgm_multi_video_player_seek_to_next_frame (IntPtr raw);
+
+		[DllImport ("libvas.dll")]
+		static extern bool lgm_multi_video_player_seek_to_previous_frame (IntPtr raw);
+
+		[DllImport ("libvas.dll")]
+		static extern long lgm_multi_video_player_get_current_time (IntPtr raw);
+
+		[DllImport ("libvas.dll")]
+		static extern long lgm_multi_video_player_get_stream_length (IntPtr raw);
+
+		[DllImport ("libvas.dll")]
+		static extern bool lgm_multi_video_player_set_rate (IntPtr raw, double rate);
+
+		[DllImport ("libvas.dll")]
+		static extern void lgm_multi_video_player_set_volume (IntPtr raw, double volume);
+
+		[DllImport ("libvas.dll")]
+		static extern double lgm_multi_video_player_get_volume (IntPtr raw);
+
+		[DllImport ("libvas.dll")]
+		static extern IntPtr lgm_multi_video_player_get_current_frame (IntPtr raw);
+
+		[DllImport ("libvas.dll")]
+		static extern void lgm_multi_video_player_expose (IntPtr raw);
+
+		[DllImport ("libvas.dll")]
+		static extern void lgm_video_player_unref_pixbuf (IntPtr pixbuf);
+
+		public GstMultiVideoPlayer () : base (IntPtr.Zero)
+		{
+			rate = 1;
+			IntPtr error = IntPtr.Zero;
+			Raw = lgm_multi_video_player_new (out error);
+			if (error != IntPtr.Zero)
+				throw new GLib.GException (error);
+
+			this.GlibError += (o, args) => {
+				if (Error != null)
+					Error (this, args.Message);
+			};
+
+			this.GlibStateChange += (o, args) => {
+				if (StateChange != null)
+					StateChange (
+						new PlaybackStateChangedEvent {
+							Sender = this,
+							Playing = args.Playing
+						}
+					);
+			};
+
+			this.GlibReadyToSeek += (sender, e) => {
+				if (ReadyToSeek != null)
+					ReadyToSeek (this);
+			};
+
+			this.GlibEos += (sender, e) => {
+				if (Eos != null)
+					Eos (this);
+			};
+
+			this.GlibPositionChanged += (o, args) => {
+				PositionChanged?.Invoke (args.StreamTime, args.RunningTime);
+			};
+		}
+
+		#pragma warning disable 0169
+
+		[GLib.Signal ("ready_to_seek")]
+		public event System.EventHandler GlibReadyToSeek {
+			add {
+				GLib.Signal sig = GLib.Signal.Lookup (this, "ready_to_seek");
+				sig.AddDelegate (value);
+			}
+			remove {
+				GLib.Signal sig = GLib.Signal.Lookup (this, "ready_to_seek");
+				sig.RemoveDelegate (value);
+			}
+		}
+
+		[GLib.Signal ("state_change")]
+		public event GlibStateChangeHandler GlibStateChange {
+			add {
+				GLib.Signal sig = GLib.Signal.Lookup (this, "state_change", typeof(StateChangeArgs));
+				sig.AddDelegate (value);
+			}
+			remove {
+				GLib.Signal sig = GLib.Signal.Lookup (this, "state_change", typeof(StateChangeArgs));
+				sig.RemoveDelegate (value);
+			}
+		}
+
+		[GLib.Signal ("eos")]
+		public event System.EventHandler GlibEos {
+			add {
+				GLib.Signal sig = GLib.Signal.Lookup (this, "eos");
+				sig.AddDelegate (value);
+			}
+			remove {
+				GLib.Signal sig = GLib.Signal.Lookup (this, "eos");
+				sig.RemoveDelegate (value);
+			}
+		}
+
+		[GLib.Signal ("error")]
+		public event GlibErrorHandler GlibError {
+			add {
+				GLib.Signal sig = GLib.Signal.Lookup (this, "error", typeof(ErrorArgs));
+				sig.AddDelegate (value);
+			}
+			remove {
+				GLib.Signal sig = GLib.Signal.Lookup (this, "error", typeof(ErrorArgs));
+				sig.RemoveDelegate (value);
+			}
+		}
+
+		[GLib.Signal ("tick")]
+		public event GlibTickHandler GlibTick {
+			add {
+				GLib.Signal sig = GLib.Signal.Lookup (this, "tick", typeof(TickArgs));
+				sig.AddDelegate (value);
+			}
+			remove {
+				GLib.Signal sig = GLib.Signal.Lookup (this, "tick", typeof(TickArgs));
+				sig.RemoveDelegate (value);
+			}
+		}
+
+		[GLib.Signal ("position_changed")]
+		public event GlibPositionChangedHandler GlibPositionChanged {
+			add {
+				GLib.Signal sig = GLib.Signal.Lookup (this, "position_changed", typeof(PositionChangedArgs));
+				sig.AddDelegate (value);
+			}
+			remove {
+				GLib.Signal sig = GLib.Signal.Lookup (this, "position_changed", typeof(PositionChangedArgs));
+				sig.RemoveDelegate (value);
+			}
+		}
+		#pragma warning restore 0169
+
+		public object WindowHandle {
+			set {
+				lgm_multi_video_player_set_window_handle (Handle, 0, (IntPtr)value);
+			}
+		}
+
+		public List<object> WindowHandles {
+			set {
+				for (int i = 0; i < value.Count; i++) {
+					lgm_multi_video_player_set_window_handle (Handle, (uint)i, (IntPtr)value [i]);
+				}
+			}
+		}
+
+		public RangeObservableCollection<CameraConfig> CamerasConfig {
+			set {
+				camerasConfig = value;
+			}
+		}
+
+		public Time CurrentTime {
+			get {
+				return new Time { NSeconds = lgm_multi_video_player_get_current_time (Handle) };
+			}
+		}
+
+		public Time StreamLength {
+			get {
+				return new Time { NSeconds = lgm_multi_video_player_get_stream_length (Handle) };
+			}
+		}
+
+		public double Volume {
+			get {
+				return lgm_multi_video_player_get_volume (Handle);
+			}
+			set {
+				lgm_multi_video_player_set_volume (Handle, value);
+			}
+		}
+
+		public bool Playing {
+			get {
+				return lgm_multi_video_player_is_playing (Handle);
+			}
+		}
+
+		public double Rate {
+			set {
+				lgm_multi_video_player_set_rate (Handle, value);
+				rate = value;
+			}
+			get {
+				return rate;
+			}
+		}
+
+		public bool Seek (Time time, bool accurate, bool synchronous)
+		{
+			return lgm_multi_video_player_seek_time (Handle, time.NSeconds, accurate, synchronous);
+		}
+
+		public bool SeekToPreviousFrame ()
+		{
+			return lgm_multi_video_player_seek_to_previous_frame (Handle);
+		}
+
+		public bool SeekToNextFrame ()
+		{
+			return lgm_multi_video_player_seek_to_next_frame (Handle);
+		}
+
+		public void Play (bool synchronous = false)
+		{
+			lgm_multi_video_player_play (Handle, synchronous);
+		}
+
+		public void Pause (bool synchronous = false)
+		{
+			lgm_multi_video_player_pause (Handle, synchronous);
+		}
+
+		public void Stop (bool synchronous = false)
+		{
+			lgm_multi_video_player_stop (Handle, synchronous);
+		}
+
+		public void Close ()
+		{
+			lgm_multi_video_player_close (Handle);
+		}
+
+		public bool Open (MediaFileSet mfs)
+		{
+			IntPtr[] uris = mfs.Select (f => GLib.Marshaller.StringToPtrGStrdup (f.FilePath)).ToArray ();
+			long[] offsets = mfs.Select (f => f.Offset.NSeconds).ToArray ();
+			IntPtr error = IntPtr.Zero;
+
+			ApplyCamerasConfig ();
+			bool ret = lgm_multi_video_player_open (Handle, uris, offsets, (uint)uris.Length, out error);
+			foreach (IntPtr uri in uris) {
+				GLib.Marshaller.Free (uri);
+			}
+			if (error != IntPtr.Zero)
+				throw new GLib.GException (error);
+			return ret;
+		}
+
+		public bool Open (MediaFile file)
+		{
+			return Open (new MediaFileSet { file });
+		}
+
+		public bool Open (string filePath)
+		{
+			return Open (new MediaFile { FilePath = filePath, Offset = new Time (0) });
+		}
+
+		/// <summary>
+		/// Sets the cameras displayed in each view. Only the displayed cameras are decoded.
+		/// </summary>
+		public void ApplyCamerasConfig ()
+		{
+			int[] files;
+
+			if (camerasConfig == null || camerasConfig.Count == 0) {
+				files = new int[] { 0 };
+			} else {
+				files = camerasConfig.Select (c => c.Index).ToArray ();
+			}
+			lgm_multi_video_player_set_views (Handle, files, (uint)files.Length);
+		}
+
+		/// <summary>
+		/// Regions of interest are not supported, the whole frame is always displayed.
+		/// </summary>
+		public void ApplyROI (CameraConfig camConfig)
+		{
+		}
+
+		public Image GetCurrentFrame (int outwidth = -1, int outheight = -1)
+		{
+			Gdk.Pixbuf managed, unmanaged;
+			IntPtr raw_ret;
+			int h, w;
+			double rate;
+
+			raw_ret = lgm_multi_video_player_get_current_frame (Handle);
+			unmanaged = GLib.Object.GetObject (raw_ret) as Gdk.Pixbuf;
+			if (unmanaged == null)
+				return null;
+
+			h = unmanaged.Height;
+			w = unmanaged.Width;
+			rate = (double)w / (double)h;
+			if (outwidth == -1 || outheight == -1) {
+				outwidth = w;
+				outheight = h;
+			} else if (h > w) {
+				outwidth = (int)(outheight * rate);
+			} else {
+				outheight = (int)(outwidth / rate);
+			}
+
+			managed = unmanaged.ScaleSimple (outwidth, outheight, Gdk.InterpType.Bilinear);
+			unmanaged.Dispose ();
+			lgm_video_player_unref_pixbuf (raw_ret);
+			return new Image (managed);
+		}
+
+		public void Expose ()
+		{
+			lgm_multi_video_player_expose (Handle);
+		}
+
+		public void ClearSegments ()
+		{
+		}
+
+		public void AddSegment (MediaFile file, Time start, Time stop, double rate)
+		{
+		}
+
+		/// <summary>
+		/// Segments are not played with several cameras, the caller switches between them.
+		/// </summary>
+		public bool PlaySegments (bool playing)
+		{
+			return false;
+		}
+
+		public static new GLib.GType GType {
+			get {
+				return new GLib.GType (lgm_multi_video_player_get_type ());
+			}
+		}
+
+		static GstMultiVideoPlayer ()
+		{
+			VAS.Multimedia.Video.ObjectManager.Initialize ();
+		}
+	}
+}
@@ -17,12 +17,14 @@
 //
 using System;
 using System.Collections.Generic;
+using System.Linq;
 using System.Runtime.InteropServices;
 using VAS.Core.Common;
 using VAS.Core.Events;
 using VAS.Core.Handlers;
 using VAS.Core.Interfaces.Multimedia;
 using VAS.Core.Store;
+using VAS.Multimedia.Capturer;
 using VAS.Multimedia.Common;
 
 namespace VAS.Multimedia.Player
@@ -34,9 +36,16 @@ namespace VAS.Multimedia.Player
 		public event StateChangeHandler StateChange;
 		public event ReadyToSeekHandler ReadyToSeek;
 		public event EosHandler Eos;
+		public event PositionChangedHandler PositionChanged;
+
+		/// <summary>
+		/// Occurs when a segment added with <see cref="AddSegment"/> starts playing.
+		/// </summary>
+		public event SegmentChangedHandler SegmentChanged;
 
 		MediaFile file;
 		double rate;
+		List<MediaFile> segmentsFiles = new List<MediaFile> ();
 
 		[DllImport ("libvas.dll")]
 		static extern IntPtr lgm_video_player_get_type ();
@@ -50,12 +59,24 @@ namespace VAS.Multimedia.Player
 		[DllImport ("libvas.dll")]
 		static extern bool lgm_video_player_open (IntPtr raw, IntPtr uri, out IntPtr error);
 
+		[DllImport ("libvas.dll")]
+		static extern bool lgm_video_player_open_timeshift (IntPtr raw, IntPtr tsb, out IntPtr error);
+
 		[DllImport ("libvas.dll")]
 		static extern bool lgm_video_player_play (IntPtr raw, bool synchronous);
 
 		[DllImport ("libvas.dll")]
 		static extern bool lgm_video_player_is_playing (IntPtr raw);
 
+		[DllImport ("libvas.dll")]
+		static extern void lgm_video_player_clear_segments (IntPtr raw);
+
+		[DllImport ("libvas.dll")]
+		static extern void lgm_video_player_add_segment (IntPtr raw, IntPtr uri, long start, long stop, double rate);
+
+		[DllImport ("libvas.dll")]
+		static extern bool lgm_video_player_play_segments (IntPtr raw, bool playing);
+
 		[DllImport ("libvas.dll")]
 		static extern void lgm_video_player_pause (IntPtr raw, bool synchronous);
 
@@ -89,6 +110,9 @@ namespace VAS.Multimedia.Player
 		[DllImport ("libvas.dll")]
 		static extern bool lgm_video_player_set_rate (IntPtr raw, double rate);
 
+		[DllImport ("libvas.dll")]
+		static extern void lgm_video_player_set_trick_mode_rate (IntPtr raw, double rate);
+
 		[DllImport ("libvas.dll")]
 		static extern void lgm_video_player_set_volume (IntPtr raw, double volume);
 
@@ -101,6 +125,13 @@ namespace VAS.Multimedia.Player
 		[DllImport ("libvas.dll")]
 		static extern void lgm_video_player_unref_pixbuf (IntPtr pixbuf);
 
+		[UnmanagedFunctionPointer (CallingConvention.Cdecl)]
+		protected delegate bool FrameFunc (IntPtr frame, long time, IntPtr data);
+
+		[DllImport ("libvas.dll")]
+		protected static extern bool lgm_video_player_get_frames (IntPtr raw, long[] times, uint n_times,
+			FrameFunc func, IntPtr data);
+
 		[DllImport ("libvas.dll")]
 		static extern void lgm_video_player_expose (IntPtr pixbuf);
 
@@ -121,6 +152,9 @@ namespace VAS.Multimedia.Player
 			Raw = lgm_video_player_new ((int)type, out error);
 			if (error != IntPtr.Zero)
 				throw new GLib.GException (error);
+			if (App.Current.TrickModeRate > 0) {
+				TrickModeRate = App.Current.TrickModeRate;
+			}
 			
 			this.GlibError += (o, args) => {
 				if (Error != null)
@@ -146,6 +180,16 @@ namespace VAS.Multimedia.Player
 				if (Eos != null)
 					Eos (this);
 			};
+
+			this.GlibElementChanged += (o, args) => {
+				file = segmentsFiles [args.Index];
+				SegmentChanged?.Invoke (args.Index);
+			};
+
+			this.GlibPositionChanged += (o, args) => {
+				if (file != null)
+					PositionChanged?.Invoke (args.StreamTime - file.Offset, args.RunningTime);
+			};
 		}
 		#pragma warning disable 0169
 
@@ -393,6 +437,29 @@ namespace VAS.Multimedia.Player
 				sig.RemoveDelegate (value);
 			}
 		}
+		[GLib.Signal ("element_changed")]
+		public event GlibElementChangedHandler GlibElementChanged {
+			add {
+				GLib.Signal sig = GLib.Signal.Lookup (this, "element_changed", typeof(ElementChangedArgs));
+				sig.AddDelegate (value);
+			}
+			remove {
+				GLib.Signal sig = GLib.Signal.Lookup (this, "element_changed", typeof(ElementChangedArgs));
+				sig.RemoveDelegate (value);
+			}
+		}
+
+		[GLib.Signal ("position_changed")]
+		public event GlibPositionChangedHandler GlibPositionChanged {
+			add {
+				GLib.Signal sig = GLib.Signal.Lookup (this, "position_changed", typeof(PositionChangedArgs));
+				sig.AddDelegate (value);
+			}
+			remove {
+				GLib.Signal sig = GLib.Signal.Lookup (this, "position_changed", typeof(PositionChangedArgs));
+				sig.RemoveDelegate (value);
+			}
+		}
 		#pragma warning restore 0169
 
 		public object WindowHandle {
@@ -446,6 +513,16 @@ namespace VAS.Multimedia.Player
 			}
 		}
 
+		/// <summary>
+		/// Sets the rate from which only the keyframes are decoded, used for fast forward when the decoder
+		/// can't keep up with all the frames. It's applied on the next change of <see cref="Rate"/>.
+		/// </summary>
+		public double TrickModeRate {
+			set {
+				lgm_video_player_set_trick_mode_rate (Handle, value);
+			}
+		}
+
 		public Time Offset {
 			get {
 				return file.Offset;
@@ -505,14 +582,74 @@ namespace VAS.Multimedia.Player
 			return Open (new MediaFile { FilePath = filePath, Offset = new Time (0) });
 		}
 
+		public bool OpenTimeshift (ICapturer capturer)
+		{
+			GstCameraCapturer gstCapturer = capturer as GstCameraCapturer;
+			IntPtr error = IntPtr.Zero;
+			IntPtr tsb;
+			bool ret;
+
+			if (gstCapturer == null)
+				return false;
+			tsb = gstCapturer.GetTimeshiftBuffer ();
+			if (tsb == IntPtr.Zero)
+				return false;
+			file = new MediaFile { Offset = new Time (0) };
+			ret = lgm_video_player_open_timeshift (Handle, tsb, out error);
+			GstCameraCapturer.ReleaseTimeshiftBuffer (tsb);
+			if (error != IntPtr.Zero)
+				throw new GLib.GException (error);
+			return ret;
+		}
+
+		/// <summary>
+		/// Removes the segments added with <see cref="AddSegment"/>.
+		/// </summary>
+		public void ClearSegments ()
+		{
+			segmentsFiles.Clear ();
+			lgm_video_player_clear_segments (Handle);
+		}
+
+		/// <summary>
+		/// Adds a segment to the list of segments played without gaps by <see cref="PlaySegments"/>.
+		/// </summary>
+		/// <param name="file">The file of the segment.</param>
+		/// <param name="start">Start of the segment.</param>
+		/// <param name="stop">Stop of the segment.</param>
+		/// <param name="rate">Playback rate of the segment.</param>
+		public void AddSegment (MediaFile file, Time start, Time stop, double rate)
+		{
+			IntPtr native_uri = GLib.Marshaller.StringToPtrGStrdup (file.FilePath);
+			lgm_video_player_add_segment (Handle, native_uri, start.NSeconds + file.Offset.NSeconds,
+				stop.NSeconds + file.Offset.NSeconds, rate);
+			GLib.Marshaller.Free (native_uri);
+			segmentsFiles.Add (file);
+		}
+
+		/// <summary>
+		/// Plays the segments added with <see cref="AddSegment"/> from the first one, switching to
+		/// the next one in the native pipeline. <see cref="SegmentChanged"/> is raised for each one
+		/// and <see cref="Eos"/> after the last one.
+		/// </summary>
+		/// <returns><c>true</c>, if there were segments to play.</returns>
+		/// <param name="playing">If set to <c>true</c> start playing.</param>
+		public bool PlaySegments (bool playing)
+		{
+			return lgm_video_player_play_segments (Handle, playing);
+		}
+
 		public Image GetCurrentFrame (int outwidth = -1, int outheight = -1)
+		{
+			return ImageFromPixbuf (lgm_video_player_get_current_frame (Handle), outwidth, outheight);
+		}
+
+		protected Image ImageFromPixbuf (IntPtr raw_ret, int outwidth, int outheight)
 		{
 			Gdk.Pixbuf managed, unmanaged;
-			IntPtr raw_ret;
 			int h, w;
 			double rate;
 			
-			raw_ret = lgm_video_player_get_current_frame (Handle);
 			unmanaged = GLib.Object.GetObject (raw_ret) as Gdk.Pixbuf;
 			if (unmanaged == null)
 				return null;
@@ -568,5 +705,22 @@ namespace VAS.Multimedia.Player
 			img = GetCurrentFrame (outwidth, outheight);
 			return img;
 		}
+
+		public void GetFrames (IList<Time> positions, FrameCapturedHandler handler,
+		                       int outwidth = -1, int outheight = -1)
+		{
+			long[] times = positions.Select (p => p.NSeconds + Offset.NSeconds).ToArray ();
+			FrameFunc func = (frame, time, data) => {
+				Image img = null;
+				if (frame != IntPtr.Zero) {
+					img = ImageFromPixbuf (frame, outwidth, outheight);
+				}
+				return handler (img, new Time { NSeconds = time - Offset.NSeconds });
+			};
+
+			Pause ();
+			lgm_video_player_get_frames (Handle, times, (uint)times.Length, func, IntPtr.Zero);
+			GC.KeepAlive (func);
+		}
 	}
 }
@@ -32,6 +32,7 @@ namespace VAS.Multimedia.Video
 			initialized = true;
 
 			GLib.GType.Register (GstVideoPlayer.GType, typeof(GstVideoPlayer));
+			GLib.GType.Register (GstMultiVideoPlayer.GType, typeof(GstMultiVideoPlayer));
 		}
 	}
 }
@@ -0,0 +1,176 @@
+//
+//  Copyright (C) 2018 Fluendo S.A.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using VAS.Core.Common;
+using VAS.Core.Handlers;
+using VAS.Core.Interfaces.Multimedia;
+using VAS.Core.MVVMC;
+
+namespace VAS.Multimedia.Remuxer
+{
+	/// <summary>
+	/// Remuxes a list of files running several remuxers at the same time.
+	/// </summary>
+	public class BatchRemuxer : DisposableBase
+	{
+		/// <summary>
+		/// Occurs when the progress of a file changes.
+		/// </summary>
+		public event RemuxJobHandler JobProgress;
+
+		/// <summary>
+		/// Occurs when a file is remuxed or fails.
+		/// </summary>
+		public event RemuxJobHandler JobFinished;
+
+		/// <summary>
+		/// Occurs when the progress of the whole batch changes, weighted by the size of the files.
+		/// It reaches 1 when all the files are finished.
+		/// </summary>
+		public event ProgressHandler Progress;
+
+		readonly Func<RemuxJob, IRemuxer> createRemuxer;
+		readonly Queue<RemuxJob> pending;
+		readonly Dictionary<RemuxJob, IRemuxer> running;
+		readonly IDisposable sharedResource;
+
+		/// <summary>
+		/// Initializes a new instance of the <see cref="BatchRemuxer"/> class.
+		/// </summary>
+		/// <param name="jobs">The files to remux.</param>
+		/// <param name="workers">The maximum number of files remuxed at the same time.</param>
+		/// <param name="createRemuxer">Creates the remuxer for a file.</param>
+		/// <param name="sharedResource">A resource shared by the remuxers, disposed with the batch.</param>
+		public BatchRemuxer (IEnumerable<RemuxJob> jobs, int workers, Func<RemuxJob, IRemuxer> createRemuxer,
+			IDisposable sharedResource = null)
+		{
+			if (workers < 1) {
+				throw new ArgumentOutOfRangeException (nameof (workers));
+			}
+			this.createRemuxer = createRemuxer;
+			this.sharedResource = sharedResource;
+			Jobs = jobs.ToList ();
+			Workers = workers;
+			pending = new Queue<RemuxJob> (Jobs);
+			running = new Dictionary<RemuxJob, IRemuxer> ();
+			foreach (RemuxJob job in Jobs) {
+				if (job.Size <= 0) {
+					job.Size = File.Exists (job.InputFile) ? new FileInfo (job.InputFile).Length : 1;
+				}
+			}
+		}
+
+		public List<RemuxJob> Jobs { get; private set; }
+
+		public int Workers { get; private set; }
+
+		/// <summary>
+		/// Gets the progress of the whole batch, from 0 to 1.
+		/// </summary>
+		public float CurrentProgress {
+			get {
+				double total = Jobs.Sum (j => (double)j.Size);
+				if (total == 0) {
+					return 1;
+				}
+				return (float)(Jobs.Sum (j => (j.Finished ? 1 : j.Progress) * (double)j.Size) / total);
+			}
+		}
+
+		public void Start ()
+		{
+			if (!Jobs.Any ()) {
+				Progress?.Invoke (1);
+				return;
+			}
+			while (running.Count < Workers && pending.Count > 0) {
+				StartJob (pending.Dequeue ());
+			}
+		}
+
+		/// <summary>
+		/// Cancels the files being remuxed and the pending ones.
+		/// </summary>
+		public void Cancel ()
+		{
+			pending.Clear ();
+			foreach (IRemuxer remuxer in running.Values.ToList ()) {
+				remuxer.Cancel ();
+				(remuxer as IDisposable)?.Dispose ();
+			}
+			running.Clear ();
+		}
+
+		protected override void DisposeManagedResources ()
+		{
+			base.DisposeManagedResources ();
+			Cancel ();
+			sharedResource?.Dispose ();
+		}
+
+		void StartJob (RemuxJob job)
+		{
+			IRemuxer remuxer = createRemuxer (job);
+			running [job] = remuxer;
+			remuxer.Progress += (progress) => HandleProgress (job, progress);
+			remuxer.Error += (sender, message) => HandleError (job, message);
+			remuxer.Start ();
+		}
+
+		void FinishJob (RemuxJob job)
+		{
+			IRemuxer remuxer;
+
+			if (!running.TryGetValue (job, out remuxer)) {
+				return;
+			}
+			running.Remove (job);
+			(remuxer as IDisposable)?.Dispose ();
+			JobFinished?.Invoke (job);
+			if (pending.Count > 0) {
+				StartJob (pending.Dequeue ());
+			}
+		}
+
+		void HandleProgress (RemuxJob job, float progress)
+		{
+			if (!running.ContainsKey (job)) {
+				return;
+			}
+			job.Progress = progress;
+			JobProgress?.Invoke (job);
+			if (job.Finished) {
+				FinishJob (job);
+			}
+			Progress?.Invoke (CurrentProgress);
+		}
+
+		void HandleError (RemuxJob job, string message)
+		{
+			if (!running.ContainsKey (job)) {
+				return;
+			}
+			job.Error = message;
+			FinishJob (job);
+			Progress?.Invoke (CurrentProgress);
+		}
+	}
+}
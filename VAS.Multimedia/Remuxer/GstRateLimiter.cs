@@ -0,0 +1,53 @@
+//
+//  Copyright (C) 2018 Fluendo S.A.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+using System;
+using System.Runtime.InteropServices;
+using VAS.Core.MVVMC;
+
+namespace VAS.Multimedia.Remuxer
+{
+	/// <summary>
+	/// Caps the disk throughput shared by the remuxers using it.
+	/// </summary>
+	public class GstRateLimiter : DisposableBase
+	{
+		[DllImport ("libvas.dll")]
+		static extern IntPtr lgm_rate_limiter_new (ulong bytes_per_second);
+
+		[DllImport ("libvas.dll")]
+		static extern void lgm_rate_limiter_unref (IntPtr raw);
+
+		/// <summary>
+		/// Initializes a new instance of the <see cref="GstRateLimiter"/> class.
+		/// </summary>
+		/// <param name="bytesPerSecond">The maximum throughput, 0 for no limit.</param>
+		public GstRateLimiter (ulong bytesPerSecond)
+		{
+			Handle = lgm_rate_limiter_new (bytesPerSecond);
+		}
+
+		public IntPtr Handle { get; private set; }
+
+		protected override void DisposeUnmanagedResources ()
+		{
+			base.DisposeUnmanagedResources ();
+			lgm_rate_limiter_unref (Handle);
+			Handle = IntPtr.Zero;
+		}
+	}
+}
@@ -183,6 +183,17 @@ namespace VAS.Multimedia.Remuxer
 
 		#endregion
 
+		[DllImport ("libvas.dll")]
+		static extern void gst_remuxer_set_rate_limiter (IntPtr raw, IntPtr limiter);
+
+		/// <summary>
+		/// Shares the input bandwidth with the other remuxers using the same limiter, it must be set before starting.
+		/// </summary>
+		public void SetRateLimiter (GstRateLimiter limiter)
+		{
+			gst_remuxer_set_rate_limiter (Handle, limiter.Handle);
+		}
+
 		[DllImport ("libvas.dll")]
 		static extern void gst_remuxer_cancel (IntPtr raw);
 
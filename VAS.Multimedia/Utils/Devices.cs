@@ -28,7 +28,13 @@ namespace VAS.Multimedia.Utils
 	public class Devices
 	{
 		[DllImport ("libvas.dll")]
-		static extern IntPtr lgm_device_enum_video_devices (string source);
+		static extern void lgm_device_cache_load (string path);
+
+		[DllImport ("libvas.dll")]
+		static extern IntPtr lgm_device_enum_video_devices_cached (string source, out bool probed);
+
+		[DllImport ("libvas.dll")]
+		static extern void lgm_device_cache_refresh (string source, DeviceChangeDelegate func, IntPtr userData);
 
 		[DllImport ("libvas.dll")]
 		static extern IntPtr lgm_device_get_formats (IntPtr raw);
@@ -56,6 +62,33 @@ namespace VAS.Multimedia.Utils
 		static readonly string [] devices_win = { KSVIDEOSRC, DSHOWVIDEOSRC, GDISCREENCAPSRC, DX9SCREENCAPSRC };
 		static readonly string [] devices_lin = { V4L2SRC, DV1394SRC };
 
+		[UnmanagedFunctionPointer (CallingConvention.Cdecl)]
+		delegate void DeviceChangeDelegate (IntPtr source, IntPtr userData);
+
+		/* Referenced here so that it's not collected while the native code uses it */
+		static readonly DeviceChangeDelegate deviceChangeCallback = HandleDeviceChange;
+
+		/// <summary>
+		/// Occurs when the background refresh started by <see cref="ListVideoDevices"/> finds that
+		/// the devices changed. It's raised from a background thread.
+		/// </summary>
+		public static event EventHandler VideoDevicesChanged;
+
+		/// <summary>
+		/// Loads the capabilities of the devices probed in previous runs.
+		/// </summary>
+		/// <param name="path">Path of the cache file.</param>
+		static public void LoadCache (string path)
+		{
+			lgm_device_cache_load (path);
+		}
+
+		/// <summary>
+		/// Lists the video devices from the cache, probing them only if they are not cached yet.
+		/// The cached devices are probed again in the background and <see cref="VideoDevicesChanged"/>
+		/// is raised if they changed.
+		/// </summary>
+		/// <returns>The video devices.</returns>
 		static public List<Device> ListVideoDevices ()
 		{
 			string [] devices;
@@ -69,8 +102,13 @@ namespace VAS.Multimedia.Utils
 			List<Device> devicesList = new List<Device> ();
 
 			foreach (string source in devices) {
-				GLib.List devices_raw = new GLib.List (lgm_device_enum_video_devices (source),
+				bool probed;
+				GLib.List devices_raw = new GLib.List (lgm_device_enum_video_devices_cached (source, out probed),
 											typeof (IntPtr), true, false);
+				/* Devices just probed are already up to date */
+				if (!probed) {
+					lgm_device_cache_refresh (source, deviceChangeCallback, IntPtr.Zero);
+				}
 
 				foreach (IntPtr device_raw in devices_raw) {
 					string deviceName = GLib.Marshaller.PtrToStringGFree (lgm_device_get_device_name (device_raw));
@@ -108,6 +146,12 @@ namespace VAS.Multimedia.Utils
 			}
 			return devicesList;
 		}
+
+		static void HandleDeviceChange (IntPtr source, IntPtr userData)
+		{
+			Log.Information ("Video devices changed for " + GLib.Marshaller.Utf8PtrToString (source));
+			VideoDevicesChanged?.Invoke (null, EventArgs.Empty);
+		}
 	}
 }
 
@@ -48,6 +48,7 @@ namespace VAS.Multimedia.Utils
 			Log.Information ("Initializing GStreamer.");
 			SetUpEnvironment ();
 			MultimediaFactory.InitBackend ();
+			Devices.LoadCache (GetDevicesCachePath ());
 			Log.Information ("GStreamer initialized successfully.");
 		}
 
@@ -87,6 +88,11 @@ namespace VAS.Multimedia.Utils
 			return Path.Combine (App.Current.ConfigDir, App.Current.SoftwareName.ToLower () + "_gst_registry.bin");
 		}
 
+		private static string GetDevicesCachePath ()
+		{
+			return Path.Combine (App.Current.ConfigDir, App.Current.SoftwareName.ToLower () + "_devices.cache");
+		}
+
 		private static bool CheckBasicPlugins ()
 		{
 			IntPtr registry = gst_registry_get_default ();
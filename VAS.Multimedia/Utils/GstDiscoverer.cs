@@ -16,6 +16,7 @@
 //  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
 //
 using System;
+using System.Collections.Generic;
 using System.Runtime.InteropServices;
 using VAS.Core;
 using VAS.Core.Common;
@@ -29,6 +30,7 @@ namespace VAS.Multimedia.Utils
 	{
 		const int THUMBNAIL_MAX_HEIGHT = 72;
 		const int THUMBNAIL_MAX_WIDTH = 96;
+		static readonly Time PREVIEW_POSITION = new Time { TotalSeconds = 2 };
 
 		[DllImport ("libvas.dll")]
 		static extern unsafe uint lgm_discover_uri (string uri, out long duration,
@@ -40,6 +42,10 @@ namespace VAS.Multimedia.Utils
 													out IntPtr audio_codec,
 													out IntPtr err);
 
+		[DllImport ("libvas.dll")]
+		static extern bool lgm_discover_keyframes (string filename, out IntPtr timestamps, out IntPtr offsets,
+												   out uint n_keyframes, out IntPtr err);
+
 		public MediaFile DiscoverFile (string filePath, bool takeScreenshot = true)
 		{
 			long duration = 0;
@@ -74,10 +80,13 @@ namespace VAS.Multimedia.Utils
 				fps = fps_n / fps_d;
 				par = (float)par_n / par_d;
 				if (takeScreenshot) {
+					preview = GetIndexedPreview (filePath);
+				}
+				if (takeScreenshot && preview == null) {
 					factory = new MultimediaFactory ();
 					thumbnailer = factory.GetFramesCapturer ();
 					thumbnailer.Open (filePath);
-					preview = thumbnailer.GetFrame (new Time { TotalSeconds = 2 }, false,
+					preview = thumbnailer.GetFrame (PREVIEW_POSITION, false,
 						THUMBNAIL_MAX_WIDTH, THUMBNAIL_MAX_HEIGHT);
 					thumbnailer.Dispose ();
 				}
@@ -87,5 +96,68 @@ namespace VAS.Multimedia.Utils
 				container, video_codec, audio_codec, width, height,
 				par, preview, null);
 		}
+
+		public MediaFileIndex CreateIndex (MediaFile file, Time thumbnailsInterval)
+		{
+			IntPtr timestamps, offsets, error;
+			uint n_keyframes;
+			MediaFileIndex index = new MediaFileIndex ();
+			List<Time> positions = new List<Time> ();
+			IFramesCapturer thumbnailer;
+
+			index.SetFileInfo (file.FilePath);
+			if (!file.HasVideo) {
+				return index;
+			}
+			if (!lgm_discover_keyframes (file.FilePath, out timestamps, out offsets, out n_keyframes, out error)) {
+				if (error != IntPtr.Zero)
+					throw new GLib.GException (error);
+				throw new Exception (Catalog.GetString ("Could not parse file:") + file.FilePath);
+			}
+			for (int i = 0; i < n_keyframes; i++) {
+				index.Keyframes.Add (new Time { NSeconds = Marshal.ReadInt64 (timestamps, i * sizeof (long)) });
+				/* Unknown offsets are G_MAXUINT64, which is read as -1 */
+				index.KeyframeOffsets.Add (Marshal.ReadInt64 (offsets, i * sizeof (long)));
+			}
+			GLib.Marshaller.Free (timestamps);
+			GLib.Marshaller.Free (offsets);
+
+			for (Time pos = new Time (0); pos < file.Duration; pos += thumbnailsInterval) {
+				positions.Add (pos);
+			}
+			/* The preview is extracted in the same pass, in order */
+			if (PREVIEW_POSITION < file.Duration && !positions.Contains (PREVIEW_POSITION)) {
+				positions.Add (PREVIEW_POSITION);
+				positions.Sort ();
+			}
+			index.ThumbnailsInterval = thumbnailsInterval;
+			thumbnailer = new MultimediaFactory ().GetFramesCapturer ();
+			thumbnailer.Open (file.FilePath);
+			thumbnailer.GetFrames (positions, (frame, time) => {
+				if (frame == null) {
+					return false;
+				}
+				byte [] data = frame.Value.SaveToBuffer ("jpeg");
+				if (time == PREVIEW_POSITION) {
+					index.Preview = data;
+				}
+				if (time.MSeconds % thumbnailsInterval.MSeconds == 0) {
+					index.Thumbnails.Add (data);
+				}
+				frame.Dispose ();
+				return true;
+			}, THUMBNAIL_MAX_WIDTH, THUMBNAIL_MAX_HEIGHT);
+			thumbnailer.Dispose ();
+			return index;
+		}
+
+		Image GetIndexedPreview (string filePath)
+		{
+			MediaFileIndex index = MediaFileIndex.Load (filePath);
+			if (index == null) {
+				return null;
+			}
+			return index.GetPreview ();
+		}
 	}
 }
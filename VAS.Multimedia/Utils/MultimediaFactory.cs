@@ -20,6 +20,7 @@
 using System;
 using System.Collections.Generic;
 using System.Runtime.InteropServices;
+using System.Threading.Tasks;
 using VAS.Core.Common;
 using VAS.Core.Interfaces.Multimedia;
 using VAS.Core.Store;
@@ -34,6 +35,10 @@ namespace VAS.Multimedia
 {
 	public class MultimediaFactory
 	{
+		static readonly Time INDEX_THUMBNAILS_INTERVAL = new Time { TotalSeconds = 5 };
+		static readonly Dictionary<string, Task> indexTasks = new Dictionary<string, Task> ();
+		static readonly Dictionary<string, MediaFileIndex> indexes = new Dictionary<string, MediaFileIndex> ();
+
 		Registry registry;
 
 		public MultimediaFactory ()
@@ -92,6 +97,21 @@ namespace VAS.Multimedia
 			return registry.Retrieve<IRemuxer> (InstanceType.New, inputFile.FilePath, outputFile, muxer);
 		}
 
+		/// <summary>
+		/// Gets a remuxer for several files, remuxing up to <paramref name="workers"/> files at the same time
+		/// and reading at most <paramref name="maxBytesPerSecond"/> from disk, 0 for no limit.
+		/// </summary>
+		public BatchRemuxer GetBatchRemuxer (IEnumerable<RemuxJob> jobs, int workers, ulong maxBytesPerSecond)
+		{
+			GstRateLimiter limiter = new GstRateLimiter (maxBytesPerSecond);
+			return new BatchRemuxer (jobs, workers, job => {
+				IRemuxer remuxer = registry.Retrieve<IRemuxer> (InstanceType.New, job.InputFile, job.OutputFile,
+					job.Muxer);
+				(remuxer as GstRemuxer)?.SetRateLimiter (limiter);
+				return remuxer;
+			}, limiter);
+		}
+
 		public MediaFile DiscoverFile (string file, bool takeScreenshot = true)
 		{
 			IDiscoverer discoverer = GetDiscoverer ();
@@ -100,12 +120,95 @@ namespace VAS.Multimedia
 			return mfile;
 		}
 
+		/// <summary>
+		/// Gets the index of a media file, loaded once from the disk and kept in memory. The index is only
+		/// created the first time it's needed, in the background, or again if the file changed.
+		/// </summary>
+		/// <returns>The index, or <c>null</c> if it's not available yet or the file has no video.</returns>
+		/// <param name="file">Media file.</param>
+		public MediaFileIndex GetIndex (MediaFile file)
+		{
+			MediaFileIndex index;
+
+			if (!file.HasVideo) {
+				return null;
+			}
+			lock (indexes) {
+				indexes.TryGetValue (file.FilePath, out index);
+			}
+			if (index != null && index.IsValid (file.FilePath)) {
+				return index;
+			}
+			index = MediaFileIndex.Load (file.FilePath);
+			lock (indexes) {
+				if (index != null) {
+					indexes [file.FilePath] = index;
+				} else {
+					indexes.Remove (file.FilePath);
+				}
+			}
+			if (index == null) {
+				CreateIndex (file);
+			}
+			return index;
+		}
+
+		/// <summary>
+		/// Creates and stores the index of a media file in the background.
+		/// Files without video are not indexed.
+		/// </summary>
+		/// <returns>The task creating the index.</returns>
+		/// <param name="file">Media file.</param>
+		public Task CreateIndex (MediaFile file)
+		{
+			string filePath = file.FilePath;
+
+			if (!file.HasVideo) {
+				return Task.FromResult (false);
+			}
+
+			lock (indexTasks) {
+				Task task;
+				if (indexTasks.TryGetValue (filePath, out task)) {
+					return task;
+				}
+				task = Task.Run (() => {
+					try {
+						IDiscoverer discoverer = GetDiscoverer ();
+						MediaFileIndex index = discoverer.CreateIndex (file, INDEX_THUMBNAILS_INTERVAL);
+						discoverer.Dispose ();
+						index.Save (filePath);
+						lock (indexes) {
+							indexes [filePath] = index;
+						}
+					} catch (Exception ex) {
+						Log.Exception (ex);
+					} finally {
+						lock (indexTasks) {
+							indexTasks.Remove (filePath);
+						}
+					}
+				});
+				indexTasks [filePath] = task;
+				return task;
+			}
+		}
+
 		public List<Device> VideoDevices {
 			get {
 				return Devices.ListVideoDevices ();
 			}
 		}
 
+		public event EventHandler VideoDevicesChanged {
+			add {
+				Devices.VideoDevicesChanged += value;
+			}
+			remove {
+				Devices.VideoDevicesChanged -= value;
+			}
+		}
+
 		public bool FileNeedsRemux (MediaFile file)
 		{
 			return GStreamer.FileNeedsRemux (file);
@@ -36,8 +36,11 @@ namespace VAS.Services
 {
 	public class RenderingJobsController : ControllerBase, IService
 	{
+		const long RENDER_CACHE_SIZE = 4L * 1024 * 1024 * 1024;
+
 		IVideoEditor videoEditor;
 		IFramesCapturer capturer;
+		bool reportCacheStats;
 		ControllerStatus status = ControllerStatus.Stopped;
 
 		public RenderingJobsController (JobsManagerVM viewModel)
@@ -176,6 +179,7 @@ namespace VAS.Services
 				videoEditor.Cancel ();
 			}
 			videoEditor = null;
+			reportCacheStats = false;
 		}
 
 		void CancelCurrentJob (bool startNext = true)
@@ -208,6 +212,11 @@ namespace VAS.Services
 		{
 			videoEditor = App.Current.MultimediaToolkit.GetVideoEditor ();
 			videoEditor.EncodingSettings = job.EncodingSettings;
+			if (App.Current.Config.UseRenderCache) {
+				videoEditor.SetCache (App.Current.RenderCacheDir, RENDER_CACHE_SIZE);
+			}
+			videoEditor.SmartRender = App.Current.Config.UseSmartRender;
+			videoEditor.ParallelWorkers = GetParallelWorkers ();
 			videoEditor.Progress += OnProgress;
 			videoEditor.Error += OnError;
 
@@ -222,9 +231,35 @@ namespace VAS.Services
 					ProcessDrawing (segment as PlaylistDrawing);
 				}
 			}
+			reportCacheStats = App.Current.Config.UseRenderCache;
 			videoEditor.Start ();
 		}
 
+		uint GetParallelWorkers ()
+		{
+			if (App.Current.Config.RenderParallelWorkers > 0) {
+				return App.Current.Config.RenderParallelWorkers;
+			}
+			// The encoders already use several threads each
+			return (uint)Math.Max (1, Environment.ProcessorCount / 2);
+		}
+
+		void ReportCacheStats ()
+		{
+			int hits = videoEditor.CacheHits;
+			int misses = videoEditor.CacheMisses;
+
+			// Smart renders copy the segments without the cache, they are not part of the stats
+			if (hits == 0 && misses == 0) {
+				return;
+			}
+			Log.Information (String.Format ("Render cache: {0} hits, {1} misses", hits, misses));
+			App.Current.KPIService.TrackEvent ("Render_cache", null, new Dictionary<string, double> {
+				{ "Hits", hits },
+				{ "Misses", misses }
+			});
+		}
+
 		void ProcessImage (Image image, Time duration)
 		{
 			string path = System.IO.Path.GetTempFileName ().Replace (@"\", @"\\");
@@ -385,6 +420,9 @@ namespace VAS.Services
 			} else if (progress == (float)EditorState.FINISHED) {
 				Log.Debug ("Job finished successfully");
 				videoEditor.Progress -= OnProgress;
+				if (reportCacheStats) {
+					ReportCacheStats ();
+				}
 				ViewModel.CurrentJob.Progress = progress;
 				ViewModel.CurrentJob.State = JobState.Finished;
 				App.Current.EventsBroker.Publish (new JobRenderedEvent ());
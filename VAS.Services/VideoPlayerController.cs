@@ -75,6 +75,8 @@ namespace VAS.Services
 		Segment loadedSegment;
 		PendingSeek pendingSeek;
 		readonly ITimer timer;
+		/* The player notifies the position of the frames displayed, so it's not polled */
+		bool positionPushed;
 		bool active;
 
 		readonly Time editDurationOffset = new Time { TotalSeconds = 10 };
@@ -88,6 +90,8 @@ namespace VAS.Services
 		object camerasLayout;
 		bool supportsMultipleCameras;
 		Time drawingCurrentTime;
+		/* Playlist elements queued in the player, which switches between them */
+		List<PlaylistPlayElementVM> queuedSegments;
 
 		protected struct Segment
 		{
@@ -137,6 +141,8 @@ namespace VAS.Services
 			player.StateChange -= HandleStateChange;
 			player.Eos -= HandleEndOfStream;
 			player.ReadyToSeek -= HandleReadyToSeek;
+			player.PositionChanged -= HandlePositionChanged;
+			player.SegmentChanged -= HandleSegmentChanged;
 			player.Dispose ();
 			player = null;
 			FileSet = null;
@@ -663,13 +669,14 @@ namespace VAS.Services
 				return;
 			}
 
+			ClearQueuedSegments ();
 			Switch (null, playlist, element);
 
 			switch (element) {
 			case PlaylistPlayElementVM ple:
 				LoadSegment (ple.Play.FileSet, ple.Play.Start, ple.Play.Stop,
 							 ple.Play.Start, ple.Play.Rate, ple.CamerasConfig,
-							ple.CamerasLayout, playing);
+							ple.CamerasLayout, playing, ple);
 				break;
 			case PlaylistVideoVM video:
 				LoadVideo (video, playing);
@@ -701,6 +708,7 @@ namespace VAS.Services
 				return;
 			}
 
+			ClearQueuedSegments ();
 			Switch (evt, null, null);
 
 			if (evt.Start != null && evt.Stop != null) {
@@ -1160,6 +1168,9 @@ namespace VAS.Services
 				Tick ();
 			} else {
 				EmitLoadDrawings (null);
+				if (!accurate) {
+					time = SnapToKeyframe (time);
+				}
 				if (readyToSeek) {
 					if (throttled) {
 						Log.Debug ("Throttled seek");
@@ -1184,6 +1195,25 @@ namespace VAS.Services
 			return true;
 		}
 
+		/// <summary>
+		/// Moves a keyframe seek to the keyframe where the player will land, taken from the index of the file,
+		/// so that the position shown while scrubbing is the one of the frame displayed.
+		/// </summary>
+		/// <returns>The keyframe position, or <paramref name="time"/> if the index is not available.</returns>
+		/// <param name="time">Time in the video to seek.</param>
+		Time SnapToKeyframe (Time time)
+		{
+			MediaFile file = FileSet?.FirstOrDefault ();
+			if (file == null) {
+				return time;
+			}
+			Time keyframe = App.Current.MultimediaToolkit.GetIndex (file)?.GetKeyframe (time + file.Offset);
+			if (keyframe == null || keyframe < file.Offset) {
+				return time;
+			}
+			return keyframe - file.Offset;
+		}
+
 		bool PlaylistSeek (Time time, bool accurate = false, bool synchronous = false, bool throttled = false)
 		{
 			if (loadedPlaylistElement == null) {
@@ -1384,6 +1414,7 @@ namespace VAS.Services
 		/// </summary>
 		void Reset ()
 		{
+			ClearQueuedSegments ();
 			UpdatePlayingState (false);
 			SetRate (1);
 			StillImageLoaded = false;
@@ -1416,6 +1447,51 @@ namespace VAS.Services
 			}
 		}
 
+		/// <summary>
+		/// Queues in the player the play elements of the playlist starting from the one loaded, so
+		/// that it plays them without gaps. If the player can't play segments they are loaded one
+		/// after the other when the current one finishes.
+		/// </summary>
+		/// <returns><c>true</c>, if the player seeked to the first segment, <c>false</c> otherwise.</returns>
+		/// <param name="element">The playlist element loaded.</param>
+		/// <param name="playing">If set to <c>true</c> starts playing.</param>
+		bool QueueSegments (PlaylistPlayElementVM element, bool playing)
+		{
+			if (PlayerVM.EditEventDurationModeEnabled) {
+				return false;
+			}
+
+			var segments = LoadedPlaylist.ViewModels.SkipWhile (e => e.Model != element.Model)
+										 .TakeWhile (e => e is PlaylistPlayElementVM)
+										 .Cast<PlaylistPlayElementVM> ().ToList ();
+			if (!segments.Any ()) {
+				return false;
+			}
+
+			player.ClearSegments ();
+			foreach (var segment in segments) {
+				MediaFileSet fileSet = segment.Play.FileSet ?? FileSet;
+				player.AddSegment (fileSet [0], segment.Play.Start, segment.Play.Stop, segment.Play.Rate);
+			}
+			if (player.PlaySegments (playing)) {
+				queuedSegments = segments;
+				return true;
+			}
+			player.ClearSegments ();
+			return false;
+		}
+
+		/// <summary>
+		/// Removes the playlist elements queued in the player.
+		/// </summary>
+		void ClearQueuedSegments ()
+		{
+			if (queuedSegments != null) {
+				queuedSegments = null;
+				player.ClearSegments ();
+			}
+		}
+
 		/// <summary>
 		/// Loads a video segment defined by a <see cref="TimelineEvent"/> in the player.
 		/// </summary>
@@ -1427,9 +1503,10 @@ namespace VAS.Services
 		/// <param name="camerasConfig">Cameras configuration.</param>
 		/// <param name="camerasLayout">Cameras layout.</param>
 		/// <param name="playing">If set to <c>true</c> starts playing.</param>
+		/// <param name="playlistElement">Playlist element queued in the player with the next ones, if any.</param>
 		void LoadSegment (MediaFileSet fileSet, Time start, Time stop, Time seekTime,
 											float rate, RangeObservableCollection<CameraConfig> camerasConfig, object camerasLayout,
-											bool playing)
+											bool playing, PlaylistPlayElementVM playlistElement = null)
 		{
 			Log.Debug (String.Format ("Update player segment {0} {1} {2}",
 				start, stop, rate));
@@ -1451,6 +1528,17 @@ namespace VAS.Services
 			loadedSegment.Stop = stop;
 			StillImageLoaded = false;
 			if (readyToSeek) {
+				if (playlistElement != null && QueueSegments (playlistElement, playing)) {
+					/* The player seeks to the first segment with its rate */
+					Log.Debug ("Playing the segments queued in the player");
+					SetEventRate (rate);
+					EmitRateChanged (rate);
+					if (playing) {
+						EmitLoadDrawings (null);
+						Playing = true;
+					}
+					return;
+				}
 				Log.Debug ("Player is ready to seek, seeking to " +
 				seekTime.ToMSecondsString ());
 				SetRate (rate);
@@ -1550,6 +1638,8 @@ namespace VAS.Services
 			player.StateChange += HandleStateChange;
 			player.Eos += HandleEndOfStream;
 			player.ReadyToSeek += HandleReadyToSeek;
+			player.PositionChanged += HandlePositionChanged;
+			player.SegmentChanged += HandleSegmentChanged;
 		}
 
 		/// <summary>
@@ -1611,8 +1701,11 @@ namespace VAS.Services
 					// playlist element.
 					if (!PlayerVM.EditEventDurationModeEnabled) {
 						if (currentTime > loadedSegment.Stop) {
-							/* Check if the segment is now finished and jump to next one */
-							Next ();
+							/* Check if the segment is now finished and jump to next one,
+							 * the player switches to the queued ones by itself */
+							if (queuedSegments == null) {
+								Next ();
+							}
 						} else {
 							var drawings = LoadedTimelineEvent?.Drawings;
 							if (drawings != null) {
@@ -1705,7 +1798,9 @@ namespace VAS.Services
 		{
 			App.Current.GUIToolkit.Invoke (delegate {
 				if (e.Playing) {
-					ReconfigureTimeout (TIMEOUT_MS);
+					if (!positionPushed || StillImageLoaded) {
+						ReconfigureTimeout (TIMEOUT_MS);
+					}
 				} else {
 					if (!StillImageLoaded) {
 						ReconfigureTimeout (0);
@@ -1738,7 +1833,7 @@ namespace VAS.Services
 		void HandleEndOfStream (object sender)
 		{
 			App.Current.GUIToolkit.Invoke (delegate {
-				if (loadedPlaylistElement is PlaylistVideo) {
+				if (loadedPlaylistElement is PlaylistVideo || queuedSegments != null) {
 					Next ();
 				} else {
 					Time position = null;
@@ -1755,6 +1850,31 @@ namespace VAS.Services
 			});
 		}
 
+		void HandleSegmentChanged (int index)
+		{
+			App.Current.GUIToolkit.Invoke (delegate {
+				/* The first one is the element already loaded */
+				if (queuedSegments == null || index <= 0 || index >= queuedSegments.Count) {
+					return;
+				}
+
+				/* The player is already playing the element, only the state is updated */
+				PlaylistPlayElementVM element = queuedSegments [index];
+				Log.Debug (string.Format ("Playlist element \"{0}\" started", element.Description));
+				Switch (null, LoadedPlaylist, element);
+				UpdateCamerasConfig (element.CamerasConfig, element.CamerasLayout);
+				if (element.Play.FileSet != null && !element.Play.FileSet.Equals (FileSet)) {
+					FileSet = element.Play.FileSet;
+				}
+				loadedSegment.Start = element.Play.Start;
+				loadedSegment.Stop = element.Play.Stop;
+				EmitRateChanged (element.Play.Rate);
+				UpdateDuration ();
+				LoadedPlaylist.SetActive (element);
+				EmitElementLoaded (element, LoadedPlaylist);
+			});
+		}
+
 		void HandleError (object sender, string message)
 		{
 			App.Current.GUIToolkit.Invoke (delegate {
@@ -1797,6 +1917,23 @@ namespace VAS.Services
 			}
 		}
 
+		void HandlePositionChanged (Time currentTime, Time runningTime)
+		{
+			App.Current.GUIToolkit.Invoke (delegate {
+				if (StillImageLoaded) {
+					return;
+				}
+				/* The timer is only needed until the player starts notifying the position */
+				positionPushed = true;
+				if (timer.Enabled) {
+					ReconfigureTimeout (0);
+				}
+				if (!IgnoreTicks) {
+					Tick (currentTime);
+				}
+			});
+		}
+
 		void HandleTimeout (object sender, EventArgs e)
 		{
 			App.Current.GUIToolkit.Invoke (delegate {
@@ -0,0 +1,51 @@
+//
+//  Copyright (C) 2018 Fluendo S.A.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+using NUnit.Framework;
+using VAS.Core.Common;
+using VAS.Core.Store;
+
+namespace VAS.Tests.Core.Common
+{
+	[TestFixture ()]
+	public class TestCaptureStats
+	{
+		[Test ()]
+		public void TestLoadEmpty ()
+		{
+			CaptureStats stats = new CaptureStats ();
+
+			Assert.AreEqual (0, stats.Load);
+		}
+
+		[Test ()]
+		public void TestLoadMostLoadedQueue ()
+		{
+			CaptureStats stats = new CaptureStats {
+				VideoQueueLevel = 5,
+				VideoQueueMaxLevel = 20,
+				AudioQueueLevel = new Time (500),
+				AudioQueueMaxLevel = new Time (1000),
+			};
+
+			Assert.AreEqual (0.5, stats.Load);
+
+			stats.VideoQueueLevel = 30;
+			Assert.AreEqual (1, stats.Load);
+		}
+	}
+}
@@ -0,0 +1,112 @@
+//
+//  Copyright (C) 2018 Fluendo S.A.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+using System;
+using System.Collections.Generic;
+using System.IO;
+using NUnit.Framework;
+using VAS.Core.Store;
+
+namespace VAS.Tests.Core.Store
+{
+	[TestFixture ()]
+	public class TestMediaFileIndex
+	{
+		[Test ()]
+		public void TestSerialization ()
+		{
+			MediaFileIndex index = new MediaFileIndex {
+				FileSize = 1000,
+				LastModified = new DateTime (2018, 1, 1, 0, 0, 0, DateTimeKind.Utc),
+				Keyframes = new List<Time> { new Time (0), new Time (2000) },
+				KeyframeOffsets = new List<long> { 0, -1 },
+				ThumbnailsInterval = new Time (5000),
+				Thumbnails = new List<byte []> { new byte [] { 1, 2, 3 } },
+				Preview = new byte [] { 4, 5, 6 },
+			};
+
+			MediaFileIndex newindex = Utils.SerializeDeserialize (index);
+			Assert.AreEqual (index.FileSize, newindex.FileSize);
+			Assert.AreEqual (index.LastModified, newindex.LastModified);
+			Assert.AreEqual (index.Keyframes, newindex.Keyframes);
+			Assert.AreEqual (index.KeyframeOffsets, newindex.KeyframeOffsets);
+			Assert.AreEqual (index.ThumbnailsInterval, newindex.ThumbnailsInterval);
+			Assert.AreEqual (index.Thumbnails, newindex.Thumbnails);
+			Assert.AreEqual (index.Preview, newindex.Preview);
+		}
+
+		[Test ()]
+		public void TestGetKeyframe ()
+		{
+			MediaFileIndex index = new MediaFileIndex {
+				Keyframes = new List<Time> { new Time (1000), new Time (3000), new Time (5000) },
+			};
+
+			Assert.IsNull (index.GetKeyframe (new Time (500)));
+			Assert.AreEqual (new Time (1000), index.GetKeyframe (new Time (1000)));
+			Assert.AreEqual (new Time (3000), index.GetKeyframe (new Time (4999)));
+			Assert.AreEqual (new Time (5000), index.GetKeyframe (new Time (60000)));
+		}
+
+		[Test ()]
+		public void TestGetThumbnail ()
+		{
+			byte [] data = Utils.LoadImageFromFile ().Serialize ();
+			MediaFileIndex index = new MediaFileIndex {
+				ThumbnailsInterval = new Time (5000),
+				Thumbnails = new List<byte []> { data, data },
+			};
+
+			Assert.IsNotNull (index.GetThumbnail (new Time (2000)));
+			Assert.IsNull (index.GetThumbnail (new Time (2000), new Time (1000)));
+			Assert.IsNotNull (index.GetThumbnail (new Time (4500), new Time (1000)));
+			Assert.IsNull (index.GetThumbnail (new Time (20000), new Time (1000)));
+		}
+
+		[Test ()]
+		public void TestGetPreview ()
+		{
+			MediaFileIndex index = new MediaFileIndex ();
+
+			Assert.IsNull (index.GetPreview ());
+			index.Preview = Utils.LoadImageFromFile ().Serialize ();
+			Assert.IsNotNull (index.GetPreview ());
+		}
+
+		[Test ()]
+		public void TestIsValid ()
+		{
+			string path = Path.GetTempFileName ();
+			MediaFileIndex index = new MediaFileIndex ();
+			try {
+				File.WriteAllBytes (path, new byte [] { 1, 2, 3 });
+				index.SetFileInfo (path);
+				Assert.IsTrue (index.IsValid (path));
+
+				File.WriteAllBytes (path, new byte [] { 1, 2, 3, 4 });
+				Assert.IsFalse (index.IsValid (path));
+
+				index.SetFileInfo (path);
+				File.SetLastWriteTimeUtc (path, index.LastModified.AddMinutes (1));
+				Assert.IsFalse (index.IsValid (path));
+			} finally {
+				File.Delete (path);
+			}
+			Assert.IsFalse (index.IsValid (path));
+		}
+	}
+}
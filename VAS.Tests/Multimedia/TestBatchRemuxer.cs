@@ -0,0 +1,139 @@
+//
+//  Copyright (C) 2018 Fluendo S.A.
+//
+//  This program is free software; you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation; either version 2 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program; if not, write to the Free Software
+//  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+using System;
+using System.Collections.Generic;
+using System.Linq;
+using Moq;
+using NUnit.Framework;
+using VAS.Core.Common;
+using VAS.Core.Interfaces.Multimedia;
+using VAS.Multimedia.Remuxer;
+
+namespace VAS.Tests.Multimedia
+{
+	[TestFixture ()]
+	public class TestBatchRemuxer
+	{
+		List<RemuxJob> jobs;
+		Dictionary<RemuxJob, Mock<IRemuxer>> remuxers;
+		BatchRemuxer batch;
+
+		[SetUp]
+		public void SetUp ()
+		{
+			jobs = Enumerable.Range (0, 4).Select (i => new RemuxJob ("in" + i + ".ts", "out" + i + ".mp4",
+				VideoMuxerType.Mp4)).ToList ();
+			remuxers = new Dictionary<RemuxJob, Mock<IRemuxer>> ();
+			batch = new BatchRemuxer (jobs, 2, job => {
+				var mock = new Mock<IRemuxer> ();
+				remuxers [job] = mock;
+				return mock.Object;
+			});
+		}
+
+		[Test ()]
+		public void TestStartRunsUpToWorkers ()
+		{
+			batch.Start ();
+
+			Assert.AreEqual (2, remuxers.Count);
+			remuxers [jobs [0]].Verify (r => r.Start (), Times.Once ());
+			remuxers [jobs [1]].Verify (r => r.Start (), Times.Once ());
+		}
+
+		[Test ()]
+		public void TestNextJobStartsWhenOneFinishes ()
+		{
+			List<RemuxJob> finished = new List<RemuxJob> ();
+			batch.JobFinished += finished.Add;
+			batch.Start ();
+
+			remuxers [jobs [0]].Raise (r => r.Progress += null, 0.5f);
+			Assert.AreEqual (2, remuxers.Count);
+
+			remuxers [jobs [0]].Raise (r => r.Progress += null, 1f);
+			Assert.AreEqual (3, remuxers.Count);
+			Assert.AreEqual (new [] { jobs [0] }, finished);
+		}
+
+		[Test ()]
+		public void TestNextJobStartsOnError ()
+		{
+			batch.Start ();
+
+			remuxers [jobs [1]].Raise (r => r.Error += null, this, "error");
+
+			Assert.AreEqual ("error", jobs [1].Error);
+			Assert.IsTrue (jobs [1].Finished);
+			Assert.AreEqual (3, remuxers.Count);
+		}
+
+		[Test ()]
+		public void TestAggregateProgress ()
+		{
+			float progress = 0;
+			batch.Progress += (p) => progress = p;
+			batch.Start ();
+
+			remuxers [jobs [0]].Raise (r => r.Progress += null, 0.5f);
+			Assert.AreEqual (0.125f, progress);
+
+			remuxers [jobs [0]].Raise (r => r.Progress += null, 1f);
+			remuxers [jobs [1]].Raise (r => r.Progress += null, 1f);
+			remuxers [jobs [2]].Raise (r => r.Error += null, this, "error");
+			remuxers [jobs [3]].Raise (r => r.Progress += null, 1f);
+			Assert.AreEqual (1f, progress);
+		}
+
+		[Test ()]
+		public void TestCancel ()
+		{
+			batch.Start ();
+
+			batch.Cancel ();
+
+			remuxers [jobs [0]].Verify (r => r.Cancel (), Times.Once ());
+			remuxers [jobs [1]].Verify (r => r.Cancel (), Times.Once ());
+			remuxers [jobs [0]].Raise (r => r.Progress += null, 1f);
+			Assert.AreEqual (2, remuxers.Count);
+		}
+
+		[Test ()]
+		public void TestFinishedRemuxersAreDisposed ()
+		{
+			var disposables = new List<Mock<IDisposable>> ();
+			var shared = new Mock<IDisposable> ();
+			batch = new BatchRemuxer (jobs, 2, job => {
+				var mock = new Mock<IRemuxer> ();
+				disposables.Add (mock.As<IDisposable> ());
+				remuxers [job] = mock;
+				return mock.Object;
+			}, shared.Object);
+			batch.Start ();
+
+			remuxers [jobs [0]].Raise (r => r.Progress += null, 1f);
+			disposables [0].Verify (d => d.Dispose (), Times.Once ());
+			disposables [1].Verify (d => d.Dispose (), Times.Never ());
+
+			batch.Dispose ();
+			disposables [1].Verify (d => d.Dispose (), Times.Once ());
+			disposables [2].Verify (d => d.Dispose (), Times.Once ());
+			shared.Verify (d => d.Dispose (), Times.Once ());
+		}
+	}
+}
@@ -167,8 +167,10 @@ namespace VAS.Tests.Multimedia
 
 		public event EosHandler Eos;
 		public event ErrorHandler Error;
+		public event PositionChangedHandler PositionChanged;
 		public event ReadyToSeekHandler ReadyToSeek;
 		public event ScopeStateChangedHandler ScopeChangedEvent;
+		public event SegmentChangedHandler SegmentChanged;
 		public event StateChangeHandler StateChange;
 
 		public void ApplyCamerasConfig ()
@@ -176,11 +178,21 @@ namespace VAS.Tests.Multimedia
 			throw new NotImplementedException ();
 		}
 
+		public void AddSegment (MediaFile file, Time start, Time stop, double rate)
+		{
+			throw new NotImplementedException ();
+		}
+
 		public void ApplyROI (CameraConfig camConfig)
 		{
 			throw new NotImplementedException ();
 		}
 
+		public void ClearSegments ()
+		{
+			throw new NotImplementedException ();
+		}
+
 		public void Close ()
 		{
 			throw new NotImplementedException ();
@@ -226,6 +238,11 @@ namespace VAS.Tests.Multimedia
 			throw new NotImplementedException ();
 		}
 
+		public bool PlaySegments (bool playing)
+		{
+			throw new NotImplementedException ();
+		}
+
 		public bool Seek (Time time, bool accurate = false, bool synchronous = false)
 		{
 			throw new NotImplementedException ();
@@ -15,6 +15,7 @@
 //  along with this program; if not, write to the Free Software
 //  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
 //
+using System.Collections.Generic;
 using System.Collections.ObjectModel;
 using System.IO;
 using Moq;
@@ -208,6 +209,108 @@ namespace VAS.Tests.Services
 			editorMock.Verify (m => m.AddSegment (file1, 8000, 2000, 1, null, false, new Area ()));
 		}
 
+		[Test]
+		public void TestLoadEditionJobReportsCacheStats ()
+		{
+			EditionJob job;
+
+			App.Current.Config.UseRenderCache = true;
+			editorMock.SetupGet (ed => ed.CacheHits).Returns (3);
+			editorMock.SetupGet (ed => ed.CacheMisses).Returns (1);
+			job = PrepareEditon ();
+			AddTimelineEvent (job.Playlist, 30000, 31000, file1);
+
+			try {
+				manager.Add (job);
+			} finally {
+				App.Current.Config.UseRenderCache = false;
+			}
+
+			editorMock.Verify (ed => ed.SetCache (App.Current.RenderCacheDir, It.IsAny<long> ()), Times.Once ());
+			kpiMock.Verify (kpi => kpi.TrackEvent ("Render_cache", null,
+				It.IsAny<IDictionary<string, double>> ()), Times.Never ());
+
+			editorMock.Raise (ed => ed.Progress += null, (float)EditorState.FINISHED);
+
+			kpiMock.Verify (kpi => kpi.TrackEvent ("Render_cache", null,
+				It.Is<IDictionary<string, double>> (d => d ["Hits"] == 3 && d ["Misses"] == 1)), Times.Once ());
+		}
+
+		[Test]
+		public void TestLoadEditionJobSmartRenderNotInCacheStats ()
+		{
+			EditionJob job;
+
+			App.Current.Config.UseRenderCache = true;
+			App.Current.Config.UseSmartRender = true;
+			editorMock.SetupGet (ed => ed.CacheHits).Returns (0);
+			editorMock.SetupGet (ed => ed.CacheMisses).Returns (0);
+			job = PrepareEditon ();
+			AddTimelineEvent (job.Playlist, 30000, 31000, file1);
+
+			try {
+				manager.Add (job);
+				editorMock.Raise (ed => ed.Progress += null, (float)EditorState.FINISHED);
+			} finally {
+				App.Current.Config.UseRenderCache = false;
+				App.Current.Config.UseSmartRender = false;
+			}
+
+			kpiMock.Verify (kpi => kpi.TrackEvent ("Render_cache", null,
+				It.IsAny<IDictionary<string, double>> ()), Times.Never ());
+		}
+
+		[Test]
+		public void TestLoadEditionJobCacheDisabledByDefault ()
+		{
+			EditionJob job;
+
+			job = PrepareEditon ();
+			AddTimelineEvent (job.Playlist, 30000, 31000, file1);
+
+			manager.Add (job);
+
+			editorMock.Verify (ed => ed.SetCache (It.IsAny<string> (), It.IsAny<long> ()), Times.Never ());
+			kpiMock.Verify (kpi => kpi.TrackEvent ("Render_cache", null,
+				It.IsAny<IDictionary<string, double>> ()), Times.Never ());
+		}
+
+		[Test]
+		public void TestLoadEditionJobSmartRender ()
+		{
+			EditionJob job;
+
+			App.Current.Config.UseSmartRender = true;
+			job = PrepareEditon ();
+			AddTimelineEvent (job.Playlist, 30000, 31000, file1);
+
+			try {
+				manager.Add (job);
+			} finally {
+				App.Current.Config.UseSmartRender = false;
+			}
+
+			editorMock.VerifySet (ed => ed.SmartRender = true, Times.Once ());
+		}
+
+		[Test]
+		public void TestLoadEditionJobParallelWorkers ()
+		{
+			EditionJob job;
+
+			App.Current.Config.RenderParallelWorkers = 3;
+			job = PrepareEditon ();
+			AddTimelineEvent (job.Playlist, 30000, 31000, file1);
+
+			try {
+				manager.Add (job);
+			} finally {
+				App.Current.Config.RenderParallelWorkers = 0;
+			}
+
+			editorMock.VerifySet (ed => ed.ParallelWorkers = 3, Times.Once ());
+		}
+
 		EditionJob PrepareEditon ()
 		{
 			var playlist = new Playlist ();
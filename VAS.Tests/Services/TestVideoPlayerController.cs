@@ -507,6 +507,23 @@ namespace VAS.Tests.Services
 			fileManager.Setup (f => f.FileExists (It.IsAny<string> ())).Returns (false);
 		}
 
+		[Test ()]
+		public void TestSeekSnapsToIndexKeyframe ()
+		{
+			var index = new MediaFileIndex {
+				Keyframes = new List<Time> { new Time (0), new Time (1000), new Time (3000) },
+			};
+			mtkMock.Setup (m => m.GetIndex (It.IsAny<MediaFile> ())).Returns (index);
+			PreparePlayer ();
+			playerMock.ResetCalls ();
+
+			player.Seek (new Time (2000), false, false, false);
+			playerMock.Verify (p => p.Seek (new Time (1000), false, false), Times.Once ());
+
+			player.Seek (new Time (2000), true, false, false);
+			playerMock.Verify (p => p.Seek (new Time (2000), true, false), Times.Once ());
+		}
+
 		[Test ()]
 		public void TestSeekProportional ()
 		{
@@ -2630,6 +2647,137 @@ namespace VAS.Tests.Services
 
 			Assert.IsNull (player.PlayerVM.FrameDrawing);
 		}
+
+		[Test]
+		public void PositionChanged_PlayerNotifiesPosition_TimeChangedWithNotifiedPosition ()
+		{
+			// Arrange
+			Time curTime = null;
+			PreparePlayer ();
+			player.TimeChangedEvent += (c, d, s) => curTime = c;
+
+			// Act
+			playerMock.Raise (p => p.PositionChanged += null, new Time (3000), new Time (1000));
+
+			// Assert
+			Assert.AreEqual (new Time (3000), curTime);
+		}
+
+		[Test]
+		public void PositionChanged_PlayerNotifiesPosition_TimerStoppedAndNotRestarted ()
+		{
+			// Arrange
+			timerMock.SetupGet (t => t.Enabled).Returns (true);
+			PreparePlayer ();
+			player.Play ();
+			timerMock.Verify (t => t.Start (), Times.Once ());
+
+			// Act
+			playerMock.Raise (p => p.PositionChanged += null, new Time (3000), new Time (1000));
+			player.Pause ();
+			timerMock.ResetCalls ();
+			player.Play ();
+
+			// Assert
+			timerMock.Verify (t => t.Start (), Times.Never ());
+		}
+
+		[Test]
+		public void LoadPlaylistEvent_PlayerPlaysSegments_PlayElementsQueued ()
+		{
+			// Arrange
+			playlistVM.Model.Elements.Insert (1, new PlaylistPlayElement (eventVM2.Model));
+			playerMock.Setup (p => p.PlaySegments (It.IsAny<bool> ())).Returns (true);
+			PreparePlayer ();
+
+			// Act
+			player.LoadPlaylistEvent (playlistVM, playlistVM.ViewModels [0], true);
+
+			// Assert
+			playerMock.Verify (p => p.AddSegment (mfs [0], eventVM1.Start, eventVM1.Stop, It.IsAny<double> ()),
+							   Times.Once ());
+			playerMock.Verify (p => p.AddSegment (mfs [0], eventVM2.Start, eventVM2.Stop, It.IsAny<double> ()),
+							   Times.Once ());
+			playerMock.Verify (p => p.AddSegment (It.IsAny<MediaFile> (), It.IsAny<Time> (), It.IsAny<Time> (),
+												  It.IsAny<double> ()), Times.Exactly (2));
+			playerMock.Verify (p => p.PlaySegments (true), Times.Once ());
+		}
+
+		[Test]
+		public void LoadPlaylistEvent_PlayerPlaysSegments_PlayerNotSeeked ()
+		{
+			// Arrange
+			playlistVM.Model.Elements.Insert (1, new PlaylistPlayElement (eventVM2.Model));
+			playerMock.Setup (p => p.PlaySegments (It.IsAny<bool> ())).Returns (true);
+			PreparePlayer ();
+			playerMock.ResetCalls ();
+
+			// Act
+			player.LoadPlaylistEvent (playlistVM, playlistVM.ViewModels [0], true);
+
+			// Assert
+			playerMock.Verify (p => p.PlaySegments (true), Times.Once ());
+			playerMock.Verify (p => p.Seek (It.IsAny<Time> (), It.IsAny<bool> (), It.IsAny<bool> ()), Times.Never ());
+			Assert.IsTrue (player.Playing);
+		}
+
+		[Test]
+		public void Tick_SegmentsQueuedAndSegmentFinished_NextElementNotLoaded ()
+		{
+			// Arrange
+			playlistVM.Model.Elements.Insert (1, new PlaylistPlayElement (eventVM2.Model));
+			playerMock.Setup (p => p.PlaySegments (It.IsAny<bool> ())).Returns (true);
+			PreparePlayer ();
+			player.LoadPlaylistEvent (playlistVM, playlistVM.ViewModels [0], true);
+			playerMock.ResetCalls ();
+
+			// Act
+			currentTime = eventVM1.Stop + new Time (100);
+			timerMock.Raise (t => t.Elapsed += null, new EventArgs () as ElapsedEventArgs);
+
+			// Assert
+			Assert.AreEqual (0, playlistVM.CurrentIndex);
+			playerMock.Verify (p => p.Seek (It.IsAny<Time> (), It.IsAny<bool> (), It.IsAny<bool> ()), Times.Never ());
+		}
+
+		[Test]
+		public void SegmentChanged_SegmentsQueued_ElementLoadedWithoutSeeking ()
+		{
+			// Arrange
+			int elementsLoaded = 0;
+			playlistVM.Model.Elements.Insert (1, new PlaylistPlayElement (eventVM2.Model));
+			playerMock.Setup (p => p.PlaySegments (It.IsAny<bool> ())).Returns (true);
+			PreparePlayer ();
+			player.LoadPlaylistEvent (playlistVM, playlistVM.ViewModels [0], true);
+			playerMock.ResetCalls ();
+			EventToken et = App.Current.EventsBroker.Subscribe<PlaylistElementLoadedEvent> ((e) => elementsLoaded++);
+
+			// Act
+			playerMock.Raise (p => p.SegmentChanged += null, 1);
+
+			// Assert
+			Assert.AreEqual (1, playlistVM.CurrentIndex);
+			Assert.AreEqual (1, elementsLoaded);
+			playerMock.Verify (p => p.Seek (It.IsAny<Time> (), It.IsAny<bool> (), It.IsAny<bool> ()), Times.Never ());
+			playerMock.Verify (p => p.ClearSegments (), Times.Never ());
+			App.Current.EventsBroker.Unsubscribe<PlaylistElementLoadedEvent> (et);
+		}
+
+		[Test]
+		public void Eos_SegmentsQueued_NextElementLoaded ()
+		{
+			// Arrange
+			playerMock.Setup (p => p.PlaySegments (It.IsAny<bool> ())).Returns (true);
+			PreparePlayer ();
+			player.LoadPlaylistEvent (playlistVM, playlistVM.ViewModels [0], true);
+
+			// Act
+			playerMock.Raise (p => p.Eos += null, this);
+
+			// Assert
+			Assert.AreEqual (1, playlistVM.CurrentIndex);
+			playerMock.Verify (p => p.ClearSegments (), Times.Exactly (2));
+		}
 	}
 }
 
@@ -74,7 +74,7 @@ namespace VAS.Video.Utils
 		public virtual void CaptureFrames ()
 		{
 			Time pos;
-			VAS.Core.Common.Image frame;
+			List<Time> positions;
 			IList<CameraConfig> cameras;
 			bool quit = false;
 			int i = 0;
@@ -112,33 +112,38 @@ namespace VAS.Video.Utils
 					});
 				}
 				
-				j = 0;
+				positions = new List<Time> ();
 				while (pos <= stop) {
+					positions.Add (pos + file.Offset);
+					pos.MSeconds += (int)interval;
+				}
+
+				j = 0;
+				capturer.GetFrames (positions, (frame, time) => {
 					Log.Debug ("Capturing fame " + j);
-					if (!cancel) {
-						frame = capturer.GetFrame (pos + file.Offset, true);
-						if (frame != null) {
-							string path = String.Format ("{0}_angle{1}_{2}.png", seriesName, cameraConfig.Index, j);
-							frame.Save (System.IO.Path.Combine (outputDir, path));
-							frame.ScaleInplace (THUMBNAIL_MAX_WIDTH, THUMBNAIL_MAX_HEIGHT);
-						}
-						
-						if (Progress != null) {
-							Application.Invoke (delegate {
-								Progress (i + 1, totalFrames, frame);
-							});
-						}
-						pos.MSeconds += (int)interval;
-						i++;
-						j++;
-					} else {
+					if (cancel) {
 						Log.Debug ("Capture cancelled, deleting output directory");
 						System.IO.Directory.Delete (outputDir, true);
 						cancel = false;
 						quit = true;
-						break;
+						return false;
 					}
-				}
+					if (frame != null) {
+						string path = String.Format ("{0}_angle{1}_{2}.png", seriesName, cameraConfig.Index, j);
+						frame.Save (System.IO.Path.Combine (outputDir, path));
+						frame.ScaleInplace (THUMBNAIL_MAX_WIDTH, THUMBNAIL_MAX_HEIGHT);
+					}
+
+					if (Progress != null) {
+						int actual = i + 1;
+						Application.Invoke (delegate {
+							Progress (actual, totalFrames, frame);
+						});
+					}
+					i++;
+					j++;
+					return true;
+				});
 			}
 			capturer.Dispose ();
 		}
@@ -286,6 +286,49 @@ baconvideowidget_marshal_VOID__INT_INT_INT_INT (GClosure     *closure,
             data2);
 }
 
+/* VOID:INT64,INT64 (./baconvideowidget-marshal.list:6) */
+extern void baconvideowidget_marshal_VOID__INT64_INT64 (GClosure     *closure,
+                                                        GValue       *return_value,
+                                                        guint         n_param_values,
+                                                        const GValue *param_values,
+                                                        gpointer      invocation_hint,
+                                                        gpointer      marshal_data);
+void
+baconvideowidget_marshal_VOID__INT64_INT64 (GClosure     *closure,
+                                            GValue       *return_value G_GNUC_UNUSED,
+                                            guint         n_param_values,
+                                            const GValue *param_values,
+                                            gpointer      invocation_hint G_GNUC_UNUSED,
+                                            gpointer      marshal_data)
+{
+  typedef void (*GMarshalFunc_VOID__INT64_INT64) (gpointer     data1,
+                                                  gint64       arg_1,
+                                                  gint64       arg_2,
+                                                  gpointer     data2);
+  register GMarshalFunc_VOID__INT64_INT64 callback;
+  register GCClosure *cc = (GCClosure*) closure;
+  register gpointer data1, data2;
+
+  g_return_if_fail (n_param_values == 3);
+
+  if (G_CCLOSURE_SWAP_DATA (closure))
+    {
+      data1 = closure->data;
+      data2 = g_value_peek_pointer (param_values + 0);
+    }
+  else
+    {
+      data1 = g_value_peek_pointer (param_values + 0);
+      data2 = closure->data;
+    }
+  callback = (GMarshalFunc_VOID__INT64_INT64) (marshal_data ? marshal_data : cc->callback);
+
+  callback (data1,
+            g_marshal_value_peek_int64 (param_values + 1),
+            g_marshal_value_peek_int64 (param_values + 2),
+            data2);
+}
+
 G_END_DECLS
 
 #endif /* __baconvideowidget_marshal_MARSHAL_H__ */
@@ -46,6 +46,14 @@ extern void baconvideowidget_marshal_VOID__INT_INT_INT_INT (GClosure     *closur
                                                             gpointer      invocation_hint,
                                                             gpointer      marshal_data);
 
+/* VOID:INT64,INT64 (./baconvideowidget-marshal.list:6) */
+extern void baconvideowidget_marshal_VOID__INT64_INT64 (GClosure     *closure,
+                                                        GValue       *return_value,
+                                                        guint         n_param_values,
+                                                        const GValue *param_values,
+                                                        gpointer      invocation_hint,
+                                                        gpointer      marshal_data);
+
 G_END_DECLS
 
 #endif /* __baconvideowidget_marshal_MARSHAL_H__ */
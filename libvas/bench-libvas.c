@@ -0,0 +1,711 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * Copyright (C) Fluendo S.A. 2018
+ *
+ * bench-libvas is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * bench-libvas is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Benchmarks for the rendering, remuxing and frame extraction paths of
+ * libvas. The input files are generated locally with videotestsrc and
+ * audiotestsrc and the results are written in JSON, so that they can be
+ * compared across releases.
+ *
+ * Build with "make bench" and run with:
+ *   bench-libvas [--iterations N] [--duration SECONDS] [--output FILE]
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <gst/gst.h>
+#include <glib/gstdio.h>
+
+#include "lgm-utils.h"
+#include "lgm-video-player.h"
+#include "gst-video-editor.h"
+#include "gst-remuxer.h"
+#include "gst-nle-source.h"
+
+#define BENCH_ERROR g_quark_from_static_string ("bench-libvas")
+#define BENCH_WIDTH 1280
+#define BENCH_HEIGHT 720
+#define BENCH_FPS 25
+#define BENCH_VIDEO_QUALITY 4000
+#define BENCH_AUDIO_QUALITY 128
+#define BENCH_SEGMENT_DURATION 2000     /* ms */
+#define BENCH_TIMEOUT 600       /* s */
+
+typedef struct
+{
+  const gchar *name;
+  VideoEncoderType video_encoder;
+  AudioEncoderType audio_encoder;
+  VideoMuxerType muxer;
+  const gchar *extension;
+} BenchFormat;
+
+static const BenchFormat bench_formats[] = {
+  {"mp4-h264", VIDEO_ENCODER_H264, AUDIO_ENCODER_AAC, VIDEO_MUXER_MP4, "mp4"},
+  {"mkv-h264", VIDEO_ENCODER_H264, AUDIO_ENCODER_AAC, VIDEO_MUXER_MATROSKA,
+      "mkv"},
+  {"avi-mpeg4", VIDEO_ENCODER_MPEG4, AUDIO_ENCODER_MP3, VIDEO_MUXER_AVI,
+      "avi"},
+  {"avi-xvid", VIDEO_ENCODER_XVID, AUDIO_ENCODER_MP3, VIDEO_MUXER_AVI, "avi"},
+  {"mpg-mpeg2", VIDEO_ENCODER_MPEG2, AUDIO_ENCODER_MP3, VIDEO_MUXER_MPEG_PS,
+      "mpg"},
+  {"ogg-theora", VIDEO_ENCODER_THEORA, AUDIO_ENCODER_VORBIS, VIDEO_MUXER_OGG,
+      "ogg"},
+  {"webm-vp8", VIDEO_ENCODER_VP8, AUDIO_ENCODER_VORBIS, VIDEO_MUXER_WEBM,
+      "webm"},
+};
+
+static const guint bench_n_segments[] = { 1, 10, 50 };
+
+static gint iterations = 3;
+static gint duration = 30;
+static gchar *output = NULL;
+static gchar *work_dir = NULL;
+static GString *results = NULL;
+static GMainLoop *loop = NULL;
+static gboolean run_ok;
+
+static GOptionEntry entries[] = {
+  {"iterations", 'i', 0, G_OPTION_ARG_INT, &iterations,
+      "Number of runs of each benchmark", "N"},
+  {"duration", 'd', 0, G_OPTION_ARG_INT, &duration,
+      "Duration of the generated sources", "SECONDS"},
+  {"output", 'o', 0, G_OPTION_ARG_FILENAME, &output,
+      "Write the results to this file instead of stdout", "FILE"},
+  {NULL}
+};
+
+/* Results */
+
+static gint
+bench_compare_samples (gconstpointer a, gconstpointer b)
+{
+  gdouble da = *(const gdouble *) a, db = *(const gdouble *) b;
+
+  return da < db ? -1 : (da > db ? 1 : 0);
+}
+
+static void
+bench_report (const gchar * name, const gchar * format, const gchar * params,
+    GArray * samples, const gchar * unit)
+{
+  gdouble total = 0;
+  guint i;
+
+  if (samples->len == 0) {
+    return;
+  }
+
+  g_array_sort (samples, bench_compare_samples);
+  for (i = 0; i < samples->len; i++) {
+    total += g_array_index (samples, gdouble, i);
+  }
+
+  if (results->len > 0) {
+    g_string_append (results, ",\n");
+  }
+  g_string_append_printf (results, "    {\"name\": \"%s\", \"format\": \"%s\", "
+      "\"params\": {%s}, \"unit\": \"%s\", \"samples\": %u, "
+      "\"mean\": %.3f, \"median\": %.3f, \"min\": %.3f, \"max\": %.3f}",
+      name, format, params ? params : "", unit, samples->len,
+      total / samples->len,
+      g_array_index (samples, gdouble, samples->len / 2),
+      g_array_index (samples, gdouble, 0),
+      g_array_index (samples, gdouble, samples->len - 1));
+
+  g_printerr ("%-16s %-12s %-24s %10.3f %s\n", name, format,
+      params ? params : "", total / samples->len, unit);
+}
+
+static void
+bench_write_results (void)
+{
+  GString *json;
+  GDateTime *now;
+  gchar *date, *version;
+
+  now = g_date_time_new_now_utc ();
+  date = g_date_time_format (now, "%Y-%m-%dT%H:%M:%SZ");
+  version = gst_version_string ();
+
+  json = g_string_new ("{\n");
+  g_string_append_printf (json, "  \"date\": \"%s\",\n", date);
+  g_string_append_printf (json, "  \"gstreamer\": \"%s\",\n", version);
+  g_string_append_printf (json, "  \"iterations\": %d,\n", iterations);
+  g_string_append_printf (json, "  \"source_duration\": %d,\n", duration);
+  g_string_append_printf (json, "  \"benchmarks\": [\n%s\n  ]\n}\n",
+      results->str);
+
+  if (output != NULL) {
+    g_file_set_contents (output, json->str, json->len, NULL);
+  } else {
+    g_print ("%s", json->str);
+  }
+
+  g_string_free (json, TRUE);
+  g_free (version);
+  g_free (date);
+  g_date_time_unref (now);
+}
+
+static gdouble
+bench_elapsed_ms (gint64 start)
+{
+  return (g_get_monotonic_time () - start) / 1000.0;
+}
+
+/* Sources */
+
+static gboolean
+bench_run_pipeline (GstElement * pipeline, GError ** err)
+{
+  GstBus *bus;
+  GstMessage *msg;
+  gboolean ret;
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, BENCH_TIMEOUT * GST_SECOND,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  if (msg == NULL) {
+    g_set_error (err, BENCH_ERROR, 0, "Timed out after %d seconds",
+        BENCH_TIMEOUT);
+    ret = FALSE;
+  } else {
+    ret = GST_MESSAGE_TYPE (msg) == GST_MESSAGE_EOS;
+    if (!ret) {
+      gst_message_parse_error (msg, err, NULL);
+    }
+    gst_message_unref (msg);
+  }
+  gst_object_unref (bus);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  return ret;
+}
+
+static gboolean
+bench_generate_source (const BenchFormat * format, const gchar * path,
+    GError ** err)
+{
+  GstElement *pipeline, *vsrc, *vfilter, *venc, *asrc, *aconv, *aenc;
+  GstElement *muxer, *sink;
+  GstCaps *caps;
+  gboolean ret;
+
+  venc = lgm_create_video_encoder (format->video_encoder, BENCH_VIDEO_QUALITY,
+      FALSE, BENCH_ERROR, err);
+  if (venc == NULL) {
+    return FALSE;
+  }
+  aenc = lgm_create_audio_encoder (format->audio_encoder, BENCH_AUDIO_QUALITY,
+      BENCH_ERROR, err);
+  if (aenc == NULL) {
+    gst_object_unref (venc);
+    return FALSE;
+  }
+  muxer = lgm_create_muxer (format->muxer, BENCH_ERROR, err);
+  if (muxer == NULL) {
+    gst_object_unref (venc);
+    gst_object_unref (aenc);
+    return FALSE;
+  }
+
+  pipeline = gst_pipeline_new ("generator");
+  vsrc = gst_element_factory_make ("videotestsrc", NULL);
+  vfilter = gst_element_factory_make ("capsfilter", NULL);
+  asrc = gst_element_factory_make ("audiotestsrc", NULL);
+  aconv = gst_element_factory_make ("audioconvert", NULL);
+  sink = gst_element_factory_make ("filesink", NULL);
+
+  /* A moving pattern, so that the encoders don't get only static frames */
+  g_object_set (vsrc, "num-buffers", duration * BENCH_FPS, "pattern", 18,
+      NULL);
+  caps = gst_caps_new_simple ("video/x-raw-yuv",
+      "format", GST_TYPE_FOURCC, GST_MAKE_FOURCC ('I', '4', '2', '0'),
+      "width", G_TYPE_INT, BENCH_WIDTH, "height", G_TYPE_INT, BENCH_HEIGHT,
+      "framerate", GST_TYPE_FRACTION, BENCH_FPS, 1, NULL);
+  g_object_set (vfilter, "caps", caps, NULL);
+  gst_caps_unref (caps);
+  g_object_set (asrc, "num-buffers", duration * 44100 / 1024,
+      "samplesperbuffer", 1024, "wave", 8, NULL);
+  g_object_set (sink, "location", path, NULL);
+
+  gst_bin_add_many (GST_BIN (pipeline), vsrc, vfilter, venc, asrc, aconv,
+      aenc, muxer, sink, NULL);
+  gst_element_link_many (vsrc, vfilter, venc, muxer, NULL);
+  gst_element_link_many (asrc, aconv, aenc, muxer, NULL);
+  gst_element_link (muxer, sink);
+
+  ret = bench_run_pipeline (pipeline, err);
+  gst_object_unref (pipeline);
+  return ret;
+}
+
+static gboolean
+bench_generate_picture (const gchar * path, GError ** err)
+{
+  GstElement *pipeline;
+  gchar *desc;
+  gboolean ret;
+
+  desc = g_strdup_printf ("videotestsrc num-buffers=1 ! "
+      "video/x-raw-rgb,width=%d,height=%d ! ffmpegcolorspace ! pngenc ! "
+      "filesink location=\"%s\"", BENCH_WIDTH, BENCH_HEIGHT, path);
+  pipeline = gst_parse_launch (desc, err);
+  g_free (desc);
+  if (pipeline == NULL) {
+    return FALSE;
+  }
+  ret = bench_run_pipeline (pipeline, err);
+  gst_object_unref (pipeline);
+  return ret;
+}
+
+static guint64
+bench_segment_start (guint index)
+{
+  guint n_starts;
+
+  /* Spread the segments over the whole source */
+  n_starts = MAX (1, duration * 1000 / BENCH_SEGMENT_DURATION - 1);
+  return (index * 7 % n_starts) * BENCH_SEGMENT_DURATION;
+}
+
+/* Editor */
+
+static gboolean
+bench_percent_cb (GObject * object, gfloat percent, gpointer data)
+{
+  if (percent == 1) {
+    run_ok = TRUE;
+    g_main_loop_quit (loop);
+  }
+  return TRUE;
+}
+
+static gboolean
+bench_error_cb (GObject * object, gchar * error, gpointer data)
+{
+  g_printerr ("ERROR: %s\n", error);
+  run_ok = FALSE;
+  g_main_loop_quit (loop);
+  return TRUE;
+}
+
+static gboolean
+bench_timeout_cb (gpointer data)
+{
+  g_printerr ("ERROR: Timed out after %d seconds\n", BENCH_TIMEOUT);
+  *(guint *) data = 0;
+  run_ok = FALSE;
+  g_main_loop_quit (loop);
+  return FALSE;
+}
+
+/* Runs the main loop until the run finishes or times out */
+static void
+bench_run_loop (void)
+{
+  guint timeout_id;
+
+  timeout_id = g_timeout_add_seconds (BENCH_TIMEOUT, bench_timeout_cb,
+      &timeout_id);
+  g_main_loop_run (loop);
+  if (timeout_id != 0)
+    g_source_remove (timeout_id);
+}
+
+static gdouble
+bench_run_editor (const gchar * source, const gchar * picture,
+    guint n_segments)
+{
+  GstVideoEditor *editor;
+  gchar *out_path;
+  gint64 start;
+  guint i;
+
+  out_path = g_build_filename (work_dir, "editor-output.mp4", NULL);
+  editor = gst_video_editor_new (NULL);
+  gst_video_editor_set_encoding_format (editor, out_path, VIDEO_ENCODER_H264,
+      AUDIO_ENCODER_AAC, VIDEO_MUXER_MP4, BENCH_VIDEO_QUALITY,
+      BENCH_AUDIO_QUALITY, BENCH_WIDTH, BENCH_HEIGHT, BENCH_FPS, 1, TRUE,
+      FALSE);
+
+  for (i = 0; i < n_segments; i++) {
+    if (picture != NULL) {
+      gst_video_editor_add_image_segment (editor, (gchar *) picture, 0,
+          BENCH_SEGMENT_DURATION, NULL, 0, 0, 0, 0);
+    } else {
+      gst_video_editor_add_segment (editor, (gchar *) source,
+          bench_segment_start (i), BENCH_SEGMENT_DURATION, 1, NULL, TRUE,
+          0, 0, 0, 0);
+    }
+  }
+
+  g_signal_connect (editor, "error", G_CALLBACK (bench_error_cb), NULL);
+  g_signal_connect (editor, "percent_completed",
+      G_CALLBACK (bench_percent_cb), NULL);
+
+  run_ok = FALSE;
+  start = g_get_monotonic_time ();
+  gst_video_editor_start (editor);
+  bench_run_loop ();
+
+  g_object_unref (editor);
+  g_unlink (out_path);
+  g_free (out_path);
+  return run_ok ? bench_elapsed_ms (start) : -1;
+}
+
+static void
+bench_editor (const BenchFormat * format, const gchar * source,
+    const gchar * picture)
+{
+  GArray *samples;
+  gchar *params;
+  gdouble ms;
+  guint i;
+  gint j;
+
+  for (i = 0; i < G_N_ELEMENTS (bench_n_segments); i++) {
+    samples = g_array_new (FALSE, FALSE, sizeof (gdouble));
+    for (j = 0; j < iterations; j++) {
+      ms = bench_run_editor (source, NULL, bench_n_segments[i]);
+      if (ms >= 0)
+        g_array_append_val (samples, ms);
+    }
+    params = g_strdup_printf ("\"segments\": %u", bench_n_segments[i]);
+    bench_report ("editor-export", format->name, params, samples, "ms");
+    g_free (params);
+    g_array_free (samples, TRUE);
+  }
+
+  /* Still pictures don't depend on the source format */
+  if (picture == NULL) {
+    return;
+  }
+  samples = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  for (j = 0; j < iterations; j++) {
+    ms = bench_run_editor (NULL, picture, 10);
+    if (ms >= 0)
+      g_array_append_val (samples, ms);
+  }
+  bench_report ("editor-still", "png", "\"segments\": 10", samples, "ms");
+  g_array_free (samples, TRUE);
+}
+
+/* Segment switch */
+
+static void
+bench_nle_pad_added_cb (GstElement * nlesrc, GstPad * pad, GstElement * bin)
+{
+  GstElement *sink;
+  GstPad *sinkpad;
+
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (sink, "sync", FALSE, NULL);
+  gst_bin_add (GST_BIN (bin), sink);
+  sinkpad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_link (pad, sinkpad);
+  gst_object_unref (sinkpad);
+  gst_element_sync_state_with_parent (sink);
+}
+
+static void
+bench_segment_switch (const BenchFormat * format, const gchar * source)
+{
+  GstElement *pipeline;
+  GstNleSource *nlesrc;
+  GstNleRectangle roi = { 0, 0, 0, 0 };
+  GstBus *bus;
+  GstMessage *msg;
+  GArray *samples;
+  gboolean done = FALSE;
+  guint64 start, latency;
+  gdouble ms;
+  guint i;
+
+  pipeline = gst_pipeline_new ("switch");
+  nlesrc = gst_nle_source_new ();
+  gst_nle_source_configure (nlesrc, BENCH_WIDTH, BENCH_HEIGHT, BENCH_FPS, 1,
+      FALSE, TRUE);
+  for (i = 0; i < 20; i++) {
+    start = bench_segment_start (i) * GST_MSECOND;
+    gst_nle_source_add_item (nlesrc, source, NULL, start,
+        start + BENCH_SEGMENT_DURATION * GST_MSECOND, 1, FALSE, roi);
+  }
+  g_signal_connect (nlesrc, "pad-added", G_CALLBACK (bench_nle_pad_added_cb),
+      pipeline);
+  gst_bin_add (GST_BIN (pipeline), GST_ELEMENT (nlesrc));
+
+  samples = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  bus = gst_element_get_bus (pipeline);
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  while (!done) {
+    msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+        GST_MESSAGE_ELEMENT | GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+    if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ELEMENT) {
+      const GstStructure *s = gst_message_get_structure (msg);
+
+      if (gst_structure_has_name (s, "nle-segment-switch") &&
+          gst_structure_get_uint64 (s, "latency", &latency)) {
+        ms = latency / (gdouble) GST_MSECOND;
+        g_array_append_val (samples, ms);
+      }
+    } else {
+      done = TRUE;
+    }
+    gst_message_unref (msg);
+  }
+  gst_object_unref (bus);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  bench_report ("segment-switch", format->name, "\"segments\": 20", samples,
+      "ms");
+  g_array_free (samples, TRUE);
+}
+
+/* Remuxer */
+
+static void
+bench_remux (const BenchFormat * format, const gchar * source)
+{
+  GstRemuxer *remuxer;
+  GArray *samples;
+  GStatBuf st;
+  gchar *out_path;
+  gdouble mbps;
+  gint64 start;
+  gint j;
+
+  if (g_stat (source, &st) != 0) {
+    return;
+  }
+
+  out_path = g_build_filename (work_dir, "remux-output.mkv", NULL);
+  samples = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  for (j = 0; j < iterations; j++) {
+    remuxer = gst_remuxer_new ((gchar *) source, out_path,
+        VIDEO_MUXER_MATROSKA, NULL);
+    if (remuxer == NULL)
+      break;
+    g_signal_connect (remuxer, "error", G_CALLBACK (bench_error_cb), NULL);
+    g_signal_connect (remuxer, "percent_completed",
+        G_CALLBACK (bench_percent_cb), NULL);
+
+    run_ok = FALSE;
+    start = g_get_monotonic_time ();
+    gst_remuxer_start (remuxer);
+    bench_run_loop ();
+    if (run_ok) {
+      mbps = st.st_size / (1024.0 * 1024.0) / (bench_elapsed_ms (start) /
+          1000.0);
+      g_array_append_val (samples, mbps);
+    }
+    g_object_unref (remuxer);
+    g_unlink (out_path);
+  }
+  g_free (out_path);
+
+  bench_report ("remux", format->name, NULL, samples, "MB/s");
+  g_array_free (samples, TRUE);
+}
+
+/* Discoverer */
+
+static void
+bench_discoverer (const BenchFormat * format, const gchar * source)
+{
+  GArray *samples;
+  GError *err = NULL;
+  guint64 dur;
+  guint width, height, fps_n, fps_d, par_n, par_d;
+  gchar *container, *video_codec, *audio_codec;
+  gint64 start;
+  gdouble ms;
+  gint j;
+
+  samples = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  for (j = 0; j < iterations; j++) {
+    container = video_codec = audio_codec = NULL;
+    start = g_get_monotonic_time ();
+    if (lgm_discover_uri (source, &dur, &width, &height, &fps_n, &fps_d,
+            &par_n, &par_d, &container, &video_codec, &audio_codec,
+            &err) == GST_DISCOVERER_OK) {
+      ms = bench_elapsed_ms (start);
+      g_array_append_val (samples, ms);
+    }
+    g_clear_error (&err);
+    g_free (container);
+    g_free (video_codec);
+    g_free (audio_codec);
+  }
+
+  bench_report ("discoverer", format->name, NULL, samples, "ms");
+  g_array_free (samples, TRUE);
+}
+
+/* Frame grab */
+
+static gboolean
+bench_frame_cb (GdkPixbuf * frame, gint64 time, gpointer data)
+{
+  if (frame != NULL) {
+    lgm_video_player_unref_pixbuf (frame);
+  }
+  return TRUE;
+}
+
+static void
+bench_frame_grab (const BenchFormat * format, const gchar * source)
+{
+  LgmVideoPlayer *player;
+  GdkPixbuf *pixbuf;
+  GArray *samples;
+  GError *err = NULL;
+  gint64 start, time, *times;
+  gdouble ms;
+  gint j, n_times;
+
+  player = lgm_video_player_new (LGM_USE_TYPE_CAPTURE, &err);
+  if (player == NULL || !lgm_video_player_open (player, source, &err)) {
+    g_printerr ("ERROR: %s\n", err ? err->message : "could not open player");
+    g_clear_error (&err);
+    if (player != NULL)
+      g_object_unref (player);
+    return;
+  }
+  lgm_video_player_pause (player, TRUE);
+
+  /* Random accurate seeks followed by a screenshot */
+  samples = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  for (j = 0; j < iterations * 10; j++) {
+    time = (j * 7919 % (duration * 1000)) * GST_MSECOND;
+    start = g_get_monotonic_time ();
+    lgm_video_player_seek_time (player, time, TRUE, TRUE);
+    pixbuf = lgm_video_player_get_current_frame (player);
+    if (pixbuf != NULL) {
+      ms = bench_elapsed_ms (start);
+      g_array_append_val (samples, ms);
+      lgm_video_player_unref_pixbuf (pixbuf);
+    }
+  }
+  bench_report ("frame-grab", format->name, NULL, samples, "ms");
+  g_array_free (samples, TRUE);
+
+  /* One frame per second in a single pass, reported per frame */
+  n_times = duration;
+  times = g_new (gint64, n_times);
+  for (j = 0; j < n_times; j++) {
+    times[j] = j * GST_SECOND;
+  }
+  samples = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  for (j = 0; j < iterations; j++) {
+    start = g_get_monotonic_time ();
+    if (lgm_video_player_get_frames (player, times, n_times, bench_frame_cb,
+            NULL)) {
+      ms = bench_elapsed_ms (start) / n_times;
+      g_array_append_val (samples, ms);
+    }
+  }
+  bench_report ("frame-series", format->name, "\"interval\": 1000", samples,
+      "ms");
+  g_array_free (samples, TRUE);
+  g_free (times);
+
+  lgm_video_player_close (player);
+  g_object_unref (player);
+}
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *context;
+  GError *err = NULL;
+  gchar *source, *picture, *name;
+  guint i;
+
+  context = g_option_context_new ("- benchmark libvas");
+  g_option_context_add_main_entries (context, entries, NULL);
+  g_option_context_add_group (context, gst_init_get_option_group ());
+  if (!g_option_context_parse (context, &argc, &argv, &err)) {
+    g_printerr ("ERROR: %s\n", err->message);
+    return 1;
+  }
+  g_option_context_free (context);
+
+  gst_video_editor_init_backend (&argc, &argv);
+  lgm_init_debug ();
+
+  iterations = MAX (iterations, 1);
+  duration = MAX (duration, 2 * BENCH_SEGMENT_DURATION / 1000);
+  work_dir = g_dir_make_tmp ("bench-libvas-XXXXXX", &err);
+  if (work_dir == NULL) {
+    g_printerr ("ERROR: %s\n", err->message);
+    return 1;
+  }
+
+  loop = g_main_loop_new (NULL, FALSE);
+  results = g_string_new (NULL);
+
+  picture = g_build_filename (work_dir, "picture.png", NULL);
+  if (!bench_generate_picture (picture, &err)) {
+    g_printerr ("ERROR: could not generate picture: %s\n", err->message);
+    g_clear_error (&err);
+    g_free (picture);
+    picture = NULL;
+  }
+
+  for (i = 0; i < G_N_ELEMENTS (bench_formats); i++) {
+    const BenchFormat *format = &bench_formats[i];
+
+    name = g_strdup_printf ("source-%s.%s", format->name, format->extension);
+    source = g_build_filename (work_dir, name, NULL);
+    g_free (name);
+
+    if (!bench_generate_source (format, source, &err)) {
+      g_printerr ("Skipping %s: %s\n", format->name,
+          err ? err->message : "could not generate source");
+      g_clear_error (&err);
+      g_free (source);
+      continue;
+    }
+
+    bench_discoverer (format, source);
+    bench_frame_grab (format, source);
+    bench_remux (format, source);
+    bench_segment_switch (format, source);
+    /* The still picture segments are only measured once */
+    bench_editor (format, source, i == 0 ? picture : NULL);
+
+    g_unlink (source);
+    g_free (source);
+  }
+
+  bench_write_results ();
+
+  if (picture != NULL) {
+    g_unlink (picture);
+    g_free (picture);
+  }
+  g_rmdir (work_dir);
+  g_free (work_dir);
+  g_string_free (results, TRUE);
+  g_main_loop_unref (loop);
+  return 0;
+}
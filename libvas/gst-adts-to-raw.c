@@ -0,0 +1,354 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+* Gstreamer ADTS to raw AAC converter
+* Copyright (C) Fluendo S.A. 2018
+*
+* You may redistribute it and/or modify it under the terms of the
+* GNU General Public License, as published by the Free Software
+* Foundation; either version 2 of the License, or (at your option)
+* any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, write to:
+*       The Free Software Foundation, Inc.,
+*       51 Franklin Street, Fifth Floor
+*       Boston, MA  02110-1301, USA.
+*/
+
+#include "gst-adts-to-raw.h"
+
+GST_DEBUG_CATEGORY_STATIC (_adts_to_raw_gst_debug_cat);
+#define GST_CAT_DEFAULT _adts_to_raw_gst_debug_cat
+
+#define ADTS_HEADER_SIZE 7
+#define ADTS_CRC_SIZE 2
+#define AAC_SAMPLES_PER_FRAME 1024
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("audio/mpeg, mpegversion = (int) { 2, 4 }"));
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("audio/mpeg, mpegversion = (int) { 2, 4 }, "
+        "stream-format = (string) raw, framed = (boolean) true"));
+
+static const gint sample_rates[] = { 96000, 88200, 64000, 48000, 44100,
+  32000, 24000, 22050, 16000, 12000, 11025, 8000, 7350
+};
+
+G_DEFINE_TYPE (GstAdtsToRaw, gst_adts_to_raw, GST_TYPE_ELEMENT);
+
+static void
+gst_adts_to_raw_reset (GstAdtsToRaw * conv)
+{
+  gst_adapter_clear (conv->adapter);
+  conv->next_ts = GST_CLOCK_TIME_NONE;
+  conv->discont = TRUE;
+}
+
+static gboolean
+gst_adts_to_raw_setcaps (GstPad * pad, GstCaps * caps)
+{
+  GstAdtsToRaw *conv = GST_ADTS_TO_RAW (gst_pad_get_parent (pad));
+  GstStructure *s;
+  const gchar *format;
+  gboolean ret = TRUE;
+
+  s = gst_caps_get_structure (caps, 0);
+  format = gst_structure_get_string (s, "stream-format");
+  conv->passthrough = gst_structure_has_field (s, "codec_data") ||
+      g_strcmp0 (format, "raw") == 0;
+  GST_INFO_OBJECT (conv, "Input stream format is %s, %s",
+      GST_STR_NULL (format), conv->passthrough ? "passthrough" : "converting");
+
+  if (conv->passthrough)
+    ret = gst_pad_set_caps (conv->srcpad, caps);
+  /* Otherwise the caps are set with the first ADTS header */
+
+  gst_object_unref (conv);
+  return ret;
+}
+
+static gboolean
+gst_adts_to_raw_sink_event (GstPad * pad, GstEvent * event)
+{
+  GstAdtsToRaw *conv = GST_ADTS_TO_RAW (gst_pad_get_parent (pad));
+  gboolean ret;
+
+  if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP ||
+      GST_EVENT_TYPE (event) == GST_EVENT_NEWSEGMENT) {
+    gst_adts_to_raw_reset (conv);
+  }
+  ret = gst_pad_event_default (pad, event);
+
+  gst_object_unref (conv);
+  return ret;
+}
+
+/* Gets the AudioSpecificConfig of an ADTS header: 5 bits object type,
+ * 4 bits sampling frequency index, 4 bits channel configuration and 3 bits
+ * set to 0 */
+static guint16
+gst_adts_to_raw_config (const guint8 * header)
+{
+  guint profile, rate_index, channels;
+
+  profile = header[2] >> 6;
+  rate_index = (header[2] >> 2) & 0x0f;
+  channels = ((header[2] & 0x01) << 2) | (header[3] >> 6);
+  return ((profile + 1) << 11) | (rate_index << 7) | (channels << 3);
+}
+
+/* Sets the raw caps for the configuration of the ADTS header */
+static gboolean
+gst_adts_to_raw_update_caps (GstAdtsToRaw * conv, const guint8 * header)
+{
+  GstCaps *caps;
+  GstBuffer *codec_data;
+  guint rate_index, channels;
+  guint16 config;
+  gboolean ret;
+
+  rate_index = (header[2] >> 2) & 0x0f;
+  channels = ((header[2] & 0x01) << 2) | (header[3] >> 6);
+
+  if (rate_index >= G_N_ELEMENTS (sample_rates)) {
+    GST_WARNING_OBJECT (conv, "Invalid sample rate index %u", rate_index);
+    return FALSE;
+  }
+
+  config = gst_adts_to_raw_config (header);
+  if (config == conv->config && GST_PAD_CAPS (conv->srcpad) != NULL)
+    return TRUE;
+
+  codec_data = gst_buffer_new_and_alloc (2);
+  GST_WRITE_UINT16_BE (GST_BUFFER_DATA (codec_data), config);
+  conv->config = config;
+  conv->rate = sample_rates[rate_index];
+
+  caps = gst_caps_new_simple ("audio/mpeg",
+      "mpegversion", G_TYPE_INT, 4,
+      "stream-format", G_TYPE_STRING, "raw",
+      "framed", G_TYPE_BOOLEAN, TRUE,
+      "rate", G_TYPE_INT, conv->rate,
+      "channels", G_TYPE_INT, channels,
+      "codec_data", GST_TYPE_BUFFER, codec_data, NULL);
+  GST_INFO_OBJECT (conv, "Setting caps %" GST_PTR_FORMAT, caps);
+  ret = gst_pad_set_caps (conv->srcpad, caps);
+  gst_caps_unref (caps);
+  gst_buffer_unref (codec_data);
+  return ret;
+}
+
+/* Pushes one raw data block of an ADTS frame as a raw AAC sample */
+static GstFlowReturn
+gst_adts_to_raw_push_block (GstAdtsToRaw * conv, GstBuffer * frame,
+    guint offset, guint size, GstClockTime ts)
+{
+  GstBuffer *block;
+
+  block = gst_buffer_create_sub (frame, offset, size);
+  GST_BUFFER_TIMESTAMP (block) = ts;
+  GST_BUFFER_DURATION (block) =
+      gst_util_uint64_scale_int (AAC_SAMPLES_PER_FRAME, GST_SECOND,
+      conv->rate);
+  if (ts != GST_CLOCK_TIME_NONE)
+    conv->next_ts = ts + GST_BUFFER_DURATION (block);
+  if (conv->discont) {
+    GST_BUFFER_FLAG_SET (block, GST_BUFFER_FLAG_DISCONT);
+    conv->discont = FALSE;
+  }
+  gst_buffer_set_caps (block, GST_PAD_CAPS (conv->srcpad));
+
+  return gst_pad_push (conv->srcpad, block);
+}
+
+/* Splits an ADTS frame with several raw data blocks in one sample per
+ * block. With CRC the header has the offsets of the blocks, relative to the
+ * first one, and each block is followed by its own CRC. Without CRC the
+ * blocks can only be found decoding them, so the stream must be encoded
+ * again */
+static GstFlowReturn
+gst_adts_to_raw_push_blocks (GstAdtsToRaw * conv, GstBuffer * frame,
+    guint n_blocks, GstClockTime ts)
+{
+  const guint8 *data = GST_BUFFER_DATA (frame);
+  guint size = GST_BUFFER_SIZE (frame);
+  guint header_size, start, end, i;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  if (data[1] & 0x01) {
+    GST_ELEMENT_ERROR (conv, STREAM, FORMAT, (NULL),
+        ("ADTS frame with %u raw data blocks and without CRC, the blocks "
+            "can't be split", n_blocks));
+    return GST_FLOW_ERROR;
+  }
+
+  /* Fixed header, the position of the blocks 1 to n - 1 and the CRC */
+  header_size = ADTS_HEADER_SIZE + 2 * (n_blocks - 1) + ADTS_CRC_SIZE;
+  if (size < header_size) {
+    GST_WARNING_OBJECT (conv, "Truncated ADTS frame, skipping it");
+    conv->discont = TRUE;
+    return GST_FLOW_OK;
+  }
+
+  start = header_size;
+  for (i = 0; i < n_blocks && ret == GST_FLOW_OK; i++) {
+    if (i < n_blocks - 1)
+      end = header_size + GST_READ_UINT16_BE (data + ADTS_HEADER_SIZE + 2 * i);
+    else
+      end = size;
+    /* Each block is followed by its CRC */
+    if (end > size || end < start + ADTS_CRC_SIZE + 1) {
+      GST_WARNING_OBJECT (conv, "Invalid position of the raw data block %u, "
+          "skipping the frame", i);
+      conv->discont = TRUE;
+      return GST_FLOW_OK;
+    }
+    ret = gst_adts_to_raw_push_block (conv, frame, start,
+        end - ADTS_CRC_SIZE - start, ts);
+    if (ts != GST_CLOCK_TIME_NONE)
+      ts = conv->next_ts;
+    start = end;
+  }
+  return ret;
+}
+
+static GstFlowReturn
+gst_adts_to_raw_chain (GstPad * pad, GstBuffer * buf)
+{
+  GstAdtsToRaw *conv = GST_ADTS_TO_RAW (GST_PAD_PARENT (pad));
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  if (conv->passthrough)
+    return gst_pad_push (conv->srcpad, buf);
+
+  if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DISCONT))
+    gst_adts_to_raw_reset (conv);
+  gst_adapter_push (conv->adapter, buf);
+
+  while (ret == GST_FLOW_OK &&
+      gst_adapter_available (conv->adapter) >= ADTS_HEADER_SIZE) {
+    const guint8 *header;
+    GstBuffer *frame;
+    GstClockTime ts;
+    guint64 distance;
+    guint header_size, frame_size, n_blocks;
+
+    header = gst_adapter_peek (conv->adapter, ADTS_HEADER_SIZE);
+
+    /* Look for the sync word */
+    if (header[0] != 0xff || (header[1] & 0xf6) != 0xf0) {
+      gst_adapter_flush (conv->adapter, 1);
+      conv->discont = TRUE;
+      continue;
+    }
+
+    header_size = ADTS_HEADER_SIZE;
+    if (!(header[1] & 0x01))
+      header_size += ADTS_CRC_SIZE;
+    frame_size = ((header[3] & 0x03) << 11) | (header[4] << 3) |
+        (header[5] >> 5);
+    n_blocks = (header[6] & 0x03) + 1;
+
+    if (frame_size <= header_size) {
+      gst_adapter_flush (conv->adapter, 1);
+      conv->discont = TRUE;
+      continue;
+    }
+    if (gst_adapter_available (conv->adapter) < frame_size)
+      break;
+
+    if (GST_PAD_CAPS (conv->srcpad) != NULL &&
+        gst_adts_to_raw_config (header) != conv->config) {
+      /* The muxers can't change the codec_data of a stream */
+      GST_ELEMENT_ERROR (conv, STREAM, FORMAT, (NULL),
+          ("The AAC configuration changed from 0x%04x to 0x%04x",
+              conv->config, gst_adts_to_raw_config (header)));
+      return GST_FLOW_NOT_NEGOTIATED;
+    }
+    if (!gst_adts_to_raw_update_caps (conv, header)) {
+      gst_adapter_flush (conv->adapter, 1);
+      conv->discont = TRUE;
+      continue;
+    }
+
+    /* Use the upstream timestamp if the frame starts a buffer, otherwise
+     * interpolate it from the previous frame */
+    ts = gst_adapter_prev_timestamp (conv->adapter, &distance);
+    if (ts == GST_CLOCK_TIME_NONE || distance != 0)
+      ts = conv->next_ts;
+
+    frame = gst_adapter_take_buffer (conv->adapter, frame_size);
+    if (G_LIKELY (n_blocks == 1)) {
+      ret = gst_adts_to_raw_push_block (conv, frame, header_size,
+          frame_size - header_size, ts);
+    } else {
+      ret = gst_adts_to_raw_push_blocks (conv, frame, n_blocks, ts);
+    }
+    gst_buffer_unref (frame);
+  }
+
+  return ret;
+}
+
+static void
+gst_adts_to_raw_finalize (GObject * object)
+{
+  GstAdtsToRaw *conv = GST_ADTS_TO_RAW (object);
+
+  g_object_unref (conv->adapter);
+
+  G_OBJECT_CLASS (gst_adts_to_raw_parent_class)->finalize (object);
+}
+
+static void
+gst_adts_to_raw_class_init (GstAdtsToRawClass * klass)
+{
+  GObjectClass *object_class = (GObjectClass *) klass;
+  GstElementClass *element_class = (GstElementClass *) klass;
+
+  object_class->finalize = gst_adts_to_raw_finalize;
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&sink_template));
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&src_template));
+
+  GST_DEBUG_CATEGORY_INIT (_adts_to_raw_gst_debug_cat, "longomatch", 0,
+      "LongoMatch GStreamer Backend");
+}
+
+static void
+gst_adts_to_raw_init (GstAdtsToRaw * conv)
+{
+  conv->sinkpad = gst_pad_new_from_static_template (&sink_template, "sink");
+  gst_pad_set_setcaps_function (conv->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_adts_to_raw_setcaps));
+  gst_pad_set_event_function (conv->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_adts_to_raw_sink_event));
+  gst_pad_set_chain_function (conv->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_adts_to_raw_chain));
+  gst_element_add_pad (GST_ELEMENT (conv), conv->sinkpad);
+
+  conv->srcpad = gst_pad_new_from_static_template (&src_template, "src");
+  gst_pad_use_fixed_caps (conv->srcpad);
+  gst_element_add_pad (GST_ELEMENT (conv), conv->srcpad);
+
+  conv->adapter = gst_adapter_new ();
+  gst_adts_to_raw_reset (conv);
+}
+
+GstElement *
+gst_adts_to_raw_new (void)
+{
+  return g_object_new (GST_TYPE_ADTS_TO_RAW, NULL);
+}
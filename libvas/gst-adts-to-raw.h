@@ -0,0 +1,67 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * Gstreamer ADTS to raw AAC converter
+ * Copyright (C) Fluendo S.A. 2018
+ *
+ * You may redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, write to:
+ *     The Free Software Foundation, Inc.,
+ *     51 Franklin Street, Fifth Floor
+ *     Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _GST_ADTS_TO_RAW_H_
+#define _GST_ADTS_TO_RAW_H_
+
+#include <gst/gst.h>
+#include <gst/base/gstadapter.h>
+
+G_BEGIN_DECLS
+#define GST_TYPE_ADTS_TO_RAW             (gst_adts_to_raw_get_type ())
+#define GST_ADTS_TO_RAW(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_ADTS_TO_RAW, GstAdtsToRaw))
+#define GST_ADTS_TO_RAW_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST ((klass), GST_TYPE_ADTS_TO_RAW, GstAdtsToRawClass))
+#define GST_IS_ADTS_TO_RAW(obj)          (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_ADTS_TO_RAW))
+#define GST_IS_ADTS_TO_RAW_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), GST_TYPE_ADTS_TO_RAW))
+typedef struct _GstAdtsToRawClass GstAdtsToRawClass;
+typedef struct _GstAdtsToRaw GstAdtsToRaw;
+
+struct _GstAdtsToRawClass
+{
+  GstElementClass parent_class;
+};
+
+/* Strips the ADTS headers of an AAC stream and sets the codec_data in the
+ * caps instead, as required by the mp4 and matroska muxers, without
+ * decoding it. Streams that are already raw are passed through. */
+struct _GstAdtsToRaw
+{
+  GstElement parent;
+
+  GstPad *sinkpad;
+  GstPad *srcpad;
+  GstAdapter *adapter;
+  gboolean passthrough;
+  gboolean discont;
+
+  /* AudioSpecificConfig of the current caps */
+  guint16 config;
+  gint rate;
+  GstClockTime next_ts;
+};
+
+GType gst_adts_to_raw_get_type (void) G_GNUC_CONST;
+
+GstElement *gst_adts_to_raw_new (void);
+
+G_END_DECLS
+#endif /* _GST_ADTS_TO_RAW_H_ */
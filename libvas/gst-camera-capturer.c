@@ -40,6 +40,53 @@
 GST_DEBUG_CATEGORY (_cesarplayer_gst_debug_cat);
 #define GST_CAT_DEFAULT _cesarplayer_gst_debug_cat
 
+/* Frames queued between the preview and the encoding branches */
+#define VIDEO_RING_SIZE 16
+#define AUDIO_RING_SIZE 64
+/* Frames waiting to be encoded tracked for the encoder latency */
+#define MAX_PENDING_FRAMES 256
+#define VIDEO_APPSRC_MAX_BYTES ((guint64) 20 * 1024 * 1024)
+#define AUDIO_QUEUE_MAX_TIME (1 * GST_SECOND)
+/* Adaptive quality: load is checked every ADAPTATION_INTERVAL ms, and the
+ * quality is lowered after ADAPTATION_DOWN_CHECKS checks under pressure and
+ * raised after ADAPTATION_UP_CHECKS checks with a low load */
+#define ADAPTATION_INTERVAL 1000
+#define ADAPTATION_DOWN_CHECKS 2
+#define ADAPTATION_UP_CHECKS 10
+#define ADAPTATION_HIGH_LOAD 0.5
+#define ADAPTATION_LOW_LOAD 0.1
+/* Frames waiting for the encoder for this time are a full load */
+#define ADAPTATION_MAX_BACKLOG (1 * GST_SECOND)
+/* Maximum time to wait for the frames before a scheduled stop */
+#define RECORDING_STOP_TIMEOUT 500
+
+/* Encoder speed and resolution for each adaptation level. Levels that
+ * don't change anything for the encoder in use are skipped */
+static const struct
+{
+  gint speed_step;
+  gint scale_n;
+  gint scale_d;
+} adaptation_levels[] = {
+  {0, 1, 1},
+  {1, 1, 1},
+  {2, 3, 4},
+  {3, 2, 3},
+  {4, 1, 2},
+};
+
+#define MAX_ADAPTATION_LEVEL (G_N_ELEMENTS (adaptation_levels) - 1)
+
+/* Encoder properties trading quality for speed, and their fastest value */
+static const struct
+{
+  const gchar *name;
+  gint fastest;
+} encoder_speed_properties[] = {
+  {"speed", 2},                 /* vp8enc */
+  {"speed-preset", 1},          /* x264enc, ultrafast */
+};
+
 /* Signals */
 enum
 {
@@ -49,6 +96,7 @@ enum
   SIGNAL_DEVICE_CHANGE,
   SIGNAL_MEDIA_INFO,
   SIGNAL_READY_TO_CAPTURE,
+  SIGNAL_STATS,
   LAST_SIGNAL
 };
 
@@ -83,6 +131,7 @@ struct GstCameraCapturerPrivate
 
   /* Snapshots */
   GstBuffer *last_buffer;
+  BvwFrameConv *frame_conv[2];
 
   /*GStreamer elements */
   GstElement *main_pipeline;
@@ -100,6 +149,43 @@ struct GstCameraCapturerPrivate
   GstElement *video_appsrc;
   GstElement *audio_appsrc;
 
+  /* Handoff between the preview and the encoding branches */
+  LgmFrameRing *video_ring;
+  LgmFrameRing *audio_ring;
+  GThread *video_feeder;
+  GThread *audio_feeder;
+  LgmFrameRingPolicy drop_policy;
+
+  /* Statistics */
+  GMutex stats_lock;
+  GQueue *pending_frames;       /* protect with stats_lock */
+  guint64 video_frames_in;
+  guint64 audio_buffers_in;
+  guint64 video_frames_encoded;
+  guint64 audio_buffers_encoded;
+  GstClockTime encoder_latency;
+  volatile gint video_appsrc_level;
+  guint stats_timeout_id;
+
+  /* Instant replay */
+  guint timeshift_duration;
+  LgmTimeshiftBuffer *timeshift;
+
+  /* Adaptive quality */
+  gboolean adaptive_quality;
+  GstElement *adaptation_filter;
+  guint64 last_encoder_input_ts;
+  GstElement *speed_element;
+  const gchar *speed_property;
+  gint speed_initial;
+  gint speed_fastest;
+  guint adaptation_id;
+  guint adaptation_level;
+  guint64 adaptations;
+  guint64 last_video_dropped;
+  guint high_load_checks;
+  guint low_load_checks;
+
   gboolean has_video;
   gboolean has_audio;
 
@@ -112,6 +198,9 @@ struct GstCameraCapturerPrivate
   GstClockTime accum_recorded_ts;
   GstClockTime last_accum_recorded_ts;
   GstClockTime current_recording_start_ts;
+  GstClockTime recording_stop_ts;
+  gboolean recording_stop_reached;
+  guint recording_stop_id;
   GstClockTime last_video_buf_ts;
   GstClockTime last_audio_buf_ts;
   GMutex recording_lock;
@@ -139,6 +228,10 @@ static void gcc_element_msg_sync (GstBus * bus, GstMessage * msg,
     gpointer data);
 static gboolean gcc_get_video_stream_info (GstPad * pad, GstPad * peer,
     GstCameraCapturer * gcc);
+static void gst_camera_capturer_stop_feeders (GstCameraCapturer * gcc,
+    gboolean flush);
+static void gst_camera_capturer_start_adaptation (GstCameraCapturer * gcc);
+static gboolean gst_camera_capturer_stop_reached (GstCameraCapturer * gcc);
 
 G_DEFINE_TYPE (GstCameraCapturer, gst_camera_capturer, G_TYPE_OBJECT);
 
@@ -162,13 +255,19 @@ gst_camera_capturer_init (GstCameraCapturer * object)
   priv->video_quality = 50;
   priv->last_buffer = NULL;
   priv->current_recording_start_ts = GST_CLOCK_TIME_NONE;
+  priv->recording_stop_ts = GST_CLOCK_TIME_NONE;
   priv->accum_recorded_ts = GST_CLOCK_TIME_NONE;
   priv->last_accum_recorded_ts = GST_CLOCK_TIME_NONE;
   priv->last_video_buf_ts = GST_CLOCK_TIME_NONE;
+  priv->last_encoder_input_ts = GST_CLOCK_TIME_NONE;
   priv->last_audio_buf_ts = GST_CLOCK_TIME_NONE;
   priv->is_recording = FALSE;
   priv->ready_to_capture = FALSE;
+  priv->drop_policy = LGM_FRAME_RING_POLICY_DROP_OLDEST;
+  priv->pending_frames = g_queue_new ();
+  priv->encoder_latency = GST_CLOCK_TIME_NONE;
   g_mutex_init (&priv->recording_lock);
+  g_mutex_init (&priv->stats_lock);
 
   priv->video_encoder_type = VIDEO_ENCODER_VP8;
   priv->audio_encoder_type = AUDIO_ENCODER_VORBIS;
@@ -183,6 +282,23 @@ gst_camera_capturer_finalize (GObject * object)
   GstCameraCapturer *gcc = (GstCameraCapturer *) object;
 
   GST_DEBUG_OBJECT (gcc, "Finalizing.");
+  if (gcc->priv->stats_timeout_id != 0) {
+    g_source_remove (gcc->priv->stats_timeout_id);
+    gcc->priv->stats_timeout_id = 0;
+  }
+  if (gcc->priv->recording_stop_id != 0) {
+    g_source_remove (gcc->priv->recording_stop_id);
+    gcc->priv->recording_stop_id = 0;
+  }
+  if (gcc->priv->adaptation_id != 0) {
+    g_source_remove (gcc->priv->adaptation_id);
+    gcc->priv->adaptation_id = 0;
+  }
+  if (gcc->priv->speed_element != NULL) {
+    gst_object_unref (gcc->priv->speed_element);
+    gcc->priv->speed_element = NULL;
+  }
+
   if (gcc->priv->bus) {
     /* make bus drop all messages to make sure none of our callbacks is ever
      * called again (main loop might be run again to display error dialog) */
@@ -218,6 +334,9 @@ gst_camera_capturer_finalize (GObject * object)
     gcc->priv->last_buffer = NULL;
   }
 
+  bvw_frame_conv_free (gcc->priv->frame_conv[LGM_FRAME_FORMAT_RGB24]);
+  bvw_frame_conv_free (gcc->priv->frame_conv[LGM_FRAME_FORMAT_I420]);
+
   if (gcc->priv->xoverlay != NULL) {
     gst_object_unref (gcc->priv->xoverlay);
     gcc->priv->xoverlay = NULL;
@@ -230,7 +349,19 @@ gst_camera_capturer_finalize (GObject * object)
     gcc->priv->main_pipeline = NULL;
   }
 
+  /* With the pipeline stopped the feeders can't be blocked in the appsrc */
+  gst_camera_capturer_stop_feeders (gcc, TRUE);
+
+  if (gcc->priv->timeshift != NULL) {
+    lgm_timeshift_buffer_unref (gcc->priv->timeshift);
+    gcc->priv->timeshift = NULL;
+  }
+
+  g_queue_foreach (gcc->priv->pending_frames, (GFunc) g_free, NULL);
+  g_queue_free (gcc->priv->pending_frames);
+
   g_mutex_clear (&gcc->priv->recording_lock);
+  g_mutex_clear (&gcc->priv->stats_lock);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -286,6 +417,14 @@ gst_camera_capturer_class_init (GstCameraCapturerClass * klass)
       NULL, NULL,
       baconvideowidget_marshal_VOID__INT_INT_INT_INT,
       G_TYPE_NONE, 4, G_TYPE_INT, G_TYPE_INT, G_TYPE_INT, G_TYPE_INT);
+
+  gcc_signals[SIGNAL_STATS] =
+      g_signal_new ("stats",
+      G_TYPE_FROM_CLASS (object_class),
+      G_SIGNAL_RUN_LAST,
+      G_STRUCT_OFFSET (GstCameraCapturerClass, stats),
+      NULL, NULL,
+      g_cclosure_marshal_VOID__POINTER, G_TYPE_NONE, 1, G_TYPE_POINTER);
 }
 
 /***********************************
@@ -384,6 +523,28 @@ gst_camera_capturer_create_converter_bin (GstCameraCapturer * gcc)
   return TRUE;
 }
 
+static gboolean
+gst_camera_capturer_timeshift_probe (GstPad * pad, GstBuffer * buf,
+    GstCameraCapturer * gcc)
+{
+  lgm_timeshift_buffer_push (gcc->priv->timeshift, gst_buffer_ref (buf));
+  return TRUE;
+}
+
+/* Keeps the last encoded GOPs in memory for instant replays */
+static void
+gst_camera_capturer_configure_timeshift (GstCameraCapturer * gcc,
+    GstPad * pad)
+{
+  if (gcc->priv->timeshift_duration == 0)
+    return;
+
+  gcc->priv->timeshift =
+      lgm_timeshift_buffer_new (gcc->priv->timeshift_duration * GST_SECOND);
+  gst_pad_add_buffer_probe (pad,
+      (GCallback) gst_camera_capturer_timeshift_probe, gcc);
+}
+
 static void
 gst_camera_capturer_create_encoder_bin (GstCameraCapturer * gcc)
 {
@@ -400,11 +561,46 @@ gst_camera_capturer_create_encoder_bin (GstCameraCapturer * gcc)
       colorspace, gcc->priv->video_enc,
       gcc->priv->muxer, gcc->priv->filesink, NULL);
 
-  gst_element_link_many (colorspace, gcc->priv->video_enc,
-      gcc->priv->muxer, gcc->priv->filesink, NULL);
+  if (gcc->priv->adaptive_quality && gcc->priv->output_width != 0
+      && gcc->priv->output_height != 0) {
+    GstElement *adapt_scale, *videoscale, *filter;
+    GstCaps *caps;
+
+    /* The resolution changes with the load in the encoding branch only, so
+     * the preview is not affected. It's scaled back to the output one, since
+     * muxers don't support resolution changes */
+    adapt_scale = gst_element_factory_make ("videoscale", NULL);
+    gcc->priv->adaptation_filter = gst_element_factory_make ("capsfilter",
+        NULL);
+    videoscale = gst_element_factory_make ("videoscale", NULL);
+    filter = gst_element_factory_make ("capsfilter", NULL);
+    caps = gst_caps_new_simple ("video/x-raw-yuv",
+        "width", G_TYPE_INT, gcc->priv->output_width,
+        "height", G_TYPE_INT, gcc->priv->output_height, NULL);
+    g_object_set (gcc->priv->adaptation_filter, "caps", caps, NULL);
+    g_object_set (filter, "caps", caps, NULL);
+    gst_caps_unref (caps);
+    gst_bin_add_many (GST_BIN (gcc->priv->encoder_bin), adapt_scale,
+        gcc->priv->adaptation_filter, videoscale, filter, NULL);
+    gst_element_link_many (colorspace, adapt_scale,
+        gcc->priv->adaptation_filter, videoscale, filter,
+        gcc->priv->video_enc, NULL);
+  } else {
+    gst_element_link (colorspace, gcc->priv->video_enc);
+  }
+  gst_element_link_many (gcc->priv->video_enc, gcc->priv->muxer,
+      gcc->priv->filesink, NULL);
 
   g_object_set (gcc->priv->filesink, "location", gcc->priv->output_file, NULL);
 
+  if (gcc->priv->timeshift_duration != 0) {
+    GstPad *pad;
+
+    pad = gst_element_get_static_pad (gcc->priv->video_enc, "src");
+    gst_camera_capturer_configure_timeshift (gcc, pad);
+    gst_object_unref (pad);
+  }
+
   /* Create ghost pads */
   v_sink_pad = gst_element_get_static_pad (colorspace, "sink");
   gst_element_add_pad (gcc->priv->encoder_bin, gst_ghost_pad_new ("video",
@@ -451,6 +647,7 @@ gst_camera_capturer_create_remuxer_bin (GstCameraCapturer * gcc)
 
   /* Create ghost pads */
   v_sink_pad = gst_element_get_request_pad (muxer, "video_%d");
+  gst_camera_capturer_configure_timeshift (gcc, v_sink_pad);
   gst_element_add_pad (gcc->priv->encoder_bin, gst_ghost_pad_new ("video",
           v_sink_pad));
   gst_object_unref (v_sink_pad);
@@ -471,7 +668,8 @@ gst_camera_capturer_encoding_retimestamper (GstCameraCapturer * gcc,
     GstBuffer * prev_buf, gboolean is_video)
 {
   GstClockTime buf_ts, new_buf_ts, duration;
-  GstBuffer *enc_buf;
+  GstBuffer *enc_buf = NULL;
+  LgmFrameRing *ring = NULL;
 
   g_mutex_lock (&gcc->priv->recording_lock);
 
@@ -495,12 +693,26 @@ gst_camera_capturer_encoding_retimestamper (GstCameraCapturer * gcc,
     }
   }
 
-  enc_buf = gst_buffer_create_sub (prev_buf, 0, GST_BUFFER_SIZE (prev_buf));
   buf_ts = GST_BUFFER_TIMESTAMP (prev_buf);
   duration = GST_BUFFER_DURATION (prev_buf);
   if (duration == GST_CLOCK_TIME_NONE)
     duration = 0;
 
+  /* Drop buffers after a scheduled pause or stop */
+  if (gcc->priv->recording_stop_ts != GST_CLOCK_TIME_NONE
+      && buf_ts != GST_CLOCK_TIME_NONE
+      && buf_ts >= gcc->priv->recording_stop_ts) {
+    if (is_video || !gcc->priv->has_video) {
+      if (!gcc->priv->recording_stop_reached) {
+        gcc->priv->recording_stop_reached = TRUE;
+        g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+            (GSourceFunc) gst_camera_capturer_stop_reached,
+            g_object_ref (gcc), g_object_unref);
+      }
+    }
+    goto done;
+  }
+
   /* Check if it's the first buffer after starting or restarting the capture
    * and update the timestamps accordingly */
   if (G_UNLIKELY (gcc->priv->current_recording_start_ts == GST_CLOCK_TIME_NONE)) {
@@ -516,6 +728,7 @@ gst_camera_capturer_encoding_retimestamper (GstCameraCapturer * gcc,
     goto done;
   }
 
+  enc_buf = gst_buffer_create_sub (prev_buf, 0, GST_BUFFER_SIZE (prev_buf));
   if (buf_ts != GST_CLOCK_TIME_NONE) {
     /* Get the buffer timestamp with respect of the encoding time and not
      * the playing time for a continous stream in the encoders input */
@@ -548,16 +761,32 @@ gst_camera_capturer_encoding_retimestamper (GstCameraCapturer * gcc,
       GST_TIME_FORMAT " out ts: %" GST_TIME_FORMAT, is_video ? "video" :
       "audio", GST_TIME_ARGS (buf_ts), GST_TIME_ARGS (new_buf_ts));
 
-  if (is_video)
-    gst_app_src_push_buffer (GST_APP_SRC (gcc->priv->video_appsrc), enc_buf);
-  else
-    gst_app_src_push_buffer (GST_APP_SRC (gcc->priv->audio_appsrc), enc_buf);
+  ring = is_video ? gcc->priv->video_ring : gcc->priv->audio_ring;
+  if (ring == NULL) {
+    gst_buffer_unref (enc_buf);
+    enc_buf = NULL;
+  } else {
+    /* The rings count a frame dropped after being queued in both pushed
+     * and dropped, so the inputs are counted here */
+    g_mutex_lock (&gcc->priv->stats_lock);
+    if (is_video)
+      gcc->priv->video_frames_in++;
+    else
+      gcc->priv->audio_buffers_in++;
+    g_mutex_unlock (&gcc->priv->stats_lock);
+  }
 
 done:
-  {
-    g_mutex_unlock (&gcc->priv->recording_lock);
-    return TRUE;
+  g_mutex_unlock (&gcc->priv->recording_lock);
+
+  /* The feeder threads push the frames to the encoder, so that a slow
+   * encoder never blocks the preview. Each ring is only pushed from the
+   * streaming thread of its pad, so the lock is not needed */
+  if (enc_buf != NULL && !lgm_frame_ring_push (ring, enc_buf)) {
+    GST_DEBUG_OBJECT (gcc, "%s frame dropped, the encoder is late",
+        is_video ? "Video" : "Audio");
   }
+  return TRUE;
 }
 
 static gboolean
@@ -574,6 +803,194 @@ gst_camera_capturer_video_encoding_probe (GstPad * pad, GstBuffer * buf,
   return gst_camera_capturer_encoding_retimestamper (gcc, buf, TRUE);
 }
 
+static gpointer
+gst_camera_capturer_feeder (LgmFrameRing * ring, GstElement * appsrc,
+    volatile gint * level)
+{
+  GstBuffer *buf;
+
+  while ((buf = lgm_frame_ring_pop (ring)) != NULL) {
+    if (level != NULL)
+      g_atomic_int_add (level, GST_BUFFER_SIZE (buf));
+    /* Blocks while the appsrc queue is full */
+    gst_app_src_push_buffer (GST_APP_SRC (appsrc), buf);
+  }
+  return NULL;
+}
+
+static gpointer
+gst_camera_capturer_video_feeder (GstCameraCapturer * gcc)
+{
+  return gst_camera_capturer_feeder (gcc->priv->video_ring,
+      gcc->priv->video_appsrc, &gcc->priv->video_appsrc_level);
+}
+
+static gpointer
+gst_camera_capturer_audio_feeder (GstCameraCapturer * gcc)
+{
+  return gst_camera_capturer_feeder (gcc->priv->audio_ring,
+      gcc->priv->audio_appsrc, NULL);
+}
+
+static gboolean
+gst_camera_capturer_appsrc_output_probe (GstPad * pad, GstBuffer * buf,
+    GstCameraCapturer * gcc)
+{
+  g_atomic_int_add (&gcc->priv->video_appsrc_level,
+      -(gint) GST_BUFFER_SIZE (buf));
+  return TRUE;
+}
+
+static gboolean
+gst_camera_capturer_encoder_input_probe (GstPad * pad, GstBuffer * buf,
+    GstCameraCapturer * gcc)
+{
+  GstClockTime *pending;
+
+  if (!GST_BUFFER_TIMESTAMP_IS_VALID (buf))
+    return TRUE;
+
+  /* Timestamp of the frame and the time it entered the encoder */
+  pending = g_new (GstClockTime, 2);
+  pending[0] = GST_BUFFER_TIMESTAMP (buf);
+  pending[1] = gst_util_get_timestamp ();
+
+  g_mutex_lock (&gcc->priv->stats_lock);
+  gcc->priv->last_encoder_input_ts = GST_BUFFER_TIMESTAMP (buf);
+  g_queue_push_tail (gcc->priv->pending_frames, pending);
+  if (g_queue_get_length (gcc->priv->pending_frames) > MAX_PENDING_FRAMES)
+    g_free (g_queue_pop_head (gcc->priv->pending_frames));
+  g_mutex_unlock (&gcc->priv->stats_lock);
+  return TRUE;
+}
+
+static gboolean
+gst_camera_capturer_video_encoder_output_probe (GstPad * pad, GstBuffer * buf,
+    GstCameraCapturer * gcc)
+{
+  GstClockTime *pending, ts, entered = GST_CLOCK_TIME_NONE;
+
+  if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_IN_CAPS))
+    return TRUE;
+
+  ts = GST_BUFFER_TIMESTAMP (buf);
+  g_mutex_lock (&gcc->priv->stats_lock);
+  gcc->priv->video_frames_encoded++;
+  if (ts != GST_CLOCK_TIME_NONE) {
+    /* Frames can be reordered, take the last one at or before this one */
+    while ((pending = g_queue_peek_head (gcc->priv->pending_frames)) != NULL
+        && pending[0] <= ts) {
+      entered = pending[1];
+      g_free (g_queue_pop_head (gcc->priv->pending_frames));
+    }
+    if (entered != GST_CLOCK_TIME_NONE)
+      gcc->priv->encoder_latency = gst_util_get_timestamp () - entered;
+  }
+  g_mutex_unlock (&gcc->priv->stats_lock);
+  return TRUE;
+}
+
+static gboolean
+gst_camera_capturer_audio_encoder_output_probe (GstPad * pad, GstBuffer * buf,
+    GstCameraCapturer * gcc)
+{
+  g_mutex_lock (&gcc->priv->stats_lock);
+  gcc->priv->audio_buffers_encoded++;
+  g_mutex_unlock (&gcc->priv->stats_lock);
+  return TRUE;
+}
+
+static void
+gst_camera_capturer_add_element_probe (GstElement * element,
+    const gchar * pad_name, GCallback callback, GstCameraCapturer * gcc)
+{
+  GstPad *pad;
+
+  pad = gst_element_get_static_pad (element, pad_name);
+  gst_pad_add_buffer_probe (pad, callback, gcc);
+  gst_object_unref (pad);
+}
+
+static void
+gst_camera_capturer_add_stats_probes (GstCameraCapturer * gcc)
+{
+  GstElement *video_enc = gcc->priv->video_enc;
+  GstElement *audio_enc = gcc->priv->audio_enc;
+
+  /* When remuxing the encoders are not used */
+  if (video_enc != NULL &&
+      GST_OBJECT_PARENT (video_enc) == GST_OBJECT (gcc->priv->encoder_bin)) {
+    gst_camera_capturer_add_element_probe (video_enc, "sink",
+        (GCallback) gst_camera_capturer_encoder_input_probe, gcc);
+    gst_camera_capturer_add_element_probe (video_enc, "src",
+        (GCallback) gst_camera_capturer_video_encoder_output_probe, gcc);
+  }
+  if (gcc->priv->audio_enabled && audio_enc != NULL &&
+      GST_OBJECT_PARENT (audio_enc) == GST_OBJECT (gcc->priv->encoder_bin)) {
+    gst_camera_capturer_add_element_probe (audio_enc, "src",
+        (GCallback) gst_camera_capturer_audio_encoder_output_probe, gcc);
+  }
+}
+
+static void
+gst_camera_capturer_start_feeders (GstCameraCapturer * gcc)
+{
+  /* The rings of the previous recording were kept for the stats */
+  lgm_frame_ring_free (gcc->priv->video_ring);
+  lgm_frame_ring_free (gcc->priv->audio_ring);
+  gcc->priv->audio_ring = NULL;
+  g_mutex_lock (&gcc->priv->stats_lock);
+  gcc->priv->video_frames_in = 0;
+  gcc->priv->audio_buffers_in = 0;
+  gcc->priv->video_frames_encoded = 0;
+  gcc->priv->audio_buffers_encoded = 0;
+  g_mutex_unlock (&gcc->priv->stats_lock);
+
+  gcc->priv->video_ring = lgm_frame_ring_new (VIDEO_RING_SIZE,
+      gcc->priv->drop_policy);
+  gcc->priv->video_feeder = g_thread_new ("video-feeder",
+      (GThreadFunc) gst_camera_capturer_video_feeder, gcc);
+
+  /* Audio is cheap to encode and the ring absorbs the jitter of the
+   * encoder. It's only dropped if the encoder stalls, since blocking would
+   * freeze the preview */
+  if (gcc->priv->audio_enabled) {
+    gcc->priv->audio_ring = lgm_frame_ring_new (AUDIO_RING_SIZE,
+        LGM_FRAME_RING_POLICY_DROP_NEWEST);
+    gcc->priv->audio_feeder = g_thread_new ("audio-feeder",
+        (GThreadFunc) gst_camera_capturer_audio_feeder, gcc);
+  }
+}
+
+static void
+gst_camera_capturer_stop_feeders (GstCameraCapturer * gcc, gboolean flush)
+{
+  LgmFrameRing *rings[] = { gcc->priv->video_ring, gcc->priv->audio_ring };
+  GThread *feeders[] = { gcc->priv->video_feeder, gcc->priv->audio_feeder };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (rings); i++) {
+    if (rings[i] == NULL)
+      continue;
+    if (flush)
+      lgm_frame_ring_set_flushing (rings[i], TRUE);
+    else
+      lgm_frame_ring_close (rings[i]);
+  }
+  for (i = 0; i < G_N_ELEMENTS (feeders); i++) {
+    if (feeders[i] != NULL)
+      g_thread_join (feeders[i]);
+  }
+  gcc->priv->video_feeder = gcc->priv->audio_feeder = NULL;
+
+  /* The rings are kept until finalize for the stats */
+  if (flush) {
+    lgm_frame_ring_free (gcc->priv->video_ring);
+    lgm_frame_ring_free (gcc->priv->audio_ring);
+    gcc->priv->video_ring = gcc->priv->audio_ring = NULL;
+  }
+}
+
 static void
 gst_camera_capturer_create_splitter_bin (GstCameraCapturer * gcc)
 {
@@ -597,7 +1014,7 @@ gst_camera_capturer_create_splitter_bin (GstCameraCapturer * gcc)
   v_queue = gst_element_factory_make ("queue", "video-queue");
 
   gst_app_src_set_max_bytes ((GstAppSrc *) gcc->priv->video_appsrc,
-      (guint64) 20 * 1024 * 1024);
+      VIDEO_APPSRC_MAX_BYTES);
   g_object_set (gcc->priv->video_appsrc, "block", TRUE, NULL);
 
   gst_camera_capturer_create_converter_bin (gcc);
@@ -610,6 +1027,8 @@ gst_camera_capturer_create_splitter_bin (GstCameraCapturer * gcc)
 
   /* Link video appsrc to the queue */
   gst_element_link (gcc->priv->video_appsrc, v_queue);
+  gst_camera_capturer_add_element_probe (gcc->priv->video_appsrc, "src",
+      (GCallback) gst_camera_capturer_appsrc_output_probe, gcc);
 
   /* Create source ghost pads */
   v_queue_pad = gst_element_get_static_pad (v_queue, "src");
@@ -647,7 +1066,7 @@ gst_camera_capturer_fill_audio_splitter_bin (GstCameraCapturer * gcc)
   a_queue = gst_element_factory_make ("queue", "audio-queue");
   a_prev_queue = gst_element_factory_make ("queue", "audio-preview-queue");
 
-  g_object_set (a_queue, "max-size-time", 1 * GST_SECOND, NULL);
+  g_object_set (a_queue, "max-size-time", AUDIO_QUEUE_MAX_TIME, NULL);
 
   gst_bin_add_many (GST_BIN (gcc->priv->splitter_bin), gcc->priv->audio_appsrc,
       a_queue, a_prev_queue, NULL);
@@ -1522,6 +1941,27 @@ gst_camera_capturer_close (GstCameraCapturer * gcc)
   }
 }
 
+/* Must be called with the recording lock. If start is GST_CLOCK_TIME_NONE
+ * the recording starts with the first buffer received */
+static void
+gst_camera_capturer_start_recording (GstCameraCapturer * gcc,
+    GstClockTime start)
+{
+  if (gcc->priv->is_recording
+      || gcc->priv->accum_recorded_ts != GST_CLOCK_TIME_NONE)
+    return;
+
+  gcc->priv->accum_recorded_ts = 0;
+  gcc->priv->last_accum_recorded_ts = 0;
+  gcc->priv->current_recording_start_ts = start;
+  gcc->priv->is_recording = TRUE;
+  gst_camera_capturer_create_encoder_bin (gcc);
+  gst_camera_capturer_link_encoder_bin (gcc);
+  gst_camera_capturer_add_stats_probes (gcc);
+  gst_camera_capturer_start_feeders (gcc);
+  gst_camera_capturer_start_adaptation (gcc);
+}
+
 void
 gst_camera_capturer_start (GstCameraCapturer * gcc)
 {
@@ -1530,16 +1970,118 @@ gst_camera_capturer_start (GstCameraCapturer * gcc)
 
   GST_INFO_OBJECT (gcc, "Started capture");
   g_mutex_lock (&gcc->priv->recording_lock);
-  if (!gcc->priv->is_recording
-      && gcc->priv->accum_recorded_ts == GST_CLOCK_TIME_NONE) {
-    gcc->priv->accum_recorded_ts = 0;
+  gst_camera_capturer_start_recording (gcc, GST_CLOCK_TIME_NONE);
+  g_mutex_unlock (&gcc->priv->recording_lock);
+}
+
+void
+gst_camera_capturer_set_clock (GstCameraCapturer * gcc, GstClock * clock,
+    GstClockTime base_time)
+{
+  g_return_if_fail (GST_IS_CAMERA_CAPTURER (gcc));
+  g_return_if_fail (GST_IS_CLOCK (clock));
+
+  gst_pipeline_use_clock (GST_PIPELINE (gcc->priv->main_pipeline), clock);
+  /* Don't let the pipeline pick a new base time when going to PLAYING, so
+   * that its running time is the same as in the other pipelines */
+  gst_element_set_start_time (gcc->priv->main_pipeline, GST_CLOCK_TIME_NONE);
+  gst_element_set_base_time (gcc->priv->main_pipeline, base_time);
+}
+
+void
+gst_camera_capturer_start_at (GstCameraCapturer * gcc, GstClockTime start)
+{
+  g_return_if_fail (GST_IS_CAMERA_CAPTURER (gcc));
+  g_return_if_fail (GST_CLOCK_TIME_IS_VALID (start));
+
+  GST_INFO_OBJECT (gcc, "Starting capture at %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (start));
+  g_mutex_lock (&gcc->priv->recording_lock);
+  gst_camera_capturer_start_recording (gcc, start);
+  g_mutex_unlock (&gcc->priv->recording_lock);
+}
+
+void
+gst_camera_capturer_toggle_pause_at (GstCameraCapturer * gcc,
+    GstClockTime time)
+{
+  g_return_if_fail (GST_IS_CAMERA_CAPTURER (gcc));
+  g_return_if_fail (GST_CLOCK_TIME_IS_VALID (time));
+
+  g_mutex_lock (&gcc->priv->recording_lock);
+  if (gcc->priv->is_recording
+      && gcc->priv->recording_stop_ts == GST_CLOCK_TIME_NONE) {
+    /* Keep the buffers already captured before the pause */
+    gcc->priv->recording_stop_ts = time;
+    GST_INFO_OBJECT (gcc, "Pausing capture at %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (time));
+  } else {
+    if (gcc->priv->is_recording
+        && gcc->priv->current_recording_start_ts != GST_CLOCK_TIME_NONE) {
+      /* Continue the recording timeline where the paused section ended,
+       * which is the same for all the capturers resumed at this time */
+      gcc->priv->last_accum_recorded_ts += gcc->priv->recording_stop_ts -
+          gcc->priv->current_recording_start_ts;
+    } else {
+      gcc->priv->last_accum_recorded_ts = gcc->priv->accum_recorded_ts;
+    }
+    gcc->priv->current_recording_start_ts = time;
+    gcc->priv->recording_stop_ts = GST_CLOCK_TIME_NONE;
+    gcc->priv->recording_stop_reached = FALSE;
     gcc->priv->is_recording = TRUE;
-    gst_camera_capturer_create_encoder_bin (gcc);
-    gst_camera_capturer_link_encoder_bin (gcc);
+    gcc->priv->video_synced = FALSE;
+    GST_INFO_OBJECT (gcc, "Resuming capture at %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (time));
   }
   g_mutex_unlock (&gcc->priv->recording_lock);
 }
 
+/* Finishes a scheduled stop once the capture reached its stop time */
+static gboolean
+gst_camera_capturer_stop_reached (GstCameraCapturer * gcc)
+{
+  if (gcc->priv->recording_stop_id != 0)
+    gst_camera_capturer_stop (gcc);
+  return FALSE;
+}
+
+static gboolean
+gst_camera_capturer_stop_timeout (GstCameraCapturer * gcc)
+{
+  GST_WARNING_OBJECT (gcc, "Timed out waiting for the stop time");
+  gcc->priv->recording_stop_id = 0;
+  gst_camera_capturer_stop (gcc);
+  return FALSE;
+}
+
+void
+gst_camera_capturer_stop_at (GstCameraCapturer * gcc, GstClockTime time)
+{
+  gboolean pending;
+
+  g_return_if_fail (GST_IS_CAMERA_CAPTURER (gcc));
+  g_return_if_fail (GST_CLOCK_TIME_IS_VALID (time));
+
+  GST_INFO_OBJECT (gcc, "Stopping capture at %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (time));
+  g_mutex_lock (&gcc->priv->recording_lock);
+  if (gcc->priv->is_recording
+      && gcc->priv->recording_stop_ts == GST_CLOCK_TIME_NONE) {
+    gcc->priv->recording_stop_ts = time;
+  }
+  pending = gcc->priv->is_recording && !gcc->priv->recording_stop_reached;
+  g_mutex_unlock (&gcc->priv->recording_lock);
+
+  if (!pending) {
+    gst_camera_capturer_stop (gcc);
+  } else if (gcc->priv->recording_stop_id == 0) {
+    /* Stop once the frames captured before the stop time are queued,
+     * without blocking the caller */
+    gcc->priv->recording_stop_id = g_timeout_add (RECORDING_STOP_TIMEOUT,
+        (GSourceFunc) gst_camera_capturer_stop_timeout, gcc);
+  }
+}
+
 void
 gst_camera_capturer_toggle_pause (GstCameraCapturer * gcc)
 {
@@ -1572,19 +2114,12 @@ gst_camera_capturer_unref_pixbuf (GdkPixbuf * pixbuf)
   g_object_unref (pixbuf);
 }
 
-GdkPixbuf *
-gst_camera_capturer_get_current_frame (GstCameraCapturer * gcc)
+static GstBuffer *
+gst_camera_capturer_get_frame (GstCameraCapturer * gcc, LgmFrameFormat format)
 {
-  GstStructure *s;
-  GdkPixbuf *pixbuf;
   GstBuffer *last_buffer;
   GstBuffer *buf;
-  GstCaps *to_caps;
-  gint outwidth = 0;
-  gint outheight = 0;
-
-  g_return_val_if_fail (gcc != NULL, NULL);
-  g_return_val_if_fail (GST_IS_CAMERA_CAPTURER (gcc), NULL);
+  GError *err = NULL;
 
   gst_element_get_state (gcc->priv->main_pipeline, NULL, NULL, -1);
 
@@ -1597,7 +2132,6 @@ gst_camera_capturer_get_current_frame (GstCameraCapturer * gcc)
 
   /* get frame */
   last_buffer = gcc->priv->last_buffer;
-  gst_buffer_ref (last_buffer);
 
   if (!last_buffer) {
     GST_DEBUG_OBJECT (gcc, "Could not take screenshot: %s",
@@ -1605,59 +2139,66 @@ gst_camera_capturer_get_current_frame (GstCameraCapturer * gcc)
     g_warning ("Could not take screenshot: %s", "no last video frame");
     return NULL;
   }
+  gst_buffer_ref (last_buffer);
 
   if (GST_BUFFER_CAPS (last_buffer) == NULL) {
     GST_DEBUG_OBJECT (gcc, "Could not take screenshot: %s",
         "no caps on buffer");
     g_warning ("Could not take screenshot: %s", "no caps on buffer");
+    gst_buffer_unref (last_buffer);
     return NULL;
   }
 
-  /* convert to our desired format (RGB24) */
-  to_caps = gst_caps_new_simple ("video/x-raw-rgb",
-      "bpp", G_TYPE_INT, 24, "depth", G_TYPE_INT, 24,
-      /* Note: we don't ask for a specific width/height here, so that
-       * videoscale can adjust dimensions from a non-1/1 pixel aspect
-       * ratio to a 1/1 pixel-aspect-ratio */
-      "pixel-aspect-ratio", GST_TYPE_FRACTION, 1,
-      1, "endianness", G_TYPE_INT, G_BIG_ENDIAN,
-      "red_mask", G_TYPE_INT, 0xff0000,
-      "green_mask", G_TYPE_INT, 0x00ff00,
-      "blue_mask", G_TYPE_INT, 0x0000ff, NULL);
-
-  if (gcc->priv->video_fps_n > 0 && gcc->priv->video_fps_d > 0) {
-    gst_caps_set_simple (to_caps, "framerate", GST_TYPE_FRACTION,
-        gcc->priv->video_fps_n, gcc->priv->video_fps_d, NULL);
+  if (gcc->priv->frame_conv[format] == NULL) {
+    gcc->priv->frame_conv[format] = bvw_frame_conv_new (format, &err);
+    if (gcc->priv->frame_conv[format] == NULL) {
+      GST_WARNING_OBJECT (gcc, "Could not create frame converter: %s",
+          err->message);
+      g_error_free (err);
+      gst_buffer_unref (last_buffer);
+      return NULL;
+    }
   }
 
   GST_DEBUG_OBJECT (gcc, "frame caps: %" GST_PTR_FORMAT,
-      GST_BUFFER_CAPS (gcc->priv->last_buffer));
-  GST_DEBUG_OBJECT (gcc, "pixbuf caps: %" GST_PTR_FORMAT, to_caps);
-
-  /* bvw_frame_conv_convert () takes ownership of the buffer passed */
-  buf = bvw_frame_conv_convert (last_buffer, to_caps);
+      GST_BUFFER_CAPS (last_buffer));
 
-  gst_caps_unref (to_caps);
+  buf = bvw_frame_conv_convert (gcc->priv->frame_conv[format], last_buffer);
   gst_buffer_unref (last_buffer);
 
   if (!buf) {
     GST_DEBUG_OBJECT (gcc, "Could not take screenshot: %s",
         "conversion failed");
     g_warning ("Could not take screenshot: %s", "conversion failed");
-    return NULL;
   }
+  return buf;
+}
 
-  if (!GST_BUFFER_CAPS (buf)) {
-    GST_DEBUG_OBJECT (gcc, "Could not take screenshot: %s",
-        "no caps on output buffer");
-    g_warning ("Could not take screenshot: %s", "no caps on output buffer");
+GdkPixbuf *
+gst_camera_capturer_get_current_frame (GstCameraCapturer * gcc)
+{
+  GstStructure *s;
+  GdkPixbuf *pixbuf;
+  GstBuffer *buf;
+  gint outwidth = 0;
+  gint outheight = 0;
+
+  g_return_val_if_fail (gcc != NULL, NULL);
+  g_return_val_if_fail (GST_IS_CAMERA_CAPTURER (gcc), NULL);
+
+  /* convert to our desired format (RGB24) */
+  buf = gst_camera_capturer_get_frame (gcc, LGM_FRAME_FORMAT_RGB24);
+  if (!buf) {
     return NULL;
   }
 
   s = gst_caps_get_structure (GST_BUFFER_CAPS (buf), 0);
   gst_structure_get_int (s, "width", &outwidth);
   gst_structure_get_int (s, "height", &outheight);
-  g_return_val_if_fail (outwidth > 0 && outheight > 0, NULL);
+  if (outwidth <= 0 || outheight <= 0) {
+    gst_buffer_unref (buf);
+    g_return_val_if_reached (NULL);
+  }
 
   /* create pixbuf from that - we don't want to use the gstreamer's buffer
    * because the GTK# bindings won't call the destroy funtion */
@@ -1669,11 +2210,35 @@ gst_camera_capturer_get_current_frame (GstCameraCapturer * gcc)
     GST_DEBUG_OBJECT (gcc, "Could not take screenshot: %s",
         "could not create pixbuf");
     g_warning ("Could not take screenshot: %s", "could not create pixbuf");
+    gst_buffer_unref (buf);
   }
 
   return pixbuf;
 }
 
+gboolean
+gst_camera_capturer_grab_frame (GstCameraCapturer * gcc, LgmFrameFormat format,
+    guint8 * data, gsize * size, gint * width, gint * height)
+{
+  GstBuffer *buf;
+  gboolean ret;
+
+  g_return_val_if_fail (gcc != NULL, FALSE);
+  g_return_val_if_fail (GST_IS_CAMERA_CAPTURER (gcc), FALSE);
+  g_return_val_if_fail (size != NULL, FALSE);
+
+  buf = gst_camera_capturer_get_frame (gcc, format);
+  if (!buf) {
+    return FALSE;
+  }
+
+  /* The frame is already converted, grabbing it only copies it */
+  ret = bvw_frame_conv_grab (gcc->priv->frame_conv[format], buf, data, size,
+      width, height);
+  gst_buffer_unref (buf);
+  return ret;
+}
+
 
 void
 gst_camera_capturer_stop (GstCameraCapturer * gcc)
@@ -1690,14 +2255,378 @@ gst_camera_capturer_stop (GstCameraCapturer * gcc)
 #endif
 
   GST_INFO_OBJECT (gcc, "Closing capture");
+  if (gcc->priv->recording_stop_id != 0) {
+    g_source_remove (gcc->priv->recording_stop_id);
+    gcc->priv->recording_stop_id = 0;
+  }
+  if (gcc->priv->adaptation_id != 0) {
+    g_source_remove (gcc->priv->adaptation_id);
+    gcc->priv->adaptation_id = 0;
+  }
+
   g_mutex_lock (&gcc->priv->recording_lock);
   gcc->priv->closing_recording = TRUE;
   gcc->priv->is_recording = FALSE;
   g_mutex_unlock (&gcc->priv->recording_lock);
 
+  /* Let the encoder get all the frames already captured */
+  gst_camera_capturer_stop_feeders (gcc, FALSE);
+  if (gcc->priv->video_ring != NULL) {
+    guint max_depth;
+    guint64 dropped;
+
+    lgm_frame_ring_get_stats (gcc->priv->video_ring, NULL, &max_depth,
+        NULL, &dropped);
+    GST_INFO_OBJECT (gcc, "Queued %" G_GUINT64_FORMAT " video frames, "
+        "dropped %" G_GUINT64_FORMAT ", max queue depth %u",
+        gcc->priv->video_frames_in - dropped, dropped, max_depth);
+  }
+
+  if (gcc->priv->timeshift != NULL)
+    lgm_timeshift_buffer_set_eos (gcc->priv->timeshift);
+
   gcc_encoder_send_event (gcc, gst_event_new_eos ());
 }
 
+void
+gst_camera_capturer_set_timeshift_duration (GstCameraCapturer * gcc,
+    guint duration)
+{
+  g_return_if_fail (GST_IS_CAMERA_CAPTURER (gcc));
+  g_return_if_fail (gcc->priv->encoder_bin == NULL);
+
+  gcc->priv->timeshift_duration = duration;
+}
+
+LgmTimeshiftBuffer *
+gst_camera_capturer_get_timeshift_buffer (GstCameraCapturer * gcc)
+{
+  g_return_val_if_fail (GST_IS_CAMERA_CAPTURER (gcc), NULL);
+
+  if (gcc->priv->timeshift == NULL)
+    return NULL;
+  return lgm_timeshift_buffer_ref (gcc->priv->timeshift);
+}
+
+void
+gst_camera_capturer_set_drop_policy (GstCameraCapturer * gcc,
+    LgmFrameRingPolicy policy)
+{
+  g_return_if_fail (GST_IS_CAMERA_CAPTURER (gcc));
+
+  g_mutex_lock (&gcc->priv->recording_lock);
+  gcc->priv->drop_policy = policy;
+  if (gcc->priv->video_ring != NULL)
+    lgm_frame_ring_set_policy (gcc->priv->video_ring, policy);
+  g_mutex_unlock (&gcc->priv->recording_lock);
+}
+
+void
+gst_camera_capturer_get_queue_stats (GstCameraCapturer * gcc,
+    guint * depth, guint * max_depth, guint64 * dropped)
+{
+  g_return_if_fail (GST_IS_CAMERA_CAPTURER (gcc));
+
+  if (gcc->priv->video_ring != NULL) {
+    lgm_frame_ring_get_stats (gcc->priv->video_ring, depth, max_depth, NULL,
+        dropped);
+    return;
+  }
+  if (depth)
+    *depth = 0;
+  if (max_depth)
+    *max_depth = 0;
+  if (dropped)
+    *dropped = 0;
+}
+
+void
+gst_camera_capturer_get_stats (GstCameraCapturer * gcc,
+    LgmCaptureStats * stats)
+{
+  GstElement *audio_queue;
+  GstFormat format = GST_FORMAT_BYTES;
+  gint64 bytes;
+  guint64 dropped;
+
+  g_return_if_fail (GST_IS_CAMERA_CAPTURER (gcc));
+  g_return_if_fail (stats != NULL);
+
+  memset (stats, 0, sizeof (LgmCaptureStats));
+  stats->video_appsrc_max_level = VIDEO_APPSRC_MAX_BYTES;
+  stats->audio_queue_max_level = AUDIO_QUEUE_MAX_TIME;
+
+  if (gcc->priv->video_ring != NULL) {
+    lgm_frame_ring_get_stats (gcc->priv->video_ring, NULL, NULL, NULL,
+        &dropped);
+    stats->video_frames_dropped = dropped;
+  }
+  if (gcc->priv->audio_ring != NULL) {
+    lgm_frame_ring_get_stats (gcc->priv->audio_ring, NULL, NULL, NULL,
+        &dropped);
+    stats->audio_buffers_dropped = dropped;
+  }
+
+  g_mutex_lock (&gcc->priv->stats_lock);
+  stats->video_frames_in = gcc->priv->video_frames_in;
+  stats->audio_buffers_in = gcc->priv->audio_buffers_in;
+  stats->video_frames_encoded = gcc->priv->video_frames_encoded;
+  stats->audio_buffers_encoded = gcc->priv->audio_buffers_encoded;
+  stats->encoder_latency = gcc->priv->encoder_latency;
+  g_mutex_unlock (&gcc->priv->stats_lock);
+
+  stats->adaptation_level = gcc->priv->adaptation_level;
+  stats->adaptations = gcc->priv->adaptations;
+  stats->cpu_time = lgm_get_process_cpu_time ();
+
+  /* Without encoders the buffers are only remuxed */
+  if (gcc->priv->video_needs_keyframe_sync) {
+    stats->video_frames_encoded = stats->video_frames_in -
+        stats->video_frames_dropped;
+    stats->audio_buffers_encoded = stats->audio_buffers_in -
+        stats->audio_buffers_dropped;
+  }
+
+  stats->video_appsrc_level =
+      MAX (0, g_atomic_int_get (&gcc->priv->video_appsrc_level));
+  if (gcc->priv->audio_enabled && gcc->priv->splitter_bin != NULL) {
+    audio_queue = gst_bin_get_by_name (GST_BIN (gcc->priv->splitter_bin),
+        "audio-queue");
+    if (audio_queue != NULL) {
+      g_object_get (audio_queue, "current-level-time",
+          &stats->audio_queue_level, NULL);
+      gst_object_unref (audio_queue);
+    }
+  }
+
+  g_mutex_lock (&gcc->priv->recording_lock);
+  if (gcc->priv->last_video_buf_ts != GST_CLOCK_TIME_NONE &&
+      gcc->priv->last_audio_buf_ts != GST_CLOCK_TIME_NONE) {
+    stats->av_drift = GST_CLOCK_DIFF (gcc->priv->last_audio_buf_ts,
+        gcc->priv->last_video_buf_ts);
+  }
+  g_mutex_unlock (&gcc->priv->recording_lock);
+
+  if (gcc->priv->filesink != NULL &&
+      gst_element_query_position (gcc->priv->filesink, &format, &bytes)) {
+    stats->bytes_written = bytes;
+  }
+}
+
+static gboolean
+gst_camera_capturer_emit_stats (GstCameraCapturer * gcc)
+{
+  LgmCaptureStats stats;
+
+  gst_camera_capturer_get_stats (gcc, &stats);
+  g_signal_emit (gcc, gcc_signals[SIGNAL_STATS], 0, &stats);
+  return TRUE;
+}
+
+void
+gst_camera_capturer_set_stats_interval (GstCameraCapturer * gcc,
+    guint interval)
+{
+  g_return_if_fail (GST_IS_CAMERA_CAPTURER (gcc));
+
+  if (gcc->priv->stats_timeout_id != 0) {
+    g_source_remove (gcc->priv->stats_timeout_id);
+    gcc->priv->stats_timeout_id = 0;
+  }
+  if (interval > 0) {
+    gcc->priv->stats_timeout_id = g_timeout_add (interval,
+        (GSourceFunc) gst_camera_capturer_emit_stats, gcc);
+  }
+}
+
+static void
+gst_camera_capturer_set_adaptation_level (GstCameraCapturer * gcc,
+    guint level)
+{
+  gint step;
+
+  GST_INFO_OBJECT (gcc, "Changing the adaptation level from %u to %u",
+      gcc->priv->adaptation_level, level);
+  gcc->priv->adaptation_level = level;
+  gcc->priv->adaptations++;
+
+  if (gcc->priv->speed_element != NULL) {
+    gint speed;
+
+    step = adaptation_levels[level].speed_step;
+    if (gcc->priv->speed_fastest > gcc->priv->speed_initial) {
+      speed = MIN (gcc->priv->speed_initial + step, gcc->priv->speed_fastest);
+    } else {
+      speed = MAX (gcc->priv->speed_initial - step, gcc->priv->speed_fastest);
+    }
+    g_object_set (gcc->priv->speed_element, gcc->priv->speed_property, speed,
+        NULL);
+  }
+
+  if (gcc->priv->adaptation_filter != NULL) {
+    GstCaps *caps;
+    gint width, height;
+
+    width = GST_ROUND_DOWN_4 (gcc->priv->output_width *
+        adaptation_levels[level].scale_n / adaptation_levels[level].scale_d);
+    height = GST_ROUND_DOWN_4 (gcc->priv->output_height *
+        adaptation_levels[level].scale_n / adaptation_levels[level].scale_d);
+
+    /* Only the resolution changes, never the framerate */
+    caps = gst_caps_new_simple ("video/x-raw-yuv", "width", G_TYPE_INT, width,
+        "height", G_TYPE_INT, height, NULL);
+    g_object_set (gcc->priv->adaptation_filter, "caps", caps, NULL);
+    gst_caps_unref (caps);
+  }
+
+  /* Let the application log every adaptation */
+  gst_camera_capturer_emit_stats (gcc);
+}
+
+/* Checks if two adaptation levels change anything in this encoder */
+static gboolean
+gst_camera_capturer_levels_differ (GstCameraCapturer * gcc, guint a, guint b)
+{
+  if (gcc->priv->speed_element != NULL &&
+      adaptation_levels[a].speed_step != adaptation_levels[b].speed_step)
+    return TRUE;
+  if (gcc->priv->adaptation_filter != NULL &&
+      adaptation_levels[a].scale_n * adaptation_levels[b].scale_d !=
+      adaptation_levels[b].scale_n * adaptation_levels[a].scale_d)
+    return TRUE;
+  return FALSE;
+}
+
+/* Finds the next level in the given direction that changes the encoding,
+ * or returns the current level if there is none */
+static guint
+gst_camera_capturer_next_level (GstCameraCapturer * gcc, gboolean down)
+{
+  guint level = gcc->priv->adaptation_level;
+
+  while (down ? level < MAX_ADAPTATION_LEVEL : level > 0) {
+    level = down ? level + 1 : level - 1;
+    if (gst_camera_capturer_levels_differ (gcc, gcc->priv->adaptation_level,
+            level))
+      return level;
+  }
+  return gcc->priv->adaptation_level;
+}
+
+static gboolean
+gst_camera_capturer_check_load (GstCameraCapturer * gcc)
+{
+  LgmCaptureStats stats;
+  GstClockTime last_in, last_encoded, backlog = 0;
+  gdouble load;
+  gboolean dropping;
+  guint level;
+
+  gst_camera_capturer_get_stats (gcc, &stats);
+  dropping = stats.video_frames_dropped > gcc->priv->last_video_dropped;
+  gcc->priv->last_video_dropped = stats.video_frames_dropped;
+
+  /* The load is the time the frames wait before reaching the encoder,
+   * which doesn't depend on the size of the frames */
+  g_mutex_lock (&gcc->priv->recording_lock);
+  last_in = gcc->priv->last_video_buf_ts;
+  g_mutex_unlock (&gcc->priv->recording_lock);
+  g_mutex_lock (&gcc->priv->stats_lock);
+  last_encoded = gcc->priv->last_encoder_input_ts;
+  g_mutex_unlock (&gcc->priv->stats_lock);
+  if (GST_CLOCK_TIME_IS_VALID (last_in) &&
+      GST_CLOCK_TIME_IS_VALID (last_encoded) && last_in > last_encoded) {
+    backlog = last_in - last_encoded;
+  }
+  load = (gdouble) backlog / ADAPTATION_MAX_BACKLOG;
+
+  if (dropping || load > ADAPTATION_HIGH_LOAD) {
+    gcc->priv->low_load_checks = 0;
+    level = gst_camera_capturer_next_level (gcc, TRUE);
+    if (++gcc->priv->high_load_checks >= ADAPTATION_DOWN_CHECKS &&
+        level != gcc->priv->adaptation_level) {
+      gcc->priv->high_load_checks = 0;
+      gst_camera_capturer_set_adaptation_level (gcc, level);
+    }
+  } else if (load < ADAPTATION_LOW_LOAD) {
+    gcc->priv->high_load_checks = 0;
+    level = gst_camera_capturer_next_level (gcc, FALSE);
+    if (++gcc->priv->low_load_checks >= ADAPTATION_UP_CHECKS &&
+        level != gcc->priv->adaptation_level) {
+      gcc->priv->low_load_checks = 0;
+      gst_camera_capturer_set_adaptation_level (gcc, level);
+    }
+  } else {
+    gcc->priv->high_load_checks = 0;
+    gcc->priv->low_load_checks = 0;
+  }
+  return TRUE;
+}
+
+/* Finds the encoder property that makes it faster, if it can be changed
+ * while encoding */
+static void
+gst_camera_capturer_find_speed_property (GstCameraCapturer * gcc)
+{
+  GstElement *encoder;
+  GParamSpec *pspec;
+  guint i;
+
+  if (GST_IS_BIN (gcc->priv->video_enc)) {
+    encoder = gst_bin_get_by_name (GST_BIN (gcc->priv->video_enc),
+        "video-encoder");
+  } else {
+    encoder = gst_object_ref (gcc->priv->video_enc);
+  }
+  if (encoder == NULL)
+    return;
+
+  for (i = 0; i < G_N_ELEMENTS (encoder_speed_properties); i++) {
+    pspec = g_object_class_find_property (G_OBJECT_GET_CLASS (encoder),
+        encoder_speed_properties[i].name);
+    if (pspec == NULL || !(pspec->flags & GST_PARAM_MUTABLE_PLAYING))
+      continue;
+
+    gcc->priv->speed_element = gst_object_ref (encoder);
+    gcc->priv->speed_property = encoder_speed_properties[i].name;
+    gcc->priv->speed_fastest = encoder_speed_properties[i].fastest;
+    g_object_get (encoder, gcc->priv->speed_property,
+        &gcc->priv->speed_initial, NULL);
+    break;
+  }
+  gst_object_unref (encoder);
+}
+
+static void
+gst_camera_capturer_start_adaptation (GstCameraCapturer * gcc)
+{
+  /* Remuxed streams are not encoded */
+  if (!gcc->priv->adaptive_quality || gcc->priv->video_needs_keyframe_sync)
+    return;
+
+  gst_camera_capturer_find_speed_property (gcc);
+  if (gcc->priv->speed_element == NULL) {
+    if (gcc->priv->adaptation_filter == NULL) {
+      GST_INFO_OBJECT (gcc, "Nothing can be adapted while encoding");
+      return;
+    }
+    GST_INFO_OBJECT (gcc, "The encoder speed can't be changed while "
+        "encoding, only the resolution will be adapted");
+  }
+  gcc->priv->adaptation_id = g_timeout_add (ADAPTATION_INTERVAL,
+      (GSourceFunc) gst_camera_capturer_check_load, gcc);
+}
+
+void
+gst_camera_capturer_set_adaptive_quality (GstCameraCapturer * gcc,
+    gboolean enabled)
+{
+  g_return_if_fail (GST_IS_CAMERA_CAPTURER (gcc));
+  g_return_if_fail (gcc->priv->encoder_bin == NULL);
+
+  gcc->priv->adaptive_quality = enabled;
+}
+
 void
 gst_camera_capturer_expose (GstCameraCapturer * gcc)
 {
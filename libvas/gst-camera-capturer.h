@@ -34,6 +34,8 @@
 #include <glib-object.h>
 #include <gdk/gdk.h>
 #include "lgm-utils.h"
+#include "lgm-frame-ring.h"
+#include "lgm-timeshift.h"
 
 G_BEGIN_DECLS
 #define GST_TYPE_CAMERA_CAPTURER             (gst_camera_capturer_get_type ())
@@ -47,6 +49,27 @@ typedef struct _GstCameraCapturerClass GstCameraCapturerClass;
 typedef struct _GstCameraCapturer GstCameraCapturer;
 typedef struct GstCameraCapturerPrivate GstCameraCapturerPrivate;
 
+/* Health of a live capture, times are in nanoseconds */
+typedef struct
+{
+  guint64 video_frames_in;
+  guint64 video_frames_encoded;
+  guint64 video_frames_dropped;
+  guint64 audio_buffers_in;
+  guint64 audio_buffers_encoded;
+  guint64 audio_buffers_dropped;
+  guint64 video_appsrc_level;        /* bytes */
+  guint64 video_appsrc_max_level;    /* bytes */
+  guint64 audio_queue_level;
+  guint64 audio_queue_max_level;
+  guint64 encoder_latency;           /* GST_CLOCK_TIME_NONE if unknown */
+  gint64 av_drift;                   /* video minus audio */
+  guint64 bytes_written;
+  guint64 adaptation_level;          /* 0 is the configured quality */
+  guint64 adaptations;
+  guint64 cpu_time;                  /* used by the process */
+} LgmCaptureStats;
+
 
 struct _GstCameraCapturerClass
 {
@@ -57,6 +80,7 @@ struct _GstCameraCapturerClass
   void (*device_change) (GstCameraCapturer * gcc, gint *device_change);
   void (*media_info) (GstCameraCapturer * gcc, gint width, gint height, gint par_n, gint par_d);
   void (*ready_to_capture) (GstCameraCapturer * gcc);
+  void (*stats) (GstCameraCapturer * gcc, LgmCaptureStats * stats);
 };
 
 struct _GstCameraCapturer
@@ -98,6 +122,25 @@ EXPORT void gst_camera_capturer_toggle_pause              (GstCameraCapturer * g
 
 EXPORT void gst_camera_capturer_stop                      (GstCameraCapturer * gcc);
 
+/* Uses a clock and base time shared with other capturers, so that their
+ * buffers have the same running time. Must be called before running */
+EXPORT void gst_camera_capturer_set_clock                 (GstCameraCapturer * gcc,
+                                                           GstClock * clock,
+                                                           GstClockTime base_time);
+
+/* Like start, toggle_pause and stop, but switching exactly on the buffers
+ * captured at the running time passed */
+EXPORT void gst_camera_capturer_start_at                  (GstCameraCapturer * gcc,
+                                                           GstClockTime start);
+
+EXPORT void gst_camera_capturer_toggle_pause_at           (GstCameraCapturer * gcc,
+                                                           GstClockTime time);
+
+/* Returns without waiting, the capture stops from the main loop once the
+ * buffers captured before the stop time are queued */
+EXPORT void gst_camera_capturer_stop_at                   (GstCameraCapturer * gcc,
+                                                           GstClockTime time);
+
 EXPORT void gst_camera_capturer_expose                    (GstCameraCapturer * gcc);
 
 EXPORT GList *gst_camera_capturer_enum_audio_devices      (const gchar *device);
@@ -106,6 +149,47 @@ EXPORT GList *gst_camera_capturer_enum_video_devices      (const gchar *device);
 
 EXPORT GdkPixbuf *gst_camera_capturer_get_current_frame   (GstCameraCapturer * gcc);
 
+/* Copies the current frame in data, see bvw_frame_conv_grab () */
+EXPORT gboolean gst_camera_capturer_grab_frame            (GstCameraCapturer * gcc,
+                                                           LgmFrameFormat format,
+                                                           guint8 * data,
+                                                           gsize * size,
+                                                           gint * width,
+                                                           gint * height);
+
+/* Keeps the last duration seconds of encoded video in memory to replay
+ * them while recording, without the audio. Must be called before starting */
+EXPORT void gst_camera_capturer_set_timeshift_duration    (GstCameraCapturer * gcc,
+                                                           guint duration);
+
+/* Returns a new reference, or NULL if the timeshift is disabled or the
+ * capture didn't start yet */
+EXPORT LgmTimeshiftBuffer *gst_camera_capturer_get_timeshift_buffer
+                                                          (GstCameraCapturer * gcc);
+
+/* Lowers the encoder speed preset and the capture resolution when the
+ * encoder can't keep up, and restores them when the load drops. Must be
+ * called before starting */
+EXPORT void gst_camera_capturer_set_adaptive_quality      (GstCameraCapturer * gcc,
+                                                           gboolean enabled);
+
+/* Sets what to do with new frames when the encoder can't keep up */
+EXPORT void gst_camera_capturer_set_drop_policy           (GstCameraCapturer * gcc,
+                                                           LgmFrameRingPolicy policy);
+
+/* Gets the frames waiting to be encoded and the video frames dropped */
+EXPORT void gst_camera_capturer_get_queue_stats           (GstCameraCapturer * gcc,
+                                                           guint * depth,
+                                                           guint * max_depth,
+                                                           guint64 * dropped);
+
+EXPORT void gst_camera_capturer_get_stats                 (GstCameraCapturer * gcc,
+                                                           LgmCaptureStats * stats);
+
+/* Emits the "stats" signal every interval ms, 0 disables it */
+EXPORT void gst_camera_capturer_set_stats_interval        (GstCameraCapturer * gcc,
+                                                           guint interval);
+
 EXPORT void gst_camera_capturer_unref_pixbuf               (GdkPixbuf * pixbuf);
 
 G_END_DECLS
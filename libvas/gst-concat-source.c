@@ -0,0 +1,681 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+* Gstreamer concat source
+* Copyright (C) Fluendo S.A. 2016
+*
+* You may redistribute it and/or modify it under the terms of the
+* GNU General Public License, as published by the Free Software
+* Foundation; either version 2 of the License, or (at your option)
+* any later version.
+*
+* Gstreamer concat source is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with foob.  If not, write to:
+*       The Free Software Foundation, Inc.,
+*       51 Franklin Street, Fifth Floor
+*       Boston, MA  02110-1301, USA.
+*/
+
+/* Concatenates already encoded parts into a single stream without decoding
+ * them. Each part is demuxed in its own pipeline and the compressed buffers
+ * are retimestamped and pushed through the "video" and "audio" source pads,
+ * which are linked directly to a muxer. All the parts must share the same
+ * format and decoder configuration, which is the case for parts encoded with
+ * the same settings. Muxers don't accept caps changes, so a part with a
+ * different format fails with a GST_STREAM_ERROR_FORMAT error, letting the
+ * application encode the parts again. The AAC parts encoded by the editor
+ * are trimmed at the joins: the frame of encoder priming at the start and the
+ * padded frame at the end are dropped, so that the audio follows the video
+ * without gaps. */
+
+#include <string.h>
+#include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
+#include <gst/app/gstappsink.h>
+
+#include "lgm-utils.h"
+#include "gst-concat-source.h"
+
+GST_DEBUG_CATEGORY (_concatsrc_gst_debug_cat);
+#define GST_CAT_DEFAULT _concatsrc_gst_debug_cat
+
+static GstStaticPadTemplate video_src_tpl = GST_STATIC_PAD_TEMPLATE ("video",
+    GST_PAD_SRC,
+    GST_PAD_SOMETIMES,
+    GST_STATIC_CAPS_ANY);
+
+static GstStaticPadTemplate audio_src_tpl = GST_STATIC_PAD_TEMPLATE ("audio",
+    GST_PAD_SRC,
+    GST_PAD_SOMETIMES,
+    GST_STATIC_CAPS_ANY);
+
+typedef struct
+{
+  gchar *file_path;
+  guint64 start;
+  guint64 stop;
+} GstConcatPart;
+
+static GstBinClass *parent_class = NULL;
+
+static void gst_concat_source_dispose (GObject * object);
+static GstStateChangeReturn gst_concat_source_change_state
+    (GstElement * element, GstStateChange transition);
+
+G_DEFINE_TYPE (GstConcatSource, gst_concat_source, GST_TYPE_BIN);
+
+static GstConcatPart *
+gst_concat_source_part_new (const gchar * file_path, guint64 start,
+    guint64 stop)
+{
+  GstConcatPart *part;
+
+  part = g_new0 (GstConcatPart, 1);
+  part->file_path = g_strdup (file_path);
+  part->start = start;
+  part->stop = stop;
+
+  return part;
+}
+
+static void
+gst_concat_source_part_free (GstConcatPart * part)
+{
+  if (part->file_path != NULL)
+    g_free (part->file_path);
+  g_free (part);
+}
+
+static void
+gst_concat_source_init (GstConcatSource * csrc)
+{
+  csrc->video_srcpad = gst_ghost_pad_new_no_target_from_template ("video",
+      gst_static_pad_template_get (&video_src_tpl));
+  csrc->audio_srcpad = gst_ghost_pad_new_no_target_from_template ("audio",
+      gst_static_pad_template_get (&audio_src_tpl));
+  g_mutex_init (&csrc->lock);
+}
+
+static void
+gst_concat_source_class_init (GstConcatSourceClass * klass)
+{
+  GObjectClass *object_class;
+  GstElementClass *element_class;
+
+  object_class = (GObjectClass *) klass;
+  element_class = (GstElementClass *) klass;
+  parent_class = g_type_class_peek_parent (klass);
+
+  /* GObject */
+  object_class->dispose = gst_concat_source_dispose;
+
+  /* GstElement */
+  element_class->change_state = gst_concat_source_change_state;
+
+  GST_DEBUG_CATEGORY_INIT (_concatsrc_gst_debug_cat, "longomatch", 0,
+      "LongoMatch GStreamer Backend");
+}
+
+static void
+gst_concat_source_dispose (GObject * object)
+{
+  GstConcatSource *csrc = GST_CONCAT_SOURCE (object);
+
+  if (csrc->parts != NULL) {
+    g_list_free_full (csrc->parts,
+        (GDestroyNotify) gst_concat_source_part_free);
+    csrc->parts = NULL;
+  }
+
+  gst_buffer_replace (&csrc->pending_audio, NULL);
+
+  if (csrc->video_srcpad != NULL) {
+    gst_object_unref (csrc->video_srcpad);
+    csrc->video_srcpad = NULL;
+  }
+  if (csrc->audio_srcpad != NULL) {
+    gst_object_unref (csrc->audio_srcpad);
+    csrc->audio_srcpad = NULL;
+  }
+
+  G_OBJECT_CLASS (parent_class)->dispose (object);
+}
+
+static GstElement *
+gst_concat_source_create_appsrc (GstConcatSource * csrc, GstPad * ghostpad)
+{
+  GstElement *appsrc;
+  GstPad *pad;
+
+  appsrc = gst_element_factory_make ("appsrc", NULL);
+  /* Block when the muxer is not consuming to avoid reading the whole part
+   * in memory */
+  g_object_set (appsrc, "format", GST_FORMAT_TIME, "block", TRUE,
+      "max-bytes", (guint64) 8 * 1024 * 1024, NULL);
+  gst_bin_add (GST_BIN (csrc), appsrc);
+
+  pad = gst_element_get_static_pad (appsrc, "src");
+  gst_ghost_pad_set_target (GST_GHOST_PAD (ghostpad), pad);
+  gst_object_unref (pad);
+
+  return appsrc;
+}
+
+static void
+gst_concat_source_setup (GstConcatSource * csrc)
+{
+  csrc->video_appsrc = gst_concat_source_create_appsrc (csrc,
+      csrc->video_srcpad);
+  if (csrc->with_audio) {
+    csrc->audio_appsrc = gst_concat_source_create_appsrc (csrc,
+        csrc->audio_srcpad);
+  }
+  csrc->index = -1;
+  csrc->offset = 0;
+  csrc->flushing = FALSE;
+}
+
+static GstFlowReturn
+gst_concat_source_push_to_appsrc (GstConcatSource * csrc, GstBuffer * buf,
+    gboolean is_audio)
+{
+  GstFlowReturn ret;
+
+  ret = gst_app_src_push_buffer (GST_APP_SRC (is_audio ? csrc->audio_appsrc :
+          csrc->video_appsrc), buf);
+  if (ret != GST_FLOW_OK) {
+    GST_WARNING_OBJECT (csrc, "pushing buffer returned %s",
+        gst_flow_get_name (ret));
+  }
+  return ret;
+}
+
+static GstFlowReturn
+gst_concat_source_push_buffer (GstConcatSource * csrc, GstBuffer * buf,
+    gboolean is_audio)
+{
+  GstConcatPart *part;
+  guint64 ts, duration, new_ts, trim = 0;
+  GstBuffer *pending = NULL;
+
+  part = (GstConcatPart *) g_list_nth_data (csrc->parts, csrc->index);
+  ts = GST_BUFFER_TIMESTAMP (buf);
+
+  g_mutex_lock (&csrc->lock);
+
+  if (!GST_CLOCK_TIME_IS_VALID (ts)) {
+    /* Headers and buffers without timestamps use the previous one */
+    ts = is_audio ? csrc->base_ts : csrc->last_video_ts;
+  }
+
+  if (!GST_CLOCK_TIME_IS_VALID (csrc->base_ts)) {
+    /* The part starts with the first video keyframe */
+    if ((is_audio && csrc->video_linked) ||
+        GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT)) {
+      goto drop;
+    }
+    csrc->base_ts = ts;
+  }
+
+  if (ts < csrc->base_ts ||
+      (GST_CLOCK_TIME_IS_VALID (part->stop) && ts >= part->stop)) {
+    goto drop;
+  }
+
+  if (is_audio && csrc->trim_audio) {
+    /* The first frame only holds the encoder priming, the rest of the audio
+     * is moved back by one frame to stay in sync with the video */
+    if (!csrc->priming_trimmed) {
+      csrc->priming_trimmed = TRUE;
+      goto drop;
+    }
+    trim = csrc->aac_frame_duration;
+    if (ts < csrc->base_ts + trim)
+      goto drop;
+  }
+
+  new_ts = csrc->offset + ts - csrc->base_ts - trim;
+
+  if (GST_BUFFER_DURATION_IS_VALID (buf)) {
+    duration = GST_BUFFER_DURATION (buf);
+  } else if (is_audio) {
+    duration = csrc->trim_audio ? csrc->aac_frame_duration : 0;
+  } else {
+    duration = csrc->video_frame_duration;
+  }
+  if (!is_audio) {
+    if (GST_CLOCK_TIME_IS_VALID (csrc->last_video_ts) &&
+        ts > csrc->last_video_ts) {
+      csrc->video_frame_duration = ts - csrc->last_video_ts;
+    }
+    csrc->last_video_ts = ts;
+  }
+  /* The trimmed audio never goes beyond the video, which sets the start of
+   * the next part */
+  if (!is_audio || !csrc->trim_audio || !csrc->video_linked)
+    csrc->end_ts = MAX (csrc->end_ts, new_ts + duration);
+
+  buf = gst_buffer_make_metadata_writable (buf);
+  GST_BUFFER_TIMESTAMP (buf) = new_ts;
+  GST_BUFFER_DURATION (buf) = duration;
+
+  if (is_audio && csrc->trim_audio) {
+    /* The last frame is padded by the encoder, so each frame is held until
+     * the next one arrives or the part ends */
+    pending = csrc->pending_audio;
+    csrc->pending_audio = buf;
+    buf = pending;
+  }
+
+  g_mutex_unlock (&csrc->lock);
+
+  if (buf == NULL)
+    return GST_FLOW_OK;
+
+  GST_LOG_OBJECT (csrc, "Pushing %s buffer with ts: %" GST_TIME_FORMAT
+      " orig:%" GST_TIME_FORMAT, is_audio ? "audio" : "video",
+      GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (buf)), GST_TIME_ARGS (ts));
+  return gst_concat_source_push_to_appsrc (csrc, buf, is_audio);
+
+drop:
+  GST_LOG_OBJECT (csrc, "Discard %s buffer with ts: %" GST_TIME_FORMAT,
+      is_audio ? "audio" : "video", GST_TIME_ARGS (ts));
+  g_mutex_unlock (&csrc->lock);
+  gst_buffer_unref (buf);
+  return GST_FLOW_OK;
+}
+
+/* Pushes the last audio frame of a trimmed part, unless most of it is the
+ * padding beyond the end of the video */
+static void
+gst_concat_source_flush_audio (GstConcatSource * csrc)
+{
+  GstBuffer *buf;
+
+  g_mutex_lock (&csrc->lock);
+  buf = csrc->pending_audio;
+  csrc->pending_audio = NULL;
+  g_mutex_unlock (&csrc->lock);
+
+  if (buf == NULL)
+    return;
+
+  if (csrc->video_linked &&
+      GST_BUFFER_TIMESTAMP (buf) + GST_BUFFER_DURATION (buf) / 2 >
+      csrc->end_ts) {
+    GST_DEBUG_OBJECT (csrc, "Discard padded audio frame with ts: %"
+        GST_TIME_FORMAT, GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (buf)));
+    gst_buffer_unref (buf);
+    return;
+  }
+  gst_concat_source_push_to_appsrc (csrc, buf, TRUE);
+}
+
+static GstFlowReturn
+gst_concat_source_on_preroll_buffer (GstAppSink * appsink, gpointer data)
+{
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+gst_concat_source_on_video_buffer (GstAppSink * appsink, gpointer data)
+{
+  return gst_concat_source_push_buffer (GST_CONCAT_SOURCE (data),
+      gst_app_sink_pull_buffer (appsink), FALSE);
+}
+
+static GstFlowReturn
+gst_concat_source_on_audio_buffer (GstAppSink * appsink, gpointer data)
+{
+  return gst_concat_source_push_buffer (GST_CONCAT_SOURCE (data),
+      gst_app_sink_pull_buffer (appsink), TRUE);
+}
+
+/* Parts without a start were encoded from the beginning by the editor. With
+ * AAC they start with the 1024 samples of priming of the encoder, which
+ * would add a gap at every join */
+static void
+gst_concat_source_check_trim_audio (GstConcatSource * csrc, GstCaps * caps)
+{
+  GstConcatPart *part;
+  GstStructure *s;
+  gint mpegversion = 0, rate = 0;
+
+  part = (GstConcatPart *) g_list_nth_data (csrc->parts, csrc->index);
+  if (GST_CLOCK_TIME_IS_VALID (part->start))
+    return;
+
+  s = gst_caps_get_structure (caps, 0);
+  if (!gst_structure_has_name (s, "audio/mpeg") ||
+      !gst_structure_get_int (s, "mpegversion", &mpegversion) ||
+      mpegversion != 4 || !gst_structure_get_int (s, "rate", &rate) ||
+      rate <= 0)
+    return;
+
+  csrc->trim_audio = TRUE;
+  csrc->aac_frame_duration = gst_util_uint64_scale_int (1024, GST_SECOND,
+      rate);
+}
+
+static void
+gst_concat_source_pad_added_cb (GstElement * uridecodebin, GstPad * pad,
+    GstConcatSource * csrc)
+{
+  GstCaps *caps, *parser_caps = NULL;
+  const gchar *mime;
+  GstElement *appsink = NULL, *parser = NULL, *reader;
+  GstAppSinkCallbacks appsink_cbs;
+  GstPad *sink_pad;
+
+  caps = gst_pad_get_caps_reffed (pad);
+  mime = gst_structure_get_name (gst_caps_get_structure (caps, 0));
+  GST_DEBUG_OBJECT (csrc, "Found mime type: %s", mime);
+
+  memset (&appsink_cbs, 0, sizeof (appsink_cbs));
+  appsink_cbs.new_preroll = gst_concat_source_on_preroll_buffer;
+
+  if (g_str_has_prefix (mime, "video") && !csrc->video_linked) {
+    appsink = gst_element_factory_make ("appsink", "video_sink");
+    appsink_cbs.new_buffer = gst_concat_source_on_video_buffer;
+    /* Output the same stream format for all the parts */
+    parser = lgm_create_video_parser (mime, &parser_caps);
+    csrc->video_linked = TRUE;
+  } else if (g_str_has_prefix (mime, "audio") && csrc->with_audio
+      && !csrc->audio_linked) {
+    appsink = gst_element_factory_make ("appsink", "audio_sink");
+    appsink_cbs.new_buffer = gst_concat_source_on_audio_buffer;
+    csrc->audio_linked = TRUE;
+    gst_concat_source_check_trim_audio (csrc, caps);
+  }
+  gst_caps_unref (caps);
+
+  if (appsink == NULL) {
+    return;
+  }
+
+  reader = GST_ELEMENT (gst_object_get_parent (GST_OBJECT (uridecodebin)));
+  g_object_set (appsink, "sync", FALSE, NULL);
+  gst_app_sink_set_callbacks (GST_APP_SINK (appsink), &appsink_cbs, csrc,
+      NULL);
+  gst_bin_add (GST_BIN (reader), appsink);
+  if (parser != NULL) {
+    gst_bin_add (GST_BIN (reader), parser);
+    if (parser_caps != NULL) {
+      gst_element_link_filtered (parser, appsink, parser_caps);
+      gst_caps_unref (parser_caps);
+    } else {
+      gst_element_link (parser, appsink);
+    }
+    gst_element_sync_state_with_parent (parser);
+    sink_pad = gst_element_get_static_pad (parser, "sink");
+  } else {
+    sink_pad = gst_element_get_static_pad (appsink, "sink");
+  }
+  gst_pad_link (pad, sink_pad);
+  gst_element_sync_state_with_parent (appsink);
+  gst_object_unref (sink_pad);
+  gst_object_unref (reader);
+}
+
+/* Exposes the source pad with the caps of the first part. The following
+ * parts must have the same caps, since the muxer can't change them */
+static gboolean
+gst_concat_source_add_pad (GstConcatSource * csrc, GstElement * reader,
+    const gchar * sink_name, GstElement * appsrc, GstPad * srcpad,
+    gboolean * added)
+{
+  GstElement *appsink;
+  GstBuffer *buf;
+  GstCaps *caps;
+  gboolean ret = TRUE;
+
+  appsink = gst_bin_get_by_name (GST_BIN (reader), sink_name);
+  if (appsink == NULL) {
+    return TRUE;
+  }
+
+  buf = gst_app_sink_pull_preroll (GST_APP_SINK (appsink));
+  gst_object_unref (appsink);
+  if (buf == NULL) {
+    return TRUE;
+  }
+
+  if (*added) {
+    caps = gst_app_src_get_caps (GST_APP_SRC (appsrc));
+    ret = lgm_caps_can_concat (caps, GST_BUFFER_CAPS (buf));
+    if (!ret) {
+      GST_WARNING_OBJECT (csrc, "Part with caps %" GST_PTR_FORMAT
+          " can't follow %" GST_PTR_FORMAT, GST_BUFFER_CAPS (buf), caps);
+    }
+    if (caps != NULL)
+      gst_caps_unref (caps);
+  } else {
+    GST_DEBUG_OBJECT (csrc, "Adding pad with caps %" GST_PTR_FORMAT,
+        GST_BUFFER_CAPS (buf));
+    gst_app_src_set_caps (GST_APP_SRC (appsrc), GST_BUFFER_CAPS (buf));
+    gst_pad_set_active (srcpad, TRUE);
+    gst_element_add_pad (GST_ELEMENT (csrc), gst_object_ref (srcpad));
+    *added = TRUE;
+  }
+  gst_buffer_unref (buf);
+  return ret;
+}
+
+static gboolean
+gst_concat_source_wait_eos (GstConcatSource * csrc, GstElement * reader)
+{
+  GstBus *bus;
+  GstMessage *msg;
+  gboolean ret = FALSE;
+
+  bus = gst_element_get_bus (reader);
+  while (!csrc->flushing) {
+    msg = gst_bus_timed_pop_filtered (bus, 100 * GST_MSECOND,
+        GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+    if (msg == NULL)
+      continue;
+    ret = GST_MESSAGE_TYPE (msg) == GST_MESSAGE_EOS;
+    gst_message_unref (msg);
+    break;
+  }
+  gst_object_unref (bus);
+  return ret;
+}
+
+/* Reads a part, returning GST_FLOW_NOT_NEGOTIATED if its format is not the
+ * one of the first part */
+static GstFlowReturn
+gst_concat_source_read_part (GstConcatSource * csrc, GstConcatPart * part)
+{
+  GstElement *reader, *uridecodebin;
+  GstStateChangeReturn ret;
+  GstCaps *caps;
+  gchar *uri;
+  GstFlowReturn res = GST_FLOW_ERROR;
+
+  GST_INFO_OBJECT (csrc, "Reading part %s start:%" GST_TIME_FORMAT " stop:%"
+      GST_TIME_FORMAT, part->file_path, GST_TIME_ARGS (part->start),
+      GST_TIME_ARGS (part->stop));
+
+  csrc->video_linked = FALSE;
+  csrc->audio_linked = FALSE;
+  csrc->base_ts = GST_CLOCK_TIME_NONE;
+  csrc->last_video_ts = GST_CLOCK_TIME_NONE;
+  csrc->video_frame_duration = 0;
+  csrc->end_ts = csrc->offset;
+  csrc->trim_audio = FALSE;
+  csrc->priming_trimmed = FALSE;
+  csrc->aac_frame_duration = 0;
+
+  reader = gst_pipeline_new ("concat-reader");
+  uridecodebin = gst_element_factory_make ("uridecodebin", NULL);
+  uri = lgm_filename_to_uri (part->file_path);
+  /* Decoding stops at these caps, the parts are read in compressed form */
+  caps = gst_caps_from_string (LGM_COMPRESSED_CAPS);
+  g_object_set (uridecodebin, "uri", uri, "caps", caps, NULL);
+  gst_caps_unref (caps);
+  g_free (uri);
+  g_signal_connect (uridecodebin, "pad-added",
+      G_CALLBACK (gst_concat_source_pad_added_cb), csrc);
+  gst_bin_add (GST_BIN (reader), uridecodebin);
+
+  gst_element_set_state (reader, GST_STATE_PAUSED);
+  ret = gst_element_get_state (reader, NULL, NULL, 10 * GST_SECOND);
+  if (ret != GST_STATE_CHANGE_SUCCESS) {
+    GST_ERROR_OBJECT (csrc, "Could not pre-roll part %s", part->file_path);
+    goto done;
+  }
+
+  if (GST_CLOCK_TIME_IS_VALID (part->start) && part->start > 0) {
+    /* Compressed streams can only start at a keyframe */
+    gst_element_seek (reader, 1, GST_FORMAT_TIME,
+        GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT,
+        GST_SEEK_TYPE_SET, part->start,
+        GST_CLOCK_TIME_IS_VALID (part->stop) ? GST_SEEK_TYPE_SET :
+        GST_SEEK_TYPE_NONE, part->stop);
+    gst_element_get_state (reader, NULL, NULL, 10 * GST_SECOND);
+  }
+
+  if (csrc->video_linked &&
+      !gst_concat_source_add_pad (csrc, reader, "video_sink",
+          csrc->video_appsrc, csrc->video_srcpad,
+          &csrc->video_srcpad_added)) {
+    res = GST_FLOW_NOT_NEGOTIATED;
+    goto done;
+  }
+  if (csrc->audio_linked &&
+      !gst_concat_source_add_pad (csrc, reader, "audio_sink",
+          csrc->audio_appsrc, csrc->audio_srcpad,
+          &csrc->audio_srcpad_added)) {
+    res = GST_FLOW_NOT_NEGOTIATED;
+    goto done;
+  }
+  if (csrc->index == 0) {
+    gst_element_no_more_pads (GST_ELEMENT (csrc));
+  }
+
+  gst_element_set_state (reader, GST_STATE_PLAYING);
+  if (gst_concat_source_wait_eos (csrc, reader))
+    res = GST_FLOW_OK;
+
+done:
+  gst_element_set_state (reader, GST_STATE_NULL);
+  gst_object_unref (reader);
+
+  if (res == GST_FLOW_OK)
+    gst_concat_source_flush_audio (csrc);
+  else
+    gst_buffer_replace (&csrc->pending_audio, NULL);
+
+  /* The next part starts where the longest stream of this one ended */
+  csrc->offset = csrc->end_ts;
+  return res;
+}
+
+static gpointer
+gst_concat_source_loop (GstConcatSource * csrc)
+{
+  GstConcatPart *part;
+  GstFlowReturn ret;
+
+  for (csrc->index = 0; csrc->index < g_list_length (csrc->parts);
+      csrc->index++) {
+    part = (GstConcatPart *) g_list_nth_data (csrc->parts, csrc->index);
+    ret = gst_concat_source_read_part (csrc, part);
+    if (ret == GST_FLOW_NOT_NEGOTIATED) {
+      GST_ELEMENT_ERROR (csrc, STREAM, FORMAT,
+          ("Part %s has a different format than the previous ones",
+              part->file_path), (NULL));
+      return NULL;
+    } else if (ret != GST_FLOW_OK) {
+      if (!csrc->flushing) {
+        GST_ELEMENT_ERROR (csrc, STREAM, FAILED,
+            ("Could not read part %s", part->file_path), (NULL));
+      }
+      return NULL;
+    }
+  }
+
+  GST_INFO_OBJECT (csrc, "All parts concatenated, pushing eos");
+  gst_app_src_end_of_stream (GST_APP_SRC (csrc->video_appsrc));
+  if (csrc->audio_appsrc != NULL) {
+    gst_app_src_end_of_stream (GST_APP_SRC (csrc->audio_appsrc));
+  }
+  return NULL;
+}
+
+static GstStateChangeReturn
+gst_concat_source_change_state (GstElement * element,
+    GstStateChange transition)
+{
+  GstConcatSource *csrc;
+  GstStateChangeReturn res;
+
+  csrc = GST_CONCAT_SOURCE (element);
+
+  switch (transition) {
+    case GST_STATE_CHANGE_NULL_TO_READY:
+      gst_concat_source_setup (csrc);
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      /* Unblocks the reading thread */
+      csrc->flushing = TRUE;
+      break;
+    default:
+      break;
+  }
+
+  res = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+  if (res == GST_STATE_CHANGE_FAILURE)
+    return res;
+
+  switch (transition) {
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      csrc->thread = g_thread_new ("concat",
+          (GThreadFunc) gst_concat_source_loop, csrc);
+      /* Pads are exposed once the first part is pre-rolled */
+      res = GST_STATE_CHANGE_NO_PREROLL;
+      break;
+    case GST_STATE_CHANGE_PAUSED_TO_READY:
+      if (csrc->thread != NULL) {
+        g_thread_join (csrc->thread);
+        csrc->thread = NULL;
+      }
+      break;
+    default:
+      break;
+  }
+
+  return res;
+}
+
+void
+gst_concat_source_add_part (GstConcatSource * csrc, const gchar * file_path,
+    guint64 start, guint64 stop)
+{
+  csrc->parts = g_list_append (csrc->parts,
+      gst_concat_source_part_new (file_path, start, stop));
+
+  GST_INFO_OBJECT (csrc, "Added new part %s start:%" GST_TIME_FORMAT
+      " stop:%" GST_TIME_FORMAT, file_path, GST_TIME_ARGS (start),
+      GST_TIME_ARGS (stop));
+}
+
+void
+gst_concat_source_configure (GstConcatSource * csrc, gboolean with_audio)
+{
+  csrc->with_audio = with_audio;
+}
+
+GstConcatSource *
+gst_concat_source_new (void)
+{
+  GstConcatSource *csrc;
+
+  csrc = g_object_new (GST_TYPE_CONCAT_SOURCE, NULL);
+  return csrc;
+}
@@ -0,0 +1,98 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * Gstreamer concat source
+ * Copyright (C) Fluendo S.A. 2016
+ *
+ * You may redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * foob is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with foob.  If not, write to:
+ *     The Free Software Foundation, Inc.,
+ *     51 Franklin Street, Fifth Floor
+ *     Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _GST_CONCAT_SOURCE_H_
+#define _GST_CONCAT_SOURCE_H_
+
+#ifdef WIN32
+#define EXPORT __declspec (dllexport)
+#else
+#define EXPORT
+#endif
+
+#include <glib-object.h>
+#include "lgm-utils.h"
+
+G_BEGIN_DECLS
+#define GST_TYPE_CONCAT_SOURCE             (gst_concat_source_get_type ())
+#define GST_CONCAT_SOURCE(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_CONCAT_SOURCE, GstConcatSource))
+#define GST_CONCAT_SOURCE_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST ((klass), GST_TYPE_CONCAT_SOURCE, GstConcatSourceClass))
+#define GST_IS_CONCAT_SOURCE(obj)          (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_CONCAT_SOURCE))
+#define GST_IS_CONCAT_SOURCE_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), GST_TYPE_CONCAT_SOURCE))
+#define GST_CONCAT_SOURCE_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), GST_TYPE_CONCAT_SOURCE, GstConcatSourceClass))
+typedef struct _GstConcatSourceClass GstConcatSourceClass;
+typedef struct _GstConcatSource GstConcatSource;
+
+struct _GstConcatSourceClass
+{
+  GstBinClass parent_class;
+};
+
+struct _GstConcatSource
+{
+  GstBin parent;
+
+  gboolean with_audio;
+
+  GstElement *video_appsrc;
+  GstElement *audio_appsrc;
+  GstPad *video_srcpad;
+  GstPad *audio_srcpad;
+  gboolean video_srcpad_added;
+  gboolean audio_srcpad_added;
+
+  GList *parts;
+  gint index;
+  GThread *thread;
+  gboolean flushing;
+  GMutex lock;
+
+  /* Current part */
+  gboolean video_linked;
+  gboolean audio_linked;
+  guint64 offset;
+  guint64 base_ts;
+  guint64 end_ts;
+  guint64 last_video_ts;
+  guint64 video_frame_duration;
+  /* AAC parts encoded by the editor start with the encoder priming and end
+   * with a padded frame, which are removed at the joins */
+  gboolean trim_audio;
+  gboolean priming_trimmed;
+  guint64 aac_frame_duration;
+  GstBuffer *pending_audio;
+};
+
+EXPORT GType gst_concat_source_get_type (void) G_GNUC_CONST;
+
+EXPORT GstConcatSource *gst_concat_source_new (void);
+
+EXPORT void gst_concat_source_configure (GstConcatSource * csrc,
+                                         gboolean with_audio);
+
+EXPORT void gst_concat_source_add_part (GstConcatSource * csrc,
+                                        const gchar * file_path,
+                                        guint64 start,
+                                        guint64 stop);
+
+G_END_DECLS
+#endif /* _GST_CONCAT_SOURCE_H_ */
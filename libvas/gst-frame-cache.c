@@ -0,0 +1,318 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+* Gstreamer decoded frames cache
+* Copyright (C) Fluendo S.A. 2018
+*
+* You may redistribute it and/or modify it under the terms of the
+* GNU General Public License, as published by the Free Software
+* Foundation; either version 2 of the License, or (at your option)
+* any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, write to:
+*       The Free Software Foundation, Inc.,
+*       51 Franklin Street, Fifth Floor
+*       Boston, MA  02110-1301, USA.
+*/
+
+#include "gst-frame-cache.h"
+
+GST_DEBUG_CATEGORY_STATIC (_frame_cache_gst_debug_cat);
+#define GST_CAT_DEFAULT _frame_cache_gst_debug_cat
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw-yuv; video/x-raw-rgb"));
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS ("video/x-raw-yuv; video/x-raw-rgb"));
+
+G_DEFINE_TYPE (GstFrameCache, gst_frame_cache, GST_TYPE_ELEMENT);
+
+/* Must be called with the object lock */
+static void
+gst_frame_cache_clear (GstFrameCache * cache)
+{
+  g_ptr_array_set_size (cache->frames, 0);
+  cache->bytes = 0;
+  cache->cursor = -1;
+  cache->pending_steps = 0;
+}
+
+/* Must be called with the object lock */
+static void
+gst_frame_cache_add (GstFrameCache * cache, GstBuffer * buf)
+{
+  g_ptr_array_add (cache->frames, gst_buffer_ref (buf));
+  cache->bytes += GST_BUFFER_SIZE (buf);
+
+  /* Drop the oldest frames, the ones further from the position */
+  while (cache->frames->len > 1 && (cache->frames->len > cache->max_frames
+          || cache->bytes > cache->max_bytes)) {
+    GstBuffer *old = g_ptr_array_index (cache->frames, 0);
+
+    cache->bytes -= GST_BUFFER_SIZE (old);
+    g_ptr_array_remove_index (cache->frames, 0);
+  }
+  cache->cursor = cache->frames->len - 1;
+}
+
+/* Gets the next frame to push for the steps requested, must be called with
+ * the object lock */
+static GstBuffer *
+gst_frame_cache_next_step (GstFrameCache * cache)
+{
+  if (cache->pending_steps < 0 && cache->cursor > 0) {
+    cache->pending_steps++;
+    cache->cursor--;
+  } else if (cache->pending_steps > 0 &&
+      cache->cursor + 1 < cache->frames->len) {
+    cache->pending_steps--;
+    cache->cursor++;
+  } else {
+    /* Forward steps past the newest frame are done by upstream */
+    cache->pending_steps = 0;
+    return NULL;
+  }
+  return gst_buffer_ref (g_ptr_array_index (cache->frames, cache->cursor));
+}
+
+static gboolean
+gst_frame_cache_sink_event (GstPad * pad, GstEvent * event)
+{
+  GstFrameCache *cache = GST_FRAME_CACHE (gst_pad_get_parent (pad));
+  gboolean ret;
+
+  if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP) {
+    GST_OBJECT_LOCK (cache);
+    gst_frame_cache_clear (cache);
+    GST_OBJECT_UNLOCK (cache);
+  }
+  ret = gst_pad_event_default (pad, event);
+
+  gst_object_unref (cache);
+  return ret;
+}
+
+/* Frames are allocated by the sink, as if the cache wasn't there */
+static GstFlowReturn
+gst_frame_cache_buffer_alloc (GstPad * pad, guint64 offset, guint size,
+    GstCaps * caps, GstBuffer ** buf)
+{
+  GstFrameCache *cache = GST_FRAME_CACHE (gst_pad_get_parent (pad));
+  GstFlowReturn ret;
+
+  if (cache == NULL)
+    return GST_FLOW_WRONG_STATE;
+
+  ret = gst_pad_alloc_buffer (cache->srcpad, offset, size, caps, buf);
+
+  gst_object_unref (cache);
+  return ret;
+}
+
+static GstFlowReturn
+gst_frame_cache_chain (GstPad * pad, GstBuffer * buf)
+{
+  GstFrameCache *cache = GST_FRAME_CACHE (GST_PAD_PARENT (pad));
+  GstClockTime end;
+  GstFlowReturn ret;
+
+  GST_OBJECT_LOCK (cache);
+  if (cache->enabled)
+    gst_frame_cache_add (cache, buf);
+
+  if (GST_CLOCK_TIME_IS_VALID (cache->fill_until)) {
+    end = GST_BUFFER_TIMESTAMP (buf);
+    if (GST_BUFFER_DURATION_IS_VALID (buf))
+      end += GST_BUFFER_DURATION (buf);
+    if (GST_BUFFER_TIMESTAMP_IS_VALID (buf) && end <= cache->fill_until) {
+      GST_OBJECT_UNLOCK (cache);
+      gst_buffer_unref (buf);
+      return GST_FLOW_OK;
+    }
+    GST_DEBUG_OBJECT (cache, "Filled %u frames up to %" GST_TIME_FORMAT,
+        cache->frames->len, GST_TIME_ARGS (cache->fill_until));
+    cache->fill_until = GST_CLOCK_TIME_NONE;
+  }
+  GST_OBJECT_UNLOCK (cache);
+
+  ret = gst_pad_push (cache->srcpad, buf);
+
+  /* The sink returns when it's stepped, the steps requested in the
+   * meantime are served from the cache */
+  while (ret == GST_FLOW_OK) {
+    GST_OBJECT_LOCK (cache);
+    buf = gst_frame_cache_next_step (cache);
+    GST_OBJECT_UNLOCK (cache);
+    if (buf == NULL)
+      break;
+    GST_LOG_OBJECT (cache, "Pushing cached frame %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (buf)));
+    ret = gst_pad_push (cache->srcpad, buf);
+  }
+  return ret;
+}
+
+static GstStateChangeReturn
+gst_frame_cache_change_state (GstElement * element, GstStateChange transition)
+{
+  GstFrameCache *cache = GST_FRAME_CACHE (element);
+  GstStateChangeReturn ret;
+
+  ret = GST_ELEMENT_CLASS (gst_frame_cache_parent_class)->change_state
+      (element, transition);
+
+  if (transition == GST_STATE_CHANGE_PAUSED_TO_READY) {
+    GST_OBJECT_LOCK (cache);
+    gst_frame_cache_clear (cache);
+    cache->fill_until = GST_CLOCK_TIME_NONE;
+    GST_OBJECT_UNLOCK (cache);
+  }
+  return ret;
+}
+
+static void
+gst_frame_cache_finalize (GObject * object)
+{
+  GstFrameCache *cache = GST_FRAME_CACHE (object);
+
+  g_ptr_array_free (cache->frames, TRUE);
+
+  G_OBJECT_CLASS (gst_frame_cache_parent_class)->finalize (object);
+}
+
+static void
+gst_frame_cache_class_init (GstFrameCacheClass * klass)
+{
+  GObjectClass *object_class = (GObjectClass *) klass;
+  GstElementClass *element_class = (GstElementClass *) klass;
+
+  object_class->finalize = gst_frame_cache_finalize;
+  element_class->change_state = gst_frame_cache_change_state;
+
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&sink_template));
+  gst_element_class_add_pad_template (element_class,
+      gst_static_pad_template_get (&src_template));
+
+  GST_DEBUG_CATEGORY_INIT (_frame_cache_gst_debug_cat, "longomatch", 0,
+      "LongoMatch GStreamer Backend");
+}
+
+static void
+gst_frame_cache_init (GstFrameCache * cache)
+{
+  cache->sinkpad = gst_pad_new_from_static_template (&sink_template, "sink");
+  gst_pad_set_getcaps_function (cache->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_pad_proxy_getcaps));
+  gst_pad_set_setcaps_function (cache->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_pad_proxy_setcaps));
+  gst_pad_set_event_function (cache->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_frame_cache_sink_event));
+  gst_pad_set_chain_function (cache->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_frame_cache_chain));
+  gst_pad_set_bufferalloc_function (cache->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_frame_cache_buffer_alloc));
+  gst_element_add_pad (GST_ELEMENT (cache), cache->sinkpad);
+
+  cache->srcpad = gst_pad_new_from_static_template (&src_template, "src");
+  gst_pad_set_getcaps_function (cache->srcpad,
+      GST_DEBUG_FUNCPTR (gst_pad_proxy_getcaps));
+  gst_element_add_pad (GST_ELEMENT (cache), cache->srcpad);
+
+  cache->frames =
+      g_ptr_array_new_with_free_func ((GDestroyNotify) gst_buffer_unref);
+  cache->max_frames = G_MAXUINT;
+  cache->max_bytes = G_MAXUINT64;
+  cache->fill_until = GST_CLOCK_TIME_NONE;
+  gst_frame_cache_clear (cache);
+}
+
+/* Keeps at most max_frames frames and max_bytes of frames */
+GstElement *
+gst_frame_cache_new (guint max_frames, guint64 max_bytes)
+{
+  GstFrameCache *cache;
+
+  cache = g_object_new (GST_TYPE_FRAME_CACHE, NULL);
+  cache->max_frames = MAX (max_frames, 1);
+  cache->max_bytes = max_bytes;
+  return GST_ELEMENT (cache);
+}
+
+/* Frames are only cached while enabled, which is while paused or stepping.
+ * Disabling the cache drops the cached frames */
+void
+gst_frame_cache_set_enabled (GstFrameCache * cache, gboolean enabled)
+{
+  g_return_if_fail (GST_IS_FRAME_CACHE (cache));
+
+  GST_OBJECT_LOCK (cache);
+  if (cache->enabled && !enabled) {
+    gst_frame_cache_clear (cache);
+    cache->fill_until = GST_CLOCK_TIME_NONE;
+  }
+  cache->enabled = enabled;
+  GST_OBJECT_UNLOCK (cache);
+}
+
+/* Requests a step to the previous (direction < 0) or next frame, to be done
+ * with a step event to the sink. Returns FALSE if the previous frame isn't
+ * cached. Forward steps past the newest frame are always possible and
+ * decoded by upstream. */
+gboolean
+gst_frame_cache_step (GstFrameCache * cache, gint direction)
+{
+  gboolean ret = TRUE;
+  gint cursor;
+
+  g_return_val_if_fail (GST_IS_FRAME_CACHE (cache), FALSE);
+
+  GST_OBJECT_LOCK (cache);
+  cursor = cache->cursor + cache->pending_steps;
+  if (direction < 0) {
+    ret = cursor > 0;
+    if (ret)
+      cache->pending_steps--;
+  } else if (cursor + 1 < cache->frames->len) {
+    cache->pending_steps++;
+  }
+  GST_OBJECT_UNLOCK (cache);
+  return ret;
+}
+
+/* After the next flush, the frames decoded before until are only cached and
+ * the first one reaching it is pushed. Used with a keyframe seek to decode
+ * a whole GOP once while seeking to a frame. */
+void
+gst_frame_cache_fill (GstFrameCache * cache, GstClockTime until)
+{
+  g_return_if_fail (GST_IS_FRAME_CACHE (cache));
+
+  GST_OBJECT_LOCK (cache);
+  cache->fill_until = until;
+  GST_OBJECT_UNLOCK (cache);
+}
+
+/* Whether the frame displayed is the newest one decoded */
+gboolean
+gst_frame_cache_is_live (GstFrameCache * cache)
+{
+  gboolean ret;
+
+  g_return_val_if_fail (GST_IS_FRAME_CACHE (cache), TRUE);
+
+  GST_OBJECT_LOCK (cache);
+  ret = cache->cursor + cache->pending_steps + 1 >= (gint) cache->frames->len;
+  GST_OBJECT_UNLOCK (cache);
+  return ret;
+}
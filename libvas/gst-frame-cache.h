@@ -0,0 +1,82 @@
+/*
+* Gstreamer decoded frames cache
+* Copyright (C) Fluendo S.A. 2018
+*
+* You may redistribute it and/or modify it under the terms of the
+* GNU General Public License, as published by the Free Software
+* Foundation; either version 2 of the License, or (at your option)
+* any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+* See the GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, write to:
+*       The Free Software Foundation, Inc.,
+*       51 Franklin Street, Fifth Floor
+*       Boston, MA  02110-1301, USA.
+*/
+
+#ifndef _GST_FRAME_CACHE_H_
+#define _GST_FRAME_CACHE_H_
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+#define GST_TYPE_FRAME_CACHE             (gst_frame_cache_get_type ())
+#define GST_FRAME_CACHE(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_FRAME_CACHE, GstFrameCache))
+#define GST_FRAME_CACHE_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST ((klass), GST_TYPE_FRAME_CACHE, GstFrameCacheClass))
+#define GST_IS_FRAME_CACHE(obj)          (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_FRAME_CACHE))
+#define GST_IS_FRAME_CACHE_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), GST_TYPE_FRAME_CACHE))
+typedef struct _GstFrameCacheClass GstFrameCacheClass;
+typedef struct _GstFrameCache GstFrameCache;
+
+struct _GstFrameCacheClass
+{
+  GstElementClass parent_class;
+};
+
+/* Placed before the video sink, keeps the last decoded frames so that the
+ * player can step backward and forward among them without seeking and
+ * decoding again from the previous keyframe. A step is served by pushing
+ * the cached frame when the sink releases the displayed one after a step
+ * event. */
+struct _GstFrameCache
+{
+  GstElement parent;
+
+  GstPad *sinkpad;
+  GstPad *srcpad;
+
+  /* Frames in timestamp order, the last one is the newest frame received */
+  GPtrArray *frames;
+  guint64 bytes;
+  guint max_frames;
+  guint64 max_bytes;
+  /* Index of the frame displayed */
+  gint cursor;
+  /* Frames to step when the sink releases the displayed one, negative
+   * backward */
+  gint pending_steps;
+  /* Frames ending before this time are only cached, not pushed */
+  GstClockTime fill_until;
+  /* Frames are only cached while paused or stepping */
+  gboolean enabled;
+};
+
+GType gst_frame_cache_get_type (void) G_GNUC_CONST;
+
+GstElement *gst_frame_cache_new (guint max_frames, guint64 max_bytes);
+
+void gst_frame_cache_set_enabled (GstFrameCache * cache, gboolean enabled);
+
+gboolean gst_frame_cache_step (GstFrameCache * cache, gint direction);
+
+void gst_frame_cache_fill (GstFrameCache * cache, GstClockTime until);
+
+gboolean gst_frame_cache_is_live (GstFrameCache * cache);
+
+G_END_DECLS
+#endif /* _GST_FRAME_CACHE_H_ */
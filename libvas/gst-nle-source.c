@@ -37,9 +37,9 @@
 GST_DEBUG_CATEGORY (_nlesrc_gst_debug_cat);
 #define GST_CAT_DEFAULT _nlesrc_gst_debug_cat
 
-#define CHANNELS 2
+#define CHANNELS GST_NLE_SOURCE_AUDIO_CHANNELS
 #define DEPTH 16
-#define RATE 44100
+#define RATE GST_NLE_SOURCE_AUDIO_RATE
 #define BITS_PER_SAMPLE DEPTH*CHANNELS*RATE
 #define AUDIO_CAPS_STR "audio/x-raw-int, endianness=1234, signed=true, "\
       " width=16, depth=16, rate=44100, channels=2"
@@ -64,17 +64,19 @@ static GstStaticPadTemplate audio_src_tpl = GST_STATIC_PAD_TEMPLATE ("audio",
     GST_PAD_SOMETIMES,
     GST_STATIC_CAPS (AUDIO_CAPS_STR));
 
+/* State of a decoder pipeline, attached to the pipeline as "nle-decoder".
+ * Decoders are created for the current item or, when a lookahead is
+ * configured, pre-rolled in advance for the following items */
 typedef struct
 {
-  gchar *file_path;
-  gchar *title;
-  guint64 start;
-  guint64 stop;
-  guint64 duration;
-  gfloat rate;
-  gboolean still_picture;
-  GstNleRectangle roi;
-} GstNleSrcItem;
+  GstNleSource *nlesrc;
+  GstElement *pipeline;
+  GstElement *source;
+  gint index;
+  gboolean video_linked;
+  gboolean audio_linked;
+  gboolean no_more_pads;
+} GstNleDecoder;
 
 static GstBinClass *parent_class = NULL;
 
@@ -84,9 +86,11 @@ static GstStateChangeReturn gst_nle_source_change_state
 static void gst_nle_source_next (GstNleSource * nlesrc);
 static void gst_nle_source_next_threaded (GstNleSource * nlesrc);
 static void gst_nle_source_no_more_pads (GstElement * element,
-    GstNleSource * nlesrc);
+    GstNleDecoder * dec);
 static void gst_nle_source_pad_added_cb (GstElement * element, GstPad * pad,
-    GstNleSource * nlesrc);
+    GstNleDecoder * dec);
+static void gst_nle_source_clear_prefetched (GstNleSource * nlesrc);
+static void gst_nle_source_stop_prefetch (GstNleSource * nlesrc);
 
 G_DEFINE_TYPE (GstNleSource, gst_nle_source, GST_TYPE_BIN);
 
@@ -146,6 +150,9 @@ gst_nle_source_init (GstNleSource * nlesrc)
   gst_element_add_pad (GST_ELEMENT (nlesrc),
       gst_object_ref (nlesrc->audio_sinkpad));
   g_mutex_init (&nlesrc->stream_lock);
+  g_mutex_init (&nlesrc->prefetch_lock);
+  g_cond_init (&nlesrc->prefetch_cond);
+  nlesrc->prefetch_index = -1;
 }
 
 static void
@@ -170,11 +177,14 @@ gst_nle_source_class_init (GstNleSourceClass * klass)
 
 static void
 gst_nle_source_bus_message (GstBus * bus, GstMessage * message,
-    GstNleSource * nlesrc)
+    GstNleDecoder * dec)
 {
   switch (message->type) {
     case GST_MESSAGE_ERROR:
-      gst_nle_source_next_threaded (nlesrc);
+      /* Errors in pre-rolled decoders are handled when they are promoted */
+      if (dec->pipeline == dec->nlesrc->decoder) {
+        gst_nle_source_next_threaded (dec->nlesrc);
+      }
       break;
     default:
       break;
@@ -186,6 +196,8 @@ gst_nle_source_dispose (GObject * object)
 {
   GstNleSource *nlesrc = GST_NLE_SOURCE (object);
 
+  gst_nle_source_stop_prefetch (nlesrc);
+
   if (nlesrc->queue != NULL) {
     g_list_free_full (nlesrc->queue, (GDestroyNotify) gst_nle_source_item_free);
     nlesrc->queue = NULL;
@@ -202,6 +214,10 @@ gst_nle_source_dispose (GObject * object)
     nlesrc->decoder = NULL;
   }
 
+  g_mutex_lock (&nlesrc->prefetch_lock);
+  gst_nle_source_clear_prefetched (nlesrc);
+  g_mutex_unlock (&nlesrc->prefetch_lock);
+
   gst_object_unref (nlesrc->video_srcpad);
   gst_object_unref (nlesrc->video_sinkpad);
   gst_object_unref (nlesrc->audio_srcpad);
@@ -410,6 +426,23 @@ gst_nle_source_update_videocrop (GstNleSource * nlesrc, GstCaps * caps)
       "top", top, "bottom", bottom, NULL);
 }
 
+static void
+gst_nle_source_post_switch_time (GstNleSource * nlesrc, gint64 switch_time)
+{
+  GstStructure *s;
+
+  GST_INFO_OBJECT (nlesrc, "Switched to item %d in %" G_GINT64_FORMAT
+      " us (prefetched:%d)", nlesrc->index, switch_time,
+      nlesrc->switch_prefetched);
+
+  s = gst_structure_new ("nle-segment-switch",
+      "index", G_TYPE_INT, nlesrc->index,
+      "latency", G_TYPE_UINT64, (guint64) switch_time * GST_USECOND,
+      "prefetched", G_TYPE_BOOLEAN, nlesrc->switch_prefetched, NULL);
+  gst_element_post_message (GST_ELEMENT (nlesrc),
+      gst_message_new_element (GST_OBJECT (nlesrc), s));
+}
+
 static GstFlowReturn
 gst_nle_source_push_buffer (GstNleSource * nlesrc, GstBuffer * buf,
     gboolean is_audio)
@@ -419,6 +452,7 @@ gst_nle_source_push_buffer (GstNleSource * nlesrc, GstBuffer * buf,
   guint64 buf_ts, buf_rel_ts, last_ts;
   GstNleSrcItem *item;
   GstFlowReturn ret;
+  gint64 switch_time = 0;
 
   item = (GstNleSrcItem *) g_list_nth_data (nlesrc->queue, nlesrc->index);
   buf_ts = GST_BUFFER_TIMESTAMP (buf);
@@ -469,11 +503,19 @@ gst_nle_source_push_buffer (GstNleSource * nlesrc, GstBuffer * buf,
       gst_nle_source_update_videocrop (nlesrc, GST_BUFFER_CAPS (buf));
       gst_nle_source_update_overlay_title (nlesrc);
       nlesrc->item_setup = TRUE;
+      if (nlesrc->switch_start != 0) {
+        switch_time = g_get_monotonic_time () - nlesrc->switch_start;
+        nlesrc->switch_start = 0;
+      }
     }
 
     /* We need to unlock before pushing since push_buffer can block */
     g_mutex_unlock (&nlesrc->stream_lock);
 
+    if (switch_time != 0) {
+      gst_nle_source_post_switch_time (nlesrc, switch_time);
+    }
+
     ret = gst_pad_chain (sinkpad, buf);
     if (ret != GST_FLOW_OK) {
       GST_WARNING_OBJECT (nlesrc, "pushing buffer returned %s",
@@ -507,8 +549,16 @@ gst_nle_source_audio_silence_buf (GstNleSource * nlesrc, guint64 start,
 }
 
 static void
-gst_nle_source_no_more_pads (GstElement * element, GstNleSource * nlesrc)
+gst_nle_source_no_more_pads (GstElement * element, GstNleDecoder * dec)
 {
+  GstNleSource *nlesrc = dec->nlesrc;
+
+  /* Pre-rolled decoders fill the gap once they become the current one */
+  if (dec->pipeline != nlesrc->decoder) {
+    dec->no_more_pads = TRUE;
+    return;
+  }
+
   /* If the input stream doesn't contain audio or it's a still picture we fill
    * the gap with a dummy audio buffer with silence */
   if (nlesrc->with_audio && !nlesrc->audio_linked) {
@@ -555,55 +605,77 @@ gst_nle_source_on_preroll_buffer (GstAppSink * appsink, gpointer data)
   return GST_FLOW_OK;
 }
 
+/* The picture is only pushed for the first and the last frame of the
+ * segment. videorate, which is the last element of the conversion chain,
+ * fills the gap between them duplicating the converted frame instead of
+ * copying and converting the picture for every output frame */
 static GstFlowReturn
 gst_nle_source_push_still_picture (GstNleSource * nlesrc, GstNleSrcItem * item,
     GstBuffer * buf)
 {
   GstCaps *bcaps, *ncaps;
+  GstBuffer *last_buf = NULL;
   guint64 buf_dur;
-  gint i, n_bufs;
+  gint n_bufs;
   GstFlowReturn ret = GST_FLOW_OK;
 
   buf_dur = GST_SECOND * nlesrc->fps_d / nlesrc->fps_n;
   n_bufs = item->duration / buf_dur;
+  if (n_bufs == 0) {
+    gst_buffer_unref (buf);
+    return ret;
+  }
 
   bcaps = gst_buffer_get_caps (buf);
   ncaps = gst_caps_make_writable (bcaps);
   gst_caps_set_simple (ncaps, "pixel-aspect-ratio", GST_TYPE_FRACTION,
       1, 1, NULL);
+  buf = gst_buffer_make_metadata_writable (buf);
   gst_buffer_set_caps (buf, ncaps);
   gst_caps_unref (ncaps);
 
+  if (n_bufs > 1) {
+    /* Shares the memory of the picture */
+    last_buf = gst_buffer_create_sub (buf, 0, GST_BUFFER_SIZE (buf));
+    GST_BUFFER_TIMESTAMP (last_buf) = item->start + buf_dur * (n_bufs - 1);
+    GST_BUFFER_DURATION (last_buf) = buf_dur;
+  }
+
   nlesrc->video_seek_done = TRUE;
-  for (i = 0; i < n_bufs; i++) {
-    GstBuffer *new_buf;
+  GST_BUFFER_TIMESTAMP (buf) = item->start;
+  GST_BUFFER_DURATION (buf) = buf_dur;
+  ret = gst_nle_source_push_buffer (nlesrc, buf, FALSE);
 
-    new_buf = gst_buffer_copy (buf);
-    GST_BUFFER_TIMESTAMP (new_buf) = item->start + buf_dur * i;
-    GST_BUFFER_DURATION (new_buf) = buf_dur;
-    ret = gst_nle_source_push_buffer (nlesrc, new_buf, FALSE);
+  if (last_buf != NULL) {
     if (ret <= GST_FLOW_UNEXPECTED) {
-      break;
+      gst_buffer_unref (last_buf);
+    } else {
+      ret = gst_nle_source_push_buffer (nlesrc, last_buf, FALSE);
     }
   }
 
-  gst_buffer_unref (buf);
   return ret;
 }
 
 static GstFlowReturn
 gst_nle_source_on_video_buffer (GstAppSink * appsink, gpointer data)
 {
+  GstNleDecoder *dec = data;
+  GstNleSource *nlesrc = dec->nlesrc;
   GstNleSrcItem *item;
-  GstNleSource *nlesrc;
   GstBuffer *buf;
   GstFlowReturn ret;
 
-  nlesrc = GST_NLE_SOURCE (data);
-  item = (GstNleSrcItem *) g_list_nth_data (nlesrc->queue, nlesrc->index);
-
   buf = gst_app_sink_pull_buffer (appsink);
 
+  /* Buffers of a decoder that is no longer the current one are dropped */
+  if (dec->pipeline != nlesrc->decoder) {
+    gst_buffer_unref (buf);
+    return GST_FLOW_OK;
+  }
+
+  item = (GstNleSrcItem *) g_list_nth_data (nlesrc->queue, dec->index);
+
   if (item->still_picture) {
     ret = gst_nle_source_push_still_picture (nlesrc, item, buf);
   } else {
@@ -616,10 +688,16 @@ gst_nle_source_on_video_buffer (GstAppSink * appsink, gpointer data)
 static GstFlowReturn
 gst_nle_source_on_audio_buffer (GstAppSink * appsink, gpointer data)
 {
-  GstNleSource *nlesrc = GST_NLE_SOURCE (data);
+  GstNleDecoder *dec = data;
+  GstBuffer *buf;
+
+  buf = gst_app_sink_pull_buffer (appsink);
+  if (dec->pipeline != dec->nlesrc->decoder) {
+    gst_buffer_unref (buf);
+    return GST_FLOW_OK;
+  }
 
-  return gst_nle_source_push_buffer (nlesrc,
-      gst_app_sink_pull_buffer (appsink), TRUE);
+  return gst_nle_source_push_buffer (dec->nlesrc, buf, TRUE);
 }
 
 static void
@@ -630,6 +708,7 @@ gst_nle_source_check_eos (GstNleSource * nlesrc)
     nlesrc->audio_eos = FALSE;
     nlesrc->video_eos = FALSE;
     nlesrc->cached_duration = 0;
+    nlesrc->switch_start = g_get_monotonic_time ();
     GST_DEBUG_OBJECT (nlesrc, "All pads are EOS");
     gst_nle_source_next_threaded (nlesrc);
   }
@@ -639,7 +718,11 @@ gst_nle_source_check_eos (GstNleSource * nlesrc)
 static void
 gst_nle_source_on_video_eos (GstAppSink * appsink, gpointer data)
 {
-  GstNleSource *nlesrc = GST_NLE_SOURCE (data);
+  GstNleDecoder *dec = data;
+  GstNleSource *nlesrc = dec->nlesrc;
+
+  if (dec->pipeline != nlesrc->decoder)
+    return;
 
   GST_DEBUG_OBJECT (nlesrc, "Video pad is EOS");
   nlesrc->video_eos = TRUE;
@@ -649,7 +732,11 @@ gst_nle_source_on_video_eos (GstAppSink * appsink, gpointer data)
 static void
 gst_nle_source_on_audio_eos (GstAppSink * appsink, gpointer data)
 {
-  GstNleSource *nlesrc = GST_NLE_SOURCE (data);
+  GstNleDecoder *dec = data;
+  GstNleSource *nlesrc = dec->nlesrc;
+
+  if (dec->pipeline != nlesrc->decoder)
+    return;
 
   GST_DEBUG_OBJECT (nlesrc, "Audio pad is EOS");
   nlesrc->audio_eos = TRUE;
@@ -658,9 +745,12 @@ gst_nle_source_on_audio_eos (GstAppSink * appsink, gpointer data)
 
 static gboolean
 gst_nle_source_video_pad_probe_cb (GstPad * pad, GstEvent * event,
-    GstNleSource * nlesrc)
+    GstNleDecoder * dec)
 {
-  if (event->type == GST_EVENT_NEWSEGMENT) {
+  GstNleSource *nlesrc = dec->nlesrc;
+
+  if (event->type == GST_EVENT_NEWSEGMENT
+      && dec->pipeline == nlesrc->decoder) {
     g_mutex_lock (&nlesrc->stream_lock);
     if (!nlesrc->video_seek_done && nlesrc->seek_done) {
       GST_DEBUG_OBJECT (nlesrc, "NEWSEGMENT on the video pad");
@@ -674,9 +764,12 @@ gst_nle_source_video_pad_probe_cb (GstPad * pad, GstEvent * event,
 
 static gboolean
 gst_nle_source_audio_pad_probe_cb (GstPad * pad, GstEvent * event,
-    GstNleSource * nlesrc)
+    GstNleDecoder * dec)
 {
-  if (event->type == GST_EVENT_NEWSEGMENT) {
+  GstNleSource *nlesrc = dec->nlesrc;
+
+  if (event->type == GST_EVENT_NEWSEGMENT
+      && dec->pipeline == nlesrc->decoder) {
     g_mutex_lock (&nlesrc->stream_lock);
     if (!nlesrc->audio_seek_done && nlesrc->seek_done) {
       GST_DEBUG_OBJECT (nlesrc, "NEWSEGMENT on the audio pad");
@@ -689,8 +782,9 @@ gst_nle_source_audio_pad_probe_cb (GstPad * pad, GstEvent * event,
 
 static void
 gst_nle_source_pad_added_cb (GstElement * element, GstPad * pad,
-    GstNleSource * nlesrc)
+    GstNleDecoder * dec)
 {
+  GstNleSource *nlesrc = dec->nlesrc;
   GstCaps *caps;
   const GstStructure *s;
   const gchar *mime;
@@ -698,21 +792,23 @@ gst_nle_source_pad_added_cb (GstElement * element, GstPad * pad,
   GstPad *sink_pad;
   GstAppSinkCallbacks appsink_cbs;
   GstNleSrcItem *item;
+  gboolean is_current;
 
-  item = (GstNleSrcItem *) g_list_nth_data (nlesrc->queue, nlesrc->index);
+  item = (GstNleSrcItem *) g_list_nth_data (nlesrc->queue, dec->index);
+  is_current = dec->pipeline == nlesrc->decoder;
 
   caps = gst_pad_get_caps_reffed (pad);
   s = gst_caps_get_structure (caps, 0);
   mime = gst_structure_get_name (s);
   GST_DEBUG_OBJECT (nlesrc, "Found mime type: %s", mime);
 
-  if (g_strrstr (mime, "video") && !nlesrc->video_linked) {
+  if (g_strrstr (mime, "video") && !dec->video_linked) {
     appsink = gst_element_factory_make ("appsink", NULL);
     memset (&appsink_cbs, 0, sizeof (appsink_cbs));
     appsink_cbs.eos = gst_nle_source_on_video_eos;
     appsink_cbs.new_preroll = gst_nle_source_on_preroll_buffer;
     appsink_cbs.new_buffer = gst_nle_source_on_video_buffer;
-    nlesrc->video_linked = TRUE;
+    dec->video_linked = TRUE;
     if (!nlesrc->video_srcpad_added) {
       gst_pad_set_active (nlesrc->video_srcpad, TRUE);
       gst_element_add_pad (GST_ELEMENT (nlesrc),
@@ -720,16 +816,19 @@ gst_nle_source_pad_added_cb (GstElement * element, GstPad * pad,
       nlesrc->video_srcpad_added = TRUE;
     }
     gst_pad_add_event_probe (GST_BASE_SINK_PAD (GST_BASE_SINK (appsink)),
-        (GCallback) gst_nle_source_video_pad_probe_cb, nlesrc);
-    nlesrc->video_eos = FALSE;
+        (GCallback) gst_nle_source_video_pad_probe_cb, dec);
+    if (is_current) {
+      nlesrc->video_linked = TRUE;
+      nlesrc->video_eos = FALSE;
+    }
   } else if (g_strrstr (mime, "audio") && nlesrc->with_audio
-      && !nlesrc->audio_linked && (item ? item->rate == 1.0 : TRUE)) {
+      && !dec->audio_linked && (item ? item->rate == 1.0 : TRUE)) {
     appsink = gst_element_factory_make ("appsink", NULL);
     memset (&appsink_cbs, 0, sizeof (appsink_cbs));
     appsink_cbs.eos = gst_nle_source_on_audio_eos;
     appsink_cbs.new_preroll = gst_nle_source_on_preroll_buffer;
     appsink_cbs.new_buffer = gst_nle_source_on_audio_buffer;
-    nlesrc->audio_linked = TRUE;
+    dec->audio_linked = TRUE;
     if (!nlesrc->audio_srcpad_added) {
       gst_pad_set_active (nlesrc->audio_srcpad, TRUE);
       gst_element_add_pad (GST_ELEMENT (nlesrc),
@@ -737,14 +836,17 @@ gst_nle_source_pad_added_cb (GstElement * element, GstPad * pad,
       nlesrc->audio_srcpad_added = TRUE;
     }
     gst_pad_add_event_probe (GST_BASE_SINK_PAD (GST_BASE_SINK (appsink)),
-        (GCallback) gst_nle_source_audio_pad_probe_cb, nlesrc);
-    nlesrc->audio_eos = FALSE;
+        (GCallback) gst_nle_source_audio_pad_probe_cb, dec);
+    if (is_current) {
+      nlesrc->audio_linked = TRUE;
+      nlesrc->audio_eos = FALSE;
+    }
   }
   if (appsink != NULL) {
     g_object_set (appsink, "sync", FALSE, NULL);
-    gst_app_sink_set_callbacks (GST_APP_SINK (appsink), &appsink_cbs, nlesrc,
+    gst_app_sink_set_callbacks (GST_APP_SINK (appsink), &appsink_cbs, dec,
         NULL);
-    gst_bin_add (GST_BIN (nlesrc->decoder), appsink);
+    gst_bin_add (GST_BIN (dec->pipeline), appsink);
     sink_pad = gst_element_get_static_pad (appsink, "sink");
     gst_pad_link (pad, sink_pad);
     gst_element_sync_state_with_parent (appsink);
@@ -770,8 +872,18 @@ gst_nle_source_next_threaded (GstNleSource * nlesrc)
 
 static void
 gst_nle_source_on_source_setup (GstElement * uridecodebin, GstElement * source,
-    GstNleSource * nlesrc)
+    GstNleDecoder * dec)
 {
+  GstNleSource *nlesrc = dec->nlesrc;
+
+  if (dec->pipeline != nlesrc->decoder) {
+    if (dec->source != NULL) {
+      gst_object_unref (dec->source);
+    }
+    dec->source = g_object_ref (source);
+    return;
+  }
+
   if (nlesrc->source != NULL) {
     gst_object_unref (nlesrc->source);
     nlesrc->source = NULL;
@@ -779,61 +891,331 @@ gst_nle_source_on_source_setup (GstElement * uridecodebin, GstElement * source,
   nlesrc->source = g_object_ref (source);
 }
 
-static void
-gst_nle_source_next (GstNleSource * nlesrc)
+static GstNleDecoder *
+gst_nle_source_get_decoder (GstElement * pipeline)
+{
+  return (GstNleDecoder *) g_object_get_data (G_OBJECT (pipeline),
+      "nle-decoder");
+}
+
+static GstElement *
+gst_nle_source_create_decoder (GstNleSource * nlesrc, gint index)
 {
   GstNleSrcItem *item;
-  GstStateChangeReturn ret;
-  GstElement *uridecodebin;
+  GstNleDecoder *dec;
+  GstElement *pipeline, *uridecodebin;
   GstBus *bus;
-  GstState state;
 
-  nlesrc->index++;
+  item = (GstNleSrcItem *) g_list_nth_data (nlesrc->queue, index);
 
-  if (nlesrc->index >= g_list_length (nlesrc->queue)) {
-    gst_nle_source_push_eos (nlesrc);
-    return;
-  }
-
-  if (nlesrc->source != NULL) {
-    gst_object_unref (nlesrc->source);
-    nlesrc->source = NULL;
-  }
+  pipeline = gst_pipeline_new ("decoder");
+  dec = g_new0 (GstNleDecoder, 1);
+  dec->nlesrc = nlesrc;
+  dec->pipeline = pipeline;
+  dec->index = index;
+  g_object_set_data_full (G_OBJECT (pipeline), "nle-decoder", dec, g_free);
 
-  if (nlesrc->decoder != NULL) {
-    gst_element_set_state (GST_ELEMENT (nlesrc->decoder), GST_STATE_NULL);
-    gst_element_get_state (GST_ELEMENT (nlesrc->decoder), NULL, NULL, 0);
-    gst_object_unref (nlesrc->decoder);
-  }
-
-  nlesrc->decoder = gst_pipeline_new ("decoder");
   uridecodebin = gst_element_factory_make ("uridecodebin", NULL);
   /* Connect signal to recover source element for queries in bytes */
   g_signal_connect (uridecodebin, "source-setup",
-      G_CALLBACK (gst_nle_source_on_source_setup), nlesrc); 
+      G_CALLBACK (gst_nle_source_on_source_setup), dec);
 
-  gst_bin_add (GST_BIN (nlesrc->decoder), uridecodebin);
+  gst_bin_add (GST_BIN (pipeline), uridecodebin);
 
   g_signal_connect (uridecodebin, "autoplug-select",
       G_CALLBACK (lgm_filter_video_decoders), nlesrc);
   g_signal_connect (uridecodebin, "pad-added",
-      G_CALLBACK (gst_nle_source_pad_added_cb), nlesrc);
+      G_CALLBACK (gst_nle_source_pad_added_cb), dec);
   g_signal_connect (uridecodebin, "no-more-pads",
-      G_CALLBACK (gst_nle_source_no_more_pads), nlesrc);
+      G_CALLBACK (gst_nle_source_no_more_pads), dec);
 
-  bus = GST_ELEMENT_BUS (nlesrc->decoder);
+  bus = GST_ELEMENT_BUS (pipeline);
   gst_bus_add_signal_watch (bus);
   g_signal_connect (bus, "message", G_CALLBACK (gst_nle_source_bus_message),
-      nlesrc);
-  item = (GstNleSrcItem *) g_list_nth_data (nlesrc->queue, nlesrc->index);
-
-  GST_INFO_OBJECT (nlesrc, "Starting next item with uri:%s", item->file_path);
-  GST_INFO_OBJECT (nlesrc, "start:%" GST_TIME_FORMAT " stop:%"
-      GST_TIME_FORMAT " rate:%f", GST_TIME_ARGS (item->start),
-      GST_TIME_ARGS (item->stop), item->rate);
+      dec);
 
   g_object_set (uridecodebin, "uri", item->file_path, NULL);
 
+  return pipeline;
+}
+
+static void
+gst_nle_source_destroy_decoder (GstElement * pipeline)
+{
+  GstNleDecoder *dec;
+  GstBus *bus;
+
+  dec = gst_nle_source_get_decoder (pipeline);
+  bus = GST_ELEMENT_BUS (pipeline);
+  g_signal_handlers_disconnect_by_func (bus, gst_nle_source_bus_message, dec);
+  gst_bus_remove_signal_watch (bus);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_element_get_state (pipeline, NULL, NULL, 0);
+  if (dec->source != NULL) {
+    gst_object_unref (dec->source);
+    dec->source = NULL;
+  }
+  gst_object_unref (pipeline);
+}
+
+/* Pre-rolls a decoder in PAUSED with an accurate flushing seek to the start
+ * of its item, so that it can start pushing buffers as soon as it's set to
+ * PLAYING */
+static gboolean
+gst_nle_source_preroll_decoder (GstNleSource * nlesrc, GstElement * pipeline)
+{
+  GstNleDecoder *dec;
+  GstNleSrcItem *item;
+  GstStateChangeReturn ret;
+
+  dec = gst_nle_source_get_decoder (pipeline);
+  item = (GstNleSrcItem *) g_list_nth_data (nlesrc->queue, dec->index);
+
+  GST_DEBUG_OBJECT (nlesrc, "Pre-rolling item %d with uri:%s", dec->index,
+      item->file_path);
+
+  gst_element_set_state (pipeline, GST_STATE_PAUSED);
+  ret = gst_element_get_state (pipeline, NULL, NULL, 5 * GST_SECOND);
+  if (ret != GST_STATE_CHANGE_SUCCESS) {
+    GST_WARNING_OBJECT (nlesrc, "Could not pre-roll item %d", dec->index);
+    return FALSE;
+  }
+
+  if (!item->still_picture && GST_CLOCK_TIME_IS_VALID (item->stop)) {
+    if (!gst_element_seek (pipeline, 1, GST_FORMAT_TIME,
+            GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE,
+            GST_SEEK_TYPE_SET, item->start, GST_SEEK_TYPE_SET, item->stop)) {
+      GST_WARNING_OBJECT (nlesrc, "Could not seek item %d", dec->index);
+      return FALSE;
+    }
+    ret = gst_element_get_state (pipeline, NULL, NULL, 5 * GST_SECOND);
+    if (ret != GST_STATE_CHANGE_SUCCESS) {
+      GST_WARNING_OBJECT (nlesrc, "Could not pre-roll item %d after seeking",
+          dec->index);
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+/* A decoder can be kept for the next item when it reads the same file and
+ * its streams were linked in the same way, only seeking it is needed */
+static gboolean
+gst_nle_source_can_reuse_decoder (GstNleSrcItem * prev, GstNleSrcItem * item)
+{
+  if (prev == NULL || item == NULL)
+    return FALSE;
+  if (prev->still_picture || item->still_picture)
+    return FALSE;
+  if (!GST_CLOCK_TIME_IS_VALID (prev->stop) ||
+      !GST_CLOCK_TIME_IS_VALID (item->stop))
+    return FALSE;
+  /* Audio is only linked for items played at normal rate */
+  if ((prev->rate == 1.0) != (item->rate == 1.0))
+    return FALSE;
+  return g_strcmp0 (prev->file_path, item->file_path) == 0;
+}
+
+/* Must be called with the prefetch lock. Returns the next item within the
+ * lookahead that needs a pre-rolled decoder, or -1 if there is none */
+static gint
+gst_nle_source_next_to_prefetch (GstNleSource * nlesrc)
+{
+  gint index, last;
+
+  last = MIN (nlesrc->index + (gint) nlesrc->lookahead,
+      (gint) g_list_length (nlesrc->queue) - 1);
+
+  for (index = MAX (nlesrc->index, nlesrc->prefetch_index) + 1; index <= last;
+      index++) {
+    /* This item will reuse the decoder of the previous one */
+    if (!gst_nle_source_can_reuse_decoder (g_list_nth_data (nlesrc->queue,
+                index - 1), g_list_nth_data (nlesrc->queue, index)))
+      return index;
+  }
+  return -1;
+}
+
+/* Pre-rolls the decoders of the following items, one at a time, without
+ * holding the lock so that switching items is never blocked */
+static gpointer
+gst_nle_source_prefetch_thread (GstNleSource * nlesrc)
+{
+  GstElement *pipeline;
+  gboolean prerolled;
+  gint index;
+
+  g_mutex_lock (&nlesrc->prefetch_lock);
+  while (!nlesrc->prefetch_stop) {
+    index = gst_nle_source_next_to_prefetch (nlesrc);
+    if (index < 0) {
+      g_cond_wait (&nlesrc->prefetch_cond, &nlesrc->prefetch_lock);
+      continue;
+    }
+
+    nlesrc->prefetch_index = index;
+    pipeline = gst_nle_source_create_decoder (nlesrc, index);
+    g_mutex_unlock (&nlesrc->prefetch_lock);
+
+    prerolled = gst_nle_source_preroll_decoder (nlesrc, pipeline);
+
+    g_mutex_lock (&nlesrc->prefetch_lock);
+    /* The item might have started while it was being pre-rolled */
+    if (prerolled && !nlesrc->prefetch_stop && index > nlesrc->index) {
+      nlesrc->prefetched = g_list_append (nlesrc->prefetched, pipeline);
+    } else {
+      g_mutex_unlock (&nlesrc->prefetch_lock);
+      gst_nle_source_destroy_decoder (pipeline);
+      g_mutex_lock (&nlesrc->prefetch_lock);
+    }
+  }
+  g_mutex_unlock (&nlesrc->prefetch_lock);
+
+  return NULL;
+}
+
+static void
+gst_nle_source_prefetch (GstNleSource * nlesrc)
+{
+  g_mutex_lock (&nlesrc->prefetch_lock);
+  if (nlesrc->prefetch_thread == NULL) {
+    nlesrc->prefetch_stop = FALSE;
+    /* No reference is taken, the thread is always joined in PAUSED->READY or
+     * dispose before the source is released */
+    nlesrc->prefetch_thread = g_thread_new ("prefetch",
+        (GThreadFunc) gst_nle_source_prefetch_thread, nlesrc);
+  }
+  g_cond_signal (&nlesrc->prefetch_cond);
+  g_mutex_unlock (&nlesrc->prefetch_lock);
+}
+
+static void
+gst_nle_source_stop_prefetch (GstNleSource * nlesrc)
+{
+  GThread *thread;
+
+  g_mutex_lock (&nlesrc->prefetch_lock);
+  thread = nlesrc->prefetch_thread;
+  nlesrc->prefetch_thread = NULL;
+  nlesrc->prefetch_stop = TRUE;
+  g_cond_signal (&nlesrc->prefetch_cond);
+  g_mutex_unlock (&nlesrc->prefetch_lock);
+
+  if (thread != NULL)
+    g_thread_join (thread);
+}
+
+/* Must be called with the prefetch lock */
+static GstElement *
+gst_nle_source_take_prefetched (GstNleSource * nlesrc, gint index)
+{
+  GstElement *pipeline = NULL;
+  GList *l, *next;
+
+  for (l = nlesrc->prefetched; l; l = next) {
+    GstNleDecoder *dec = gst_nle_source_get_decoder (l->data);
+
+    next = l->next;
+    if (dec->index == index) {
+      pipeline = l->data;
+      nlesrc->prefetched = g_list_delete_link (nlesrc->prefetched, l);
+    } else if (dec->index < index) {
+      gst_nle_source_destroy_decoder (l->data);
+      nlesrc->prefetched = g_list_delete_link (nlesrc->prefetched, l);
+    }
+  }
+  return pipeline;
+}
+
+/* Must be called with the prefetch lock */
+static void
+gst_nle_source_clear_prefetched (GstNleSource * nlesrc)
+{
+  if (nlesrc->prefetched != NULL) {
+    g_list_free_full (nlesrc->prefetched,
+        (GDestroyNotify) gst_nle_source_destroy_decoder);
+    nlesrc->prefetched = NULL;
+  }
+}
+
+static void
+gst_nle_source_start_prefetched (GstNleSource * nlesrc, GstElement * pipeline)
+{
+  GstNleDecoder *dec;
+
+  dec = gst_nle_source_get_decoder (pipeline);
+
+  GST_DEBUG_OBJECT (nlesrc, "Using pre-rolled decoder for item %d",
+      dec->index);
+
+  g_mutex_lock (&nlesrc->stream_lock);
+  nlesrc->decoder = pipeline;
+  nlesrc->source = dec->source;
+  dec->source = NULL;
+  /* The decoder is already pre-rolled at the start position */
+  nlesrc->seek_done = TRUE;
+  nlesrc->video_seek_done = TRUE;
+  nlesrc->audio_seek_done = TRUE;
+  nlesrc->video_linked = dec->video_linked;
+  nlesrc->audio_linked = dec->audio_linked;
+  nlesrc->video_eos = !dec->video_linked;
+  nlesrc->audio_eos = !dec->audio_linked;
+  nlesrc->switch_prefetched = TRUE;
+  g_mutex_unlock (&nlesrc->stream_lock);
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  if (dec->no_more_pads) {
+    gst_nle_source_no_more_pads (NULL, dec);
+  }
+}
+
+static gboolean
+gst_nle_source_reuse_decoder (GstNleSource * nlesrc, GstNleSrcItem * item)
+{
+  GstNleDecoder *dec;
+
+  dec = gst_nle_source_get_decoder (nlesrc->decoder);
+
+  GST_DEBUG_OBJECT (nlesrc, "Reusing the decoder of the previous item");
+
+  g_mutex_lock (&nlesrc->stream_lock);
+  dec->index = nlesrc->index;
+  nlesrc->video_seek_done = FALSE;
+  nlesrc->audio_seek_done = FALSE;
+  nlesrc->video_eos = !dec->video_linked;
+  nlesrc->audio_eos = !dec->audio_linked;
+  nlesrc->switch_prefetched = FALSE;
+  nlesrc->seek_done = TRUE;
+  g_mutex_unlock (&nlesrc->stream_lock);
+
+  /* The flushing seek clears the EOS of the appsinks and the segment
+   * restarts with a NEWSEGMENT like with a new decoder */
+  if (!gst_element_seek (nlesrc->decoder, 1, GST_FORMAT_TIME,
+          GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE,
+          GST_SEEK_TYPE_SET, item->start, GST_SEEK_TYPE_SET, item->stop)) {
+    GST_WARNING_OBJECT (nlesrc, "Could not seek the decoder to the next item");
+    g_mutex_lock (&nlesrc->stream_lock);
+    nlesrc->video_eos = TRUE;
+    nlesrc->audio_eos = TRUE;
+    g_mutex_unlock (&nlesrc->stream_lock);
+    return FALSE;
+  }
+
+  if (nlesrc->with_audio && !nlesrc->audio_linked) {
+    gst_nle_source_no_more_pads (NULL, dec);
+  }
+  return TRUE;
+}
+
+static gboolean
+gst_nle_source_start_decoder (GstNleSource * nlesrc, GstNleSrcItem * item)
+{
+  GstStateChangeReturn ret;
+  GstState state;
+
+  nlesrc->decoder = gst_nle_source_create_decoder (nlesrc, nlesrc->index);
+
   nlesrc->seek_done = FALSE;
   if (GST_CLOCK_TIME_IS_VALID (item->stop)) {
     nlesrc->video_seek_done = FALSE;
@@ -844,22 +1226,14 @@ gst_nle_source_next (GstNleSource * nlesrc)
   }
   nlesrc->audio_eos = TRUE;
   nlesrc->video_eos = TRUE;
-  nlesrc->audio_ts = 0;
-  nlesrc->video_ts = 0;
-  nlesrc->start_ts = nlesrc->accu_time;
   nlesrc->video_linked = FALSE;
   nlesrc->audio_linked = FALSE;
-  nlesrc->item_setup = FALSE;
-  nlesrc->cached_duration = 0;
+  nlesrc->switch_prefetched = FALSE;
 
-  GST_DEBUG_OBJECT (nlesrc, "Start ts:%" GST_TIME_FORMAT,
-      GST_TIME_ARGS (nlesrc->start_ts));
   gst_element_set_state (nlesrc->decoder, GST_STATE_PLAYING);
   ret = gst_element_get_state (nlesrc->decoder, &state, NULL, 5 * GST_SECOND);
   if (ret == GST_STATE_CHANGE_FAILURE) {
-    GST_WARNING_OBJECT (nlesrc, "Error changing state, selecting next item.");
-    gst_nle_source_check_eos (nlesrc);
-    return;
+    return FALSE;
   }
 
   nlesrc->seek_done = TRUE;
@@ -869,6 +1243,83 @@ gst_nle_source_next (GstNleSource * nlesrc)
         GST_SEEK_FLAG_ACCURATE,
         GST_SEEK_TYPE_SET, item->start, GST_SEEK_TYPE_SET, item->stop);
   }
+  return TRUE;
+}
+
+static void
+gst_nle_source_next (GstNleSource * nlesrc)
+{
+  GstNleSrcItem *item, *prev;
+  GstElement *prefetched;
+  gboolean reuse;
+
+  g_mutex_lock (&nlesrc->prefetch_lock);
+
+  prev = (GstNleSrcItem *) g_list_nth_data (nlesrc->queue, nlesrc->index);
+  nlesrc->index++;
+
+  if (nlesrc->index >= g_list_length (nlesrc->queue)) {
+    g_mutex_unlock (&nlesrc->prefetch_lock);
+    gst_nle_source_push_eos (nlesrc);
+    return;
+  }
+
+  item = (GstNleSrcItem *) g_list_nth_data (nlesrc->queue, nlesrc->index);
+  reuse = nlesrc->decoder != NULL &&
+      gst_nle_source_can_reuse_decoder (prev, item);
+
+  if (!reuse) {
+    if (nlesrc->source != NULL) {
+      gst_object_unref (nlesrc->source);
+      nlesrc->source = NULL;
+    }
+
+    if (nlesrc->decoder != NULL) {
+      gst_nle_source_destroy_decoder (nlesrc->decoder);
+      nlesrc->decoder = NULL;
+    }
+  }
+
+  GST_INFO_OBJECT (nlesrc, "Starting next item with uri:%s", item->file_path);
+  GST_INFO_OBJECT (nlesrc, "start:%" GST_TIME_FORMAT " stop:%"
+      GST_TIME_FORMAT " rate:%f", GST_TIME_ARGS (item->start),
+      GST_TIME_ARGS (item->stop), item->rate);
+
+  nlesrc->audio_ts = 0;
+  nlesrc->video_ts = 0;
+  nlesrc->start_ts = nlesrc->accu_time;
+  nlesrc->item_setup = FALSE;
+  nlesrc->cached_duration = 0;
+
+  GST_DEBUG_OBJECT (nlesrc, "Start ts:%" GST_TIME_FORMAT,
+      GST_TIME_ARGS (nlesrc->start_ts));
+
+  prefetched = gst_nle_source_take_prefetched (nlesrc, nlesrc->index);
+  if (reuse) {
+    if (prefetched != NULL) {
+      gst_nle_source_destroy_decoder (prefetched);
+    }
+    if (!gst_nle_source_reuse_decoder (nlesrc, item)) {
+      GST_WARNING_OBJECT (nlesrc, "Error seeking, selecting next item.");
+      g_mutex_unlock (&nlesrc->prefetch_lock);
+      gst_nle_source_check_eos (nlesrc);
+      return;
+    }
+  } else if (prefetched != NULL) {
+    gst_nle_source_start_prefetched (nlesrc, prefetched);
+  } else if (!gst_nle_source_start_decoder (nlesrc, item)) {
+    GST_WARNING_OBJECT (nlesrc, "Error changing state, selecting next item.");
+    g_mutex_unlock (&nlesrc->prefetch_lock);
+    gst_nle_source_check_eos (nlesrc);
+    return;
+  }
+
+  g_mutex_unlock (&nlesrc->prefetch_lock);
+
+  /* Prepare the following items while this one is being decoded */
+  if (nlesrc->lookahead > 0) {
+    gst_nle_source_prefetch (nlesrc);
+  }
 }
 
 static GstStateChangeReturn
@@ -906,11 +1357,17 @@ gst_nle_source_change_state (GstElement * element, GstStateChange transition)
       if (nlesrc->decoder) {
         gst_element_set_state (nlesrc->decoder, GST_STATE_READY);
       }
+      /* Items can't be released while they are being pre-rolled */
+      gst_nle_source_stop_prefetch (nlesrc);
+      g_mutex_lock (&nlesrc->prefetch_lock);
+      gst_nle_source_clear_prefetched (nlesrc);
+      nlesrc->prefetch_index = -1;
       if (nlesrc->queue != NULL) {
         g_list_free_full (nlesrc->queue,
             (GDestroyNotify) gst_nle_source_item_free);
         nlesrc->queue = NULL;
       }
+      g_mutex_unlock (&nlesrc->prefetch_lock);
       break;
     case GST_STATE_CHANGE_READY_TO_NULL:
       if (nlesrc->source) {
@@ -1004,6 +1461,91 @@ void gst_nle_source_set_watermark (GstNleSource * nlesrc,
   nlesrc->watermark_height = height;
 }
 
+void
+gst_nle_source_set_lookahead (GstNleSource * nlesrc, guint depth)
+{
+  nlesrc->lookahead = depth;
+
+  GST_INFO_OBJECT (nlesrc, "Pre-rolling %d items in advance", depth);
+}
+
+guint
+gst_nle_source_get_n_items (GstNleSource * nlesrc)
+{
+  return g_list_length (nlesrc->queue);
+}
+
+guint64
+gst_nle_source_get_item_duration (GstNleSource * nlesrc, guint index)
+{
+  GstNleSrcItem *item;
+
+  item = (GstNleSrcItem *) g_list_nth_data (nlesrc->queue, index);
+  if (item == NULL || !GST_CLOCK_TIME_IS_VALID (item->duration))
+    return GST_CLOCK_TIME_NONE;
+  return item->duration / item->rate;
+}
+
+GstNleSrcItem *
+gst_nle_source_get_item (GstNleSource * nlesrc, guint index)
+{
+  return (GstNleSrcItem *) g_list_nth_data (nlesrc->queue, index);
+}
+
+static GstNleSource *
+gst_nle_source_copy_settings (GstNleSource * nlesrc)
+{
+  GstNleSource *copy;
+
+  copy = gst_nle_source_new ();
+  gst_nle_source_configure (copy, nlesrc->width, nlesrc->height,
+      nlesrc->fps_n, nlesrc->fps_d, nlesrc->overlay_title, nlesrc->with_audio);
+  copy->title_size = nlesrc->title_size;
+  gst_nle_source_set_watermark (copy, nlesrc->watermark, nlesrc->watermark_x,
+      nlesrc->watermark_y, nlesrc->watermark_height);
+  gst_nle_source_set_lookahead (copy, nlesrc->lookahead);
+  return copy;
+}
+
+GstNleSource *
+gst_nle_source_copy_range (GstNleSource * nlesrc, guint first, guint n_items)
+{
+  GstNleSource *copy;
+  GstNleSrcItem *item, *new_item;
+  GList *l;
+
+  copy = gst_nle_source_copy_settings (nlesrc);
+
+  for (l = g_list_nth (nlesrc->queue, first); l != NULL && n_items > 0;
+      l = l->next, n_items--) {
+    item = (GstNleSrcItem *) l->data;
+    /* Items already store the URI, don't convert it again */
+    new_item = gst_nle_source_item_new (item->file_path, item->title,
+        item->start, item->stop, item->rate, item->still_picture, item->roi);
+    copy->queue = g_list_append (copy->queue, new_item);
+  }
+
+  return copy;
+}
+
+/* Copies an item, rendering only the [start, stop) range of its file */
+GstNleSource *
+gst_nle_source_copy_item (GstNleSource * nlesrc, guint index, guint64 start,
+    guint64 stop)
+{
+  GstNleSource *copy;
+  GstNleSrcItem *item;
+
+  copy = gst_nle_source_copy_settings (nlesrc);
+  item = gst_nle_source_get_item (nlesrc, index);
+  if (item != NULL) {
+    copy->queue = g_list_append (copy->queue,
+        gst_nle_source_item_new (item->file_path, item->title, start, stop,
+            item->rate, item->still_picture, item->roi));
+  }
+  return copy;
+}
+
 GstNleSource *
 gst_nle_source_new (void)
 {
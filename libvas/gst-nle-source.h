@@ -40,6 +40,9 @@ G_BEGIN_DECLS
 #define GST_IS_NLE_SOURCE_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), GST_TYPE_NLE_SOURCE))
 #define GST_NLE_SOURCE_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), GST_TYPE_NLE_SOURCE, GstNleSourceClass))
 #define GCC_ERROR gst_nle_source_error_quark ()
+/* Raw audio format of the output */
+#define GST_NLE_SOURCE_AUDIO_RATE 44100
+#define GST_NLE_SOURCE_AUDIO_CHANNELS 2
 typedef struct _GstNleSourceClass GstNleSourceClass;
 typedef struct _GstNleSource GstNleSource;
 
@@ -95,6 +98,16 @@ struct _GstNleSource
   gint index;
 
   gint64 cached_duration;
+
+  guint lookahead;
+  GList *prefetched;
+  GMutex prefetch_lock;
+  GCond prefetch_cond;
+  GThread *prefetch_thread;
+  gboolean prefetch_stop;
+  gint prefetch_index;
+  gint64 switch_start;
+  gboolean switch_prefetched;
 };
 
 typedef struct
@@ -105,6 +118,18 @@ typedef struct
   guint height;
 } GstNleRectangle;
 
+typedef struct
+{
+  gchar *file_path;
+  gchar *title;
+  guint64 start;
+  guint64 stop;
+  guint64 duration;
+  gfloat rate;
+  gboolean still_picture;
+  GstNleRectangle roi;
+} GstNleSrcItem;
+
 EXPORT GType gst_nle_source_get_type (void) G_GNUC_CONST;
 
 EXPORT GstNleSource *gst_nle_source_new (void);
@@ -132,6 +157,23 @@ EXPORT void gst_nle_source_query_progress (GstNleSource * nlesrc,
 EXPORT void gst_nle_source_set_watermark (GstNleSource * nlesrc,
     GdkPixbuf * watermark, gdouble x, gdouble y, gdouble height);
 
+EXPORT void gst_nle_source_set_lookahead (GstNleSource * nlesrc,
+    guint depth);
+
+EXPORT guint gst_nle_source_get_n_items (GstNleSource * nlesrc);
+
+EXPORT guint64 gst_nle_source_get_item_duration (GstNleSource * nlesrc,
+    guint index);
+
+EXPORT GstNleSrcItem *gst_nle_source_get_item (GstNleSource * nlesrc,
+    guint index);
+
+EXPORT GstNleSource *gst_nle_source_copy_range (GstNleSource * nlesrc,
+    guint first, guint n_items);
+
+EXPORT GstNleSource *gst_nle_source_copy_item (GstNleSource * nlesrc,
+    guint index, guint64 start, guint64 stop);
+
 G_END_DECLS
 #endif /* _GST_NLE_SOURCE_H_ */
 
@@ -28,10 +28,14 @@
 #include <gst/gst.h>
 
 #include "gst-remuxer.h"
+#include "gst-adts-to-raw.h"
 
 GST_DEBUG_CATEGORY (_remuxer_gst_debug_cat);
 #define GST_CAT_DEFAULT _remuxer_gst_debug_cat
 
+/* Interval in ms between progress updates */
+#define PROGRESS_INTERVAL 500
+
 /* Signals */
 enum
 {
@@ -53,6 +57,8 @@ struct GstRemuxerPrivate
   GstClockTime last_audio_buf_ts;
   gboolean audio_linked;
   gboolean video_linked;
+  LgmRateLimiter *limiter;
+  guint progress_id;
 
   /*GStreamer elements */
   GstElement *main_pipeline;
@@ -69,6 +75,7 @@ static int remuxer_signals[LAST_SIGNAL] = { 0 };
 static void remuxer_error_msg (GstRemuxer * remuxer, GstMessage * msg);
 static void remuxer_bus_message_cb (GstBus * bus, GstMessage * message,
     gpointer data);
+static void gst_remuxer_stop_progress (GstRemuxer * remuxer);
 
 G_DEFINE_TYPE (GstRemuxer, gst_remuxer, G_TYPE_OBJECT);
 
@@ -113,6 +120,11 @@ gst_remuxer_finalize (GObject * object)
     remuxer->priv->bus = NULL;
   }
 
+  if (remuxer->priv->progress_id != 0) {
+    g_source_remove (remuxer->priv->progress_id);
+    remuxer->priv->progress_id = 0;
+  }
+
   if (remuxer->priv->input_file) {
     g_free (remuxer->priv->input_file);
     remuxer->priv->input_file = NULL;
@@ -130,6 +142,11 @@ gst_remuxer_finalize (GObject * object)
     remuxer->priv->main_pipeline = NULL;
   }
 
+  if (remuxer->priv->limiter != NULL) {
+    lgm_rate_limiter_unref (remuxer->priv->limiter);
+    remuxer->priv->limiter = NULL;
+  }
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -205,6 +222,8 @@ gst_remuxer_create_video_muxer (GstRemuxer * remuxer, VideoMuxerType type)
       break;
     case VIDEO_MUXER_MP4:
       muxer = gst_element_factory_make ("qtmux", "muxer");
+      if (muxer != NULL)
+        lgm_set_muxer_faststart (muxer, remuxer->priv->output_file);
       break;
     case VIDEO_MUXER_WEBM:
     default:
@@ -246,27 +265,14 @@ gst_remuxer_pad_added_cb (GstElement * demuxer, GstPad * pad,
 
   if (g_strrstr (mime, "video") && !remuxer->priv->video_linked) {
     muxer_pad_name = "video_%d";
-    if (g_strrstr (mime, "video/x-h264")) {
-      GstPad *parser_pad;
-
-      GST_DEBUG_OBJECT (remuxer, "adding h264parse");
-      parser = gst_element_factory_make ("h264parse", "video-parser");
-      parser_caps =
-          gst_caps_from_string
-          ("video/x-h264, stream-format=avc, alignment=au");
-
-      parser_pad = gst_element_get_static_pad (parser, "src");
-      gst_pad_add_buffer_probe (parser_pad,
-          (GCallback) gst_remuxer_fix_video_ts, remuxer);
-    } else if (g_strrstr (mime, "video/mpeg")) {
+    parser = lgm_create_video_parser (mime, &parser_caps);
+    if (parser != NULL) {
       GstPad *parser_pad;
 
-      GST_DEBUG_OBJECT (remuxer, "adding mpegvideoparse");
-      parser = gst_element_factory_make ("mpegvideoparse", "video-parser");
-
       parser_pad = gst_element_get_static_pad (parser, "src");
       gst_pad_add_buffer_probe (parser_pad,
           (GCallback) gst_remuxer_fix_video_ts, remuxer);
+      gst_object_unref (parser_pad);
     }
     is_video = TRUE;
   } else if (g_strrstr (mime, "audio") && !remuxer->priv->audio_linked) {
@@ -274,14 +280,11 @@ gst_remuxer_pad_added_cb (GstElement * demuxer, GstPad * pad,
     if (g_strrstr (mime, "audio/mpeg")) {
       gint version;
       gst_structure_get_int (s, "mpegversion", &version);
-      if (version == 4) {
-        /* FIXME: aacparse doesn't seem to support adts to raw conversion */
-        //parser = gst_element_factory_make ("aacparse", NULL);
-        parser =
-            gst_parse_bin_from_description ("fluaacdec ! fluaacenc", TRUE,
-            NULL);
-        if (parser == NULL)
-          parser = gst_parse_bin_from_description ("faad ! faac", TRUE, NULL);
+      if (version == 2 || version == 4) {
+        /* aacparse doesn't support adts to raw conversion, strip the headers
+         * ourselves instead of transcoding */
+        GST_DEBUG_OBJECT (remuxer, "adding adts to raw converter");
+        parser = gst_adts_to_raw_new ();
       } else if (version == 3) {
         GST_DEBUG_OBJECT (remuxer, "adding mp3parse");
         parser = gst_element_factory_make ("mp3parse", "audio-parser");
@@ -466,6 +469,8 @@ remuxer_bus_message_cb (GstBus * bus, GstMessage * message, gpointer data)
   switch (msg_type) {
     case GST_MESSAGE_ERROR:
     {
+      /* No progress is emitted after the error */
+      gst_remuxer_stop_progress (remuxer);
       if (remuxer->priv->main_pipeline) {
         gst_remuxer_cancel (remuxer);
       }
@@ -484,6 +489,7 @@ remuxer_bus_message_cb (GstBus * bus, GstMessage * message, gpointer data)
       GST_DEBUG_BIN_TO_DOT_FILE (GST_BIN (remuxer->priv->main_pipeline),
         GST_DEBUG_GRAPH_SHOW_ALL, "remux.dot");
       GST_INFO_OBJECT (remuxer, "EOS message");
+      gst_remuxer_stop_progress (remuxer);
       gst_remuxer_cancel (remuxer);
       g_signal_emit (remuxer, remuxer_signals[SIGNAL_PERCENT], 0, (gfloat) 1);
       break;
@@ -525,6 +531,43 @@ remuxer_error_msg (GstRemuxer * remuxer, GstMessage * msg)
  *
  * ****************************************/
 
+static gboolean
+gst_remuxer_limit_rate_probe (GstPad * pad, GstBuffer * buf,
+    GstRemuxer * remuxer)
+{
+  lgm_rate_limiter_consume (remuxer->priv->limiter, GST_BUFFER_SIZE (buf));
+  return TRUE;
+}
+
+static void
+gst_remuxer_stop_progress (GstRemuxer * remuxer)
+{
+  if (remuxer->priv->progress_id != 0) {
+    g_source_remove (remuxer->priv->progress_id);
+    remuxer->priv->progress_id = 0;
+  }
+}
+
+static gboolean
+gst_remuxer_emit_progress (GstRemuxer * remuxer)
+{
+  GstElement *filesrc;
+  GstFormat format = GST_FORMAT_BYTES;
+  gint64 position, duration;
+
+  filesrc = gst_bin_get_by_name (GST_BIN (remuxer->priv->main_pipeline),
+      "source");
+  if (gst_element_query_position (filesrc, &format, &position) &&
+      gst_element_query_duration (filesrc, &format, &duration) &&
+      duration > 0) {
+    /* 1 is only emitted once the output is complete */
+    g_signal_emit (remuxer, remuxer_signals[SIGNAL_PERCENT], 0,
+        MIN ((gfloat) position / duration, 0.99));
+  }
+  gst_object_unref (filesrc);
+  return TRUE;
+}
+
 void
 gst_remuxer_start (GstRemuxer * remuxer)
 {
@@ -532,6 +575,30 @@ gst_remuxer_start (GstRemuxer * remuxer)
   g_return_if_fail (GST_IS_REMUXER (remuxer));
 
   gst_element_set_state (remuxer->priv->main_pipeline, GST_STATE_PLAYING);
+  if (remuxer->priv->progress_id == 0) {
+    remuxer->priv->progress_id = g_timeout_add (PROGRESS_INTERVAL,
+        (GSourceFunc) gst_remuxer_emit_progress, remuxer);
+  }
+}
+
+void
+gst_remuxer_set_rate_limiter (GstRemuxer * remuxer, LgmRateLimiter * limiter)
+{
+  GstElement *filesrc;
+  GstPad *pad;
+
+  g_return_if_fail (GST_IS_REMUXER (remuxer));
+  g_return_if_fail (limiter != NULL);
+  g_return_if_fail (remuxer->priv->limiter == NULL);
+
+  remuxer->priv->limiter = lgm_rate_limiter_ref (limiter);
+  filesrc = gst_bin_get_by_name (GST_BIN (remuxer->priv->main_pipeline),
+      "source");
+  pad = gst_element_get_static_pad (filesrc, "src");
+  gst_pad_add_buffer_probe (pad, (GCallback) gst_remuxer_limit_rate_probe,
+      remuxer);
+  gst_object_unref (pad);
+  gst_object_unref (filesrc);
 }
 
 void
@@ -540,6 +607,7 @@ gst_remuxer_cancel (GstRemuxer * remuxer)
   g_return_if_fail (remuxer != NULL);
   g_return_if_fail (GST_IS_REMUXER (remuxer));
 
+  gst_remuxer_stop_progress (remuxer);
   gst_element_set_state (remuxer->priv->main_pipeline, GST_STATE_NULL);
   gst_element_get_state (remuxer->priv->main_pipeline, NULL, NULL, -1);
 }
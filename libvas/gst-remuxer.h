@@ -33,6 +33,7 @@
 
 #include <gst/gst.h>
 #include "lgm-utils.h"
+#include "lgm-rate-limiter.h"
 
 G_BEGIN_DECLS
 #define GST_TYPE_REMUXER             (gst_remuxer_get_type ())
@@ -68,6 +69,10 @@ EXPORT GstRemuxer *gst_remuxer_new (gchar *in_filename, gchar *out_filename,
                                     VideoMuxerType muxer, GError ** err);
 EXPORT void gst_remuxer_start (GstRemuxer * remuxer);
 EXPORT void gst_remuxer_cancel (GstRemuxer * remuxer);
+/* Shares the input bandwidth with the other remuxers using the same
+ * limiter. Must be called before starting */
+EXPORT void gst_remuxer_set_rate_limiter (GstRemuxer * remuxer,
+                                          LgmRateLimiter * limiter);
 
 G_END_DECLS
 #endif /* _GST_REMUXER_H_ */
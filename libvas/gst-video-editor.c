@@ -23,14 +23,21 @@
 #include <string.h>
 #include <stdio.h>
 #include <gst/gst.h>
+#include <glib/gstdio.h>
 #include "gst-video-editor.h"
 #include "gst-nle-source.h"
+#include "gst-concat-source.h"
 #include "lgm-utils.h"
 
 #define AUDIO_INT_CAPS "audio/x-raw-int, rate=44100, channels=2"
 #define AUDIO_FLOAT "audio/x-raw-float, rate=44100, channels=2"
 
 #define TIMEOUT 200
+/* Changed when the encoding of the cached parts changes, to invalidate
+ * the parts encoded by previous versions */
+#define GVE_CACHE_VERSION 2
+/* Incomplete parts older than this are left by renders that didn't finish */
+#define GVE_CACHE_STALE_PART (24 * 60 * 60)
 
 /* Signals */
 enum
@@ -75,17 +82,6 @@ struct GstVideoEditorPrivate
   /* Source */
   GstNleSource *nle_source;
 
-  /* Video */
-  GstElement *identity;
-  GstElement *ffmpegcolorspace;
-  GstElement *queue;
-  GstElement *video_encoder;
-
-  /* Audio */
-  GstElement *audioidentity;
-  GstElement *audioqueue;
-  GstElement *audioencoder;
-
   /* Sink */
   GstElement *muxer;
   GstElement *file_sink;
@@ -94,16 +90,81 @@ struct GstVideoEditorPrivate
   gulong sig_bus_async;
 
   gint update_id;
+
+  /* Segments switch */
+  guint lookahead;
+  guint switch_count;
+  guint64 switch_total;
+  guint64 switch_max;
+
+  /* Parallel rendering */
+  guint parallel_workers;
+  gboolean smart_render;
+  struct _GveSmartPlan *smart_plan;
+  GstCaps *copy_video_caps;
+  GstCaps *copy_audio_caps;
+  guint smart_fallback_id;
+  gchar *temp_dir;
+  GList *workers;
+  guint workers_done;
+  guint workers_error_id;
+  GstConcatSource *concat_source;
+
+  /* Cache of encoded segments */
+  gchar *cache_dir;
+  guint64 cache_max_size;
+  guint cache_hits;
+  guint cache_misses;
 };
 
+/* Encodes a contiguous range of segments in its own pipeline to a
+ * temporary file, which is later concatenated without re-encoding */
+typedef struct _GveRenderWorker
+{
+  GstVideoEditor *gve;
+  GstElement *pipeline;
+  GstNleSource *nle_source;
+  GstElement *vencode_bin;
+  GstElement *aencode_bin;
+  GstBus *bus;
+  gulong sig_bus_async;
+  gchar *output_file;
+  gchar *cache_file;
+  gboolean cached;
+  /* A segment repeated in the render reuses the part of its first
+   * occurrence, done when that one is encoded */
+  struct _GveRenderWorker *encoder;
+  /* A range of a source file copied to the output without re-encoding */
+  gboolean copy;
+  guint64 start;
+  guint64 stop;
+  gint64 duration;
+  gint64 last_pos;
+  gboolean started;
+  gboolean done;
+} GveRenderWorker;
+
+typedef struct
+{
+  gchar *path;
+  guint64 size;
+  gint64 mtime;
+} GveCacheEntry;
+
 static int gve_signals[LAST_SIGNAL] = { 0 };
 
 static void gve_error_msg (GstVideoEditor * gve, GstMessage * msg);
+static void gve_segment_switch_msg (GstVideoEditor * gve,
+    const GstStructure * s);
 static void new_decoded_pad_cb (GstElement * object, GstPad * arg0,
     gpointer user_data);
 static void gve_bus_message_cb (GstBus * bus, GstMessage * message,
     gpointer data);
 static gboolean gve_query_timeout (GstVideoEditor * gve);
+static void gve_clear_workers (GstVideoEditor * gve);
+static void gve_start_render (GstVideoEditor * gve);
+static void gve_start_workers (GstVideoEditor * gve);
+static void gve_cache_evict (GstVideoEditor * gve);
 
 G_DEFINE_TYPE (GstVideoEditor, gst_video_editor, G_TYPE_OBJECT);
 
@@ -134,6 +195,9 @@ gst_video_editor_init (GstVideoEditor * object)
   priv->audio_enabled = TRUE;
   priv->nle_source = NULL;
   priv->update_id = 0;
+  priv->lookahead = 1;
+  priv->parallel_workers = 1;
+  priv->temp_dir = g_strdup (g_get_tmp_dir ());
 }
 
 static void
@@ -159,7 +223,16 @@ gst_video_editor_finalize (GObject * object)
     gve->priv->main_pipeline = NULL;
   }
 
+  gve_clear_workers (gve);
+
+  if (gve->priv->nle_source != NULL) {
+    gst_object_unref (gve->priv->nle_source);
+    gve->priv->nle_source = NULL;
+  }
+
   g_free (gve->priv->output_file);
+  g_free (gve->priv->temp_dir);
+  g_free (gve->priv->cache_dir);
   G_OBJECT_CLASS (gst_video_editor_parent_class)->finalize (object);
 }
 
@@ -220,127 +293,108 @@ gst_video_editor_error_quark (void)
   return q;
 }
 
-static void
+static GstElement *
 gve_create_video_encode_bin (GstVideoEditor * gve, GError ** err)
 {
+  GstElement *bin, *identity, *ffmpegcolorspace, *queue, *video_encoder;
   GstPad *sinkpad = NULL;
   GstPad *srcpad = NULL;
 
-  gve->priv->vencode_bin = gst_element_factory_make ("bin", "vencodebin");
-  gve->priv->identity = gst_element_factory_make ("identity", "identity");
-  gve->priv->ffmpegcolorspace =
-      gst_element_factory_make ("ffmpegcolorspace", "ffmpegcolorspace");
-  gve->priv->queue = gst_element_factory_make ("queue", "video-encode-queue");
-  gve->priv->video_encoder =
-      lgm_create_video_encoder (gve->priv->video_encoder_type,
+  video_encoder = lgm_create_video_encoder (gve->priv->video_encoder_type,
       gve->priv->video_quality, FALSE, GVE_ERROR, err);
   if (*err) {
-    return;
+    return NULL;
   }
+  bin = gst_element_factory_make ("bin", "vencodebin");
+  identity = gst_element_factory_make ("identity", "identity");
+  ffmpegcolorspace =
+      gst_element_factory_make ("ffmpegcolorspace", "ffmpegcolorspace");
+  queue = gst_element_factory_make ("queue", "video-encode-queue");
 
-  g_object_set (G_OBJECT (gve->priv->identity), "single-segment", TRUE, NULL);
-  g_object_set (G_OBJECT (gve->priv->queue), "max-size-bytes", 4 * 1000 * 1000,
+  g_object_set (G_OBJECT (identity), "single-segment", TRUE, NULL);
+  g_object_set (G_OBJECT (queue), "max-size-bytes", 4 * 1000 * 1000,
       "max-size-buffers", 0, "max-size-time", (guint64) 0, NULL);
 
   /*Add and link elements */
-  gst_bin_add_many (GST_BIN (gve->priv->vencode_bin),
-      gve->priv->identity,
-      gve->priv->ffmpegcolorspace,
-      gve->priv->video_encoder, gve->priv->queue, NULL);
-  gst_element_link_many (gve->priv->identity,
-      gve->priv->ffmpegcolorspace,
-      gve->priv->video_encoder, gve->priv->queue, NULL);
+  gst_bin_add_many (GST_BIN (bin), identity, ffmpegcolorspace,
+      video_encoder, queue, NULL);
+  gst_element_link_many (identity, ffmpegcolorspace, video_encoder, queue,
+      NULL);
 
   /*Create bin sink pad */
-  sinkpad = gst_element_get_static_pad (gve->priv->identity, "sink");
+  sinkpad = gst_element_get_static_pad (identity, "sink");
   gst_pad_set_active (sinkpad, TRUE);
-  gst_element_add_pad (GST_ELEMENT (gve->priv->vencode_bin),
-      gst_ghost_pad_new ("sink", sinkpad));
+  gst_element_add_pad (bin, gst_ghost_pad_new ("sink", sinkpad));
 
   /*Creat bin src pad */
-  srcpad = gst_element_get_static_pad (gve->priv->queue, "src");
+  srcpad = gst_element_get_static_pad (queue, "src");
   gst_pad_set_active (srcpad, TRUE);
-  gst_element_add_pad (GST_ELEMENT (gve->priv->vencode_bin),
-      gst_ghost_pad_new ("src", srcpad));
+  gst_element_add_pad (bin, gst_ghost_pad_new ("src", srcpad));
 
   gst_object_unref (srcpad);
   gst_object_unref (sinkpad);
+
+  return bin;
 }
 
-static void
+static GstElement *
 gve_create_audio_encode_bin (GstVideoEditor * gve, GError ** err)
 {
+  GstElement *bin, *audioidentity, *audioqueue, *audioencoder;
   GstPad *sinkpad = NULL;
   GstPad *srcpad = NULL;
 
-  if (gve->priv->aencode_bin != NULL)
-    return;
-
-  gve->priv->aencode_bin = gst_element_factory_make ("bin", "aencodebin");
-  gve->priv->audioidentity =
-      gst_element_factory_make ("identity", "audio-identity");
-  gve->priv->audioqueue = gst_element_factory_make ("queue", "audio-queue");
-  gve->priv->audioencoder =
-      lgm_create_audio_encoder (gve->priv->audio_encoder_type,
+  audioencoder = lgm_create_audio_encoder (gve->priv->audio_encoder_type,
       gve->priv->audio_quality, GVE_ERROR, err);
   if (*err) {
-    return;
+    return NULL;
   }
+  bin = gst_element_factory_make ("bin", "aencodebin");
+  audioidentity = gst_element_factory_make ("identity", "audio-identity");
+  audioqueue = gst_element_factory_make ("queue", "audio-queue");
 
-  g_object_set (G_OBJECT (gve->priv->audioidentity), "single-segment", TRUE,
-      NULL);
-  g_object_set (G_OBJECT (gve->priv->audioqueue), "max-size-bytes",
+  g_object_set (G_OBJECT (audioidentity), "single-segment", TRUE, NULL);
+  g_object_set (G_OBJECT (audioqueue), "max-size-bytes",
       4 * 1000 * 1000, "max-size-buffers", 0, "max-size-time", (guint64) 0,
       NULL);
 
   /*Add and link elements */
-  gst_bin_add_many (GST_BIN (gve->priv->aencode_bin),
-      gve->priv->audioidentity,
-      gve->priv->audioencoder, gve->priv->audioqueue, NULL);
-
-  gst_element_link_many (gve->priv->audioidentity,
-      gve->priv->audioencoder, gve->priv->audioqueue, NULL);
+  gst_bin_add_many (GST_BIN (bin), audioidentity, audioencoder, audioqueue,
+      NULL);
+  gst_element_link_many (audioidentity, audioencoder, audioqueue, NULL);
 
   /*Create bin sink pad */
-  sinkpad = gst_element_get_static_pad (gve->priv->audioidentity, "sink");
+  sinkpad = gst_element_get_static_pad (audioidentity, "sink");
   gst_pad_set_active (sinkpad, TRUE);
-  gst_element_add_pad (GST_ELEMENT (gve->priv->aencode_bin),
-      gst_ghost_pad_new ("sink", sinkpad));
+  gst_element_add_pad (bin, gst_ghost_pad_new ("sink", sinkpad));
 
   /*Creat bin src pad */
-  srcpad = gst_element_get_static_pad (gve->priv->audioqueue, "src");
+  srcpad = gst_element_get_static_pad (audioqueue, "src");
   gst_pad_set_active (srcpad, TRUE);
-  gst_element_add_pad (GST_ELEMENT (gve->priv->aencode_bin),
-      gst_ghost_pad_new ("src", srcpad));
+  gst_element_add_pad (bin, gst_ghost_pad_new ("src", srcpad));
 
   gst_object_unref (srcpad);
   gst_object_unref (sinkpad);
-}
 
-/* =========================================== */
-/*                                             */
-/*                Callbacks                    */
-/*                                             */
-/* =========================================== */
+  return bin;
+}
 
+/* Links a decoded pad of a GstNleSource to the matching encode bin */
 static void
-new_decoded_pad_cb (GstElement * object, GstPad * pad, gpointer user_data)
+gve_link_decoded_pad (GstVideoEditor * gve, GstPad * pad,
+    GstElement * vencode_bin, GstElement * aencode_bin)
 {
   GstCaps *caps = NULL;
   GstStructure *str = NULL;
   GstPad *videopad = NULL;
   GstPad *audiopad = NULL;
-  GstVideoEditor *gve = NULL;
-
-  g_return_if_fail (GST_IS_VIDEO_EDITOR (user_data));
-  gve = GST_VIDEO_EDITOR (user_data);
 
   /* check media type */
   caps = GST_PAD_CAPS (pad);
   str = gst_caps_get_structure (caps, 0);
 
   if (g_strrstr (gst_structure_get_name (str), "video")) {
-    videopad = gst_element_get_static_pad (gve->priv->vencode_bin, "sink");
+    videopad = gst_element_get_static_pad (vencode_bin, "sink");
     /* only link once */
     if (GST_PAD_IS_LINKED (videopad)) {
       gst_object_unref (videopad);
@@ -353,8 +407,8 @@ new_decoded_pad_cb (GstElement * object, GstPad * pad, gpointer user_data)
   }
 
   else if (g_strrstr (gst_structure_get_name (str), "audio")
-      && gve->priv->audio_enabled) {
-    audiopad = gst_element_get_static_pad (gve->priv->aencode_bin, "sink");
+      && gve->priv->audio_enabled && aencode_bin != NULL) {
+    audiopad = gst_element_get_static_pad (aencode_bin, "sink");
     /* only link once */
     if (GST_PAD_IS_LINKED (audiopad)) {
       gst_object_unref (audiopad);
@@ -367,6 +421,190 @@ new_decoded_pad_cb (GstElement * object, GstPad * pad, gpointer user_data)
   }
 }
 
+static gchar *
+gve_worker_temp_file (GstVideoEditor * gve, gint index)
+{
+  gchar *name, *path;
+
+  name = g_strdup_printf ("gve-%" G_GINT64_FORMAT "-part%02d",
+      g_get_real_time (), index);
+  path = g_build_filename (gve->priv->temp_dir, name, NULL);
+  g_free (name);
+  return path;
+}
+
+static void
+gve_worker_free (GveRenderWorker * worker)
+{
+  if (worker->bus) {
+    gst_bus_set_flushing (worker->bus, TRUE);
+    if (worker->sig_bus_async)
+      g_signal_handler_disconnect (worker->bus, worker->sig_bus_async);
+    gst_bus_remove_signal_watch (worker->bus);
+    gst_object_unref (worker->bus);
+  }
+  if (worker->pipeline != NULL) {
+    gst_element_set_state (worker->pipeline, GST_STATE_NULL);
+    gst_object_unref (worker->pipeline);
+  }
+  if (worker->output_file != NULL) {
+    /* Parts stored in the cache and source files are kept */
+    if (!worker->cached && !worker->copy)
+      g_unlink (worker->output_file);
+    g_free (worker->output_file);
+  }
+  g_free (worker->cache_file);
+  g_free (worker);
+}
+
+static void
+gve_clear_workers (GstVideoEditor * gve)
+{
+  if (gve->priv->workers != NULL) {
+    g_list_free_full (gve->priv->workers, (GDestroyNotify) gve_worker_free);
+    gve->priv->workers = NULL;
+  }
+  gve->priv->workers_done = 0;
+  gve->priv->concat_source = NULL;
+  if (gve->priv->copy_video_caps != NULL) {
+    gst_caps_unref (gve->priv->copy_video_caps);
+    gve->priv->copy_video_caps = NULL;
+  }
+  if (gve->priv->copy_audio_caps != NULL) {
+    gst_caps_unref (gve->priv->copy_audio_caps);
+    gve->priv->copy_audio_caps = NULL;
+  }
+}
+
+/* =========================================== */
+/*                                             */
+/*                Callbacks                    */
+/*                                             */
+/* =========================================== */
+
+static void
+new_decoded_pad_cb (GstElement * object, GstPad * pad, gpointer user_data)
+{
+  GstVideoEditor *gve = NULL;
+
+  g_return_if_fail (GST_IS_VIDEO_EDITOR (user_data));
+  gve = GST_VIDEO_EDITOR (user_data);
+
+  gve_link_decoded_pad (gve, pad, gve->priv->vencode_bin,
+      gve->priv->aencode_bin);
+}
+
+static void
+gve_worker_decoded_pad_cb (GstElement * object, GstPad * pad,
+    GveRenderWorker * worker)
+{
+  gve_link_decoded_pad (worker->gve, pad, worker->vencode_bin,
+      worker->aencode_bin);
+}
+
+static void
+gve_concat_pad_cb (GstElement * object, GstPad * pad, GstVideoEditor * gve)
+{
+  GstPad *muxpad;
+
+  muxpad = gst_element_get_compatible_pad (gve->priv->muxer, pad, NULL);
+  if (muxpad == NULL) {
+    GST_ERROR_OBJECT (gve, "Could not link %" GST_PTR_FORMAT " to the muxer",
+        pad);
+    return;
+  }
+  gst_pad_link (pad, muxpad);
+  gst_object_unref (muxpad);
+}
+
+/* The parts copied by the smart render can only be muxed with the
+ * re-encoded ones if the encoder produced the same decoder configuration.
+ * When it doesn't, the whole render is re-encoded */
+static void
+gve_smart_render_fallback (GstVideoEditor * gve)
+{
+  GstVideoEditorPrivate *priv = gve->priv;
+
+  GST_WARNING_OBJECT (gve, "The copied parts have a different format than "
+      "the re-encoded ones, re-encoding all the segments");
+
+  if (priv->smart_fallback_id != 0) {
+    g_source_remove (priv->smart_fallback_id);
+    priv->smart_fallback_id = 0;
+  }
+  if (priv->update_id > 0) {
+    g_source_remove (priv->update_id);
+    priv->update_id = 0;
+  }
+  gst_element_set_state (priv->main_pipeline, GST_STATE_NULL);
+  if (priv->concat_source != NULL) {
+    gst_bin_remove_many (GST_BIN (priv->main_pipeline),
+        GST_ELEMENT (priv->concat_source), priv->muxer, priv->file_sink,
+        NULL);
+    priv->muxer = NULL;
+    priv->file_sink = NULL;
+  }
+  gve_clear_workers (gve);
+  gve_start_render (gve);
+}
+
+/* The workers can't be freed from the callbacks of their own bus */
+static gboolean
+gve_smart_render_fallback_idle (GstVideoEditor * gve)
+{
+  gve->priv->smart_fallback_id = 0;
+  gve_smart_render_fallback (gve);
+  return FALSE;
+}
+
+static gboolean
+gve_concat_format_error (GstVideoEditor * gve, GstMessage * message)
+{
+  GError *err = NULL;
+  gboolean ret;
+
+  if (gve->priv->concat_source == NULL ||
+      gve->priv->copy_video_caps == NULL ||
+      GST_MESSAGE_SRC (message) != GST_OBJECT (gve->priv->concat_source))
+    return FALSE;
+
+  gst_message_parse_error (message, &err, NULL);
+  ret = g_error_matches (err, GST_STREAM_ERROR, GST_STREAM_ERROR_FORMAT);
+  g_error_free (err);
+  return ret;
+}
+
+/* Checks the output of a worker of the smart render against the copied
+ * streams, before the remaining parts are encoded for nothing */
+static gboolean
+gve_worker_caps_match (GveRenderWorker * worker)
+{
+  GstVideoEditorPrivate *priv = worker->gve->priv;
+  GstCaps *caps;
+  GstPad *pad;
+  gboolean ret = TRUE;
+
+  if (priv->copy_video_caps == NULL)
+    return TRUE;
+
+  pad = gst_element_get_static_pad (worker->vencode_bin, "src");
+  caps = gst_pad_get_negotiated_caps (pad);
+  gst_object_unref (pad);
+  ret = lgm_caps_can_concat (priv->copy_video_caps, caps);
+  if (caps != NULL)
+    gst_caps_unref (caps);
+
+  if (ret && worker->aencode_bin != NULL && priv->copy_audio_caps != NULL) {
+    pad = gst_element_get_static_pad (worker->aencode_bin, "src");
+    caps = gst_pad_get_negotiated_caps (pad);
+    gst_object_unref (pad);
+    ret = lgm_caps_can_concat (priv->copy_audio_caps, caps);
+    if (caps != NULL)
+      gst_caps_unref (caps);
+  }
+  return ret;
+}
+
 static void
 gve_bus_message_cb (GstBus * bus, GstMessage * message, gpointer data)
 {
@@ -380,6 +618,10 @@ gve_bus_message_cb (GstBus * bus, GstMessage * message, gpointer data)
 
   switch (msg_type) {
     case GST_MESSAGE_ERROR:
+      if (gve_concat_format_error (gve, message)) {
+        gve_smart_render_fallback (gve);
+        break;
+      }
       gve_error_msg (gve, message);
       if (gve->priv->main_pipeline)
         gst_element_set_state (gve->priv->main_pipeline, GST_STATE_NULL);
@@ -409,7 +651,7 @@ gve_bus_message_cb (GstBus * bus, GstMessage * message, gpointer data)
           gst_element_state_get_name (new_state));
       g_free (src_name);
 
-      if (new_state == GST_STATE_PLAYING)
+      if (new_state == GST_STATE_PLAYING && gve->priv->update_id == 0)
         gve_set_tick_timeout (gve, TIMEOUT);
       if (old_state == GST_STATE_PAUSED && new_state == GST_STATE_READY) {
         if (gve->priv->update_id > 0) {
@@ -425,15 +667,33 @@ gve_bus_message_cb (GstBus * bus, GstMessage * message, gpointer data)
             GST_DEBUG_GRAPH_SHOW_ALL, "longomatch-editor-ready-to-paused");
       break;
     }
+    case GST_MESSAGE_ELEMENT:
+    {
+      const GstStructure *s = gst_message_get_structure (message);
+
+      if (s != NULL && gst_structure_has_name (s, "nle-segment-switch")) {
+        gve_segment_switch_msg (gve, s);
+      }
+      break;
+    }
     case GST_MESSAGE_EOS:
       if (gve->priv->update_id > 0) {
         g_source_remove (gve->priv->update_id);
         gve->priv->update_id = 0;
       }
+      if (gve->priv->switch_count > 0) {
+        GST_INFO_OBJECT (gve, "Segment switches: %d, average:%" GST_TIME_FORMAT
+            " max:%" GST_TIME_FORMAT, gve->priv->switch_count,
+            GST_TIME_ARGS (gve->priv->switch_total / gve->priv->switch_count),
+            GST_TIME_ARGS (gve->priv->switch_max));
+      }
       gst_element_set_state (gve->priv->main_pipeline, GST_STATE_NULL);
       g_signal_emit (gve, gve_signals[SIGNAL_PERCENT_COMPLETED], 0, (gfloat) 1);
       /* Close file sink properly */
       g_object_set (G_OBJECT (gve->priv->file_sink), "location", "", NULL);
+      /* Remove the temporary parts */
+      gve_clear_workers (gve);
+      gve_cache_evict (gve);
       break;
     default:
       GST_LOG ("Unhandled message: %" GST_PTR_FORMAT, message);
@@ -441,6 +701,26 @@ gve_bus_message_cb (GstBus * bus, GstMessage * message, gpointer data)
   }
 }
 
+static void
+gve_segment_switch_msg (GstVideoEditor * gve, const GstStructure * s)
+{
+  gint index = 0;
+  guint64 latency = 0;
+  gboolean prefetched = FALSE;
+
+  gst_structure_get_int (s, "index", &index);
+  gst_structure_get_clock_time (s, "latency", &latency);
+  gst_structure_get_boolean (s, "prefetched", &prefetched);
+
+  gve->priv->switch_count++;
+  gve->priv->switch_total += latency;
+  gve->priv->switch_max = MAX (gve->priv->switch_max, latency);
+
+  GST_INFO_OBJECT (gve, "Switched to segment %d in %" GST_TIME_FORMAT
+      " (%s)", index, GST_TIME_ARGS (latency),
+      prefetched ? "pre-rolled" : "not pre-rolled");
+}
+
 static void
 gve_error_msg (GstVideoEditor * gve, GstMessage * msg)
 {
@@ -464,11 +744,45 @@ gve_error_msg (GstVideoEditor * gve, GstMessage * msg)
   g_free (dbg);
 }
 
+static gfloat
+gve_parallel_progress (GstVideoEditor * gve)
+{
+  GveRenderWorker *worker;
+  GList *l;
+  gint64 encoded = 0;
+  gfloat progress;
+
+  /* Encoding the parts takes most of the time, the last 10% is used for
+   * the concatenation */
+  if (gve->priv->concat_source != NULL) {
+    progress = 0.9;
+    if (gve->priv->duration > 0)
+      progress += 0.1 * gve->priv->last_pos / gve->priv->duration;
+    return MIN (progress, 1.0);
+  }
+
+  if (gve->priv->duration <= 0) {
+    return 0.9 * gve->priv->workers_done / g_list_length (gve->priv->workers);
+  }
+
+  for (l = gve->priv->workers; l; l = l->next) {
+    worker = (GveRenderWorker *) l->data;
+    if (worker->done && worker->duration > 0)
+      encoded += worker->duration;
+    else
+      encoded += worker->last_pos;
+  }
+  progress = 0.9 * encoded / gve->priv->duration;
+  return MIN (progress, 0.9);
+}
+
 static gboolean
 gve_query_timeout (GstVideoEditor * gve)
 {
   gfloat progress = 0.0;
-  if (gve->priv->duration > 0) {
+  if (gve->priv->workers != NULL) {
+    progress = gve_parallel_progress (gve);
+  } else if (gve->priv->duration > 0) {
     progress = (float) gve->priv->last_pos / (float) gve->priv->duration;
   } else {
     /* fallback to source progress reporting */
@@ -488,111 +802,702 @@ gve_on_buffer_cb (GstPad * pad, GstBuffer * buf, GstVideoEditor * gve)
   return TRUE;
 }
 
-/* =========================================== */
-/*                                             */
-/*              Public Methods                 */
-/*                                             */
-/* =========================================== */
-
+static gboolean
+gve_worker_on_buffer_cb (GstPad * pad, GstBuffer * buf,
+    GveRenderWorker * worker)
+{
+  if (GST_BUFFER_TIMESTAMP_IS_VALID (buf)) {
+    worker->last_pos = MAX (worker->last_pos, GST_BUFFER_TIMESTAMP (buf));
+  }
+  return TRUE;
+}
 
-void
-gst_video_editor_add_segment (GstVideoEditor * gve, gchar * file,
-    gint64 start, gint64 duration, gdouble rate,
-    gchar * title, gboolean hasAudio,
-    guint roi_x, guint roi_y, guint roi_w, guint roi_h)
+/* Muxes the parts of a GstConcatSource in the output file */
+static void
+gve_start_concat (GstVideoEditor * gve, GstConcatSource * csrc)
 {
-  GstState cur_state;
-  GstNleRectangle roi = { roi_x, roi_y, roi_w, roi_h };
-  guint64 stop = -1;
+  GError *error = NULL;
+  GstPad *pad;
 
-  g_return_if_fail (GST_IS_VIDEO_EDITOR (gve));
+  GST_INFO_OBJECT (gve, "Concatenating parts in %s", gve->priv->output_file);
 
-  gst_element_get_state (gve->priv->main_pipeline, &cur_state, NULL, 0);
-  if (cur_state > GST_STATE_READY) {
-    GST_WARNING ("Segments can only be added for a state <= GST_STATE_READY");
+  gve->priv->muxer = lgm_create_muxer (gve->priv->muxer_type, GVE_ERROR,
+      &error);
+  if (error) {
+    g_signal_emit (gve, gve_signals[SIGNAL_ERROR], 0, error->message);
+    g_error_free (error);
+    gst_object_unref (csrc);
+    gve_clear_workers (gve);
     return;
   }
+  lgm_set_muxer_faststart (gve->priv->muxer, gve->priv->output_file);
+  gve->priv->file_sink = gst_element_factory_make ("filesink", "filesink");
+  g_object_set (G_OBJECT (gve->priv->file_sink), "location",
+      gve->priv->output_file, NULL);
 
-  start = start * GST_MSECOND;
-  if (duration != -1) {
-    duration = duration * GST_MSECOND;
-    stop = start + duration;
-  }
+  gve->priv->concat_source = csrc;
+  g_signal_connect (gve->priv->concat_source, "pad-added",
+      G_CALLBACK (gve_concat_pad_cb), gve);
 
-  gst_nle_source_add_item (gve->priv->nle_source, file, title, start,
-      stop, rate, FALSE, roi);
+  gst_bin_add_many (GST_BIN (gve->priv->main_pipeline),
+      GST_ELEMENT (gve->priv->concat_source), gve->priv->muxer,
+      gve->priv->file_sink, NULL);
+  gst_element_link (gve->priv->muxer, gve->priv->file_sink);
 
-  GST_INFO ("New segment: start={%" GST_TIME_FORMAT "} duration={%"
-      GST_TIME_FORMAT "} ", GST_TIME_ARGS (gve->priv->duration),
-      GST_TIME_ARGS (duration));
+  gve->priv->last_pos = 0;
+  pad = gst_element_get_static_pad (gve->priv->file_sink, "sink");
+  gst_pad_add_buffer_probe (pad, (GCallback) gve_on_buffer_cb, gve);
+  gst_object_unref (pad);
 
-  if (duration != -1)
-    gve->priv->duration += duration;
+  gst_element_set_state (gve->priv->main_pipeline, GST_STATE_PLAYING);
 }
 
-void
-gst_video_editor_add_image_segment (GstVideoEditor * gve, gchar * file,
-    guint64 start, gint64 duration, gchar * title,
-    guint roi_x, guint roi_y, guint roi_w, guint roi_h)
+static void
+gve_concat_workers (GstVideoEditor * gve)
 {
-  GstState cur_state;
-  GstNleRectangle roi = { roi_x, roi_y, roi_w, roi_h };
+  GstConcatSource *csrc;
+  GveRenderWorker *worker;
+  GList *l;
+
+  csrc = gst_concat_source_new ();
+  gst_concat_source_configure (csrc, gve->priv->audio_enabled);
+  for (l = gve->priv->workers; l; l = l->next) {
+    worker = (GveRenderWorker *) l->data;
+    if (worker->copy)
+      gst_concat_source_add_part (csrc, worker->output_file, worker->start,
+          worker->stop);
+    else
+      gst_concat_source_add_part (csrc, worker->output_file,
+          GST_CLOCK_TIME_NONE, GST_CLOCK_TIME_NONE);
+  }
+  gve_start_concat (gve, csrc);
+}
 
-  g_return_if_fail (GST_IS_VIDEO_EDITOR (gve));
+/* Starts the pending workers, keeping at most parallel_workers running,
+ * and concatenates the parts once all of them are done */
+static void
+gve_start_workers (GstVideoEditor * gve)
+{
+  GveRenderWorker *worker;
+  guint running = 0;
+  GList *l;
 
-  gst_element_get_state (gve->priv->main_pipeline, &cur_state, NULL, 0);
-  if (cur_state > GST_STATE_READY) {
-    GST_WARNING ("Segments can only be added for a state <= GST_STATE_READY");
+  if (gve->priv->workers_done == g_list_length (gve->priv->workers)) {
+    gve_concat_workers (gve);
     return;
   }
 
-  duration = duration * GST_MSECOND;
-  start = start * GST_MSECOND;
-
-  gst_nle_source_add_item (gve->priv->nle_source, file, title, start,
-      start + duration, 1, TRUE, roi);
-
-  GST_INFO ("New segment: start={%" GST_TIME_FORMAT "} duration={%"
-      GST_TIME_FORMAT "} ", GST_TIME_ARGS (gve->priv->duration),
-      GST_TIME_ARGS (duration));
+  for (l = gve->priv->workers; l; l = l->next) {
+    worker = (GveRenderWorker *) l->data;
+    if (worker->started && !worker->done)
+      running++;
+  }
 
-  gve->priv->duration += duration;
+  for (l = gve->priv->workers; l && running < gve->priv->parallel_workers;
+      l = l->next) {
+    worker = (GveRenderWorker *) l->data;
+    if (!worker->started && worker->pipeline != NULL) {
+      worker->started = TRUE;
+      gst_element_set_state (worker->pipeline, GST_STATE_PLAYING);
+      running++;
+    }
+  }
 }
 
-void
-gst_video_editor_clear_segments_list (GstVideoEditor * gve)
+/* Moves a complete part to the cache. The rename is atomic, so other
+ * renders never see an incomplete part */
+static void
+gve_worker_store_in_cache (GveRenderWorker * worker)
 {
-  g_return_if_fail (GST_IS_VIDEO_EDITOR (gve));
+  if (g_rename (worker->output_file, worker->cache_file) != 0 &&
+      !g_file_test (worker->cache_file, G_FILE_TEST_IS_REGULAR)) {
+    GST_WARNING_OBJECT (worker->gve, "Could not store %s in the cache",
+        worker->cache_file);
+    return;
+  }
+  /* If another render stored the same part first, its part is used */
+  g_unlink (worker->output_file);
+  g_free (worker->output_file);
+  worker->output_file = worker->cache_file;
+  worker->cache_file = NULL;
+  worker->cached = TRUE;
+}
 
-  GST_INFO_OBJECT (gve, "Clearing list of segments");
+/* Completes the repetitions of the segment encoded by this worker */
+static void
+gve_worker_done_duplicates (GveRenderWorker * worker)
+{
+  GstVideoEditor *gve = worker->gve;
+  GveRenderWorker *dup;
+  GList *l;
+
+  for (l = gve->priv->workers; l; l = l->next) {
+    dup = (GveRenderWorker *) l->data;
+    if (dup->encoder != worker)
+      continue;
+    /* The part is owned and removed by the worker that encoded it */
+    g_free (dup->output_file);
+    dup->output_file = g_strdup (worker->output_file);
+    dup->cached = TRUE;
+    dup->started = TRUE;
+    dup->done = TRUE;
+    gve->priv->workers_done++;
+  }
+}
 
+/* The workers can't be freed from the callbacks of their own bus */
+static gboolean
+gve_workers_error_idle (GstVideoEditor * gve)
+{
+  gve->priv->workers_error_id = 0;
   gst_video_editor_cancel (gve);
-  gst_element_set_state (gve->priv->main_pipeline, GST_STATE_NULL);
-
-  gve->priv->nle_source = NULL;
-  gve->priv->duration = 0;
+  return FALSE;
 }
 
-void
-gst_video_editor_start (GstVideoEditor * gve)
+static void
+gve_worker_bus_message_cb (GstBus * bus, GstMessage * message,
+    GveRenderWorker * worker)
 {
-  GError *error = NULL;
-  GstPad *pad;
-
-  g_return_if_fail (GST_IS_VIDEO_EDITOR (gve));
+  GstVideoEditor *gve = worker->gve;
 
-  GST_INFO_OBJECT (gve, "Starting. output file: %s", gve->priv->output_file);
-
-  /* Create elements */
-  gve->priv->muxer = lgm_create_muxer (gve->priv->muxer_type, GVE_ERROR,
-      &error);
-  if (error) {
-    g_signal_emit (gve, gve_signals[SIGNAL_ERROR], 0, error->message);
-    g_error_free (error);
+  switch (GST_MESSAGE_TYPE (message)) {
+    case GST_MESSAGE_ERROR:
+      if (gve->priv->workers_error_id != 0)
+        break;
+      gve_error_msg (gve, message);
+      gve->priv->workers_error_id = g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+          (GSourceFunc) gve_workers_error_idle, g_object_ref (gve),
+          g_object_unref);
+      break;
+    case GST_MESSAGE_EOS:
+      GST_INFO_OBJECT (gve, "Part %s encoded", worker->output_file);
+      if (!gve_worker_caps_match (worker)) {
+        if (gve->priv->smart_fallback_id == 0) {
+          gve->priv->smart_fallback_id =
+              g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+              (GSourceFunc) gve_smart_render_fallback_idle,
+              g_object_ref (gve), g_object_unref);
+        }
+        break;
+      }
+      gst_element_set_state (worker->pipeline, GST_STATE_NULL);
+      worker->done = TRUE;
+      gve->priv->workers_done++;
+      if (worker->cache_file != NULL)
+        gve_worker_store_in_cache (worker);
+      gve_worker_done_duplicates (worker);
+      gve_start_workers (gve);
+      break;
+    default:
+      break;
+  }
+}
+
+static GveRenderWorker *
+gve_create_worker (GstVideoEditor * gve, guint index,
+    GstNleSource * nle_source, gint64 duration, const gchar * output_file,
+    GError ** err)
+{
+  GveRenderWorker *worker;
+  GstElement *muxer, *file_sink;
+  GstPad *pad;
+
+  worker = g_new0 (GveRenderWorker, 1);
+  worker->gve = gve;
+  worker->duration = duration;
+  if (output_file != NULL)
+    worker->output_file = g_strdup (output_file);
+  else
+    worker->output_file = gve_worker_temp_file (gve, index);
+  worker->pipeline = gst_pipeline_new (NULL);
+
+  /* The parts use the same encoding settings than the final output, so they
+   * can be concatenated without re-encoding. A new encoder is created for
+   * each part, which always starts with a keyframe */
+  worker->vencode_bin = gve_create_video_encode_bin (gve, err);
+  if (*err) {
+    gst_object_unref (nle_source);
+    return worker;
+  }
+  muxer = lgm_create_muxer (gve->priv->muxer_type, GVE_ERROR, err);
+  if (*err) {
+    gst_object_unref (nle_source);
+    gst_object_unref (worker->vencode_bin);
+    return worker;
+  }
+  if (gve->priv->audio_enabled) {
+    worker->aencode_bin = gve_create_audio_encode_bin (gve, err);
+    if (*err) {
+      gst_object_unref (nle_source);
+      gst_object_unref (worker->vencode_bin);
+      gst_object_unref (muxer);
+      return worker;
+    }
+  }
+
+  file_sink = gst_element_factory_make ("filesink", NULL);
+  g_object_set (G_OBJECT (file_sink), "location", worker->output_file, NULL);
+
+  worker->nle_source = nle_source;
+  g_signal_connect (worker->nle_source, "pad-added",
+      G_CALLBACK (gve_worker_decoded_pad_cb), worker);
+
+  gst_bin_add_many (GST_BIN (worker->pipeline),
+      GST_ELEMENT (worker->nle_source), worker->vencode_bin, muxer, file_sink,
+      NULL);
+  gst_element_link_many (worker->vencode_bin, muxer, file_sink, NULL);
+  if (worker->aencode_bin != NULL) {
+    gst_bin_add (GST_BIN (worker->pipeline), worker->aencode_bin);
+    gst_element_link (worker->aencode_bin, muxer);
+  }
+
+  pad = gst_element_get_static_pad (file_sink, "sink");
+  gst_pad_add_buffer_probe (pad, (GCallback) gve_worker_on_buffer_cb, worker);
+  gst_object_unref (pad);
+
+  worker->bus = gst_element_get_bus (worker->pipeline);
+  gst_bus_add_signal_watch (worker->bus);
+  worker->sig_bus_async = g_signal_connect (worker->bus, "message",
+      G_CALLBACK (gve_worker_bus_message_cb), worker);
+
+  GST_INFO_OBJECT (gve, "Part %d with %d segments encoded in %s", index,
+      gst_nle_source_get_n_items (nle_source), worker->output_file);
+
+  return worker;
+}
+
+static gboolean
+gve_video_codec_matches (GstVideoEditor * gve, const GstStructure * s)
+{
+  const gchar *mime = gst_structure_get_name (s);
+  gint version = 0;
+
+  gst_structure_get_int (s, "mpegversion", &version);
+
+  switch (gve->priv->video_encoder_type) {
+    case VIDEO_ENCODER_H264:
+      return g_str_equal (mime, "video/x-h264");
+    case VIDEO_ENCODER_VP8:
+      return g_str_equal (mime, "video/x-vp8");
+    case VIDEO_ENCODER_THEORA:
+      return g_str_equal (mime, "video/x-theora");
+    case VIDEO_ENCODER_MPEG4:
+    case VIDEO_ENCODER_XVID:
+      return g_str_equal (mime, "video/x-xvid") ||
+          g_str_equal (mime, "video/x-divx") ||
+          (g_str_equal (mime, "video/mpeg") && version == 4);
+    case VIDEO_ENCODER_MPEG2:
+      return g_str_equal (mime, "video/mpeg") && version == 2;
+    default:
+      return FALSE;
+  }
+}
+
+static gboolean
+gve_audio_codec_matches (GstVideoEditor * gve, const GstStructure * s)
+{
+  const gchar *mime = gst_structure_get_name (s);
+  gint version = 0;
+
+  gst_structure_get_int (s, "mpegversion", &version);
+
+  switch (gve->priv->audio_encoder_type) {
+    case AUDIO_ENCODER_MP3:
+      return g_str_equal (mime, "audio/mpeg") && version == 1;
+    case AUDIO_ENCODER_AAC:
+      return g_str_equal (mime, "audio/mpeg") && version == 4;
+    case AUDIO_ENCODER_VORBIS:
+      return g_str_equal (mime, "audio/x-vorbis");
+    default:
+      return FALSE;
+  }
+}
+
+/* Checks if the streams of a file can be copied to the output as they are,
+ * returning their caps. The copied streams are muxed with re-encoded ones,
+ * so they must have the format of the GstNleSource output */
+static gboolean
+gve_can_copy_uri (GstVideoEditor * gve, const gchar * uri,
+    GstCaps ** video_caps, GstCaps ** audio_caps)
+{
+  GstDiscoverer *discoverer;
+  GstDiscovererInfo *info;
+  GstDiscovererVideoInfo *vinfo;
+  GstDiscovererAudioInfo *ainfo;
+  GList *videos = NULL, *audios = NULL;
+  GstCaps *caps;
+  GError *err = NULL;
+  gboolean ret = FALSE;
+
+  *video_caps = *audio_caps = NULL;
+
+  discoverer = gst_discoverer_new (4 * GST_SECOND, &err);
+  if (err != NULL) {
+    g_error_free (err);
+    return FALSE;
+  }
+
+  info = gst_discoverer_discover_uri (discoverer, uri, &err);
+  if (err != NULL) {
+    GST_WARNING_OBJECT (gve, "Could not discover %s: %s", uri, err->message);
+    g_error_free (err);
+    goto done;
+  }
+
+  videos = gst_discoverer_info_get_video_streams (info);
+  audios = gst_discoverer_info_get_audio_streams (info);
+  if (videos == NULL) {
+    goto done;
+  }
+
+  vinfo = (GstDiscovererVideoInfo *) videos->data;
+  caps = gst_discoverer_stream_info_get_caps (GST_DISCOVERER_STREAM_INFO
+      (vinfo));
+  GST_DEBUG_OBJECT (gve, "Video stream of %s: %" GST_PTR_FORMAT, uri, caps);
+  /* GstNleSource outputs square pixels */
+  ret = gve_video_codec_matches (gve, gst_caps_get_structure (caps, 0)) &&
+      gst_discoverer_video_info_get_width (vinfo) == gve->priv->width &&
+      gst_discoverer_video_info_get_height (vinfo) == gve->priv->height &&
+      gst_discoverer_video_info_get_framerate_num (vinfo) * gve->priv->fps_d ==
+      gst_discoverer_video_info_get_framerate_denom (vinfo) * gve->priv->fps_n
+      && gst_discoverer_video_info_get_par_num (vinfo) ==
+      gst_discoverer_video_info_get_par_denom (vinfo);
+  *video_caps = caps;
+
+  if (ret && gve->priv->audio_enabled) {
+    /* Sources without audio would need silence to be encoded */
+    ret = audios != NULL;
+    if (ret) {
+      ainfo = (GstDiscovererAudioInfo *) audios->data;
+      caps = gst_discoverer_stream_info_get_caps (GST_DISCOVERER_STREAM_INFO
+          (ainfo));
+      GST_DEBUG_OBJECT (gve, "Audio stream of %s: %" GST_PTR_FORMAT, uri,
+          caps);
+      ret = gve_audio_codec_matches (gve, gst_caps_get_structure (caps, 0)) &&
+          gst_discoverer_audio_info_get_sample_rate (ainfo) ==
+          GST_NLE_SOURCE_AUDIO_RATE &&
+          gst_discoverer_audio_info_get_channels (ainfo) ==
+          GST_NLE_SOURCE_AUDIO_CHANNELS;
+      *audio_caps = caps;
+    }
+  }
+
+  if (!ret) {
+    if (*video_caps != NULL)
+      gst_caps_unref (*video_caps);
+    if (*audio_caps != NULL)
+      gst_caps_unref (*audio_caps);
+    *video_caps = *audio_caps = NULL;
+  }
+
+done:
+  if (videos != NULL)
+    gst_discoverer_stream_info_list_free (videos);
+  if (audios != NULL)
+    gst_discoverer_stream_info_list_free (audios);
+  if (info != NULL)
+    gst_discoverer_info_unref (info);
+  g_object_unref (discoverer);
+  return ret;
+}
+
+/* Identifies the encoded output of a segment. Any change in the segment,
+ * in its source file or in the encoding settings produces a new key */
+static gchar *
+gve_cache_key (GstVideoEditor * gve, GstNleSrcItem * item)
+{
+  GstVideoEditorPrivate *priv = gve->priv;
+  GstNleSource *nlesrc = priv->nle_source;
+  GChecksum *checksum;
+  GStatBuf st;
+  gchar *str, *path, *key;
+
+  checksum = g_checksum_new (G_CHECKSUM_SHA1);
+
+  str = g_strdup_printf ("%d|%s|%" G_GUINT64_FORMAT "|%" G_GUINT64_FORMAT
+      "|%f|%d|%u,%u,%u,%u|%s", GVE_CACHE_VERSION, item->file_path,
+      item->start, item->stop,
+      item->rate, item->still_picture, item->roi.x, item->roi.y,
+      item->roi.width, item->roi.height,
+      priv->title_enabled && item->title ? item->title : "");
+  g_checksum_update (checksum, (guchar *) str, -1);
+  g_free (str);
+
+  str = g_strdup_printf ("|%d,%d,%d,%u,%u,%ux%u@%u/%u,%d,%d,%u",
+      priv->video_encoder_type, priv->audio_encoder_type, priv->muxer_type,
+      priv->video_quality, priv->audio_quality, priv->width, priv->height,
+      priv->fps_n, priv->fps_d, priv->audio_enabled, priv->title_enabled,
+      priv->title_size);
+  g_checksum_update (checksum, (guchar *) str, -1);
+  g_free (str);
+
+  /* A file replaced with a new recording invalidates its segments */
+  path = g_filename_from_uri (item->file_path, NULL, NULL);
+  if (path != NULL && g_stat (path, &st) == 0) {
+    str = g_strdup_printf ("|%" G_GINT64_FORMAT ",%" G_GINT64_FORMAT,
+        (gint64) st.st_size, (gint64) st.st_mtime);
+    g_checksum_update (checksum, (guchar *) str, -1);
+    g_free (str);
+  }
+  g_free (path);
+
+  if (nlesrc->watermark != NULL) {
+    str = g_strdup_printf ("|%f,%f,%f", nlesrc->watermark_x,
+        nlesrc->watermark_y, nlesrc->watermark_height);
+    g_checksum_update (checksum, (guchar *) str, -1);
+    g_free (str);
+    g_checksum_update (checksum, gdk_pixbuf_get_pixels (nlesrc->watermark),
+        gdk_pixbuf_get_rowstride (nlesrc->watermark) *
+        gdk_pixbuf_get_height (nlesrc->watermark));
+  }
+
+  key = g_strdup (g_checksum_get_string (checksum));
+  g_checksum_free (checksum);
+  return key;
+}
+
+static gint
+gve_cache_entry_compare (GveCacheEntry * a, GveCacheEntry * b)
+{
+  if (a->mtime == b->mtime)
+    return 0;
+  return a->mtime < b->mtime ? -1 : 1;
+}
+
+static void
+gve_cache_entry_free (GveCacheEntry * entry)
+{
+  g_free (entry->path);
+  g_free (entry);
+}
+
+/* Removes the least recently used parts until the cache fits in its
+ * maximum size. Parts are touched when they are used */
+static void
+gve_cache_evict (GstVideoEditor * gve)
+{
+  GDir *dir;
+  GList *entries = NULL, *l;
+  GveCacheEntry *entry;
+  GStatBuf st;
+  const gchar *name;
+  guint64 total = 0;
+
+  if (gve->priv->cache_dir == NULL || gve->priv->cache_max_size == 0)
+    return;
+
+  dir = g_dir_open (gve->priv->cache_dir, 0, NULL);
+  if (dir == NULL)
+    return;
+
+  while ((name = g_dir_read_name (dir)) != NULL) {
+    gchar *path = g_build_filename (gve->priv->cache_dir, name, NULL);
+
+    if (g_stat (path, &st) != 0 || !S_ISREG (st.st_mode)) {
+      g_free (path);
+      continue;
+    }
+    if (g_str_has_suffix (name, ".part")) {
+      /* Parts being encoded by other renders are not evicted */
+      if (g_get_real_time () / G_USEC_PER_SEC - st.st_mtime >
+          GVE_CACHE_STALE_PART)
+        g_unlink (path);
+      g_free (path);
+      continue;
+    }
+    entry = g_new0 (GveCacheEntry, 1);
+    entry->path = path;
+    entry->size = st.st_size;
+    entry->mtime = st.st_mtime;
+    entries = g_list_prepend (entries, entry);
+    total += entry->size;
+  }
+  g_dir_close (dir);
+
+  entries = g_list_sort (entries, (GCompareFunc) gve_cache_entry_compare);
+  for (l = entries; l && total > gve->priv->cache_max_size; l = l->next) {
+    entry = (GveCacheEntry *) l->data;
+    GST_INFO_OBJECT (gve, "Removing %s from the cache", entry->path);
+    g_unlink (entry->path);
+    total -= entry->size;
+  }
+  g_list_free_full (entries, (GDestroyNotify) gve_cache_entry_free);
+}
+
+/* Encodes each segment in its own part. Parts found in the cache are
+ * concatenated as they are and only the new segments are encoded */
+static void
+gve_start_cached (GstVideoEditor * gve)
+{
+  GveRenderWorker *worker;
+  GstNleSrcItem *item;
+  GError *error = NULL;
+  GHashTable *encoders;
+  gchar *key, *cache_file, *part_file;
+  guint i, n_items;
+  gint64 dur;
+  gint fd;
+
+  g_mkdir_with_parents (gve->priv->cache_dir, 0755);
+  n_items = gst_nle_source_get_n_items (gve->priv->nle_source);
+  /* Workers encoding each missing key, so that it's written only once */
+  encoders = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  for (i = 0; i < n_items; i++) {
+    item = gst_nle_source_get_item (gve->priv->nle_source, i);
+    dur = gst_nle_source_get_item_duration (gve->priv->nle_source, i);
+    if (!GST_CLOCK_TIME_IS_VALID (dur))
+      dur = 0;
+
+    key = gve_cache_key (gve, item);
+    cache_file = g_build_filename (gve->priv->cache_dir, key, NULL);
+
+    if (g_hash_table_lookup (encoders, key) != NULL) {
+      GST_INFO_OBJECT (gve, "Segment %d is a repetition of an encoded one", i);
+      worker = g_new0 (GveRenderWorker, 1);
+      worker->gve = gve;
+      worker->output_file = cache_file;
+      worker->cached = TRUE;
+      worker->duration = dur;
+      worker->encoder = g_hash_table_lookup (encoders, key);
+      g_free (key);
+    } else if (g_file_test (cache_file, G_FILE_TEST_IS_REGULAR)) {
+      GST_INFO_OBJECT (gve, "Segment %d found in the cache: %s", i,
+          cache_file);
+      /* Update the access time for the LRU eviction */
+      g_utime (cache_file, NULL);
+      worker = g_new0 (GveRenderWorker, 1);
+      worker->gve = gve;
+      worker->output_file = cache_file;
+      worker->cached = TRUE;
+      worker->duration = dur;
+      worker->started = TRUE;
+      worker->done = TRUE;
+      gve->priv->workers_done++;
+      gve->priv->cache_hits++;
+      g_free (key);
+    } else {
+      /* A unique name, in case another render encodes the same part */
+      part_file = g_strdup_printf ("%s.XXXXXX.part", cache_file);
+      fd = g_mkstemp (part_file);
+      if (fd != -1)
+        g_close (fd, NULL);
+      worker = gve_create_worker (gve, i,
+          gst_nle_source_copy_range (gve->priv->nle_source, i, 1), dur,
+          part_file, &error);
+      worker->cache_file = cache_file;
+      g_free (part_file);
+      g_hash_table_insert (encoders, key, worker);
+      gve->priv->cache_misses++;
+    }
+    gve->priv->workers = g_list_append (gve->priv->workers, worker);
+    if (error) {
+      g_signal_emit (gve, gve_signals[SIGNAL_ERROR], 0, error->message);
+      g_error_free (error);
+      g_hash_table_destroy (encoders);
+      gve_clear_workers (gve);
+      return;
+    }
+  }
+  g_hash_table_destroy (encoders);
+
+  GST_INFO_OBJECT (gve, "Cache hits: %d misses: %d", gve->priv->cache_hits,
+      gve->priv->cache_misses);
+
+  gve_start_workers (gve);
+  gve_set_tick_timeout (gve, TIMEOUT);
+}
+
+/* Splits the segments in contiguous ranges of similar duration and encodes
+ * each of them in parallel */
+static void
+gve_start_parallel (GstVideoEditor * gve)
+{
+  GveRenderWorker *worker;
+  GError *error = NULL;
+  guint n_items, n_workers, first, count, i;
+  gint64 remaining = 0, target, acc, dur;
+
+  n_items = gst_nle_source_get_n_items (gve->priv->nle_source);
+  n_workers = MIN (gve->priv->parallel_workers, n_items);
+
+  for (i = 0; i < n_items; i++) {
+    dur = gst_nle_source_get_item_duration (gve->priv->nle_source, i);
+    if (GST_CLOCK_TIME_IS_VALID (dur))
+      remaining += dur;
+  }
+
+  GST_INFO_OBJECT (gve, "Rendering %d segments with %d workers", n_items,
+      n_workers);
+
+  first = 0;
+  for (i = 0; i < n_workers; i++) {
+    target = remaining / (n_workers - i);
+    count = 0;
+    acc = 0;
+    /* Leave at least one segment for each of the next workers */
+    while (first + count < n_items - (n_workers - i - 1)) {
+      dur = gst_nle_source_get_item_duration (gve->priv->nle_source,
+          first + count);
+      if (!GST_CLOCK_TIME_IS_VALID (dur))
+        dur = 0;
+      if (count > 0 && i < n_workers - 1 && acc + dur / 2 > target)
+        break;
+      acc += dur;
+      count++;
+    }
+    remaining -= acc;
+
+    worker = gve_create_worker (gve, i,
+        gst_nle_source_copy_range (gve->priv->nle_source, first, count), acc,
+        NULL, &error);
+    gve->priv->workers = g_list_append (gve->priv->workers, worker);
+    if (error) {
+      g_signal_emit (gve, gve_signals[SIGNAL_ERROR], 0, error->message);
+      g_error_free (error);
+      gve_clear_workers (gve);
+      return;
+    }
+    first += count;
+  }
+
+  gve_start_workers (gve);
+  gve_set_tick_timeout (gve, TIMEOUT);
+}
+
+/* Renders the segments with the cache, in parallel or in a single
+ * pipeline */
+static void
+gve_start_render (GstVideoEditor * gve)
+{
+  GError *error = NULL;
+  GstPad *pad;
+
+  if (gve->priv->cache_dir != NULL &&
+      gst_nle_source_get_n_items (gve->priv->nle_source) > 0) {
+    gve_start_cached (gve);
+    g_signal_emit (gve, gve_signals[SIGNAL_PERCENT_COMPLETED], 0, (gfloat) 0);
+    return;
+  }
+
+  if (gve->priv->parallel_workers > 1 &&
+      gst_nle_source_get_n_items (gve->priv->nle_source) > 1) {
+    gve_start_parallel (gve);
+    g_signal_emit (gve, gve_signals[SIGNAL_PERCENT_COMPLETED], 0, (gfloat) 0);
+    return;
+  }
+
+  /* Create elements */
+  gve->priv->muxer = lgm_create_muxer (gve->priv->muxer_type, GVE_ERROR,
+      &error);
+  if (error) {
+    g_signal_emit (gve, gve_signals[SIGNAL_ERROR], 0, error->message);
+    g_error_free (error);
     return;
   }
+  lgm_set_muxer_faststart (gve->priv->muxer, gve->priv->output_file);
   gve->priv->file_sink = gst_element_factory_make ("filesink", "filesink");
-  gve_create_video_encode_bin (gve, &error);
+  gve->priv->vencode_bin = gve_create_video_encode_bin (gve, &error);
   if(error) {
     g_signal_emit (gve, gve_signals[SIGNAL_ERROR], 0, error->message);
     g_error_free (error);
@@ -612,7 +1517,8 @@ gst_video_editor_start (GstVideoEditor * gve)
       gve->priv->muxer, gve->priv->file_sink, NULL);
 
   if (gve->priv->audio_enabled) {
-    gve_create_audio_encode_bin (gve, &error);
+    if (gve->priv->aencode_bin == NULL)
+      gve->priv->aencode_bin = gve_create_audio_encode_bin (gve, &error);
     if(error) {
       g_signal_emit (gve, gve_signals[SIGNAL_ERROR], 0, error->message);
       g_error_free (error);
@@ -622,7 +1528,6 @@ gst_video_editor_start (GstVideoEditor * gve)
     gst_element_link (gve->priv->aencode_bin, gve->priv->muxer);
   }
 
-  gve->priv->last_pos = 0;
   pad = gst_element_get_static_pad (gve->priv->file_sink, "sink");
   gst_pad_add_buffer_probe (pad, (GCallback) gve_on_buffer_cb, gve);
   gst_object_unref (pad);
@@ -632,16 +1537,462 @@ gst_video_editor_start (GstVideoEditor * gve)
   g_signal_emit (gve, gve_signals[SIGNAL_PERCENT_COMPLETED], 0, (gfloat) 0);
 }
 
+/* A piece of a segment in the smart render, either copied from its file or
+ * re-encoded */
+typedef struct
+{
+  guint item;
+  guint64 start;
+  guint64 stop;
+  gboolean copy;
+} GveSmartPiece;
+
+/* Streams of a source file that can be copied to the output */
+typedef struct
+{
+  gboolean copy;
+  GstCaps *video_caps;
+  GstCaps *audio_caps;
+} GveSmartFile;
+
+/* The segments are split in pieces in a thread, since discovering the
+ * source files and their keyframes takes a while */
+typedef struct _GveSmartPlan
+{
+  GstVideoEditor *gve;
+  gchar **uris;
+  GArray *segments;
+  GArray *pieces;
+  /* Caps of the copied streams, all the copied files must have them */
+  GstCaps *video_caps;
+  GstCaps *audio_caps;
+  volatile gint cancelled;
+} GveSmartPlan;
+
+static void
+gve_smart_plan_free (GveSmartPlan * plan)
+{
+  g_strfreev (plan->uris);
+  g_array_free (plan->segments, TRUE);
+  if (plan->pieces != NULL)
+    g_array_free (plan->pieces, TRUE);
+  if (plan->video_caps != NULL)
+    gst_caps_unref (plan->video_caps);
+  if (plan->audio_caps != NULL)
+    gst_caps_unref (plan->audio_caps);
+  g_object_unref (plan->gve);
+  g_free (plan);
+}
+
+static GveSmartFile *
+gve_smart_file_new (GstVideoEditor * gve, const gchar * uri)
+{
+  GveSmartFile *file;
+
+  file = g_new0 (GveSmartFile, 1);
+  file->copy = gve_can_copy_uri (gve, uri, &file->video_caps,
+      &file->audio_caps);
+  return file;
+}
+
+static void
+gve_smart_file_free (GveSmartFile * file)
+{
+  if (file->video_caps != NULL)
+    gst_caps_unref (file->video_caps);
+  if (file->audio_caps != NULL)
+    gst_caps_unref (file->audio_caps);
+  g_free (file);
+}
+
+/* Checks if the streams of a file can be muxed with the ones copied from
+ * the other files, the first copied file sets the caps of the output */
+static gboolean
+gve_smart_plan_accepts (GveSmartPlan * plan, GveSmartFile * file)
+{
+  if (!file->copy)
+    return FALSE;
+
+  if (plan->video_caps == NULL) {
+    plan->video_caps = gst_caps_ref (file->video_caps);
+    if (file->audio_caps != NULL)
+      plan->audio_caps = gst_caps_ref (file->audio_caps);
+    return TRUE;
+  }
+
+  return lgm_caps_can_concat (plan->video_caps, file->video_caps) &&
+      (plan->audio_caps == NULL ||
+      lgm_caps_can_concat (plan->audio_caps, file->audio_caps));
+}
+
+/* Splits a segment at the keyframes of its file. The GOPs inside the
+ * segment are copied and the partial GOPs at its start and end are
+ * re-encoded, so that the cuts are frame accurate. Only the keyframes of
+ * the segment are read from the file */
+static void
+gve_smart_split_segment (GstVideoEditor * gve, GveSmartPiece * seg,
+    const gchar * uri, GArray * pieces)
+{
+  GveSmartPiece piece = *seg;
+  guint64 first = GST_CLOCK_TIME_NONE, last = GST_CLOCK_TIME_NONE, kf;
+  guint64 *keyframes = NULL, *offsets = NULL;
+  guint i, n_keyframes = 0;
+  GError *err = NULL;
+
+  if (uri != NULL &&
+      !lgm_discover_keyframes_range (uri, seg->start, seg->stop, &keyframes,
+          &offsets, &n_keyframes, &err)) {
+    GST_WARNING_OBJECT (gve, "Could not read the keyframes of %s: %s", uri,
+        err ? err->message : "unknown error");
+    g_clear_error (&err);
+  }
+  g_free (offsets);
+
+  piece.copy = FALSE;
+  for (i = 0; i < n_keyframes; i++) {
+    kf = keyframes[i];
+    if (kf < seg->start)
+      continue;
+    if (GST_CLOCK_TIME_IS_VALID (seg->stop) && kf >= seg->stop)
+      break;
+    if (!GST_CLOCK_TIME_IS_VALID (first))
+      first = kf;
+    last = kf;
+  }
+  g_free (keyframes);
+
+  /* Without a complete GOP the whole segment is re-encoded */
+  if (!GST_CLOCK_TIME_IS_VALID (first) ||
+      (GST_CLOCK_TIME_IS_VALID (seg->stop) && first == last)) {
+    g_array_append_val (pieces, piece);
+    return;
+  }
+
+  if (first > seg->start) {
+    piece.stop = first;
+    g_array_append_val (pieces, piece);
+  }
+  piece.start = first;
+  piece.stop = GST_CLOCK_TIME_IS_VALID (seg->stop) ? last : GST_CLOCK_TIME_NONE;
+  piece.copy = TRUE;
+  g_array_append_val (pieces, piece);
+  if (GST_CLOCK_TIME_IS_VALID (seg->stop)) {
+    piece.start = last;
+    piece.stop = seg->stop;
+    piece.copy = FALSE;
+    g_array_append_val (pieces, piece);
+  }
+}
+
+static void
+gve_start_smart_render (GstVideoEditor * gve, GveSmartPlan * plan)
+{
+  GArray *pieces = plan->pieces;
+  GveRenderWorker *worker;
+  GveSmartPiece *piece;
+  GstNleSrcItem *item;
+  GError *error = NULL;
+  guint i, n_copied = 0;
+  gint64 dur;
+
+  for (i = 0; i < pieces->len; i++) {
+    piece = &g_array_index (pieces, GveSmartPiece, i);
+    if (GST_CLOCK_TIME_IS_VALID (piece->stop)) {
+      dur = piece->stop - piece->start;
+    } else {
+      dur = gst_nle_source_get_item_duration (gve->priv->nle_source,
+          piece->item);
+      if (!GST_CLOCK_TIME_IS_VALID (dur))
+        dur = 0;
+    }
+
+    if (piece->copy) {
+      item = gst_nle_source_get_item (gve->priv->nle_source, piece->item);
+      worker = g_new0 (GveRenderWorker, 1);
+      worker->gve = gve;
+      worker->output_file = g_strdup (item->file_path);
+      worker->copy = TRUE;
+      worker->start = piece->start;
+      worker->stop = piece->stop;
+      worker->duration = dur;
+      worker->started = TRUE;
+      worker->done = TRUE;
+      gve->priv->workers_done++;
+      n_copied++;
+    } else {
+      worker = gve_create_worker (gve, i,
+          gst_nle_source_copy_item (gve->priv->nle_source, piece->item,
+              piece->start, piece->stop), dur, NULL, &error);
+    }
+    gve->priv->workers = g_list_append (gve->priv->workers, worker);
+    if (error) {
+      g_signal_emit (gve, gve_signals[SIGNAL_ERROR], 0, error->message);
+      g_error_free (error);
+      gve_clear_workers (gve);
+      return;
+    }
+  }
+
+  GST_INFO_OBJECT (gve, "Smart render: %d of %d pieces copied", n_copied,
+      pieces->len);
+
+  /* The re-encoded pieces are checked against the copied streams */
+  gve->priv->copy_video_caps = gst_caps_ref (plan->video_caps);
+  if (plan->audio_caps != NULL)
+    gve->priv->copy_audio_caps = gst_caps_ref (plan->audio_caps);
+
+  gve_start_workers (gve);
+  gve_set_tick_timeout (gve, TIMEOUT);
+}
+
+static gboolean
+gve_smart_plan_done (GveSmartPlan * plan)
+{
+  GstVideoEditor *gve = plan->gve;
+  GveSmartPiece *piece;
+  gboolean copy = FALSE;
+  guint i;
+
+  if (g_atomic_int_get (&plan->cancelled)) {
+    gve_smart_plan_free (plan);
+    return FALSE;
+  }
+  gve->priv->smart_plan = NULL;
+
+  for (i = 0; i < plan->pieces->len; i++) {
+    piece = &g_array_index (plan->pieces, GveSmartPiece, i);
+    copy |= piece->copy;
+  }
+
+  if (copy) {
+    gve_start_smart_render (gve, plan);
+  } else {
+    GST_INFO_OBJECT (gve, "No segment can be copied, re-encoding all");
+    gve_start_render (gve);
+  }
+  gve_smart_plan_free (plan);
+  return FALSE;
+}
+
+static gpointer
+gve_smart_plan_thread (GveSmartPlan * plan)
+{
+  GHashTable *files;
+  GveSmartFile *file;
+  GveSmartPiece *seg;
+  const gchar *uri;
+  guint i;
+
+  files = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+      (GDestroyNotify) gve_smart_file_free);
+  plan->pieces = g_array_new (FALSE, FALSE, sizeof (GveSmartPiece));
+
+  for (i = 0; i < plan->segments->len; i++) {
+    if (g_atomic_int_get (&plan->cancelled))
+      break;
+    seg = &g_array_index (plan->segments, GveSmartPiece, i);
+    uri = plan->uris[seg->item];
+    file = NULL;
+    if (seg->copy) {
+      file = g_hash_table_lookup (files, uri);
+      if (file == NULL) {
+        file = gve_smart_file_new (plan->gve, uri);
+        g_hash_table_insert (files, (gpointer) uri, file);
+      }
+    }
+    gve_smart_split_segment (plan->gve, seg,
+        file != NULL && gve_smart_plan_accepts (plan, file) ? uri : NULL,
+        plan->pieces);
+  }
+  g_hash_table_destroy (files);
+
+  g_idle_add ((GSourceFunc) gve_smart_plan_done, plan);
+  return NULL;
+}
+
+/* Starts planning the smart render in a thread if any segment could be
+ * copied without re-encoding, that is, a segment without ROI, rate change
+ * or title. The render starts once the plan is ready */
+static gboolean
+gve_smart_render_plan (GstVideoEditor * gve)
+{
+  GveSmartPlan *plan;
+  GveSmartPiece seg;
+  GstNleSrcItem *item;
+  guint i, n_items;
+  gboolean copy = FALSE;
+
+  if (!gve->priv->smart_render || gve->priv->nle_source->watermark != NULL) {
+    return FALSE;
+  }
+
+  n_items = gst_nle_source_get_n_items (gve->priv->nle_source);
+  plan = g_new0 (GveSmartPlan, 1);
+  plan->gve = g_object_ref (gve);
+  plan->uris = g_new0 (gchar *, n_items + 1);
+  plan->segments = g_array_new (FALSE, FALSE, sizeof (GveSmartPiece));
+
+  for (i = 0; i < n_items; i++) {
+    item = gst_nle_source_get_item (gve->priv->nle_source, i);
+    plan->uris[i] = g_strdup (item->file_path);
+    seg.item = i;
+    seg.start = item->start;
+    seg.stop = item->stop;
+    seg.copy = !item->still_picture && item->rate == 1 &&
+        item->roi.width == 0 && item->roi.height == 0 &&
+        (!gve->priv->title_enabled || item->title == NULL ||
+        item->title[0] == '\0');
+    copy |= seg.copy;
+    g_array_append_val (plan->segments, seg);
+  }
+
+  if (!copy) {
+    gve_smart_plan_free (plan);
+    return FALSE;
+  }
+
+  GST_INFO_OBJECT (gve, "Planning the smart render of %d segments", n_items);
+  gve->priv->smart_plan = plan;
+  g_thread_unref (g_thread_new ("gve-smart-render",
+          (GThreadFunc) gve_smart_plan_thread, plan));
+  return TRUE;
+}
+
+/* =========================================== */
+/*                                             */
+/*              Public Methods                 */
+/*                                             */
+/* =========================================== */
+
+
+void
+gst_video_editor_add_segment (GstVideoEditor * gve, gchar * file,
+    gint64 start, gint64 duration, gdouble rate,
+    gchar * title, gboolean hasAudio,
+    guint roi_x, guint roi_y, guint roi_w, guint roi_h)
+{
+  GstState cur_state;
+  GstNleRectangle roi = { roi_x, roi_y, roi_w, roi_h };
+  guint64 stop = -1;
+
+  g_return_if_fail (GST_IS_VIDEO_EDITOR (gve));
+
+  gst_element_get_state (gve->priv->main_pipeline, &cur_state, NULL, 0);
+  if (cur_state > GST_STATE_READY) {
+    GST_WARNING ("Segments can only be added for a state <= GST_STATE_READY");
+    return;
+  }
+
+  start = start * GST_MSECOND;
+  if (duration != -1) {
+    duration = duration * GST_MSECOND;
+    stop = start + duration;
+  }
+
+  gst_nle_source_add_item (gve->priv->nle_source, file, title, start,
+      stop, rate, FALSE, roi);
+
+  GST_INFO ("New segment: start={%" GST_TIME_FORMAT "} duration={%"
+      GST_TIME_FORMAT "} ", GST_TIME_ARGS (gve->priv->duration),
+      GST_TIME_ARGS (duration));
+
+  if (duration != -1)
+    gve->priv->duration += duration;
+}
+
+void
+gst_video_editor_add_image_segment (GstVideoEditor * gve, gchar * file,
+    guint64 start, gint64 duration, gchar * title,
+    guint roi_x, guint roi_y, guint roi_w, guint roi_h)
+{
+  GstState cur_state;
+  GstNleRectangle roi = { roi_x, roi_y, roi_w, roi_h };
+
+  g_return_if_fail (GST_IS_VIDEO_EDITOR (gve));
+
+  gst_element_get_state (gve->priv->main_pipeline, &cur_state, NULL, 0);
+  if (cur_state > GST_STATE_READY) {
+    GST_WARNING ("Segments can only be added for a state <= GST_STATE_READY");
+    return;
+  }
+
+  duration = duration * GST_MSECOND;
+  start = start * GST_MSECOND;
+
+  gst_nle_source_add_item (gve->priv->nle_source, file, title, start,
+      start + duration, 1, TRUE, roi);
+
+  GST_INFO ("New segment: start={%" GST_TIME_FORMAT "} duration={%"
+      GST_TIME_FORMAT "} ", GST_TIME_ARGS (gve->priv->duration),
+      GST_TIME_ARGS (duration));
+
+  gve->priv->duration += duration;
+}
+
+void
+gst_video_editor_clear_segments_list (GstVideoEditor * gve)
+{
+  g_return_if_fail (GST_IS_VIDEO_EDITOR (gve));
+
+  GST_INFO_OBJECT (gve, "Clearing list of segments");
+
+  gst_video_editor_cancel (gve);
+  gst_element_set_state (gve->priv->main_pipeline, GST_STATE_NULL);
+
+  if (gve->priv->nle_source != NULL) {
+    gst_object_unref (gve->priv->nle_source);
+    gve->priv->nle_source = NULL;
+  }
+  gve->priv->duration = 0;
+}
+
+void
+gst_video_editor_start (GstVideoEditor * gve)
+{
+  g_return_if_fail (GST_IS_VIDEO_EDITOR (gve));
+
+  GST_INFO_OBJECT (gve, "Starting. output file: %s", gve->priv->output_file);
+
+  gve_clear_workers (gve);
+  gve->priv->last_pos = 0;
+  gve->priv->switch_count = 0;
+  gve->priv->switch_total = 0;
+  gve->priv->switch_max = 0;
+  gve->priv->cache_hits = 0;
+  gve->priv->cache_misses = 0;
+  gst_nle_source_set_lookahead (gve->priv->nle_source, gve->priv->lookahead);
+
+  if (gve_smart_render_plan (gve)) {
+    g_signal_emit (gve, gve_signals[SIGNAL_PERCENT_COMPLETED], 0, (gfloat) 0);
+    return;
+  }
+
+  gve_start_render (gve);
+}
+
 void
 gst_video_editor_cancel (GstVideoEditor * gve)
 {
   g_return_if_fail (GST_IS_VIDEO_EDITOR (gve));
 
   GST_INFO_OBJECT (gve, "Cancelling");
+  if (gve->priv->workers_error_id != 0) {
+    g_source_remove (gve->priv->workers_error_id);
+    gve->priv->workers_error_id = 0;
+  }
+  if (gve->priv->smart_fallback_id != 0) {
+    g_source_remove (gve->priv->smart_fallback_id);
+    gve->priv->smart_fallback_id = 0;
+  }
+  if (gve->priv->smart_plan != NULL) {
+    g_atomic_int_set (&gve->priv->smart_plan->cancelled, TRUE);
+    gve->priv->smart_plan = NULL;
+  }
   if (gve->priv->update_id > 0) {
     g_source_remove (gve->priv->update_id);
     gve->priv->update_id = 0;
   }
+  gve_clear_workers (gve);
   gst_element_set_state (gve->priv->main_pipeline, GST_STATE_NULL);
 }
 
@@ -683,6 +2034,60 @@ gst_video_editor_set_watermark (GstVideoEditor * gve,
   gst_nle_source_set_watermark (gve->priv->nle_source, watermark, x, y, height);
 }
 
+void
+gst_video_editor_set_lookahead (GstVideoEditor * gve, guint depth)
+{
+  g_return_if_fail (GST_IS_VIDEO_EDITOR (gve));
+
+  gve->priv->lookahead = depth;
+}
+
+void
+gst_video_editor_set_parallel_workers (GstVideoEditor * gve, guint workers)
+{
+  g_return_if_fail (GST_IS_VIDEO_EDITOR (gve));
+
+  gve->priv->parallel_workers = MAX (workers, 1);
+}
+
+void
+gst_video_editor_set_smart_render (GstVideoEditor * gve, gboolean enabled)
+{
+  g_return_if_fail (GST_IS_VIDEO_EDITOR (gve));
+
+  gve->priv->smart_render = enabled;
+}
+
+void
+gst_video_editor_set_cache (GstVideoEditor * gve, const gchar * cache_dir,
+    guint64 max_size)
+{
+  g_return_if_fail (GST_IS_VIDEO_EDITOR (gve));
+
+  g_free (gve->priv->cache_dir);
+  gve->priv->cache_dir = g_strdup (cache_dir);
+  gve->priv->cache_max_size = max_size;
+}
+
+void
+gst_video_editor_get_cache_stats (GstVideoEditor * gve, guint * hits,
+    guint * misses)
+{
+  g_return_if_fail (GST_IS_VIDEO_EDITOR (gve));
+
+  *hits = gve->priv->cache_hits;
+  *misses = gve->priv->cache_misses;
+}
+
+void
+gst_video_editor_set_temp_dir (GstVideoEditor * gve, const gchar * temp_dir)
+{
+  g_return_if_fail (GST_IS_VIDEO_EDITOR (gve));
+
+  g_free (gve->priv->temp_dir);
+  gve->priv->temp_dir = g_strdup (temp_dir);
+}
+
 GstVideoEditor *
 gst_video_editor_new (GError ** err)
 {
@@ -702,7 +2107,10 @@ gst_video_editor_new (GError ** err)
   }
 
   /* Create elements */
+  /* Owned by the editor, the pipelines rendering it add their own ref */
   gve->priv->nle_source = gst_nle_source_new ();
+  gst_object_ref (gve->priv->nle_source);
+  gst_object_sink (gve->priv->nle_source);
 
   /* Listen for a "pad-added" to link the composition with the encoder tail */
   gve->priv->bus = gst_element_get_bus (GST_ELEMENT (gve->priv->main_pipeline));
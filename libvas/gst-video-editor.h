@@ -93,5 +93,17 @@ EXPORT void gst_video_editor_add_image_segment (GstVideoEditor * gve, gchar * fi
     guint roi_x, guint roi_y, guint roi_w, guint roi_h);
 EXPORT void gst_video_editor_set_watermark (GstVideoEditor * gve,
     GdkPixbuf * watermark, gdouble x, gdouble y, gdouble height);
+EXPORT void gst_video_editor_set_lookahead (GstVideoEditor * gve,
+    guint depth);
+EXPORT void gst_video_editor_set_parallel_workers (GstVideoEditor * gve,
+    guint workers);
+EXPORT void gst_video_editor_set_smart_render (GstVideoEditor * gve,
+    gboolean enabled);
+EXPORT void gst_video_editor_set_cache (GstVideoEditor * gve,
+    const gchar * cache_dir, guint64 max_size);
+EXPORT void gst_video_editor_get_cache_stats (GstVideoEditor * gve,
+    guint * hits, guint * misses);
+EXPORT void gst_video_editor_set_temp_dir (GstVideoEditor * gve,
+    const gchar * temp_dir);
 G_END_DECLS
 #endif /* _GST_VIDEO_EDITOR_H_ */
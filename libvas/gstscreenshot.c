@@ -28,24 +28,14 @@
 #include "lgm-utils.h"
 
 
-static void
-feed_fakesrc (GstElement * src, GstBuffer * buf, GstPad * pad, gpointer data)
+struct _BvwFrameConv
 {
-  GstBuffer *in_buf = GST_BUFFER (data);
-
-  g_assert (GST_BUFFER_SIZE (buf) >= GST_BUFFER_SIZE (in_buf));
-  g_assert (!GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_READONLY));
-
-  gst_buffer_set_caps (buf, GST_BUFFER_CAPS (in_buf));
-
-  memcpy (GST_BUFFER_DATA (buf), GST_BUFFER_DATA (in_buf),
-      GST_BUFFER_SIZE (in_buf));
-
-  GST_BUFFER_SIZE (buf) = GST_BUFFER_SIZE (in_buf);
-
-  GST_DEBUG ("feeding buffer %p, size %u, caps %" GST_PTR_FORMAT,
-      buf, GST_BUFFER_SIZE (buf), GST_BUFFER_CAPS (buf));
-}
+  GstElement *pipeline;
+  GstPad *srcpad;
+  GstCaps *caps;
+  GstBuffer *result;
+  GMutex lock;
+};
 
 static void
 save_result (GstElement * sink, GstBuffer * buf, GstPad * pad, gpointer data)
@@ -75,129 +65,160 @@ create_element (const gchar * factory_name, GstElement ** element,
   return FALSE;
 }
 
-/* takes ownership of the input buffer */
-GstBuffer *
-bvw_frame_conv_convert (GstBuffer * buf, GstCaps * to_caps)
+static GstCaps *
+bvw_frame_conv_get_caps (LgmFrameFormat format)
 {
-  GstElement *src, *csp, *filter1, *vscale, *filter2, *sink, *pipeline;
-  GstMessage *msg;
-  GstBuffer *result = NULL;
-  GError *error = NULL;
-  GstBus *bus;
-  GstCaps *to_caps_no_par;
+  switch (format) {
+    case LGM_FRAME_FORMAT_I420:
+      /* Without pixel-aspect-ratio frames are not scaled */
+      return gst_caps_new_simple ("video/x-raw-yuv",
+          "format", GST_TYPE_FOURCC, GST_MAKE_FOURCC ('I', '4', '2', '0'),
+          NULL);
+    case LGM_FRAME_FORMAT_RGB24:
+    default:
+      /* Note: we don't ask for a specific width/height here, so that
+       * videoscale can adjust dimensions from a non-1/1 pixel aspect
+       * ratio to a 1/1 pixel-aspect-ratio */
+      return gst_caps_new_simple ("video/x-raw-rgb",
+          "bpp", G_TYPE_INT, 24, "depth", G_TYPE_INT, 24,
+          "pixel-aspect-ratio", GST_TYPE_FRACTION, 1,
+          1, "endianness", G_TYPE_INT, G_BIG_ENDIAN,
+          "red_mask", G_TYPE_INT, 0xff0000,
+          "green_mask", G_TYPE_INT, 0x00ff00,
+          "blue_mask", G_TYPE_INT, 0x0000ff, NULL);
+  }
+}
 
-  g_return_val_if_fail (GST_BUFFER_CAPS (buf) != NULL, NULL);
+/* Creates a converter to the requested format. The conversion pipeline is
+ * created once and frames are pushed to it from the calling thread, so
+ * converting a frame does not need to build and pre-roll a new pipeline */
+BvwFrameConv *
+bvw_frame_conv_new (LgmFrameFormat format, GError ** err)
+{
+  BvwFrameConv *conv;
+  GstElement *csp, *filter1, *vscale, *filter2, *sink;
+  GstCaps *caps_no_par;
+  GstPad *sinkpad;
 
-  /* videoscale is here to correct for the pixel-aspect-ratio for us */
   GST_DEBUG ("creating elements");
-  if (!create_element ("fakesrc", &src, &error) ||
-      !create_element ("ffmpegcolorspace", &csp, &error) ||
-      !create_element ("videoscale", &vscale, &error) ||
-      !create_element ("capsfilter", &filter1, &error) ||
-      !create_element ("capsfilter", &filter2, &error) ||
-      !create_element ("fakesink", &sink, &error)) {
-    g_warning ("Could not take screenshot: %s", error->message);
-    g_error_free (error);
-    return NULL;
-  }
-
-  pipeline = gst_pipeline_new ("screenshot-pipeline");
-  if (pipeline == NULL) {
-    g_warning ("Could not take screenshot: %s", "no pipeline (unknown error)");
+  if (!create_element ("ffmpegcolorspace", &csp, err) ||
+      !create_element ("videoscale", &vscale, err) ||
+      !create_element ("capsfilter", &filter1, err) ||
+      !create_element ("capsfilter", &filter2, err) ||
+      !create_element ("fakesink", &sink, err)) {
     return NULL;
   }
 
-  GST_DEBUG ("adding elements");
-  gst_bin_add_many (GST_BIN (pipeline), src, csp, filter1, vscale, filter2,
+  conv = g_new0 (BvwFrameConv, 1);
+  g_mutex_init (&conv->lock);
+  conv->caps = bvw_frame_conv_get_caps (format);
+  conv->pipeline = gst_pipeline_new ("frame-converter");
+  gst_bin_add_many (GST_BIN (conv->pipeline), csp, filter1, vscale, filter2,
       sink, NULL);
 
-  g_signal_connect (src, "handoff", G_CALLBACK (feed_fakesrc), buf);
-
-  /* set to 'fixed' sizetype */
-  g_object_set (src, "sizemax", GST_BUFFER_SIZE (buf), "sizetype", 2,
-      "num-buffers", 1, "signal-handoffs", TRUE, NULL);
-
   /* adding this superfluous capsfilter makes linking cheaper */
-  to_caps_no_par = gst_caps_copy (to_caps);
-  gst_structure_remove_field (gst_caps_get_structure (to_caps_no_par, 0),
+  caps_no_par = gst_caps_copy (conv->caps);
+  gst_structure_remove_field (gst_caps_get_structure (caps_no_par, 0),
       "pixel-aspect-ratio");
-  g_object_set (filter1, "caps", to_caps_no_par, NULL);
-  gst_caps_unref (to_caps_no_par);
+  g_object_set (filter1, "caps", caps_no_par, NULL);
+  gst_caps_unref (caps_no_par);
+  g_object_set (filter2, "caps", conv->caps, NULL);
 
-  g_object_set (filter2, "caps", to_caps, NULL);
+  g_object_set (sink, "sync", FALSE, "signal-handoffs", TRUE, NULL);
+  g_signal_connect (sink, "handoff", G_CALLBACK (save_result), &conv->result);
 
-  g_signal_connect (sink, "handoff", G_CALLBACK (save_result), &result);
+  gst_element_link_many (csp, filter1, vscale, filter2, sink, NULL);
 
-  g_object_set (sink, "preroll-queue-len", 1, "signal-handoffs", TRUE, NULL);
+  conv->srcpad = gst_pad_new ("src", GST_PAD_SRC);
+  sinkpad = gst_element_get_static_pad (csp, "sink");
+  gst_pad_link (conv->srcpad, sinkpad);
+  gst_object_unref (sinkpad);
+  gst_pad_set_active (conv->srcpad, TRUE);
 
-  /* FIXME: linking is still way too expensive, profile this properly */
-  GST_DEBUG ("linking src->csp");
-  if (!gst_element_link_pads (src, "src", csp, "sink"))
-    return NULL;
+  gst_element_set_state (conv->pipeline, GST_STATE_PLAYING);
+  gst_pad_push_event (conv->srcpad, gst_event_new_new_segment (FALSE, 1.0,
+          GST_FORMAT_TIME, 0, -1, 0));
 
-  GST_DEBUG ("linking csp->filter1");
-  if (!gst_element_link_pads (csp, "src", filter1, "sink"))
-    return NULL;
+  return conv;
+}
 
-  GST_DEBUG ("linking filter1->vscale");
-  if (!gst_element_link_pads (filter1, "src", vscale, "sink"))
-    return NULL;
+void
+bvw_frame_conv_free (BvwFrameConv * conv)
+{
+  if (conv == NULL)
+    return;
+
+  gst_pad_set_active (conv->srcpad, FALSE);
+  gst_element_set_state (conv->pipeline, GST_STATE_NULL);
+  gst_object_unref (conv->srcpad);
+  gst_object_unref (conv->pipeline);
+  gst_caps_unref (conv->caps);
+  g_mutex_clear (&conv->lock);
+  g_free (conv);
+}
 
-  GST_DEBUG ("linking vscale->capsfilter");
-  if (!gst_element_link_pads (vscale, "src", filter2, "sink"))
-    return NULL;
+/* Returns a new reference to the converted frame, or to the same frame if
+ * it's already in the requested format */
+GstBuffer *
+bvw_frame_conv_convert (BvwFrameConv * conv, GstBuffer * buf)
+{
+  GstBuffer *result;
+  GstFlowReturn ret;
 
-  GST_DEBUG ("linking capsfilter->sink");
-  if (!gst_element_link_pads (filter2, "src", sink, "sink"))
-    return NULL;
+  g_return_val_if_fail (GST_BUFFER_CAPS (buf) != NULL, NULL);
 
-  GST_DEBUG ("running conversion pipeline");
-  gst_element_set_state (pipeline, GST_STATE_PLAYING);
-
-  bus = gst_element_get_bus (pipeline);
-  msg =
-      gst_bus_timed_pop_filtered (bus, 25 * GST_SECOND,
-      GST_MESSAGE_ERROR | GST_MESSAGE_EOS);
-
-  if (msg) {
-    switch (GST_MESSAGE_TYPE (msg)) {
-      case GST_MESSAGE_EOS:
-      {
-        if (result) {
-          GST_DEBUG ("conversion successful: result = %p", result);
-        } else {
-          GST_WARNING ("EOS but no result frame?!");
-        }
-        break;
-      }
-      case GST_MESSAGE_ERROR:
-      {
-        gchar *dbg = NULL;
-
-        gst_message_parse_error (msg, &error, &dbg);
-        if (error) {
-          g_warning ("Could not take screenshot: %s", error->message);
-          GST_DEBUG ("%s [debug: %s]", error->message, GST_STR_NULL (dbg));
-          g_error_free (error);
-        } else {
-          g_warning ("Could not take screenshot (and NULL error!)");
-        }
-        g_free (dbg);
-        result = NULL;
-        break;
-      }
-      default:
-      {
-        g_return_val_if_reached (NULL);
-      }
-    }
-  } else {
-    g_warning ("Could not take screenshot: %s", "timeout during conversion");
-    result = NULL;
+  if (gst_caps_is_always_compatible (GST_BUFFER_CAPS (buf), conv->caps)) {
+    return gst_buffer_ref (buf);
   }
 
-  gst_element_set_state (pipeline, GST_STATE_NULL);
-  gst_object_unref (pipeline);
+  /* The frame data is shared, only the metadata is copied */
+  buf = gst_buffer_make_metadata_writable (gst_buffer_ref (buf));
+  GST_BUFFER_TIMESTAMP (buf) = GST_CLOCK_TIME_NONE;
+  GST_BUFFER_DURATION (buf) = GST_CLOCK_TIME_NONE;
+
+  g_mutex_lock (&conv->lock);
+  ret = gst_pad_push (conv->srcpad, buf);
+  result = conv->result;
+  conv->result = NULL;
+  g_mutex_unlock (&conv->lock);
+
+  if (ret != GST_FLOW_OK || result == NULL) {
+    GST_WARNING ("Could not convert frame: %s", gst_flow_get_name (ret));
+    if (result != NULL)
+      gst_buffer_unref (result);
+    return NULL;
+  }
 
+  GST_DEBUG ("conversion successful: result = %p", result);
   return result;
 }
+
+/* Converts the frame and copies it in the memory provided by the caller,
+ * which must have at least *size bytes. If data is NULL or too small, *size
+ * is set to the required size and FALSE is returned */
+gboolean
+bvw_frame_conv_grab (BvwFrameConv * conv, GstBuffer * buf, guint8 * data,
+    gsize * size, gint * width, gint * height)
+{
+  GstBuffer *result;
+  GstStructure *s;
+  gboolean ret = FALSE;
+
+  result = bvw_frame_conv_convert (conv, buf);
+  if (result == NULL) {
+    return FALSE;
+  }
+
+  s = gst_caps_get_structure (GST_BUFFER_CAPS (result), 0);
+  gst_structure_get_int (s, "width", width);
+  gst_structure_get_int (s, "height", height);
+
+  if (data != NULL && *size >= GST_BUFFER_SIZE (result)) {
+    memcpy (data, GST_BUFFER_DATA (result), GST_BUFFER_SIZE (result));
+    ret = TRUE;
+  }
+  *size = GST_BUFFER_SIZE (result);
+
+  gst_buffer_unref (result);
+  return ret;
+}
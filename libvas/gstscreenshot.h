@@ -21,9 +21,17 @@
 #define __BVW_FRAME_CONV_H__
 
 #include <gst/gst.h>
+#include "lgm-utils.h"
 
 G_BEGIN_DECLS
-    GstBuffer * bvw_frame_conv_convert (GstBuffer * buf, GstCaps * to);
+
+typedef struct _BvwFrameConv BvwFrameConv;
+
+BvwFrameConv * bvw_frame_conv_new (LgmFrameFormat format, GError ** err);
+void bvw_frame_conv_free (BvwFrameConv * conv);
+GstBuffer * bvw_frame_conv_convert (BvwFrameConv * conv, GstBuffer * buf);
+gboolean bvw_frame_conv_grab (BvwFrameConv * conv, GstBuffer * buf,
+    guint8 * data, gsize * size, gint * width, gint * height);
 
 G_END_DECLS
 #endif /* __BVW_FRAME_CONV_H__ */
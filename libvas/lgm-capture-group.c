@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2018  Fluendo S.A.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "lgm-capture-group.h"
+
+struct _LgmCaptureGroup
+{
+  GstClock *clock;
+  GstClockTime base_time;
+  GList *capturers;
+};
+
+static GstClockTime
+lgm_capture_group_get_running_time (LgmCaptureGroup * group)
+{
+  return gst_clock_get_time (group->clock) - group->base_time;
+}
+
+LgmCaptureGroup *
+lgm_capture_group_new (void)
+{
+  LgmCaptureGroup *group;
+
+  group = g_new0 (LgmCaptureGroup, 1);
+  group->clock = gst_system_clock_obtain ();
+  group->base_time = gst_clock_get_time (group->clock);
+  return group;
+}
+
+void
+lgm_capture_group_free (LgmCaptureGroup * group)
+{
+  g_list_free_full (group->capturers, g_object_unref);
+  gst_object_unref (group->clock);
+  g_free (group);
+}
+
+void
+lgm_capture_group_add (LgmCaptureGroup * group, GstCameraCapturer * gcc)
+{
+  g_return_if_fail (GST_IS_CAMERA_CAPTURER (gcc));
+
+  gst_camera_capturer_set_clock (gcc, group->clock, group->base_time);
+  group->capturers = g_list_append (group->capturers, g_object_ref (gcc));
+}
+
+void
+lgm_capture_group_start (LgmCaptureGroup * group)
+{
+  GstClockTime time;
+  GList *l;
+
+  time = lgm_capture_group_get_running_time (group);
+  for (l = group->capturers; l; l = l->next) {
+    gst_camera_capturer_start_at (l->data, time);
+  }
+}
+
+void
+lgm_capture_group_toggle_pause (LgmCaptureGroup * group)
+{
+  GstClockTime time;
+  GList *l;
+
+  time = lgm_capture_group_get_running_time (group);
+  for (l = group->capturers; l; l = l->next) {
+    gst_camera_capturer_toggle_pause_at (l->data, time);
+  }
+}
+
+void
+lgm_capture_group_stop (LgmCaptureGroup * group)
+{
+  GstClockTime time;
+  GList *l;
+
+  time = lgm_capture_group_get_running_time (group);
+  for (l = group->capturers; l; l = l->next) {
+    gst_camera_capturer_stop_at (l->data, time);
+  }
+}
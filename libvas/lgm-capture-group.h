@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2018  Fluendo S.A.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __LGM_CAPTURE_GROUP_H__
+#define __LGM_CAPTURE_GROUP_H__
+
+#include "gst-camera-capturer.h"
+
+G_BEGIN_DECLS
+
+/* Set of capturers recording several angles of the same event. They share
+ * one clock and running time, and start, pause and stop on the same
+ * buffer timestamps, so their recordings are synchronized. */
+typedef struct _LgmCaptureGroup LgmCaptureGroup;
+
+EXPORT LgmCaptureGroup * lgm_capture_group_new (void);
+EXPORT void lgm_capture_group_free (LgmCaptureGroup * group);
+
+/* Capturers must be added before running them */
+EXPORT void lgm_capture_group_add (LgmCaptureGroup * group,
+    GstCameraCapturer * gcc);
+
+EXPORT void lgm_capture_group_start (LgmCaptureGroup * group);
+EXPORT void lgm_capture_group_toggle_pause (LgmCaptureGroup * group);
+EXPORT void lgm_capture_group_stop (LgmCaptureGroup * group);
+
+G_END_DECLS
+#endif /* __LGM_CAPTURE_GROUP_H__ */
@@ -17,9 +17,27 @@
  *
  */
 
+#include <stdio.h>
 #include "lgm-device.h"
 #include <gst/interfaces/propertyprobe.h>
 
+#define DEVICE_CACHE_DRIVER_KEY "driver"
+#define DEVICE_CACHE_DEVICES_KEY "devices"
+
+/* Formats of the video devices probed in previous runs, with a group per
+ * source element */
+static GMutex cache_lock;
+static GKeyFile *cache = NULL;
+static gchar *cache_path = NULL;
+static GHashTable *cache_refreshing = NULL;
+
+typedef struct
+{
+  gchar *source_name;
+  LgmDeviceChangeFunc func;
+  gpointer user_data;
+} LgmDeviceRefresh;
+
 static LgmDeviceVideoFormat *
 lgm_device_video_format_new (gint width, gint height, gint fps_n, gint fps_d)
 {
@@ -351,6 +369,316 @@ lgm_device_enum_audio_devices (const gchar * device)
   return lgm_device_enum_devices (device, LGM_DEVICE_TYPE_AUDIO);
 }
 
+static LgmDeviceVideoFormat *
+lgm_device_video_format_copy (LgmDeviceVideoFormat * format)
+{
+  return lgm_device_video_format_new (format->width, format->height,
+      format->fps_n, format->fps_d);
+}
+
+static gboolean
+lgm_device_equal (LgmDevice * d1, LgmDevice * d2)
+{
+  GList *f1, *f2;
+
+  if (g_strcmp0 (d1->device_name, d2->device_name))
+    return FALSE;
+
+  for (f1 = d1->formats, f2 = d2->formats; f1 && f2;
+      f1 = f1->next, f2 = f2->next) {
+    LgmDeviceVideoFormat *fmt1 = f1->data, *fmt2 = f2->data;
+
+    if (fmt1->width != fmt2->width || fmt1->height != fmt2->height ||
+        fmt1->fps_n != fmt2->fps_n || fmt1->fps_d != fmt2->fps_d)
+      return FALSE;
+  }
+  return f1 == NULL && f2 == NULL;
+}
+
+static gboolean
+lgm_device_list_equal (GList * l1, GList * l2)
+{
+  for (; l1 && l2; l1 = l1->next, l2 = l2->next) {
+    if (!lgm_device_equal (l1->data, l2->data))
+      return FALSE;
+  }
+  return l1 == NULL && l2 == NULL;
+}
+
+/* Identifies the plugin providing the source, so that the cache is not
+ * used after it's upgraded or replaced */
+static gchar *
+lgm_device_get_driver_id (const gchar * source_name)
+{
+  GstElementFactory *factory;
+  GstPlugin *plugin = NULL;
+  gchar *id;
+
+  factory = gst_element_factory_find (source_name);
+  if (factory == NULL)
+    return NULL;
+
+  plugin = gst_registry_find_plugin (gst_registry_get_default (),
+      GST_PLUGIN_FEATURE (factory)->plugin_name);
+  if (plugin != NULL) {
+    id = g_strdup_printf ("%s %s", gst_plugin_get_filename (plugin),
+        gst_plugin_get_version (plugin));
+    gst_object_unref (plugin);
+  } else {
+    id = g_strdup (GST_PLUGIN_FEATURE (factory)->plugin_name);
+  }
+  gst_object_unref (factory);
+  return id;
+}
+
+static gchar *
+lgm_device_cache_formats_key (guint index)
+{
+  return g_strdup_printf ("formats-%u", index);
+}
+
+/* Must be called with the cache lock */
+static gboolean
+lgm_device_cache_lookup (const gchar * source_name, const gchar * driver,
+    GList ** list)
+{
+  gchar *cached_driver, **names;
+  gsize i, n_names;
+
+  *list = NULL;
+  if (cache == NULL || driver == NULL)
+    return FALSE;
+
+  cached_driver = g_key_file_get_string (cache, source_name,
+      DEVICE_CACHE_DRIVER_KEY, NULL);
+  if (g_strcmp0 (cached_driver, driver)) {
+    g_free (cached_driver);
+    return FALSE;
+  }
+  g_free (cached_driver);
+
+  names = g_key_file_get_string_list (cache, source_name,
+      DEVICE_CACHE_DEVICES_KEY, &n_names, NULL);
+  for (i = 0; i < n_names; i++) {
+    LgmDevice *device;
+    gchar *key, **formats;
+    gsize j, n_formats;
+
+    device = lgm_device_new (source_name, names[i], LGM_DEVICE_TYPE_VIDEO);
+    key = lgm_device_cache_formats_key (i);
+    formats = g_key_file_get_string_list (cache, source_name, key,
+        &n_formats, NULL);
+    for (j = 0; j < n_formats; j++) {
+      gint width, height, fps_n, fps_d;
+
+      if (sscanf (formats[j], "%dx%d@%d/%d", &width, &height, &fps_n,
+              &fps_d) == 4) {
+        device->formats = g_list_append (device->formats,
+            lgm_device_video_format_new (width, height, fps_n, fps_d));
+      }
+    }
+    g_strfreev (formats);
+    g_free (key);
+    *list = g_list_append (*list, device);
+  }
+  g_strfreev (names);
+  return TRUE;
+}
+
+/* Must be called with the cache lock */
+static void
+lgm_device_cache_store (const gchar * source_name, const gchar * driver,
+    GList * list)
+{
+  GPtrArray *names;
+  GList *l;
+  GError *error = NULL;
+  gchar *data;
+  gsize length;
+
+  if (cache == NULL || driver == NULL)
+    return;
+
+  g_key_file_remove_group (cache, source_name, NULL);
+  g_key_file_set_string (cache, source_name, DEVICE_CACHE_DRIVER_KEY, driver);
+
+  names = g_ptr_array_new ();
+  for (l = list; l; l = l->next) {
+    LgmDevice *device = l->data;
+    GPtrArray *formats;
+    GList *f;
+    gchar *key;
+
+    formats = g_ptr_array_new_with_free_func (g_free);
+    for (f = device->formats; f; f = f->next) {
+      g_ptr_array_add (formats, lgm_device_video_format_to_string (f->data));
+    }
+    key = lgm_device_cache_formats_key (names->len);
+    g_key_file_set_string_list (cache, source_name, key,
+        (const gchar * const *) formats->pdata, formats->len);
+    g_free (key);
+    g_ptr_array_free (formats, TRUE);
+    g_ptr_array_add (names, device->device_name);
+  }
+  g_key_file_set_string_list (cache, source_name, DEVICE_CACHE_DEVICES_KEY,
+      (const gchar * const *) names->pdata, names->len);
+  g_ptr_array_free (names, TRUE);
+
+  if (cache_path == NULL)
+    return;
+  data = g_key_file_to_data (cache, &length, NULL);
+  if (!g_file_set_contents (cache_path, data, length, &error)) {
+    GST_WARNING ("Could not save the devices cache: %s", error->message);
+    g_error_free (error);
+  }
+  g_free (data);
+}
+
+static GList *
+lgm_device_list_copy (GList * list)
+{
+  GList *copy = NULL, *l, *f;
+
+  for (l = list; l; l = l->next) {
+    LgmDevice *device = l->data, *device_copy;
+
+    device_copy = lgm_device_new (device->source_name, device->device_name,
+        device->type);
+    for (f = device->formats; f; f = f->next) {
+      device_copy->formats = g_list_append (device_copy->formats,
+          lgm_device_video_format_copy (f->data));
+    }
+    copy = g_list_append (copy, device_copy);
+  }
+  return copy;
+}
+
+/* A device in use by a capture can't be opened to probe its formats, in
+ * that case keep the formats found the last time */
+static void
+lgm_device_list_merge_busy (GList * list, GList * cached)
+{
+  GList *l, *c;
+
+  for (l = list; l; l = l->next) {
+    LgmDevice *device = l->data;
+
+    if (device->formats != NULL)
+      continue;
+    for (c = cached; c; c = c->next) {
+      LgmDevice *cached_device = c->data;
+
+      if (!g_strcmp0 (device->device_name, cached_device->device_name)) {
+        device->formats = cached_device->formats;
+        cached_device->formats = NULL;
+        break;
+      }
+    }
+  }
+}
+
+void
+lgm_device_cache_load (const gchar * path)
+{
+  GError *error = NULL;
+
+  g_mutex_lock (&cache_lock);
+  if (cache == NULL) {
+    cache = g_key_file_new ();
+    cache_refreshing = g_hash_table_new_full (g_str_hash, g_str_equal,
+        g_free, NULL);
+  }
+  g_free (cache_path);
+  cache_path = g_strdup (path);
+  if (!g_key_file_load_from_file (cache, path, G_KEY_FILE_NONE, &error)) {
+    GST_DEBUG ("No devices cache loaded from %s: %s", path, error->message);
+    g_error_free (error);
+  }
+  g_mutex_unlock (&cache_lock);
+}
+
+GList *
+lgm_device_enum_video_devices_cached (const gchar * source_name,
+    gboolean * probed)
+{
+  GList *list;
+  gchar *driver;
+  gboolean found;
+
+  driver = lgm_device_get_driver_id (source_name);
+
+  g_mutex_lock (&cache_lock);
+  found = lgm_device_cache_lookup (source_name, driver, &list);
+  g_mutex_unlock (&cache_lock);
+
+  if (probed != NULL)
+    *probed = !found;
+  if (!found) {
+    GST_DEBUG ("Devices of %s not cached, probing them", source_name);
+    list = lgm_device_enum_video_devices (source_name);
+    g_mutex_lock (&cache_lock);
+    lgm_device_cache_store (source_name, driver, list);
+    g_mutex_unlock (&cache_lock);
+  }
+  g_free (driver);
+  return list;
+}
+
+static gpointer
+lgm_device_cache_refresh_thread (LgmDeviceRefresh * refresh)
+{
+  GList *list, *cached = NULL;
+  gchar *driver;
+  gboolean found, changed;
+
+  driver = lgm_device_get_driver_id (refresh->source_name);
+  list = lgm_device_enum_video_devices (refresh->source_name);
+
+  g_mutex_lock (&cache_lock);
+  found = lgm_device_cache_lookup (refresh->source_name, driver, &cached);
+  lgm_device_list_merge_busy (list, cached);
+  changed = !found || !lgm_device_list_equal (list, cached);
+  if (changed) {
+    GST_INFO ("Devices of %s changed", refresh->source_name);
+    lgm_device_cache_store (refresh->source_name, driver, list);
+  }
+  g_hash_table_remove (cache_refreshing, refresh->source_name);
+  g_mutex_unlock (&cache_lock);
+
+  /* Only notify changes in devices listed before */
+  if (changed && found && refresh->func != NULL)
+    refresh->func (refresh->source_name, refresh->user_data);
+
+  g_list_free_full (cached, (GDestroyNotify) lgm_device_free);
+  g_list_free_full (list, (GDestroyNotify) lgm_device_free);
+  g_free (driver);
+  g_free (refresh->source_name);
+  g_free (refresh);
+  return NULL;
+}
+
+void
+lgm_device_cache_refresh (const gchar * source_name,
+    LgmDeviceChangeFunc func, gpointer user_data)
+{
+  LgmDeviceRefresh *refresh;
+
+  g_mutex_lock (&cache_lock);
+  if (cache == NULL || g_hash_table_contains (cache_refreshing, source_name)) {
+    g_mutex_unlock (&cache_lock);
+    return;
+  }
+  g_hash_table_add (cache_refreshing, g_strdup (source_name));
+  g_mutex_unlock (&cache_lock);
+
+  refresh = g_new0 (LgmDeviceRefresh, 1);
+  refresh->source_name = g_strdup (source_name);
+  refresh->func = func;
+  refresh->user_data = user_data;
+  g_thread_unref (g_thread_new ("device-refresh",
+          (GThreadFunc) lgm_device_cache_refresh_thread, refresh));
+}
+
 const gchar *
 lgm_device_get_property_name_for_source (const gchar *source_name)
 {
@@ -42,6 +42,10 @@ struct _LgmDeviceVideoFormat
   gint fps_d;
 };
 
+/* Called from a background thread when the devices of a source changed */
+typedef void (*LgmDeviceChangeFunc) (const gchar *source_name,
+                                     gpointer user_data);
+
 struct _LgmDevice
 {
   gchar *source_name;
@@ -72,5 +76,14 @@ EXPORT GList *    lgm_device_enum_video_devices     (const gchar *source_name);
 EXPORT GList *    lgm_device_enum_audio_devices     (const gchar *source_name);
 
 EXPORT const gchar * lgm_device_get_property_name_for_source (const gchar *source_name);
+
+EXPORT void       lgm_device_cache_load             (const gchar *path);
+
+EXPORT GList *    lgm_device_enum_video_devices_cached (const gchar *source_name,
+                                                     gboolean *probed);
+
+EXPORT void       lgm_device_cache_refresh          (const gchar *source_name,
+                                                     LgmDeviceChangeFunc func,
+                                                     gpointer user_data);
 G_END_DECLS
 #endif
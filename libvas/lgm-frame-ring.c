@@ -0,0 +1,276 @@
+/*
+ * Copyright (C) 2018  Fluendo S.A.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "lgm-frame-ring.h"
+
+/* head and tail are free running counters and the capacity a power of 2, so
+ * that the slot of a counter is still right when it wraps around.
+ * Only the producer writes the slots and the tail. A frame is owned by
+ * whoever moves the head past it: the consumer when it pops it or the
+ * producer when it drops it. */
+struct _LgmFrameRing
+{
+  GstBuffer **slots;
+  gboolean *keyframes;
+  guint capacity;
+  volatile gint head;
+  volatile gint tail;
+  volatile gint policy;
+  volatile gint closed;
+  volatile gint flushing;
+
+  /* Only used to sleep when the ring is full or empty */
+  volatile gint waiters;
+  GMutex lock;
+  GCond cond;
+
+  /* Only written by the producer */
+  volatile gint max_depth;
+  guint64 pushed;
+  guint64 dropped;
+};
+
+static guint
+lgm_frame_ring_depth (LgmFrameRing * ring)
+{
+  return (guint) g_atomic_int_get (&ring->tail) -
+      (guint) g_atomic_int_get (&ring->head);
+}
+
+static void
+lgm_frame_ring_wake (LgmFrameRing * ring, gboolean force)
+{
+  if (force || g_atomic_int_get (&ring->waiters) > 0) {
+    g_mutex_lock (&ring->lock);
+    g_cond_broadcast (&ring->cond);
+    g_mutex_unlock (&ring->lock);
+  }
+}
+
+static void
+lgm_frame_ring_wait (LgmFrameRing * ring, gboolean for_space)
+{
+  g_mutex_lock (&ring->lock);
+  g_atomic_int_inc (&ring->waiters);
+  while (!g_atomic_int_get (&ring->flushing)
+      && !g_atomic_int_get (&ring->closed)) {
+    guint depth = lgm_frame_ring_depth (ring);
+
+    if (for_space && (depth < ring->capacity ||
+            g_atomic_int_get (&ring->policy) != LGM_FRAME_RING_POLICY_BLOCK))
+      break;
+    if (!for_space && depth > 0)
+      break;
+    g_cond_wait (&ring->cond, &ring->lock);
+  }
+  g_atomic_int_add (&ring->waiters, -1);
+  g_mutex_unlock (&ring->lock);
+}
+
+/* Takes the frame in the head, returns NULL if the other side took it first */
+static GstBuffer *
+lgm_frame_ring_take (LgmFrameRing * ring, guint head)
+{
+  GstBuffer *buf;
+
+  buf = g_atomic_pointer_get (&ring->slots[head & (ring->capacity - 1)]);
+  if (!g_atomic_int_compare_and_exchange (&ring->head, (gint) head,
+          (gint) (head + 1)))
+    return NULL;
+  return buf;
+}
+
+LgmFrameRing *
+lgm_frame_ring_new (guint capacity, LgmFrameRingPolicy policy)
+{
+  LgmFrameRing *ring;
+
+  g_return_val_if_fail (capacity > 0, NULL);
+
+  ring = g_new0 (LgmFrameRing, 1);
+  ring->capacity = 1;
+  while (ring->capacity < capacity)
+    ring->capacity <<= 1;
+  ring->slots = g_new0 (GstBuffer *, ring->capacity);
+  ring->keyframes = g_new0 (gboolean, ring->capacity);
+  ring->policy = policy;
+  g_mutex_init (&ring->lock);
+  g_cond_init (&ring->cond);
+  return ring;
+}
+
+void
+lgm_frame_ring_free (LgmFrameRing * ring)
+{
+  GstBuffer *buf;
+  guint head;
+
+  if (ring == NULL)
+    return;
+
+  for (head = ring->head; head != (guint) ring->tail; head++) {
+    buf = ring->slots[head & (ring->capacity - 1)];
+    gst_buffer_unref (buf);
+  }
+  g_mutex_clear (&ring->lock);
+  g_cond_clear (&ring->cond);
+  g_free (ring->keyframes);
+  g_free (ring->slots);
+  g_free (ring);
+}
+
+/* Takes ownership of buf. Returns FALSE if the frame was dropped. Must be
+ * called always from the same thread. */
+gboolean
+lgm_frame_ring_push (LgmFrameRing * ring, GstBuffer * buf)
+{
+  GstBuffer *old;
+  gboolean keyframe;
+  guint head, tail, slot, depth;
+
+  keyframe = !GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+
+  while (TRUE) {
+    if (g_atomic_int_get (&ring->flushing) || g_atomic_int_get (&ring->closed)) {
+      gst_buffer_unref (buf);
+      return FALSE;
+    }
+
+    head = g_atomic_int_get (&ring->head);
+    tail = ring->tail;
+    if (tail - head < ring->capacity)
+      break;
+
+    switch (g_atomic_int_get (&ring->policy)) {
+      case LGM_FRAME_RING_POLICY_BLOCK:
+        lgm_frame_ring_wait (ring, TRUE);
+        break;
+      case LGM_FRAME_RING_POLICY_DROP_OLDEST:
+        /* Dropping a keyframe would break all the frames depending on it,
+         * drop the new frame instead unless it can replace it */
+        if (ring->keyframes[head & (ring->capacity - 1)] && !keyframe)
+          goto drop;
+        old = lgm_frame_ring_take (ring, head);
+        if (old != NULL) {
+          GST_LOG ("Dropping oldest frame %" GST_TIME_FORMAT,
+              GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (old)));
+          gst_buffer_unref (old);
+          ring->dropped++;
+        }
+        break;
+      case LGM_FRAME_RING_POLICY_DROP_NEWEST:
+        goto drop;
+    }
+  }
+
+  slot = tail & (ring->capacity - 1);
+  ring->keyframes[slot] = keyframe;
+  g_atomic_pointer_set (&ring->slots[slot], buf);
+  g_atomic_int_inc (&ring->tail);
+  ring->pushed++;
+
+  depth = tail + 1 - head;
+  if (depth > (guint) g_atomic_int_get (&ring->max_depth))
+    g_atomic_int_set (&ring->max_depth, depth);
+
+  lgm_frame_ring_wake (ring, FALSE);
+  return TRUE;
+
+drop:
+  GST_LOG ("Dropping new frame %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (buf)));
+  gst_buffer_unref (buf);
+  ring->dropped++;
+  return FALSE;
+}
+
+/* Waits for the next frame. Returns NULL when the ring is flushing, or when
+ * it's closed and all the frames have been popped. */
+GstBuffer *
+lgm_frame_ring_pop (LgmFrameRing * ring)
+{
+  GstBuffer *buf;
+  guint head;
+
+  while (!g_atomic_int_get (&ring->flushing)) {
+    head = g_atomic_int_get (&ring->head);
+    if (head == (guint) g_atomic_int_get (&ring->tail)) {
+      if (g_atomic_int_get (&ring->closed))
+        return NULL;
+      lgm_frame_ring_wait (ring, FALSE);
+      continue;
+    }
+
+    buf = lgm_frame_ring_take (ring, head);
+    if (buf != NULL) {
+      lgm_frame_ring_wake (ring, FALSE);
+      return buf;
+    }
+  }
+  return NULL;
+}
+
+/* No more frames are accepted, pop returns NULL once the ring is empty */
+void
+lgm_frame_ring_close (LgmFrameRing * ring)
+{
+  g_atomic_int_set (&ring->closed, TRUE);
+  lgm_frame_ring_wake (ring, TRUE);
+}
+
+/* Unblocks both sides and discards the queued frames */
+void
+lgm_frame_ring_set_flushing (LgmFrameRing * ring, gboolean flushing)
+{
+  GstBuffer *buf;
+  guint head;
+
+  g_atomic_int_set (&ring->flushing, flushing);
+  if (!flushing)
+    return;
+
+  lgm_frame_ring_wake (ring, TRUE);
+  while ((head = g_atomic_int_get (&ring->head)) !=
+      (guint) g_atomic_int_get (&ring->tail)) {
+    buf = lgm_frame_ring_take (ring, head);
+    if (buf != NULL)
+      gst_buffer_unref (buf);
+  }
+}
+
+void
+lgm_frame_ring_set_policy (LgmFrameRing * ring, LgmFrameRingPolicy policy)
+{
+  g_atomic_int_set (&ring->policy, policy);
+  /* A producer waiting for space must re-evaluate the policy */
+  lgm_frame_ring_wake (ring, TRUE);
+}
+
+void
+lgm_frame_ring_get_stats (LgmFrameRing * ring, guint * depth,
+    guint * max_depth, guint64 * pushed, guint64 * dropped)
+{
+  if (depth)
+    *depth = lgm_frame_ring_depth (ring);
+  if (max_depth)
+    *max_depth = g_atomic_int_get (&ring->max_depth);
+  if (pushed)
+    *pushed = ring->pushed;
+  if (dropped)
+    *dropped = ring->dropped;
+}
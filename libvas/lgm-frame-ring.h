@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2018  Fluendo S.A.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __LGM_FRAME_RING_H__
+#define __LGM_FRAME_RING_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* What to do when a frame is pushed in a full ring */
+typedef enum
+{
+  /* Wait until the consumer pops a frame */
+  LGM_FRAME_RING_POLICY_BLOCK,
+  /* Drop the oldest frame, unless it's a keyframe and the new frame is not */
+  LGM_FRAME_RING_POLICY_DROP_OLDEST,
+  /* Drop the new frame */
+  LGM_FRAME_RING_POLICY_DROP_NEWEST,
+} LgmFrameRingPolicy;
+
+/* Bounded single-producer/single-consumer ring of buffers. Pushing and
+ * popping don't take any lock unless the producer has to wait for space or
+ * the consumer for a frame. */
+typedef struct _LgmFrameRing LgmFrameRing;
+
+LgmFrameRing * lgm_frame_ring_new (guint capacity, LgmFrameRingPolicy policy);
+void lgm_frame_ring_free (LgmFrameRing * ring);
+gboolean lgm_frame_ring_push (LgmFrameRing * ring, GstBuffer * buf);
+GstBuffer * lgm_frame_ring_pop (LgmFrameRing * ring);
+void lgm_frame_ring_close (LgmFrameRing * ring);
+void lgm_frame_ring_set_flushing (LgmFrameRing * ring, gboolean flushing);
+void lgm_frame_ring_set_policy (LgmFrameRing * ring, LgmFrameRingPolicy policy);
+void lgm_frame_ring_get_stats (LgmFrameRing * ring, guint * depth,
+    guint * max_depth, guint64 * pushed, guint64 * dropped);
+
+G_END_DECLS
+#endif /* __LGM_FRAME_RING_H__ */
@@ -0,0 +1,1120 @@
+/*
+ * Copyright (C) 2018  Fluendo S.A.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <string.h>
+#include "lgm-multi-video-player.h"
+#include "lgm-video-player.h"
+#include "baconvideowidget-marshal.h"
+#include "gstscreenshot.h"
+#include "lgm-position-probe.h"
+
+/* Maximum time to wait for all the angles to preroll a seek or a step */
+#define PREROLL_TIMEOUT (5 * GST_SECOND)
+/* Used to step back when the streams don't have a frame duration */
+#define DEFAULT_FRAME_DURATION (GST_SECOND / 25)
+/* Minimum interval between position notifications */
+#define POSITION_INTERVAL (GST_SECOND / 50)
+
+GST_DEBUG_CATEGORY_STATIC (_multi_player_debug_cat);
+#define GST_CAT_DEFAULT _multi_player_debug_cat
+
+G_DEFINE_TYPE (LgmMultiVideoPlayer, lgm_multi_video_player, GST_TYPE_ELEMENT)
+
+/* Signals */
+enum
+{
+  SIGNAL_ERROR,
+  SIGNAL_EOS,
+  SIGNAL_TICK,
+  SIGNAL_STATE_CHANGE,
+  SIGNAL_READY_TO_SEEK,
+  SIGNAL_POSITION_CHANGED,
+  LAST_SIGNAL
+};
+
+/* A file decoded in the pipeline and the first view displaying it */
+typedef struct
+{
+  LgmMultiVideoPlayer *mvp;
+  gint file;
+  guint view;
+  gint64 offset;
+  GstElement *decoder;
+  GstElement *video_bin;
+  GstXOverlay *xoverlay;
+  gboolean has_video;
+  /* The new frame after a seek or a step reached the sink */
+  gboolean prerolled;
+  gboolean wait_flush;
+  GstBuffer *last_buffer;
+} LgmAngle;
+
+struct LgmMultiVideoPlayerPrivate
+{
+  gchar **uris;
+  gint64 *offsets;
+  guint n_files;
+  GArray *views;
+  GArray *window_handles;
+  GPtrArray *angles;
+
+  GstElement *pipeline;
+  GstBus *bus;
+  GstElement *audio_bin;
+  GstElement *volume_element;
+  gdouble volume;
+  gdouble rate;
+  GstState target_state;
+
+  GMutex lock;
+  GCond prerolled_cond;
+  gboolean seeking;
+  gint64 seek_target;
+  /* The pipeline was just built and the files must be seeked to their
+   * offsets before it's ready */
+  gboolean initial_seek;
+  gboolean notify_ready;
+
+  gint64 current_time;
+  gint64 stream_length;
+  BvwFrameConv *frame_conv;
+
+  /* Watches the frames displayed in the first view and its offset */
+  LgmPositionProbe *position_probe;
+  gint64 position_offset;
+};
+
+static GstElementClass *parent_class = NULL;
+
+static int lgm_signals[LAST_SIGNAL] = { 0 };
+
+static void
+lgm_angle_free (LgmAngle * angle)
+{
+  if (angle->xoverlay != NULL)
+    gst_object_unref (angle->xoverlay);
+  if (angle->last_buffer != NULL)
+    gst_buffer_unref (angle->last_buffer);
+  g_free (angle);
+}
+
+static LgmAngle *
+lgm_multi_get_angle_for_file (LgmMultiVideoPlayer * mvp, gint file)
+{
+  guint i;
+
+  for (i = 0; i < mvp->priv->angles->len; i++) {
+    LgmAngle *angle = g_ptr_array_index (mvp->priv->angles, i);
+    if (angle->file == file)
+      return angle;
+  }
+  return NULL;
+}
+
+/* The angle used for the position and the frames */
+static LgmAngle *
+lgm_multi_get_main_angle (LgmMultiVideoPlayer * mvp)
+{
+  guint i;
+
+  for (i = 0; i < mvp->priv->angles->len; i++) {
+    LgmAngle *angle = g_ptr_array_index (mvp->priv->angles, i);
+    if (angle->has_video)
+      return angle;
+  }
+  return NULL;
+}
+
+static guintptr
+lgm_multi_get_window_handle (LgmMultiVideoPlayer * mvp, guint view)
+{
+  if (view >= mvp->priv->window_handles->len)
+    return 0;
+  return g_array_index (mvp->priv->window_handles, guintptr, view);
+}
+
+/* Must be called with the lock */
+static gboolean
+lgm_multi_all_prerolled (LgmMultiVideoPlayer * mvp)
+{
+  guint i;
+
+  for (i = 0; i < mvp->priv->angles->len; i++) {
+    LgmAngle *angle = g_ptr_array_index (mvp->priv->angles, i);
+    if (!angle->prerolled)
+      return FALSE;
+  }
+  return TRUE;
+}
+
+static void
+lgm_multi_post_prerolled (LgmMultiVideoPlayer * mvp)
+{
+  gst_element_post_message (mvp->priv->pipeline,
+      gst_message_new_application (GST_OBJECT (mvp->priv->pipeline),
+          gst_structure_new ("lgm-prerolled", NULL)));
+}
+
+/* Starts waiting for a new frame in all the angles. With wait_flush, only
+ * frames after the flush of a seek are taken into account */
+static void
+lgm_multi_reset_preroll (LgmMultiVideoPlayer * mvp, gint64 target,
+    gboolean wait_flush)
+{
+  LgmMultiVideoPlayerPrivate *priv = mvp->priv;
+  gboolean done;
+  guint i;
+
+  g_mutex_lock (&priv->lock);
+  priv->seeking = TRUE;
+  priv->seek_target = target;
+  for (i = 0; i < priv->angles->len; i++) {
+    LgmAngle *angle = g_ptr_array_index (priv->angles, i);
+    angle->prerolled = !angle->has_video;
+    angle->wait_flush = wait_flush;
+  }
+  done = lgm_multi_all_prerolled (mvp);
+  if (done)
+    priv->seeking = FALSE;
+  g_mutex_unlock (&priv->lock);
+
+  if (done)
+    lgm_multi_post_prerolled (mvp);
+}
+
+static gboolean
+lgm_multi_wait_preroll (LgmMultiVideoPlayer * mvp)
+{
+  LgmMultiVideoPlayerPrivate *priv = mvp->priv;
+  gint64 end_time;
+  gboolean ret = TRUE;
+
+  end_time = g_get_monotonic_time () + PREROLL_TIMEOUT / GST_USECOND;
+  g_mutex_lock (&priv->lock);
+  while (priv->seeking && ret) {
+    ret = g_cond_wait_until (&priv->prerolled_cond, &priv->lock, end_time);
+  }
+  g_mutex_unlock (&priv->lock);
+
+  if (!ret)
+    GST_WARNING ("Timed out waiting for all the angles to preroll");
+  return ret;
+}
+
+static gboolean
+lgm_multi_video_probe (GstPad * pad, GstMiniObject * obj, LgmAngle * angle)
+{
+  LgmMultiVideoPlayerPrivate *priv = angle->mvp->priv;
+  gboolean done = FALSE;
+
+  g_mutex_lock (&priv->lock);
+  if (GST_IS_EVENT (obj)) {
+    if (GST_EVENT_TYPE (obj) == GST_EVENT_FLUSH_STOP)
+      angle->wait_flush = FALSE;
+  } else if (GST_IS_BUFFER (obj)) {
+    gst_buffer_replace (&angle->last_buffer, GST_BUFFER (obj));
+    if (!angle->prerolled && !angle->wait_flush) {
+      angle->prerolled = TRUE;
+      if (priv->seeking && lgm_multi_all_prerolled (angle->mvp)) {
+        priv->seeking = FALSE;
+        g_cond_broadcast (&priv->prerolled_cond);
+        done = TRUE;
+      }
+    }
+  }
+  g_mutex_unlock (&priv->lock);
+
+  if (done)
+    lgm_multi_post_prerolled (angle->mvp);
+  return TRUE;
+}
+
+/* Sends the same seek to all the angles, each one moved by its offset */
+static gboolean
+lgm_multi_seek (LgmMultiVideoPlayer * mvp, gint64 time, GstSeekFlags flags)
+{
+  LgmMultiVideoPlayerPrivate *priv = mvp->priv;
+  gboolean ret = TRUE;
+  guint i;
+
+  GST_DEBUG ("Seeking %u angles to %" GST_TIME_FORMAT, priv->angles->len,
+      GST_TIME_ARGS (time));
+
+  lgm_multi_reset_preroll (mvp, time, TRUE);
+  for (i = 0; i < priv->angles->len; i++) {
+    LgmAngle *angle = g_ptr_array_index (priv->angles, i);
+    gint64 pos;
+
+    if (!angle->has_video)
+      continue;
+    pos = MAX (time + angle->offset, 0);
+    ret &= gst_element_send_event (angle->video_bin,
+        gst_event_new_seek (priv->rate, GST_FORMAT_TIME,
+            flags | GST_SEEK_FLAG_FLUSH, GST_SEEK_TYPE_SET, pos,
+            GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE));
+  }
+  return ret;
+}
+
+static void
+lgm_multi_tick (LgmMultiVideoPlayer * mvp)
+{
+  gint64 time, length;
+  gdouble position = 0;
+
+  time = lgm_multi_video_player_get_current_time (mvp);
+  length = lgm_multi_video_player_get_stream_length (mvp);
+  if (length > 0)
+    position = (gdouble) time / length;
+  g_signal_emit (mvp, lgm_signals[SIGNAL_TICK], 0, time, length, position);
+}
+
+/* Position of the frame displayed in the first view, from the main context */
+static void
+lgm_multi_position_changed_cb (gint64 running_time, gint64 stream_time,
+    LgmMultiVideoPlayer * mvp)
+{
+  LgmMultiVideoPlayerPrivate *priv = mvp->priv;
+  gboolean seeking;
+
+  g_mutex_lock (&priv->lock);
+  seeking = priv->seeking || priv->initial_seek;
+  g_mutex_unlock (&priv->lock);
+
+  /* Until all the angles prerolled the position is the seek target */
+  if (seeking)
+    return;
+
+  g_signal_emit (mvp, lgm_signals[SIGNAL_POSITION_CHANGED], 0, running_time,
+      MAX (stream_time - priv->position_offset, 0));
+}
+
+static void
+lgm_multi_pad_added_cb (GstElement * decoder, GstPad * pad, LgmAngle * angle)
+{
+  LgmMultiVideoPlayerPrivate *priv = angle->mvp->priv;
+  GstElement *sink = NULL, *video_sink;
+  GstPad *sink_pad;
+  GstCaps *caps;
+  const gchar *name;
+  GError *err = NULL;
+
+  caps = gst_pad_get_caps_reffed (pad);
+  name = gst_structure_get_name (gst_caps_get_structure (caps, 0));
+
+  if (g_str_has_prefix (name, "video/") && angle->video_bin == NULL) {
+    sink = gst_parse_bin_from_description ("queue ! ffmpegcolorspace ! "
+        "videoscale ! " DEFAULT_VIDEO_SINK " name=videosink", TRUE, &err);
+    if (sink != NULL) {
+      /* The frames displayed are the ones reaching the sink, after the
+       * queue */
+      video_sink = gst_bin_get_by_name (GST_BIN (sink), "videosink");
+      sink_pad = gst_element_get_static_pad (video_sink, "sink");
+      gst_pad_add_data_probe (sink_pad, G_CALLBACK (lgm_multi_video_probe),
+          angle);
+      g_mutex_lock (&priv->lock);
+      angle->video_bin = sink;
+      angle->has_video = TRUE;
+      if (angle->view == 0 && priv->position_probe == NULL) {
+        priv->position_offset = angle->offset;
+        priv->position_probe = lgm_position_probe_new (sink_pad,
+            POSITION_INTERVAL,
+            (LgmPositionFunc) lgm_multi_position_changed_cb, angle->mvp);
+      }
+      g_mutex_unlock (&priv->lock);
+      gst_object_unref (sink_pad);
+      gst_object_unref (video_sink);
+    }
+  } else if (g_str_has_prefix (name, "audio/") && angle->view == 0 &&
+      priv->audio_bin == NULL) {
+    /* Only the angle of the first view is heard */
+    sink = gst_parse_bin_from_description ("queue ! audioconvert ! "
+        "audioresample ! volume name=volume ! autoaudiosink", TRUE, &err);
+    if (sink != NULL) {
+      priv->audio_bin = sink;
+      priv->volume_element = gst_bin_get_by_name (GST_BIN (sink), "volume");
+      g_object_set (priv->volume_element, "volume", priv->volume, NULL);
+    }
+  }
+  gst_caps_unref (caps);
+
+  if (err != NULL) {
+    GST_ERROR ("Could not create the sink for %s: %s", name, err->message);
+    g_error_free (err);
+  }
+
+  if (sink == NULL) {
+    sink = gst_element_factory_make ("fakesink", NULL);
+    g_object_set (sink, "sync", TRUE, "async", FALSE, NULL);
+  }
+
+  gst_bin_add (GST_BIN (priv->pipeline), sink);
+  gst_element_sync_state_with_parent (sink);
+  sink_pad = gst_element_get_static_pad (sink, "sink");
+  if (gst_pad_link (pad, sink_pad) != GST_PAD_LINK_OK)
+    GST_WARNING ("Could not link the %s stream of file %d", name, angle->file);
+  gst_object_unref (sink_pad);
+}
+
+static void
+lgm_multi_element_msg_sync_cb (GstBus * bus, GstMessage * msg,
+    LgmMultiVideoPlayer * mvp)
+{
+  GstObject *sender = GST_MESSAGE_SRC (msg);
+  guint i;
+
+  if (msg->structure == NULL ||
+      !gst_structure_has_name (msg->structure, "prepare-xwindow-id") ||
+      sender == NULL || !GST_IS_X_OVERLAY (sender))
+    return;
+
+  g_mutex_lock (&mvp->priv->lock);
+  for (i = 0; i < mvp->priv->angles->len; i++) {
+    LgmAngle *angle = g_ptr_array_index (mvp->priv->angles, i);
+
+    if (angle->video_bin != NULL &&
+        gst_object_has_ancestor (sender, GST_OBJECT (angle->video_bin))) {
+      gst_object_replace ((GstObject **) & angle->xoverlay, sender);
+      lgm_set_window_handle (angle->xoverlay,
+          lgm_multi_get_window_handle (mvp, angle->view));
+      break;
+    }
+  }
+  g_mutex_unlock (&mvp->priv->lock);
+}
+
+static void
+lgm_multi_bus_message_cb (GstBus * bus, GstMessage * message,
+    LgmMultiVideoPlayer * mvp)
+{
+  LgmMultiVideoPlayerPrivate *priv = mvp->priv;
+
+  switch (GST_MESSAGE_TYPE (message)) {
+    case GST_MESSAGE_ERROR:
+    {
+      GError *err = NULL;
+      gchar *dbg = NULL;
+
+      gst_message_parse_error (message, &err, &dbg);
+      GST_ERROR ("Error from %" GST_PTR_FORMAT ": %s\n%s", message->src,
+          err->message, GST_STR_NULL (dbg));
+      priv->target_state = GST_STATE_NULL;
+      gst_element_set_state (priv->pipeline, GST_STATE_NULL);
+      g_signal_emit (mvp, lgm_signals[SIGNAL_ERROR], 0, err->message);
+      g_error_free (err);
+      g_free (dbg);
+      break;
+    }
+    case GST_MESSAGE_EOS:
+      GST_DEBUG ("EOS message");
+      g_signal_emit (mvp, lgm_signals[SIGNAL_EOS], 0);
+      break;
+    case GST_MESSAGE_STATE_CHANGED:
+    {
+      GstState old_state, new_state;
+
+      if (GST_MESSAGE_SRC (message) != GST_OBJECT (priv->pipeline))
+        break;
+
+      gst_message_parse_state_changed (message, &old_state, &new_state, NULL);
+      if (old_state == new_state)
+        break;
+
+      if (old_state == GST_STATE_READY && new_state == GST_STATE_PAUSED &&
+          priv->initial_seek) {
+        priv->initial_seek = FALSE;
+        priv->notify_ready = TRUE;
+        lgm_multi_seek (mvp, priv->seek_target, GST_SEEK_FLAG_ACCURATE);
+      }
+      g_signal_emit (mvp, lgm_signals[SIGNAL_STATE_CHANGE], 0,
+          new_state > GST_STATE_PAUSED);
+      break;
+    }
+    case GST_MESSAGE_APPLICATION:
+      if (!gst_structure_has_name (message->structure, "lgm-prerolled"))
+        break;
+      lgm_multi_tick (mvp);
+      if (priv->notify_ready) {
+        priv->notify_ready = FALSE;
+        g_signal_emit (mvp, lgm_signals[SIGNAL_READY_TO_SEEK], 0);
+        if (priv->target_state == GST_STATE_PLAYING)
+          gst_element_set_state (priv->pipeline, GST_STATE_PLAYING);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+static gboolean
+lgm_multi_build_pipeline (LgmMultiVideoPlayer * mvp, GError ** error)
+{
+  LgmMultiVideoPlayerPrivate *priv = mvp->priv;
+  guint view;
+
+  priv->pipeline = gst_pipeline_new ("multi-player");
+  priv->bus = gst_element_get_bus (priv->pipeline);
+  gst_bus_add_signal_watch (priv->bus);
+  g_signal_connect (priv->bus, "message",
+      G_CALLBACK (lgm_multi_bus_message_cb), mvp);
+  /* we want to catch "prepare-xwindow-id" element messages synchronously */
+  gst_bus_set_sync_handler (priv->bus, gst_bus_sync_signal_handler, mvp);
+  g_signal_connect (priv->bus, "sync-message::element",
+      G_CALLBACK (lgm_multi_element_msg_sync_cb), mvp);
+
+  /* A single decoder per file, even if it's displayed in several views */
+  for (view = 0; view < priv->views->len; view++) {
+    gint file = g_array_index (priv->views, gint, view);
+    LgmAngle *angle;
+
+    if (file < 0 || file >= priv->n_files ||
+        lgm_multi_get_angle_for_file (mvp, file) != NULL)
+      continue;
+
+    angle = g_new0 (LgmAngle, 1);
+    angle->mvp = mvp;
+    angle->file = file;
+    angle->view = view;
+    angle->offset = priv->offsets[file];
+    angle->prerolled = TRUE;
+    angle->decoder = gst_element_factory_make ("uridecodebin", NULL);
+    if (angle->decoder == NULL) {
+      g_set_error (error, LGM_ERROR, GST_ERROR_PLUGIN_LOAD,
+          _("Failed to create a GStreamer decoder. "
+              "Please check your GStreamer installation."));
+      g_free (angle);
+      return FALSE;
+    }
+    g_object_set (angle->decoder, "uri", priv->uris[file], NULL);
+    g_signal_connect (angle->decoder, "pad-added",
+        G_CALLBACK (lgm_multi_pad_added_cb), angle);
+    gst_bin_add (GST_BIN (priv->pipeline), angle->decoder);
+    g_ptr_array_add (priv->angles, angle);
+  }
+
+  priv->initial_seek = TRUE;
+  gst_element_set_state (priv->pipeline, GST_STATE_PAUSED);
+  return TRUE;
+}
+
+static void
+lgm_multi_destroy_pipeline (LgmMultiVideoPlayer * mvp)
+{
+  LgmMultiVideoPlayerPrivate *priv = mvp->priv;
+
+  if (priv->pipeline == NULL)
+    return;
+
+  gst_element_set_state (priv->pipeline, GST_STATE_NULL);
+
+  /* make bus drop all messages to make sure none of our callbacks is ever
+   * called again */
+  gst_bus_set_flushing (priv->bus, TRUE);
+  gst_bus_remove_signal_watch (priv->bus);
+  gst_bus_set_sync_handler (priv->bus, NULL, NULL);
+  g_signal_handlers_disconnect_matched (priv->bus, G_SIGNAL_MATCH_DATA,
+      0, 0, NULL, NULL, mvp);
+  gst_object_unref (priv->bus);
+  priv->bus = NULL;
+
+  if (priv->volume_element != NULL) {
+    gst_object_unref (priv->volume_element);
+    priv->volume_element = NULL;
+  }
+  priv->audio_bin = NULL;
+
+  gst_object_unref (priv->pipeline);
+  priv->pipeline = NULL;
+
+  lgm_position_probe_free (priv->position_probe);
+  priv->position_probe = NULL;
+
+  g_mutex_lock (&priv->lock);
+  g_ptr_array_set_size (priv->angles, 0);
+  priv->seeking = FALSE;
+  g_cond_broadcast (&priv->prerolled_cond);
+  g_mutex_unlock (&priv->lock);
+
+  priv->initial_seek = FALSE;
+  priv->notify_ready = FALSE;
+  priv->stream_length = 0;
+}
+
+gboolean
+lgm_multi_video_player_open (LgmMultiVideoPlayer * mvp, const gchar ** uris,
+    const gint64 * offsets, guint n_files, GError ** error)
+{
+  LgmMultiVideoPlayerPrivate *priv;
+  guint i;
+
+  g_return_val_if_fail (LGM_IS_MULTI_VIDEO_PLAYER (mvp), FALSE);
+  g_return_val_if_fail (uris != NULL && offsets != NULL, FALSE);
+  g_return_val_if_fail (n_files > 0, FALSE);
+
+  priv = mvp->priv;
+  lgm_multi_video_player_close (mvp);
+
+  priv->uris = g_new0 (gchar *, n_files + 1);
+  for (i = 0; i < n_files; i++) {
+    priv->uris[i] = lgm_filename_to_uri (uris[i]);
+    GST_DEBUG ("Opening file %u: %s offset:%" GST_TIME_FORMAT, i,
+        priv->uris[i], GST_TIME_ARGS (offsets[i]));
+  }
+  priv->offsets = g_memdup (offsets, n_files * sizeof (gint64));
+  priv->n_files = n_files;
+
+  if (priv->views->len == 0) {
+    gint first = 0;
+    g_array_append_val (priv->views, first);
+  }
+
+  priv->rate = 1.0;
+  priv->seek_target = 0;
+  priv->current_time = 0;
+  priv->target_state = GST_STATE_PAUSED;
+
+  if (!lgm_multi_build_pipeline (mvp, error)) {
+    lgm_multi_video_player_close (mvp);
+    return FALSE;
+  }
+  return TRUE;
+}
+
+void
+lgm_multi_video_player_set_views (LgmMultiVideoPlayer * mvp,
+    const gint * files, guint n_views)
+{
+  LgmMultiVideoPlayerPrivate *priv;
+  gboolean same_files = TRUE;
+  guint i;
+
+  g_return_if_fail (LGM_IS_MULTI_VIDEO_PLAYER (mvp));
+
+  priv = mvp->priv;
+  if (n_views == priv->views->len &&
+      !memcmp (priv->views->data, files, n_views * sizeof (gint)))
+    return;
+
+  g_array_set_size (priv->views, 0);
+  g_array_append_vals (priv->views, files, n_views);
+
+  if (priv->pipeline == NULL)
+    return;
+
+  /* If the same files are displayed, only the windows are swapped */
+  for (i = 0; i < n_views && same_files; i++) {
+    if (files[i] >= 0 && files[i] < priv->n_files &&
+        lgm_multi_get_angle_for_file (mvp, files[i]) == NULL)
+      same_files = FALSE;
+  }
+  g_mutex_lock (&priv->lock);
+  for (i = 0; i < priv->angles->len && same_files; i++) {
+    LgmAngle *angle = g_ptr_array_index (priv->angles, i);
+    guint view;
+
+    for (view = 0; view < n_views && files[view] != angle->file; view++);
+    if (view == n_views || (view != 0 && angle->view == 0) ||
+        (view == 0 && angle->view != 0)) {
+      /* Not displayed anymore or the audio must come from another file */
+      same_files = FALSE;
+    }
+  }
+  if (same_files) {
+    for (i = 0; i < priv->angles->len; i++) {
+      LgmAngle *angle = g_ptr_array_index (priv->angles, i);
+
+      for (angle->view = 0; files[angle->view] != angle->file; angle->view++);
+      if (angle->xoverlay != NULL) {
+        lgm_set_window_handle (angle->xoverlay,
+            lgm_multi_get_window_handle (mvp, angle->view));
+      }
+    }
+  }
+  g_mutex_unlock (&priv->lock);
+
+  if (!same_files) {
+    gint64 position;
+
+    /* Decode the new set of files from the current position */
+    GST_DEBUG ("Displayed files changed, rebuilding the pipeline");
+    position = lgm_multi_video_player_get_current_time (mvp);
+    lgm_multi_destroy_pipeline (mvp);
+    priv->seek_target = position;
+    lgm_multi_build_pipeline (mvp, NULL);
+  }
+}
+
+void
+lgm_multi_video_player_set_window_handle (LgmMultiVideoPlayer * mvp,
+    guint view, guintptr window_handle)
+{
+  LgmMultiVideoPlayerPrivate *priv;
+  guint i;
+
+  g_return_if_fail (LGM_IS_MULTI_VIDEO_PLAYER (mvp));
+
+  priv = mvp->priv;
+  g_mutex_lock (&priv->lock);
+  if (view >= priv->window_handles->len)
+    g_array_set_size (priv->window_handles, view + 1);
+  g_array_index (priv->window_handles, guintptr, view) = window_handle;
+
+  for (i = 0; i < priv->angles->len; i++) {
+    LgmAngle *angle = g_ptr_array_index (priv->angles, i);
+    if (angle->view == view && angle->xoverlay != NULL)
+      lgm_set_window_handle (angle->xoverlay, window_handle);
+  }
+  g_mutex_unlock (&priv->lock);
+}
+
+gboolean
+lgm_multi_video_player_play (LgmMultiVideoPlayer * mvp, gboolean synchronous)
+{
+  g_return_val_if_fail (LGM_IS_MULTI_VIDEO_PLAYER (mvp), FALSE);
+  g_return_val_if_fail (mvp->priv->pipeline != NULL, FALSE);
+
+  mvp->priv->target_state = GST_STATE_PLAYING;
+  /* Started once the angles are at their offsets */
+  if (mvp->priv->initial_seek || mvp->priv->notify_ready)
+    return TRUE;
+
+  gst_element_set_state (mvp->priv->pipeline, GST_STATE_PLAYING);
+  if (synchronous)
+    gst_element_get_state (mvp->priv->pipeline, NULL, NULL, PREROLL_TIMEOUT);
+  return TRUE;
+}
+
+void
+lgm_multi_video_player_pause (LgmMultiVideoPlayer * mvp, gboolean synchronous)
+{
+  g_return_if_fail (LGM_IS_MULTI_VIDEO_PLAYER (mvp));
+  g_return_if_fail (mvp->priv->pipeline != NULL);
+
+  mvp->priv->target_state = GST_STATE_PAUSED;
+  gst_element_set_state (mvp->priv->pipeline, GST_STATE_PAUSED);
+  if (synchronous)
+    gst_element_get_state (mvp->priv->pipeline, NULL, NULL, PREROLL_TIMEOUT);
+}
+
+void
+lgm_multi_video_player_stop (LgmMultiVideoPlayer * mvp, gboolean synchronous)
+{
+  g_return_if_fail (LGM_IS_MULTI_VIDEO_PLAYER (mvp));
+
+  if (mvp->priv->pipeline == NULL)
+    return;
+
+  /* Keep the pipeline prerolled at the start, it's costly to build */
+  lgm_multi_video_player_pause (mvp, synchronous);
+  lgm_multi_video_player_seek_time (mvp, 0, TRUE, synchronous);
+}
+
+void
+lgm_multi_video_player_close (LgmMultiVideoPlayer * mvp)
+{
+  LgmMultiVideoPlayerPrivate *priv;
+
+  g_return_if_fail (LGM_IS_MULTI_VIDEO_PLAYER (mvp));
+
+  priv = mvp->priv;
+  GST_LOG ("Closing");
+  lgm_multi_destroy_pipeline (mvp);
+  g_strfreev (priv->uris);
+  priv->uris = NULL;
+  g_free (priv->offsets);
+  priv->offsets = NULL;
+  priv->n_files = 0;
+  priv->target_state = GST_STATE_NULL;
+  priv->current_time = 0;
+}
+
+gboolean
+lgm_multi_video_player_is_playing (LgmMultiVideoPlayer * mvp)
+{
+  g_return_val_if_fail (LGM_IS_MULTI_VIDEO_PLAYER (mvp), FALSE);
+
+  return mvp->priv->target_state == GST_STATE_PLAYING;
+}
+
+gboolean
+lgm_multi_video_player_seek_time (LgmMultiVideoPlayer * mvp, gint64 time,
+    gboolean accurate, gboolean synchronous)
+{
+  gboolean ret;
+
+  g_return_val_if_fail (LGM_IS_MULTI_VIDEO_PLAYER (mvp), FALSE);
+
+  if (mvp->priv->pipeline == NULL)
+    return FALSE;
+
+  /* Not prerolled yet, it will be the initial position */
+  if (mvp->priv->initial_seek) {
+    mvp->priv->seek_target = time;
+    return TRUE;
+  }
+
+  ret = lgm_multi_seek (mvp, time,
+      accurate ? GST_SEEK_FLAG_ACCURATE : GST_SEEK_FLAG_KEY_UNIT);
+  if (ret && synchronous)
+    ret = lgm_multi_wait_preroll (mvp);
+  return ret;
+}
+
+static GstClockTime
+lgm_multi_get_frame_duration (LgmMultiVideoPlayer * mvp)
+{
+  LgmAngle *angle;
+  GstClockTime duration = DEFAULT_FRAME_DURATION;
+
+  g_mutex_lock (&mvp->priv->lock);
+  angle = lgm_multi_get_main_angle (mvp);
+  if (angle != NULL && angle->last_buffer != NULL &&
+      GST_BUFFER_DURATION_IS_VALID (angle->last_buffer))
+    duration = GST_BUFFER_DURATION (angle->last_buffer);
+  g_mutex_unlock (&mvp->priv->lock);
+  return duration;
+}
+
+gboolean
+lgm_multi_video_player_seek_to_next_frame (LgmMultiVideoPlayer * mvp)
+{
+  LgmMultiVideoPlayerPrivate *priv;
+  gint64 pos;
+  guint i;
+
+  g_return_val_if_fail (LGM_IS_MULTI_VIDEO_PLAYER (mvp), FALSE);
+
+  priv = mvp->priv;
+  if (priv->pipeline == NULL || priv->initial_seek)
+    return FALSE;
+
+  GST_DEBUG ("Seeking to next frame");
+  lgm_multi_video_player_pause (mvp, TRUE);
+  pos = lgm_multi_video_player_get_current_time (mvp);
+
+  lgm_multi_reset_preroll (mvp, pos + lgm_multi_get_frame_duration (mvp),
+      FALSE);
+  for (i = 0; i < priv->angles->len; i++) {
+    LgmAngle *angle = g_ptr_array_index (priv->angles, i);
+
+    if (angle->has_video) {
+      gst_element_send_event (angle->video_bin,
+          gst_event_new_step (GST_FORMAT_BUFFERS, 1, 1.0, TRUE, FALSE));
+    }
+  }
+  return lgm_multi_wait_preroll (mvp);
+}
+
+gboolean
+lgm_multi_video_player_seek_to_previous_frame (LgmMultiVideoPlayer * mvp)
+{
+  gint64 pos;
+
+  g_return_val_if_fail (LGM_IS_MULTI_VIDEO_PLAYER (mvp), FALSE);
+
+  if (mvp->priv->pipeline == NULL || mvp->priv->initial_seek)
+    return FALSE;
+
+  GST_DEBUG ("Seeking to previous frame");
+  lgm_multi_video_player_pause (mvp, TRUE);
+  pos = lgm_multi_video_player_get_current_time (mvp);
+  if (pos <= 0)
+    return FALSE;
+
+  return lgm_multi_video_player_seek_time (mvp,
+      MAX (pos - (gint64) lgm_multi_get_frame_duration (mvp), 0), TRUE, TRUE);
+}
+
+gint64
+lgm_multi_video_player_get_current_time (LgmMultiVideoPlayer * mvp)
+{
+  LgmMultiVideoPlayerPrivate *priv;
+  GstFormat fmt = GST_FORMAT_TIME;
+  LgmAngle *angle;
+  gint64 pos = -1;
+
+  g_return_val_if_fail (LGM_IS_MULTI_VIDEO_PLAYER (mvp), -1);
+
+  priv = mvp->priv;
+  /* Until all the angles reached the new position */
+  g_mutex_lock (&priv->lock);
+  if (priv->seeking || priv->initial_seek) {
+    pos = priv->seek_target;
+    g_mutex_unlock (&priv->lock);
+    return pos;
+  }
+  angle = lgm_multi_get_main_angle (mvp);
+  g_mutex_unlock (&priv->lock);
+
+  if (angle != NULL &&
+      gst_element_query_position (angle->video_bin, &fmt, &pos) && pos != -1) {
+    priv->current_time = MAX (pos - angle->offset, 0);
+  }
+  return priv->current_time;
+}
+
+gint64
+lgm_multi_video_player_get_stream_length (LgmMultiVideoPlayer * mvp)
+{
+  LgmMultiVideoPlayerPrivate *priv;
+  GstFormat fmt = GST_FORMAT_TIME;
+  LgmAngle *angle;
+  gint64 len = -1;
+
+  g_return_val_if_fail (LGM_IS_MULTI_VIDEO_PLAYER (mvp), -1);
+
+  priv = mvp->priv;
+  if (priv->stream_length == 0 && priv->pipeline != NULL) {
+    g_mutex_lock (&priv->lock);
+    angle = lgm_multi_get_main_angle (mvp);
+    g_mutex_unlock (&priv->lock);
+    if (angle != NULL &&
+        gst_element_query_duration (angle->video_bin, &fmt, &len) &&
+        len != -1) {
+      priv->stream_length = MAX (len - angle->offset, 0);
+    }
+  }
+  return priv->stream_length;
+}
+
+gboolean
+lgm_multi_video_player_set_rate (LgmMultiVideoPlayer * mvp, gdouble rate)
+{
+  g_return_val_if_fail (LGM_IS_MULTI_VIDEO_PLAYER (mvp), FALSE);
+
+  GST_DEBUG ("Setting rate to %f", rate);
+  mvp->priv->rate = rate;
+  return lgm_multi_video_player_seek_time (mvp,
+      lgm_multi_video_player_get_current_time (mvp), TRUE, FALSE);
+}
+
+void
+lgm_multi_video_player_set_volume (LgmMultiVideoPlayer * mvp, gdouble volume)
+{
+  g_return_if_fail (LGM_IS_MULTI_VIDEO_PLAYER (mvp));
+
+  mvp->priv->volume = CLAMP (volume, 0.0, 1.0);
+  if (mvp->priv->volume_element != NULL)
+    g_object_set (mvp->priv->volume_element, "volume", mvp->priv->volume,
+        NULL);
+}
+
+gdouble
+lgm_multi_video_player_get_volume (LgmMultiVideoPlayer * mvp)
+{
+  g_return_val_if_fail (LGM_IS_MULTI_VIDEO_PLAYER (mvp), 0.0);
+
+  return mvp->priv->volume;
+}
+
+static void
+destroy_pixbuf (guchar * pix, gpointer data)
+{
+  gst_buffer_unref (GST_BUFFER (data));
+}
+
+GdkPixbuf *
+lgm_multi_video_player_get_current_frame (LgmMultiVideoPlayer * mvp)
+{
+  LgmMultiVideoPlayerPrivate *priv;
+  GstBuffer *buf = NULL, *frame;
+  GstStructure *s;
+  GdkPixbuf *pixbuf;
+  LgmAngle *angle;
+  GError *err = NULL;
+  gint width = 0, height = 0;
+
+  g_return_val_if_fail (LGM_IS_MULTI_VIDEO_PLAYER (mvp), NULL);
+
+  priv = mvp->priv;
+  g_mutex_lock (&priv->lock);
+  angle = lgm_multi_get_main_angle (mvp);
+  if (angle != NULL && angle->last_buffer != NULL)
+    buf = gst_buffer_ref (angle->last_buffer);
+  g_mutex_unlock (&priv->lock);
+
+  if (buf == NULL || GST_BUFFER_CAPS (buf) == NULL) {
+    GST_DEBUG ("Could not take screenshot: %s", "no last video frame");
+    if (buf != NULL)
+      gst_buffer_unref (buf);
+    return NULL;
+  }
+
+  if (priv->frame_conv == NULL) {
+    priv->frame_conv = bvw_frame_conv_new (LGM_FRAME_FORMAT_RGB24, &err);
+    if (priv->frame_conv == NULL) {
+      GST_WARNING ("Could not create frame converter: %s", err->message);
+      g_error_free (err);
+      gst_buffer_unref (buf);
+      return NULL;
+    }
+  }
+  frame = bvw_frame_conv_convert (priv->frame_conv, buf);
+  gst_buffer_unref (buf);
+  if (frame == NULL) {
+    GST_DEBUG ("Could not take screenshot: %s", "conversion failed");
+    return NULL;
+  }
+
+  s = gst_caps_get_structure (GST_BUFFER_CAPS (frame), 0);
+  gst_structure_get_int (s, "width", &width);
+  gst_structure_get_int (s, "height", &height);
+  if (width <= 0 || height <= 0) {
+    gst_buffer_unref (frame);
+    return NULL;
+  }
+
+  pixbuf = gdk_pixbuf_new_from_data (GST_BUFFER_DATA (frame),
+      GDK_COLORSPACE_RGB, FALSE, 8, width, height,
+      GST_ROUND_UP_4 (width * 3), destroy_pixbuf, frame);
+  if (pixbuf == NULL)
+    gst_buffer_unref (frame);
+  return pixbuf;
+}
+
+void
+lgm_multi_video_player_expose (LgmMultiVideoPlayer * mvp)
+{
+  guint i;
+
+  g_return_if_fail (LGM_IS_MULTI_VIDEO_PLAYER (mvp));
+
+  g_mutex_lock (&mvp->priv->lock);
+  for (i = 0; i < mvp->priv->angles->len; i++) {
+    LgmAngle *angle = g_ptr_array_index (mvp->priv->angles, i);
+    if (angle->xoverlay != NULL)
+      gst_x_overlay_expose (angle->xoverlay);
+  }
+  g_mutex_unlock (&mvp->priv->lock);
+}
+
+LgmMultiVideoPlayer *
+lgm_multi_video_player_new (GError ** error)
+{
+  return (LgmMultiVideoPlayer *)
+      g_object_new (lgm_multi_video_player_get_type (), NULL);
+}
+
+/* =========================================== */
+/*                                             */
+/*          GObject type                       */
+/*                                             */
+/* =========================================== */
+
+static void
+lgm_multi_video_player_finalize (GObject * object)
+{
+  LgmMultiVideoPlayer *mvp = (LgmMultiVideoPlayer *) object;
+
+  GST_INFO ("finalizing");
+
+  lgm_multi_video_player_close (mvp);
+  g_ptr_array_free (mvp->priv->angles, TRUE);
+  g_array_free (mvp->priv->views, TRUE);
+  g_array_free (mvp->priv->window_handles, TRUE);
+  g_mutex_clear (&mvp->priv->lock);
+  g_cond_clear (&mvp->priv->prerolled_cond);
+  if (mvp->priv->frame_conv != NULL)
+    bvw_frame_conv_free (mvp->priv->frame_conv);
+
+  G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+lgm_multi_video_player_init (LgmMultiVideoPlayer * mvp)
+{
+  LgmMultiVideoPlayerPrivate *priv;
+
+  mvp->priv = priv =
+      G_TYPE_INSTANCE_GET_PRIVATE (mvp, LGM_TYPE_MULTI_VIDEO_PLAYER,
+      LgmMultiVideoPlayerPrivate);
+
+  priv->views = g_array_new (FALSE, FALSE, sizeof (gint));
+  priv->window_handles = g_array_new (FALSE, TRUE, sizeof (guintptr));
+  priv->angles = g_ptr_array_new_with_free_func ((GDestroyNotify)
+      lgm_angle_free);
+  priv->volume = 1.0;
+  priv->rate = 1.0;
+  g_mutex_init (&priv->lock);
+  g_cond_init (&priv->prerolled_cond);
+}
+
+static void
+lgm_multi_video_player_class_init (LgmMultiVideoPlayerClass * klass)
+{
+  GObjectClass *object_class;
+
+  object_class = (GObjectClass *) klass;
+  parent_class = (GstElementClass *) g_type_class_peek_parent (klass);
+  g_type_class_add_private (object_class, sizeof (LgmMultiVideoPlayerPrivate));
+
+  GST_DEBUG_CATEGORY_INIT (_multi_player_debug_cat, "longomatch", 0,
+      "LongoMatch GStreamer Backend");
+
+  /* GObject */
+  object_class->finalize = lgm_multi_video_player_finalize;
+
+  /* Signals */
+  lgm_signals[SIGNAL_ERROR] =
+      g_signal_new ("error",
+      G_TYPE_FROM_CLASS (object_class),
+      G_SIGNAL_RUN_LAST,
+      G_STRUCT_OFFSET (LgmMultiVideoPlayerClass, error),
+      NULL, NULL,
+      g_cclosure_marshal_VOID__STRING, G_TYPE_NONE, 1, G_TYPE_STRING);
+
+  lgm_signals[SIGNAL_EOS] =
+      g_signal_new ("eos",
+      G_TYPE_FROM_CLASS (object_class),
+      G_SIGNAL_RUN_LAST,
+      G_STRUCT_OFFSET (LgmMultiVideoPlayerClass, eos),
+      NULL, NULL, g_cclosure_marshal_VOID__VOID, G_TYPE_NONE, 0);
+
+  lgm_signals[SIGNAL_READY_TO_SEEK] =
+      g_signal_new ("ready_to_seek",
+      G_TYPE_FROM_CLASS (object_class),
+      G_SIGNAL_RUN_LAST,
+      G_STRUCT_OFFSET (LgmMultiVideoPlayerClass, ready_to_seek),
+      NULL, NULL, g_cclosure_marshal_VOID__VOID, G_TYPE_NONE, 0);
+
+  lgm_signals[SIGNAL_TICK] =
+      g_signal_new ("tick",
+      G_TYPE_FROM_CLASS (object_class),
+      G_SIGNAL_RUN_LAST,
+      G_STRUCT_OFFSET (LgmMultiVideoPlayerClass, tick),
+      NULL, NULL,
+      baconvideowidget_marshal_VOID__INT64_INT64_DOUBLE,
+      G_TYPE_NONE, 3, G_TYPE_INT64, G_TYPE_INT64, G_TYPE_DOUBLE);
+
+  lgm_signals[SIGNAL_STATE_CHANGE] =
+      g_signal_new ("state_change",
+      G_TYPE_FROM_CLASS (object_class),
+      G_SIGNAL_RUN_LAST,
+      G_STRUCT_OFFSET (LgmMultiVideoPlayerClass, state_change),
+      NULL, NULL,
+      g_cclosure_marshal_VOID__BOOLEAN, G_TYPE_NONE, 1, G_TYPE_BOOLEAN);
+
+  lgm_signals[SIGNAL_POSITION_CHANGED] =
+      g_signal_new ("position_changed",
+      G_TYPE_FROM_CLASS (object_class),
+      G_SIGNAL_RUN_LAST,
+      G_STRUCT_OFFSET (LgmMultiVideoPlayerClass, position_changed),
+      NULL, NULL,
+      baconvideowidget_marshal_VOID__INT64_INT64,
+      G_TYPE_NONE, 2, G_TYPE_INT64, G_TYPE_INT64);
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2018  Fluendo S.A.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef HAVE_LGM_MULTI_VIDEO_PLAYER_H
+#define HAVE_LGM_MULTI_VIDEO_PLAYER_H
+
+#include "lgm-utils.h"
+
+G_BEGIN_DECLS
+#define LGM_TYPE_MULTI_VIDEO_PLAYER            (lgm_multi_video_player_get_type ())
+#define LGM_MULTI_VIDEO_PLAYER(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), lgm_multi_video_player_get_type (), LgmMultiVideoPlayer))
+#define LGM_MULTI_VIDEO_PLAYER_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), lgm_multi_video_player_get_type (), LgmMultiVideoPlayerClass))
+#define LGM_IS_MULTI_VIDEO_PLAYER(obj)         (G_TYPE_CHECK_INSTANCE_TYPE (obj, lgm_multi_video_player_get_type ()))
+typedef struct LgmMultiVideoPlayerPrivate LgmMultiVideoPlayerPrivate;
+
+/* Plays several angles of the same event in a single pipeline, so that
+ * they share the clock and are seeked and stepped together. Each file has
+ * an offset, the time of the file at the position 0 of the player. */
+typedef struct
+{
+  GstElement parent;
+  LgmMultiVideoPlayerPrivate *priv;
+} LgmMultiVideoPlayer;
+
+typedef struct
+{
+  GstElementClass parent_class;
+
+  void (*error) (LgmMultiVideoPlayer * mvp, const char *message);
+  void (*eos) (LgmMultiVideoPlayer * mvp);
+  void (*tick) (LgmMultiVideoPlayer * mvp, gint64 current_time,
+      gint64 stream_length, gdouble current_position);
+  void (*state_change) (LgmMultiVideoPlayer * mvp, gboolean playing);
+  void (*ready_to_seek) (LgmMultiVideoPlayer * mvp);
+  /* Running time and position of the frame displayed in the first view */
+  void (*position_changed) (LgmMultiVideoPlayer * mvp, gint64 running_time,
+      gint64 position);
+} LgmMultiVideoPlayerClass;
+
+EXPORT GType lgm_multi_video_player_get_type (void) G_GNUC_CONST;
+
+EXPORT LgmMultiVideoPlayer *lgm_multi_video_player_new   (GError ** error);
+
+EXPORT gboolean lgm_multi_video_player_open              (LgmMultiVideoPlayer * mvp,
+                                                          const gchar ** uris,
+                                                          const gint64 * offsets,
+                                                          guint n_files,
+                                                          GError ** error);
+
+/* Sets the file displayed in each view, only those files are decoded */
+EXPORT void lgm_multi_video_player_set_views             (LgmMultiVideoPlayer * mvp,
+                                                          const gint * files,
+                                                          guint n_views);
+
+EXPORT void lgm_multi_video_player_set_window_handle     (LgmMultiVideoPlayer * mvp,
+                                                          guint view,
+                                                          guintptr window_handle);
+
+EXPORT gboolean lgm_multi_video_player_play              (LgmMultiVideoPlayer * mvp,
+                                                          gboolean synchronous);
+
+EXPORT void lgm_multi_video_player_pause                 (LgmMultiVideoPlayer * mvp,
+                                                          gboolean synchronous);
+
+EXPORT void lgm_multi_video_player_stop                  (LgmMultiVideoPlayer * mvp,
+                                                          gboolean synchronous);
+
+EXPORT void lgm_multi_video_player_close                 (LgmMultiVideoPlayer * mvp);
+
+EXPORT gboolean lgm_multi_video_player_is_playing        (LgmMultiVideoPlayer * mvp);
+
+/* Seeks and steps are done in all the angles and are complete once all of
+ * them prerolled the new frame */
+EXPORT gboolean lgm_multi_video_player_seek_time         (LgmMultiVideoPlayer * mvp,
+                                                          gint64 time,
+                                                          gboolean accurate,
+                                                          gboolean synchronous);
+
+EXPORT gboolean lgm_multi_video_player_seek_to_next_frame (LgmMultiVideoPlayer * mvp);
+
+EXPORT gboolean lgm_multi_video_player_seek_to_previous_frame (LgmMultiVideoPlayer * mvp);
+
+EXPORT gint64 lgm_multi_video_player_get_current_time    (LgmMultiVideoPlayer * mvp);
+
+EXPORT gint64 lgm_multi_video_player_get_stream_length   (LgmMultiVideoPlayer * mvp);
+
+EXPORT gboolean lgm_multi_video_player_set_rate          (LgmMultiVideoPlayer * mvp,
+                                                          gdouble rate);
+
+EXPORT void lgm_multi_video_player_set_volume            (LgmMultiVideoPlayer * mvp,
+                                                          gdouble volume);
+
+EXPORT gdouble lgm_multi_video_player_get_volume         (LgmMultiVideoPlayer * mvp);
+
+/* Frame of the first view, release it with lgm_video_player_unref_pixbuf () */
+EXPORT GdkPixbuf *lgm_multi_video_player_get_current_frame (LgmMultiVideoPlayer * mvp);
+
+EXPORT void lgm_multi_video_player_expose                (LgmMultiVideoPlayer * mvp);
+
+G_END_DECLS
+#endif /* HAVE_LGM_MULTI_VIDEO_PLAYER_H */
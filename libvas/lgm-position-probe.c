@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2018  Fluendo S.A.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "lgm-position-probe.h"
+
+/* The segment is only used from the streaming thread, the position and
+ * the pending notification are shared with the main context. */
+struct _LgmPositionProbe
+{
+  GstPad *pad;
+  gulong probe_id;
+  GstSegment segment;
+  GstClockTime interval;
+  LgmPositionFunc func;
+  gpointer user_data;
+
+  GMutex lock;
+  gint64 running_time;
+  gint64 stream_time;
+  guint source_id;
+  gint64 last_notify;
+};
+
+static gboolean
+lgm_position_probe_notify (LgmPositionProbe * probe)
+{
+  gint64 running_time, stream_time;
+
+  g_mutex_lock (&probe->lock);
+  running_time = probe->running_time;
+  stream_time = probe->stream_time;
+  probe->source_id = 0;
+  probe->last_notify = g_get_monotonic_time ();
+  g_mutex_unlock (&probe->lock);
+
+  probe->func (running_time, stream_time, probe->user_data);
+  return FALSE;
+}
+
+static void
+lgm_position_probe_handle_event (LgmPositionProbe * probe, GstEvent * event)
+{
+  GstFormat format;
+  gboolean update;
+  gdouble rate, applied_rate;
+  gint64 start, stop, time;
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_NEWSEGMENT:
+      gst_event_parse_new_segment_full (event, &update, &rate, &applied_rate,
+          &format, &start, &stop, &time);
+      if (format != GST_FORMAT_TIME)
+        break;
+      gst_segment_set_newsegment_full (&probe->segment, update, rate,
+          applied_rate, format, start, stop, time);
+      break;
+    case GST_EVENT_FLUSH_STOP:
+      gst_segment_init (&probe->segment, GST_FORMAT_TIME);
+      break;
+    default:
+      break;
+  }
+}
+
+static void
+lgm_position_probe_handle_buffer (LgmPositionProbe * probe, GstBuffer * buf)
+{
+  GstClockTime ts = GST_BUFFER_TIMESTAMP (buf);
+  gint64 running_time, stream_time, elapsed, interval;
+
+  if (!GST_CLOCK_TIME_IS_VALID (ts))
+    return;
+
+  /* Frames played backward are displayed from their end */
+  if (probe->segment.rate < 0 && GST_BUFFER_DURATION_IS_VALID (buf))
+    ts += GST_BUFFER_DURATION (buf);
+
+  stream_time = gst_segment_to_stream_time (&probe->segment, GST_FORMAT_TIME,
+      ts);
+  running_time = gst_segment_to_running_time (&probe->segment,
+      GST_FORMAT_TIME, ts);
+  if (stream_time == -1)
+    return;
+
+  g_mutex_lock (&probe->lock);
+  probe->running_time = running_time;
+  probe->stream_time = stream_time;
+  /* A notification already scheduled reports the newest position */
+  if (probe->source_id == 0) {
+    elapsed = g_get_monotonic_time () - probe->last_notify;
+    interval = probe->interval / GST_USECOND;
+    if (elapsed >= interval) {
+      probe->source_id = g_idle_add ((GSourceFunc) lgm_position_probe_notify,
+          probe);
+    } else {
+      probe->source_id = g_timeout_add ((interval - elapsed) / 1000,
+          (GSourceFunc) lgm_position_probe_notify, probe);
+    }
+  }
+  g_mutex_unlock (&probe->lock);
+}
+
+static gboolean
+lgm_position_probe_data_probe (GstPad * pad, GstMiniObject * obj,
+    LgmPositionProbe * probe)
+{
+  if (GST_IS_EVENT (obj))
+    lgm_position_probe_handle_event (probe, GST_EVENT (obj));
+  else if (GST_IS_BUFFER (obj))
+    lgm_position_probe_handle_buffer (probe, GST_BUFFER (obj));
+  return TRUE;
+}
+
+LgmPositionProbe *
+lgm_position_probe_new (GstPad * pad, GstClockTime interval,
+    LgmPositionFunc func, gpointer user_data)
+{
+  LgmPositionProbe *probe;
+
+  g_return_val_if_fail (GST_IS_PAD (pad), NULL);
+  g_return_val_if_fail (func != NULL, NULL);
+
+  probe = g_new0 (LgmPositionProbe, 1);
+  probe->pad = gst_object_ref (pad);
+  probe->interval = interval;
+  probe->func = func;
+  probe->user_data = user_data;
+  gst_segment_init (&probe->segment, GST_FORMAT_TIME);
+  g_mutex_init (&probe->lock);
+
+  probe->probe_id = gst_pad_add_data_probe (pad,
+      G_CALLBACK (lgm_position_probe_data_probe), probe);
+  return probe;
+}
+
+void
+lgm_position_probe_free (LgmPositionProbe * probe)
+{
+  if (probe == NULL)
+    return;
+
+  gst_pad_remove_data_probe (probe->pad, probe->probe_id);
+  gst_object_unref (probe->pad);
+  if (probe->source_id != 0)
+    g_source_remove (probe->source_id);
+  g_mutex_clear (&probe->lock);
+  g_free (probe);
+}
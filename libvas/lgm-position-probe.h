@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2018  Fluendo S.A.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __LGM_POSITION_PROBE_H__
+#define __LGM_POSITION_PROBE_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+/* Called from the main context with the running and stream time of the
+ * last frame that reached the pad */
+typedef void (*LgmPositionFunc) (gint64 running_time, gint64 stream_time,
+    gpointer user_data);
+
+/* Watches the frames reaching a sink pad and notifies their position
+ * instead of having to query it periodically. Notifications are coalesced
+ * so that there is at most one every interval, with the newest position. */
+typedef struct _LgmPositionProbe LgmPositionProbe;
+
+LgmPositionProbe *lgm_position_probe_new (GstPad * pad, GstClockTime interval,
+    LgmPositionFunc func, gpointer user_data);
+
+/* Must be called when the pad isn't streaming, after the pipeline is
+ * stopped, and from the main context */
+void lgm_position_probe_free (LgmPositionProbe * probe);
+
+G_END_DECLS
+#endif /* __LGM_POSITION_PROBE_H__ */
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2018  Fluendo S.A.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "lgm-rate-limiter.h"
+
+struct _LgmRateLimiter
+{
+  volatile gint refcount;
+  GMutex lock;
+  guint64 rate;
+  /* Bytes that can be consumed right away, negative when consumers are
+   * waiting for the bytes they already took */
+  gdouble tokens;
+  gint64 last_refill;
+};
+
+LgmRateLimiter *
+lgm_rate_limiter_new (guint64 bytes_per_second)
+{
+  LgmRateLimiter *limiter;
+
+  limiter = g_new0 (LgmRateLimiter, 1);
+  limiter->refcount = 1;
+  limiter->rate = bytes_per_second;
+  limiter->tokens = bytes_per_second;
+  limiter->last_refill = g_get_monotonic_time ();
+  g_mutex_init (&limiter->lock);
+  return limiter;
+}
+
+LgmRateLimiter *
+lgm_rate_limiter_ref (LgmRateLimiter * limiter)
+{
+  g_atomic_int_inc (&limiter->refcount);
+  return limiter;
+}
+
+void
+lgm_rate_limiter_unref (LgmRateLimiter * limiter)
+{
+  if (!g_atomic_int_dec_and_test (&limiter->refcount))
+    return;
+
+  g_mutex_clear (&limiter->lock);
+  g_free (limiter);
+}
+
+void
+lgm_rate_limiter_consume (LgmRateLimiter * limiter, gsize size)
+{
+  gint64 now;
+  gdouble wait = 0;
+
+  if (limiter->rate == 0)
+    return;
+
+  g_mutex_lock (&limiter->lock);
+  now = g_get_monotonic_time ();
+  /* Allow bursts of up to one second */
+  limiter->tokens = MIN (limiter->rate, limiter->tokens +
+      (gdouble) limiter->rate * (now - limiter->last_refill) /
+      G_TIME_SPAN_SECOND);
+  limiter->last_refill = now;
+  limiter->tokens -= size;
+  if (limiter->tokens < 0)
+    wait = -limiter->tokens / limiter->rate;
+  g_mutex_unlock (&limiter->lock);
+
+  /* Each consumer waits for its own debt, so they get served in order */
+  if (wait > 0)
+    g_usleep (wait * G_USEC_PER_SEC);
+}
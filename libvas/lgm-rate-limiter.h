@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2018  Fluendo S.A.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __LGM_RATE_LIMITER_H__
+#define __LGM_RATE_LIMITER_H__
+
+#include <glib.h>
+
+#ifdef WIN32
+#define EXPORT __declspec (dllexport)
+#else
+#define EXPORT
+#endif
+
+G_BEGIN_DECLS
+
+/* Token bucket limiting the throughput of the threads sharing it, used to
+ * cap the disk bandwidth of several pipelines working at the same time */
+typedef struct _LgmRateLimiter LgmRateLimiter;
+
+/* A rate of 0 doesn't limit the throughput */
+EXPORT LgmRateLimiter * lgm_rate_limiter_new (guint64 bytes_per_second);
+EXPORT LgmRateLimiter * lgm_rate_limiter_ref (LgmRateLimiter * limiter);
+EXPORT void lgm_rate_limiter_unref (LgmRateLimiter * limiter);
+
+/* Blocks until size bytes can be consumed without exceeding the rate */
+void lgm_rate_limiter_consume (LgmRateLimiter * limiter, gsize size);
+
+G_END_DECLS
+#endif /* __LGM_RATE_LIMITER_H__ */
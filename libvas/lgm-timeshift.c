@@ -0,0 +1,341 @@
+/*
+ * Copyright (C) 2018  Fluendo S.A.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/app/gstappsrc.h>
+#include "lgm-timeshift.h"
+
+typedef struct
+{
+  GstClockTime start;
+  GPtrArray *buffers;
+} LgmGop;
+
+struct _LgmTimeshiftBuffer
+{
+  volatile gint refcount;
+  GMutex lock;
+  GstClockTime max_duration;
+  GstCaps *caps;
+  /* GOPs from the oldest to the newest, the first one is number first_gop
+   * since the recording started */
+  GPtrArray *gops;
+  guint64 first_gop;
+  GstClockTime last_ts;
+  gboolean eos;
+  GList *readers;
+};
+
+struct _LgmTimeshiftReader
+{
+  LgmTimeshiftBuffer *tsb;
+  GstElement *appsrc;
+  guint64 gop;
+  guint index;
+  gboolean discont;
+  /* Caught up with the recording, new frames are pushed as they arrive */
+  gboolean live;
+  /* Set by the appsrc once its queue is full, without taking the lock */
+  volatile gint enough_data;
+};
+
+static void
+lgm_gop_free (LgmGop * gop)
+{
+  g_ptr_array_foreach (gop->buffers, (GFunc) gst_buffer_unref, NULL);
+  g_ptr_array_free (gop->buffers, TRUE);
+  g_free (gop);
+}
+
+/* Pushes the frames following the reader's position, at most a GOP at a
+ * time, so that the appsrc queue stays small. Must be called with the lock */
+static void
+lgm_timeshift_reader_fill (LgmTimeshiftReader * reader)
+{
+  LgmTimeshiftBuffer *tsb = reader->tsb;
+  LgmGop *gop;
+  GstBuffer *buf;
+  gboolean pushed = FALSE;
+
+  if (tsb->gops->len == 0) {
+    reader->live = TRUE;
+    return;
+  }
+
+  /* The reader was too slow and its GOP was dropped */
+  if (reader->gop < tsb->first_gop) {
+    reader->gop = tsb->first_gop;
+    reader->index = 0;
+    reader->discont = TRUE;
+  }
+
+  while (TRUE) {
+    /* Continue on need-data once the appsrc queue is drained */
+    if (g_atomic_int_get (&reader->enough_data)) {
+      reader->live = FALSE;
+      return;
+    }
+
+    gop = g_ptr_array_index (tsb->gops, reader->gop - tsb->first_gop);
+    if (reader->index < gop->buffers->len) {
+      buf = gst_buffer_ref (g_ptr_array_index (gop->buffers, reader->index));
+      reader->index++;
+      if (reader->discont) {
+        buf = gst_buffer_make_metadata_writable (buf);
+        GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DISCONT);
+        reader->discont = FALSE;
+      }
+      gst_app_src_push_buffer (GST_APP_SRC (reader->appsrc), buf);
+      pushed = TRUE;
+    } else if (reader->gop - tsb->first_gop + 1 < tsb->gops->len) {
+      reader->gop++;
+      reader->index = 0;
+      if (pushed && !reader->live)
+        return;
+    } else {
+      break;
+    }
+  }
+
+  if (tsb->eos) {
+    gst_app_src_end_of_stream (GST_APP_SRC (reader->appsrc));
+  } else {
+    reader->live = TRUE;
+  }
+}
+
+static void
+lgm_timeshift_reader_need_data (GstAppSrc * appsrc, guint length,
+    gpointer user_data)
+{
+  LgmTimeshiftReader *reader = user_data;
+
+  g_atomic_int_set (&reader->enough_data, FALSE);
+  g_mutex_lock (&reader->tsb->lock);
+  lgm_timeshift_reader_fill (reader);
+  g_mutex_unlock (&reader->tsb->lock);
+}
+
+/* Called from gst_app_src_push_buffer with the lock taken */
+static void
+lgm_timeshift_reader_enough_data (GstAppSrc * appsrc, gpointer user_data)
+{
+  LgmTimeshiftReader *reader = user_data;
+
+  g_atomic_int_set (&reader->enough_data, TRUE);
+}
+
+static gboolean
+lgm_timeshift_reader_seek_data (GstAppSrc * appsrc, guint64 time,
+    gpointer user_data)
+{
+  LgmTimeshiftReader *reader = user_data;
+  LgmTimeshiftBuffer *tsb = reader->tsb;
+  LgmGop *gop;
+  guint i;
+
+  g_mutex_lock (&tsb->lock);
+  /* Start from the last keyframe before the position */
+  for (i = tsb->gops->len; i > 1; i--) {
+    gop = g_ptr_array_index (tsb->gops, i - 1);
+    if (gop->start <= time)
+      break;
+  }
+  GST_DEBUG ("Seeking timeshift reader to %" GST_TIME_FORMAT " from GOP %u",
+      GST_TIME_ARGS (time), i - 1);
+  reader->gop = tsb->first_gop + (i > 0 ? i - 1 : 0);
+  reader->index = 0;
+  reader->discont = TRUE;
+  reader->live = FALSE;
+  g_mutex_unlock (&tsb->lock);
+  return TRUE;
+}
+
+LgmTimeshiftBuffer *
+lgm_timeshift_buffer_new (GstClockTime max_duration)
+{
+  LgmTimeshiftBuffer *tsb;
+
+  tsb = g_new0 (LgmTimeshiftBuffer, 1);
+  tsb->refcount = 1;
+  tsb->max_duration = max_duration;
+  tsb->gops = g_ptr_array_new_with_free_func ((GDestroyNotify) lgm_gop_free);
+  tsb->last_ts = GST_CLOCK_TIME_NONE;
+  g_mutex_init (&tsb->lock);
+  return tsb;
+}
+
+LgmTimeshiftBuffer *
+lgm_timeshift_buffer_ref (LgmTimeshiftBuffer * tsb)
+{
+  g_atomic_int_inc (&tsb->refcount);
+  return tsb;
+}
+
+void
+lgm_timeshift_buffer_unref (LgmTimeshiftBuffer * tsb)
+{
+  if (!g_atomic_int_dec_and_test (&tsb->refcount))
+    return;
+
+  g_ptr_array_free (tsb->gops, TRUE);
+  if (tsb->caps != NULL)
+    gst_caps_unref (tsb->caps);
+  g_mutex_clear (&tsb->lock);
+  g_free (tsb);
+}
+
+/* Takes ownership of buf */
+void
+lgm_timeshift_buffer_push (LgmTimeshiftBuffer * tsb, GstBuffer * buf)
+{
+  LgmGop *gop;
+  GstCaps *caps;
+  GList *l;
+
+  g_mutex_lock (&tsb->lock);
+
+  if (tsb->eos)
+    goto drop;
+
+  caps = GST_BUFFER_CAPS (buf);
+  if (caps != NULL && (tsb->caps == NULL || !gst_caps_is_equal (caps,
+              tsb->caps))) {
+    gst_caps_replace (&tsb->caps, caps);
+    for (l = tsb->readers; l; l = l->next) {
+      LgmTimeshiftReader *reader = l->data;
+      gst_app_src_set_caps (GST_APP_SRC (reader->appsrc), caps);
+    }
+  }
+
+  if (GST_BUFFER_TIMESTAMP_IS_VALID (buf))
+    tsb->last_ts = GST_BUFFER_TIMESTAMP (buf);
+
+  if (!GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT)) {
+    gop = g_new0 (LgmGop, 1);
+    gop->start = tsb->last_ts;
+    gop->buffers = g_ptr_array_new ();
+    g_ptr_array_add (tsb->gops, gop);
+  } else if (tsb->gops->len == 0) {
+    /* Nothing can be decoded before the first keyframe */
+    goto drop;
+  }
+  gop = g_ptr_array_index (tsb->gops, tsb->gops->len - 1);
+  g_ptr_array_add (gop->buffers, buf);
+
+  /* Keep at least max_duration of recording */
+  while (tsb->gops->len > 1) {
+    LgmGop *next = g_ptr_array_index (tsb->gops, 1);
+
+    if (tsb->last_ts - next->start < tsb->max_duration)
+      break;
+    g_ptr_array_remove_index (tsb->gops, 0);
+    tsb->first_gop++;
+  }
+
+  for (l = tsb->readers; l; l = l->next) {
+    LgmTimeshiftReader *reader = l->data;
+    if (reader->live)
+      lgm_timeshift_reader_fill (reader);
+  }
+
+  g_mutex_unlock (&tsb->lock);
+  return;
+
+drop:
+  gst_buffer_unref (buf);
+  g_mutex_unlock (&tsb->lock);
+}
+
+void
+lgm_timeshift_buffer_set_eos (LgmTimeshiftBuffer * tsb)
+{
+  GList *l;
+
+  g_mutex_lock (&tsb->lock);
+  tsb->eos = TRUE;
+  for (l = tsb->readers; l; l = l->next) {
+    LgmTimeshiftReader *reader = l->data;
+    if (reader->live)
+      gst_app_src_end_of_stream (GST_APP_SRC (reader->appsrc));
+  }
+  g_mutex_unlock (&tsb->lock);
+}
+
+/* Gets the recording time range available */
+gboolean
+lgm_timeshift_buffer_get_range (LgmTimeshiftBuffer * tsb,
+    GstClockTime * start, GstClockTime * stop)
+{
+  gboolean ret = FALSE;
+
+  g_mutex_lock (&tsb->lock);
+  if (tsb->gops->len > 0) {
+    *start = ((LgmGop *) g_ptr_array_index (tsb->gops, 0))->start;
+    *stop = tsb->last_ts;
+    ret = TRUE;
+  }
+  g_mutex_unlock (&tsb->lock);
+  return ret;
+}
+
+LgmTimeshiftReader *
+lgm_timeshift_reader_new (LgmTimeshiftBuffer * tsb, GstElement * appsrc)
+{
+  LgmTimeshiftReader *reader;
+  GstAppSrcCallbacks callbacks = { 0, };
+
+  reader = g_new0 (LgmTimeshiftReader, 1);
+  reader->tsb = lgm_timeshift_buffer_ref (tsb);
+  reader->appsrc = gst_object_ref (appsrc);
+  reader->discont = TRUE;
+
+  g_object_set (appsrc, "format", GST_FORMAT_TIME, NULL);
+  gst_app_src_set_stream_type (GST_APP_SRC (appsrc),
+      GST_APP_STREAM_TYPE_SEEKABLE);
+  callbacks.need_data = lgm_timeshift_reader_need_data;
+  callbacks.enough_data = lgm_timeshift_reader_enough_data;
+  callbacks.seek_data = lgm_timeshift_reader_seek_data;
+  gst_app_src_set_callbacks (GST_APP_SRC (appsrc), &callbacks, reader, NULL);
+
+  g_mutex_lock (&tsb->lock);
+  if (tsb->caps != NULL)
+    gst_app_src_set_caps (GST_APP_SRC (appsrc), tsb->caps);
+  reader->gop = tsb->first_gop;
+  tsb->readers = g_list_prepend (tsb->readers, reader);
+  g_mutex_unlock (&tsb->lock);
+
+  return reader;
+}
+
+void
+lgm_timeshift_reader_free (LgmTimeshiftReader * reader)
+{
+  LgmTimeshiftBuffer *tsb = reader->tsb;
+  GstAppSrcCallbacks callbacks = { 0, };
+
+  g_mutex_lock (&tsb->lock);
+  tsb->readers = g_list_remove (tsb->readers, reader);
+  g_mutex_unlock (&tsb->lock);
+
+  gst_app_src_set_callbacks (GST_APP_SRC (reader->appsrc), &callbacks, NULL,
+      NULL);
+
+  gst_object_unref (reader->appsrc);
+  lgm_timeshift_buffer_unref (tsb);
+  g_free (reader);
+}
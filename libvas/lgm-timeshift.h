@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2018  Fluendo S.A.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __LGM_TIMESHIFT_H__
+#define __LGM_TIMESHIFT_H__
+
+#include <gst/gst.h>
+
+#ifdef WIN32
+#define EXPORT __declspec (dllexport)
+#else
+#define EXPORT
+#endif
+
+G_BEGIN_DECLS
+
+/* In-memory ring of the last encoded video GOPs of a recording, indexed by
+ * their recording time, that can be played while it's still being written.
+ * Only the video is kept, the timeshift plays without audio */
+typedef struct _LgmTimeshiftBuffer LgmTimeshiftBuffer;
+
+/* Feeds an appsrc from a LgmTimeshiftBuffer, following the recording live
+ * once it reaches the last frame */
+typedef struct _LgmTimeshiftReader LgmTimeshiftReader;
+
+LgmTimeshiftBuffer * lgm_timeshift_buffer_new (GstClockTime max_duration);
+EXPORT LgmTimeshiftBuffer * lgm_timeshift_buffer_ref (LgmTimeshiftBuffer * tsb);
+EXPORT void lgm_timeshift_buffer_unref (LgmTimeshiftBuffer * tsb);
+void lgm_timeshift_buffer_push (LgmTimeshiftBuffer * tsb, GstBuffer * buf);
+void lgm_timeshift_buffer_set_eos (LgmTimeshiftBuffer * tsb);
+EXPORT gboolean lgm_timeshift_buffer_get_range (LgmTimeshiftBuffer * tsb,
+    GstClockTime * start, GstClockTime * stop);
+
+LgmTimeshiftReader * lgm_timeshift_reader_new (LgmTimeshiftBuffer * tsb,
+    GstElement * appsrc);
+void lgm_timeshift_reader_free (LgmTimeshiftReader * reader);
+
+G_END_DECLS
+#endif /* __LGM_TIMESHIFT_H__ */
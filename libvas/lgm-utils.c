@@ -24,6 +24,14 @@
 
 #include "lgm-utils.h"
 
+#include <gst/app/gstappsink.h>
+
+#ifdef G_OS_WIN32
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
 #if defined (GDK_WINDOWING_X11)
 #include <gdk/gdkx.h>
 #elif defined (GDK_WINDOWING_WIN32)
@@ -218,6 +226,280 @@ lgm_discover_uri (const gchar * filename, guint64 * duration, guint * width,
   return ret;
 }
 
+/* Stop reading the keyframes if no buffer arrives in this time */
+#define LGM_KEYFRAMES_TIMEOUT (10 * GST_SECOND)
+
+typedef struct
+{
+  GMutex lock;
+  GArray *timestamps;
+  GArray *offsets;
+  guint n_buffers;
+} LgmKeyframesContext;
+
+static GstFlowReturn
+lgm_keyframes_new_buffer_cb (GstAppSink * appsink, gpointer user_data)
+{
+  LgmKeyframesContext *ctx = (LgmKeyframesContext *) user_data;
+  GstBuffer *buf;
+  guint64 ts, offset;
+
+  buf = gst_app_sink_pull_buffer (appsink);
+  if (buf == NULL) {
+    return GST_FLOW_OK;
+  }
+
+  g_mutex_lock (&ctx->lock);
+  ctx->n_buffers++;
+  if (!GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT) &&
+      GST_BUFFER_TIMESTAMP_IS_VALID (buf)) {
+    ts = GST_BUFFER_TIMESTAMP (buf);
+    offset = GST_BUFFER_OFFSET_IS_VALID (buf) ?
+        GST_BUFFER_OFFSET (buf) : G_MAXUINT64;
+    g_array_append_val (ctx->timestamps, ts);
+    g_array_append_val (ctx->offsets, offset);
+  }
+  g_mutex_unlock (&ctx->lock);
+  gst_buffer_unref (buf);
+  return GST_FLOW_OK;
+}
+
+static void
+lgm_keyframes_pad_added_cb (GstElement * uridecodebin, GstPad * pad,
+    GstElement * appsink)
+{
+  GstElement *pipeline, *sink;
+  GstCaps *caps;
+  GstPad *sink_pad;
+  gboolean is_video;
+
+  caps = gst_pad_get_caps_reffed (pad);
+  is_video = g_str_has_prefix (gst_structure_get_name
+      (gst_caps_get_structure (caps, 0)), "video");
+  gst_caps_unref (caps);
+
+  sink_pad = gst_element_get_static_pad (appsink, "sink");
+  if (is_video && !gst_pad_is_linked (sink_pad)) {
+    gst_pad_link (pad, sink_pad);
+    gst_object_unref (sink_pad);
+    return;
+  }
+  gst_object_unref (sink_pad);
+
+  pipeline = GST_ELEMENT (gst_object_get_parent (GST_OBJECT (uridecodebin)));
+  sink = gst_element_factory_make ("fakesink", NULL);
+  /* Don't throttle the video stream on the clock */
+  g_object_set (sink, "sync", FALSE, NULL);
+  gst_bin_add (GST_BIN (pipeline), sink);
+  sink_pad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_link (pad, sink_pad);
+  gst_element_sync_state_with_parent (sink);
+  gst_object_unref (sink_pad);
+  gst_object_unref (pipeline);
+}
+
+static void
+lgm_keyframes_no_more_pads_cb (GstElement * uridecodebin,
+    GstElement * appsink)
+{
+  GstPad *sink_pad;
+  GError *err;
+
+  sink_pad = gst_element_get_static_pad (appsink, "sink");
+  if (!gst_pad_is_linked (sink_pad)) {
+    /* The appsink would wait forever for a buffer */
+    err = g_error_new (GST_STREAM_ERROR, GST_STREAM_ERROR_WRONG_TYPE,
+        "The file has no video stream");
+    gst_element_post_message (uridecodebin,
+        gst_message_new_error (GST_OBJECT (uridecodebin), err, NULL));
+    g_error_free (err);
+  }
+  gst_object_unref (sink_pad);
+}
+
+/* Waits for the end of the stream or an error, giving up if the stream
+ * stalls */
+static gboolean
+lgm_keyframes_wait (GstBus * bus, LgmKeyframesContext * ctx,
+    const gchar * filename, GError ** err)
+{
+  GstMessage *msg;
+  guint n_buffers = 0;
+  gboolean ret = TRUE;
+
+  while (TRUE) {
+    msg = gst_bus_timed_pop_filtered (bus, LGM_KEYFRAMES_TIMEOUT,
+        GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+    if (msg != NULL) {
+      if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+        gst_message_parse_error (msg, err, NULL);
+        ret = FALSE;
+      }
+      gst_message_unref (msg);
+      break;
+    }
+    g_mutex_lock (&ctx->lock);
+    if (ctx->n_buffers == n_buffers) {
+      g_mutex_unlock (&ctx->lock);
+      g_set_error (err, GST_STREAM_ERROR, GST_STREAM_ERROR_FAILED,
+          "Timed out reading the keyframes of %s", filename);
+      ret = FALSE;
+      break;
+    }
+    n_buffers = ctx->n_buffers;
+    g_mutex_unlock (&ctx->lock);
+  }
+  return ret;
+}
+
+/* Lists the timestamps and the byte offsets of the video keyframes between
+ * start and stop, reading the stream without decoding it. The demuxer seeks
+ * to the keyframe before start with the index of the container, so only the
+ * requested range of the file is read. Offsets are G_MAXUINT64 when the
+ * demuxer does not provide them. The arrays must be freed with g_free () */
+gboolean
+lgm_discover_keyframes_range (const gchar * filename, guint64 start,
+    guint64 stop, guint64 ** timestamps, guint64 ** offsets,
+    guint * n_keyframes, GError ** err)
+{
+  GstElement *pipeline, *uridecodebin, *appsink;
+  GstAppSinkCallbacks callbacks = { NULL, };
+  LgmKeyframesContext ctx;
+  GstStateChangeReturn state_ret;
+  GstCaps *caps;
+  GstBus *bus;
+  GstMessage *msg;
+  gchar *uri;
+  gboolean ret = TRUE;
+
+  *timestamps = *offsets = NULL;
+  *n_keyframes = 0;
+
+  uri = lgm_filename_to_uri (filename);
+  if (uri == NULL) {
+    return FALSE;
+  }
+
+  g_mutex_init (&ctx.lock);
+  ctx.timestamps = g_array_new (FALSE, FALSE, sizeof (guint64));
+  ctx.offsets = g_array_new (FALSE, FALSE, sizeof (guint64));
+  ctx.n_buffers = 0;
+
+  pipeline = gst_pipeline_new ("keyframes-reader");
+  uridecodebin = gst_element_factory_make ("uridecodebin", NULL);
+  appsink = gst_element_factory_make ("appsink", NULL);
+  caps = gst_caps_from_string (LGM_COMPRESSED_CAPS);
+  g_object_set (uridecodebin, "uri", uri, "caps", caps, NULL);
+  gst_caps_unref (caps);
+  g_free (uri);
+  g_object_set (appsink, "sync", FALSE, NULL);
+  callbacks.new_buffer = lgm_keyframes_new_buffer_cb;
+  gst_app_sink_set_callbacks (GST_APP_SINK (appsink), &callbacks, &ctx,
+      NULL);
+  g_signal_connect (uridecodebin, "pad-added",
+      G_CALLBACK (lgm_keyframes_pad_added_cb), appsink);
+  g_signal_connect (uridecodebin, "no-more-pads",
+      G_CALLBACK (lgm_keyframes_no_more_pads_cb), appsink);
+  gst_bin_add_many (GST_BIN (pipeline), uridecodebin, appsink, NULL);
+
+  bus = gst_element_get_bus (pipeline);
+
+  if (start > 0 || GST_CLOCK_TIME_IS_VALID (stop)) {
+    /* Seeks need a pre-rolled pipeline */
+    gst_element_set_state (pipeline, GST_STATE_PAUSED);
+    state_ret = gst_element_get_state (pipeline, NULL, NULL,
+        LGM_KEYFRAMES_TIMEOUT);
+    if (state_ret == GST_STATE_CHANGE_FAILURE ||
+        state_ret == GST_STATE_CHANGE_ASYNC) {
+      msg = gst_bus_pop_filtered (bus, GST_MESSAGE_ERROR);
+      if (msg != NULL) {
+        gst_message_parse_error (msg, err, NULL);
+        gst_message_unref (msg);
+      } else {
+        g_set_error (err, GST_STREAM_ERROR, GST_STREAM_ERROR_FAILED,
+            "Could not pre-roll %s", filename);
+      }
+      ret = FALSE;
+      goto done;
+    }
+    gst_element_seek (pipeline, 1, GST_FORMAT_TIME,
+        GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT,
+        GST_SEEK_TYPE_SET, start,
+        GST_CLOCK_TIME_IS_VALID (stop) ? GST_SEEK_TYPE_SET :
+        GST_SEEK_TYPE_NONE, stop);
+  }
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  ret = lgm_keyframes_wait (bus, &ctx, filename, err);
+
+done:
+  gst_object_unref (bus);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  *n_keyframes = ret ? ctx.timestamps->len : 0;
+  *timestamps = (guint64 *) g_array_free (ctx.timestamps, !ret);
+  *offsets = (guint64 *) g_array_free (ctx.offsets, !ret);
+  g_mutex_clear (&ctx.lock);
+  return ret;
+}
+
+/* Lists the video keyframes of the whole file */
+gboolean
+lgm_discover_keyframes (const gchar * filename, guint64 ** timestamps,
+    guint64 ** offsets, guint * n_keyframes, GError ** err)
+{
+  return lgm_discover_keyframes_range (filename, 0, GST_CLOCK_TIME_NONE,
+      timestamps, offsets, n_keyframes, err);
+}
+
+/* Checks if a stream with caps can follow a stream with first_caps in the
+ * same track of a muxer. The decoder configuration and the format of the
+ * stream must be the same, since muxers don't accept caps changes */
+gboolean
+lgm_caps_can_concat (const GstCaps * first_caps, const GstCaps * caps)
+{
+  static const gchar *config_fields[] = { "codec_data", "streamheader",
+    NULL
+  };
+  static const gchar *format_fields[] = { "stream-format", "mpegversion",
+    "width", "height", "framerate", "pixel-aspect-ratio", "rate", "channels",
+    NULL
+  };
+  const GstStructure *s1, *s2;
+  const GValue *v1, *v2;
+  guint i;
+
+  if (first_caps == NULL || caps == NULL ||
+      gst_caps_get_size (first_caps) == 0 || gst_caps_get_size (caps) == 0)
+    return FALSE;
+
+  s1 = gst_caps_get_structure (first_caps, 0);
+  s2 = gst_caps_get_structure (caps, 0);
+  if (!gst_structure_has_name (s2, gst_structure_get_name (s1)))
+    return FALSE;
+
+  for (i = 0; config_fields[i] != NULL; i++) {
+    v1 = gst_structure_get_value (s1, config_fields[i]);
+    v2 = gst_structure_get_value (s2, config_fields[i]);
+    if (v1 == NULL && v2 == NULL)
+      continue;
+    if (v1 == NULL || v2 == NULL ||
+        gst_value_compare (v1, v2) != GST_VALUE_EQUAL)
+      return FALSE;
+  }
+
+  /* Fields missing in one of them are not known to differ */
+  for (i = 0; format_fields[i] != NULL; i++) {
+    v1 = gst_structure_get_value (s1, format_fields[i]);
+    v2 = gst_structure_get_value (s2, format_fields[i]);
+    if (v1 != NULL && v2 != NULL &&
+        gst_value_compare (v1, v2) != GST_VALUE_EQUAL)
+      return FALSE;
+  }
+  return TRUE;
+}
+
 GstElement *
 lgm_create_video_encoder (VideoEncoderType type, guint quality,
     gboolean realtime, GQuark quark, GError ** err)
@@ -382,6 +664,49 @@ lgm_create_audio_encoder (AudioEncoderType type, guint quality,
   return encoder;
 }
 
+GstElement *
+lgm_create_video_parser (const gchar * mime, GstCaps ** parser_caps)
+{
+  GstElement *parser = NULL;
+
+  *parser_caps = NULL;
+
+  if (g_strrstr (mime, "video/x-h264")) {
+    GST_DEBUG ("adding h264parse");
+    parser = gst_element_factory_make ("h264parse", "video-parser");
+    *parser_caps =
+        gst_caps_from_string ("video/x-h264, stream-format=avc, alignment=au");
+  } else if (g_strrstr (mime, "video/mpeg")) {
+    GST_DEBUG ("adding mpegvideoparse");
+    parser = gst_element_factory_make ("mpegvideoparse", "video-parser");
+  }
+
+  if (parser == NULL && *parser_caps != NULL) {
+    gst_caps_unref (*parser_caps);
+    *parser_caps = NULL;
+  }
+  return parser;
+}
+
+/* With faststart the moov atom is written at the beginning of the file, so
+ * that players don't need to read its end to start. The media is written to
+ * a temporary file next to the output and copied after the moov atom when
+ * the muxer finishes, so it must not be used for live captures, which
+ * could not be recovered after a crash */
+void
+lgm_set_muxer_faststart (GstElement * muxer, const gchar * output_file)
+{
+  gchar *faststart_file;
+
+  if (!g_object_class_find_property (G_OBJECT_GET_CLASS (muxer), "faststart"))
+    return;
+
+  faststart_file = g_strconcat (output_file, ".faststart", NULL);
+  g_object_set (muxer, "faststart", TRUE, "faststart-file", faststart_file,
+      NULL);
+  g_free (faststart_file);
+}
+
 GstElement *
 lgm_create_muxer (VideoMuxerType type, GQuark quark, GError ** err)
 {
@@ -423,3 +748,30 @@ lgm_create_muxer (VideoMuxerType type, GQuark quark, GError ** err)
 
   return muxer;
 }
+
+/* User and system CPU time used by the process, in nanoseconds */
+guint64
+lgm_get_process_cpu_time (void)
+{
+#ifdef G_OS_WIN32
+  FILETIME creation, exit, kernel, user;
+  ULARGE_INTEGER k, u;
+
+  if (!GetProcessTimes (GetCurrentProcess (), &creation, &exit, &kernel,
+          &user))
+    return 0;
+  k.LowPart = kernel.dwLowDateTime;
+  k.HighPart = kernel.dwHighDateTime;
+  u.LowPart = user.dwLowDateTime;
+  u.HighPart = user.dwHighDateTime;
+  /* FILETIME counts 100ns intervals */
+  return (k.QuadPart + u.QuadPart) * 100;
+#else
+  struct rusage usage;
+
+  if (getrusage (RUSAGE_SELF, &usage) != 0)
+    return 0;
+  return GST_TIMEVAL_TO_TIME (usage.ru_utime) +
+      GST_TIMEVAL_TO_TIME (usage.ru_stime);
+#endif
+}
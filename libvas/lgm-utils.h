@@ -136,6 +136,17 @@ typedef enum
   CAPTURE_SOURCE_TYPE_FILE = 4,
 } CaptureSourceType;
 
+typedef enum
+{
+  LGM_FRAME_FORMAT_RGB24,
+  LGM_FRAME_FORMAT_I420,
+} LgmFrameFormat;
+
+/* Compressed formats that can be read without decoding them */
+#define LGM_COMPRESSED_CAPS "video/x-h264; video/x-vp8; video/x-theora; "\
+      "video/x-xvid; video/x-divx; video/mpeg, systemstream=(boolean)false; "\
+      "audio/mpeg; audio/x-vorbis; audio/x-ac3; audio/x-dts"
+
 typedef enum {
   GST_AUTOPLUG_SELECT_TRY,
   GST_AUTOPLUG_SELECT_EXPOSE,
@@ -148,6 +159,12 @@ EXPORT GstDiscovererResult lgm_discover_uri (const gchar *uri, guint64 *duration
     guint *width, guint *height, guint *fps_n, guint *fps_d, guint *par_n,
     guint *par_d, gchar **container, gchar **video_codec, gchar **audio_codec,
     GError **err);
+EXPORT gboolean lgm_discover_keyframes (const gchar *filename,
+    guint64 **timestamps, guint64 **offsets, guint *n_keyframes,
+    GError **err);
+EXPORT gboolean lgm_discover_keyframes_range (const gchar *filename,
+    guint64 start, guint64 stop, guint64 **timestamps, guint64 **offsets,
+    guint *n_keyframes, GError **err);
 EXPORT guintptr lgm_get_window_handle (GdkWindow *window);
 EXPORT void lgm_set_window_handle (GstXOverlay *overlay, guintptr window_handle);
 
@@ -159,6 +176,11 @@ GstElement * lgm_create_audio_encoder (AudioEncoderType type, guint quality,
     GQuark quark, GError **err);
 GstElement * lgm_create_muxer (VideoMuxerType type,
     GQuark quark, GError **err);
+void lgm_set_muxer_faststart (GstElement *muxer, const gchar *output_file);
+guint64 lgm_get_process_cpu_time (void);
+GstElement * lgm_create_video_parser (const gchar *mime,
+    GstCaps **parser_caps);
+gboolean lgm_caps_can_concat (const GstCaps *first_caps, const GstCaps *caps);
 GstAutoplugSelectResult lgm_filter_video_decoders (GstElement* object,
     GstPad* arg0, GstCaps* arg1, GstElementFactory* arg2, gpointer user_data);
 
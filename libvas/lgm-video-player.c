@@ -20,9 +20,29 @@
 #include "lgm-video-player.h"
 #include "baconvideowidget-marshal.h"
 #include "gstscreenshot.h"
+#include "gst-frame-cache.h"
+#include "lgm-position-probe.h"
+
+#include <string.h>
+#include <gst/app/gstappsink.h>
+#include <gst/app/gstappsrc.h>
 
 #define LGM_PLAY_TIMEOUT 20
 #define LGM_PAUSE_TIMEOUT 100
+/* Frames closer than this are reached decoding forward instead of seeking,
+ * it should be close to the usual GOP length */
+#define LGM_FRAMES_MAX_DECODE_GAP (2 * GST_SECOND)
+/* Decoded frames kept to step backward while paused, about a GOP of 1080p
+ * or a few seconds of SD */
+#define LGM_FRAME_CACHE_MAX_FRAMES 250
+#define LGM_FRAME_CACHE_MAX_BYTES (96 * 1024 * 1024)
+/* Default rate from which only keyframes are decoded */
+#define LGM_TRICK_MODE_RATE 4.0
+/* skip-frame value of the ffmpeg decoders to skip the B-frames */
+#define LGM_SKIP_FRAME_BFRAMES 1
+/* Minimum interval between position notifications, coalescing the frames
+ * displayed in between */
+#define LGM_POSITION_INTERVAL (GST_SECOND / 50)
 
 #define is_error(e, d, c) \
   (e->domain == GST_##d##_ERROR && \
@@ -41,6 +61,8 @@ enum
   SIGNAL_TICK,
   SIGNAL_STATE_CHANGE,
   SIGNAL_READY_TO_SEEK,
+  SIGNAL_ELEMENT_CHANGED,
+  SIGNAL_POSITION_CHANGED,
   LAST_SIGNAL
 };
 
@@ -59,6 +81,31 @@ typedef enum
   GST_PLAY_FLAG_SOFT_COLORBALANCE = (1 << 10)
 } GstPlayFlags;
 
+typedef struct
+{
+  gchar *uri;
+  gint64 start;
+  gint64 stop;
+  gdouble rate;
+} LgmSegment;
+
+/* Pipeline prerolled with the file of the next segment, swapped with the
+ * one playing when the current segment is done */
+typedef struct
+{
+  guint index;
+  GstElement *play;
+  GstElement *video_sink;
+  GstElement *frame_cache;
+  GstXOverlay *xoverlay;
+  GstBus *bus;
+  gulong sig_bus_async;
+  gulong sig_bus_sync;
+  /* The seek to the segment is sent once prerolled, the pipeline can only
+   * replace the one playing when it's done */
+  gboolean seeking;
+  gboolean ready;
+} LgmNextPipeline;
 
 struct LgmVideoPlayerPrivate
 {
@@ -67,6 +114,8 @@ struct LgmVideoPlayerPrivate
 
   GstElement *play;
   GstElement *video_sink;
+  GstElement *frame_cache;
+  LgmPositionProbe *position_probe;
   GstXOverlay *xoverlay;
   guintptr window_handle;
   gboolean window_set;
@@ -78,6 +127,11 @@ struct LgmVideoPlayerPrivate
   gint64 current_time;
   gdouble current_position;
   gdouble rate;
+  gdouble trick_mode_rate;
+  gboolean trick_mode;
+  /* Set by the trick mode seeks done while playing, any other seek or step
+   * decodes all the frames again */
+  gboolean skip_delta_units;
 
   GstBus *bus;
   gulong sig_bus_async;
@@ -87,10 +141,39 @@ struct LgmVideoPlayerPrivate
   gint video_fps_n;
 
   GstState target_state;
+
+  BvwFrameConv *frame_conv[2];  /* created with frame_conv_lock */
+  GMutex frame_conv_lock;
+
+  LgmTimeshiftBuffer *timeshift;
+  LgmTimeshiftReader *timeshift_reader;
+
+  /* Segments played one after the other with segment seeks */
+  GPtrArray *segments;
+  gint segment_index;
+  /* Waiting for a new file to preroll to seek to its segment */
+  gboolean segment_preroll;
+  /* Protected with overlay_lock, the sync bus handlers use it */
+  LgmNextPipeline *next_pipeline;
 };
 
 static void lgm_video_player_finalize (GObject * object);
 static gboolean lgm_query_timeout (LgmVideoPlayer * lvp);
+static void lgm_segment_seek (LgmVideoPlayer * lvp, gboolean flush);
+static void lgm_load_segment (LgmVideoPlayer * lvp, guint index,
+    gboolean flush);
+static void lgm_update_trick_mode (LgmVideoPlayer * lvp);
+static void lgm_set_skip_delta_units (LgmVideoPlayer * lvp, gboolean skip);
+static gboolean lgm_is_video_decoder (GstElement * element);
+static void lgm_configure_video_decoder (LgmVideoPlayer * lvp,
+    GstElement * decoder);
+static void lgm_next_pipeline_message (LgmVideoPlayer * lvp,
+    GstMessage * message);
+static void lgm_free_next_pipeline (LgmVideoPlayer * lvp);
+static gboolean lgm_create_sinks (LgmVideoPlayer * lvp,
+    GstElement ** video_sink, GstElement ** audio_sink,
+    GstElement ** frame_cache);
+static void lgm_watch_video_sink (LgmVideoPlayer * lvp);
 
 static GError *lgm_error_from_gst_error (LgmVideoPlayer * lvp, GstMessage * m);
 
@@ -138,6 +221,15 @@ lgm_reconfigure_tick_timeout (LgmVideoPlayer * lvp, guint msecs)
   }
 }
 
+static void
+lgm_set_show_preroll_frame (GstObject * sink, gboolean show)
+{
+  if (g_object_class_find_property (G_OBJECT_GET_CLASS (sink),
+          "show-preroll-frame")) {
+    g_object_set (sink, "show-preroll-frame", show, NULL);
+  }
+}
+
 static void
 lgm_element_msg_sync_cb (GstBus * bus, GstMessage * msg, gpointer data)
 {
@@ -151,13 +243,24 @@ lgm_element_msg_sync_cb (GstBus * bus, GstMessage * msg, gpointer data)
     GstObject *sender = GST_MESSAGE_SRC (msg);
 
     if (sender && GST_IS_X_OVERLAY (sender)) {
+      GstXOverlay **xoverlay = &lvp->priv->xoverlay;
+
       g_mutex_lock (&lvp->priv->overlay_lock);
-      if (lvp->priv->xoverlay != NULL) {
-        gst_object_unref (lvp->priv->xoverlay);
+      if (lvp->priv->next_pipeline != NULL &&
+          bus == lvp->priv->next_pipeline->bus) {
+        /* The next segment is shown in the same window once it starts */
+        xoverlay = &lvp->priv->next_pipeline->xoverlay;
+        lgm_set_show_preroll_frame (sender, FALSE);
+      } else if (bus != lvp->priv->bus) {
+        /* From a next pipeline being freed */
+        g_mutex_unlock (&lvp->priv->overlay_lock);
+        return;
+      }
+      if (*xoverlay != NULL) {
+        gst_object_unref (*xoverlay);
       }
-      lvp->priv->xoverlay =
-          (GstXOverlay *) gst_object_ref (GST_X_OVERLAY (sender));
-      lgm_set_window_handle (lvp->priv->xoverlay, lvp->priv->window_handle);
+      *xoverlay = (GstXOverlay *) gst_object_ref (GST_X_OVERLAY (sender));
+      lgm_set_window_handle (*xoverlay, lvp->priv->window_handle);
       lvp->priv->window_set = TRUE;
       g_mutex_unlock (&lvp->priv->overlay_lock);
     }
@@ -173,6 +276,12 @@ lgm_bus_message_cb (GstBus * bus, GstMessage * message, gpointer data)
   g_return_if_fail (lvp != NULL);
   g_return_if_fail (LGM_IS_VIDEO_WIDGET (lvp));
 
+  if (lvp->priv->next_pipeline != NULL &&
+      bus == lvp->priv->next_pipeline->bus) {
+    lgm_next_pipeline_message (lvp, message);
+    return;
+  }
+
   msg_type = GST_MESSAGE_TYPE (message);
 
   switch (msg_type) {
@@ -202,6 +311,19 @@ lgm_bus_message_cb (GstBus * bus, GstMessage * message, gpointer data)
       lgm_query_timeout (lvp);
       g_signal_emit (lvp, lgm_signals[SIGNAL_EOS], 0, FALSE);
       break;
+    case GST_MESSAGE_SEGMENT_DONE:
+      GST_DEBUG ("Segment done message");
+      if (lvp->priv->segment_index < 0)
+        break;
+      if (lvp->priv->segment_index + 1 < lvp->priv->segments->len) {
+        lgm_load_segment (lvp, lvp->priv->segment_index + 1, FALSE);
+      } else {
+        lvp->priv->segment_index = -1;
+        lgm_video_player_pause (lvp, FALSE);
+        lgm_query_timeout (lvp);
+        g_signal_emit (lvp, lgm_signals[SIGNAL_EOS], 0, FALSE);
+      }
+      break;
     case GST_MESSAGE_STATE_CHANGED:
     {
       GstState old_state, new_state;
@@ -212,12 +334,32 @@ lgm_bus_message_cb (GstBus * bus, GstMessage * message, gpointer data)
       if (old_state == new_state)
         break;
 
-      if (GST_MESSAGE_SRC (message) != GST_OBJECT (lvp->priv->play))
+      if (GST_MESSAGE_SRC (message) != GST_OBJECT (lvp->priv->play)) {
+        /* Decoders are also created later, like when switching files */
+        if (old_state == GST_STATE_NULL && new_state == GST_STATE_READY &&
+            lgm_is_video_decoder (GST_ELEMENT (GST_MESSAGE_SRC (message)))) {
+          lgm_configure_video_decoder (lvp,
+              GST_ELEMENT (GST_MESSAGE_SRC (message)));
+        }
         break;
+      }
 
       src_name = gst_object_get_name (message->src);
       g_free (src_name);
 
+      if (lvp->priv->segment_preroll) {
+        /* The file of the next segment is loaded, the UI keeps the state
+         * it had before switching */
+        if (old_state == GST_STATE_READY && new_state == GST_STATE_PAUSED) {
+          lvp->priv->stream_length = 0;
+          lvp->priv->segment_preroll = FALSE;
+          lgm_segment_seek (lvp, TRUE);
+          if (lvp->priv->target_state == GST_STATE_PLAYING)
+            gst_element_set_state (lvp->priv->play, GST_STATE_PLAYING);
+        }
+        break;
+      }
+
       if (new_state <= GST_STATE_PAUSED) {
         lgm_query_timeout (lvp);
         lgm_reconfigure_tick_timeout (lvp, 0);
@@ -230,6 +372,16 @@ lgm_bus_message_cb (GstBus * bus, GstMessage * message, gpointer data)
         g_signal_emit (lvp, lgm_signals[SIGNAL_STATE_CHANGE], 0, TRUE);
       }
       if (old_state == GST_STATE_READY && new_state == GST_STATE_PAUSED) {
+        GstClockTime start, stop;
+
+        /* The timeshift buffers keep the recording time, start playing
+         * from the oldest one available instead of waiting for it */
+        if (lvp->priv->timeshift != NULL &&
+            lgm_timeshift_buffer_get_range (lvp->priv->timeshift, &start,
+                &stop)) {
+          gst_element_seek_simple (lvp->priv->play, GST_FORMAT_TIME,
+              GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT, start);
+        }
         lvp->priv->stream_length = 0;
         g_signal_emit (lvp, lgm_signals[SIGNAL_READY_TO_SEEK], 0, FALSE);
       }
@@ -262,6 +414,16 @@ got_time_tick (GstElement * play, gint64 time_nanos, LgmVideoPlayer * lvp)
       lvp->priv->current_position);
 }
 
+/* Position of the frame reaching the video sink, from the main context */
+static void
+lgm_position_changed_cb (gint64 running_time, gint64 stream_time,
+    LgmVideoPlayer * lvp)
+{
+  got_time_tick (GST_ELEMENT (lvp->priv->play), stream_time, lvp);
+  g_signal_emit (lvp, lgm_signals[SIGNAL_POSITION_CHANGED], 0,
+      running_time, stream_time);
+}
+
 static gboolean
 lgm_query_timeout (LgmVideoPlayer * lvp)
 {
@@ -473,6 +635,8 @@ lgm_video_player_open (LgmVideoPlayer * lvp, const gchar * uri, GError ** error)
 
   lvp->priv->stream_length = 0;
   lvp->priv->rate = 1.0;
+  lvp->priv->trick_mode = FALSE;
+  lvp->priv->skip_delta_units = FALSE;
   lvp->priv->target_state = GST_STATE_PAUSED;
 
   gst_element_set_state (lvp->priv->play, GST_STATE_PAUSED);
@@ -506,6 +670,369 @@ lgm_video_player_open (LgmVideoPlayer * lvp, const gchar * uri, GError ** error)
   return ret;
 }
 
+static void
+lgm_free_timeshift (LgmVideoPlayer * lvp)
+{
+  if (lvp->priv->timeshift_reader != NULL) {
+    lgm_timeshift_reader_free (lvp->priv->timeshift_reader);
+    lvp->priv->timeshift_reader = NULL;
+  }
+  if (lvp->priv->timeshift != NULL) {
+    lgm_timeshift_buffer_unref (lvp->priv->timeshift);
+    lvp->priv->timeshift = NULL;
+  }
+}
+
+static void
+lgm_source_setup_cb (GstElement * play, GstElement * source,
+    LgmVideoPlayer * lvp)
+{
+  if (lvp->priv->timeshift == NULL || !GST_IS_APP_SRC (source))
+    return;
+
+  if (lvp->priv->timeshift_reader != NULL)
+    lgm_timeshift_reader_free (lvp->priv->timeshift_reader);
+  lvp->priv->timeshift_reader =
+      lgm_timeshift_reader_new (lvp->priv->timeshift, source);
+}
+
+gboolean
+lgm_video_player_open_timeshift (LgmVideoPlayer * lvp,
+    LgmTimeshiftBuffer * tsb, GError ** error)
+{
+  g_return_val_if_fail (lvp != NULL, FALSE);
+  g_return_val_if_fail (tsb != NULL, FALSE);
+  g_return_val_if_fail (LGM_IS_VIDEO_WIDGET (lvp), FALSE);
+  g_return_val_if_fail (lvp->priv->play != NULL, FALSE);
+
+  if (lvp->priv->uri) {
+    lgm_video_player_close (lvp);
+  }
+
+  lvp->priv->timeshift = lgm_timeshift_buffer_ref (tsb);
+  return lgm_video_player_open (lvp, "appsrc://", error);
+}
+
+static void
+lgm_segment_free (LgmSegment * segment)
+{
+  g_free (segment->uri);
+  g_free (segment);
+}
+
+static void
+lgm_seek_segment (GstElement * play, LgmSegment * segment, gboolean flush)
+{
+  GstSeekFlags flags;
+
+  /* Without flushing the segment starts once the previous one is rendered */
+  flags = GST_SEEK_FLAG_SEGMENT | GST_SEEK_FLAG_ACCURATE;
+  if (flush)
+    flags |= GST_SEEK_FLAG_FLUSH;
+
+  gst_element_seek (play, segment->rate, GST_FORMAT_TIME, flags,
+      GST_SEEK_TYPE_SET, segment->start, GST_SEEK_TYPE_SET, segment->stop);
+}
+
+static void
+lgm_segment_seek (LgmVideoPlayer * lvp, gboolean flush)
+{
+  LgmSegment *segment;
+
+  segment = g_ptr_array_index (lvp->priv->segments, lvp->priv->segment_index);
+  GST_DEBUG ("Seeking to segment %d %" GST_TIME_FORMAT " - %" GST_TIME_FORMAT,
+      lvp->priv->segment_index, GST_TIME_ARGS (segment->start),
+      GST_TIME_ARGS (segment->stop));
+
+  lvp->priv->rate = segment->rate;
+  lgm_update_trick_mode (lvp);
+  lgm_set_skip_delta_units (lvp, FALSE);
+  lgm_seek_segment (lvp->priv->play, segment, flush);
+}
+
+static void
+lgm_free_bus (GstBus * bus, gulong sig_bus_async, gulong sig_bus_sync)
+{
+  gst_bus_set_flushing (bus, TRUE);
+  if (sig_bus_async)
+    g_signal_handler_disconnect (bus, sig_bus_async);
+  if (sig_bus_sync)
+    g_signal_handler_disconnect (bus, sig_bus_sync);
+  gst_bus_remove_signal_watch (bus);
+  gst_object_unref (bus);
+}
+
+static void
+lgm_next_pipeline_free (LgmNextPipeline * next)
+{
+  lgm_free_bus (next->bus, next->sig_bus_async, next->sig_bus_sync);
+  gst_element_set_state (next->play, GST_STATE_NULL);
+  gst_object_unref (next->play);
+  if (next->xoverlay != NULL)
+    gst_object_unref (next->xoverlay);
+  g_free (next);
+}
+
+static void
+lgm_free_next_pipeline (LgmVideoPlayer * lvp)
+{
+  LgmNextPipeline *next;
+
+  g_mutex_lock (&lvp->priv->overlay_lock);
+  next = lvp->priv->next_pipeline;
+  lvp->priv->next_pipeline = NULL;
+  g_mutex_unlock (&lvp->priv->overlay_lock);
+
+  if (next != NULL)
+    lgm_next_pipeline_free (next);
+}
+
+/* Starts prerolling the segment at index if it's in a different file than
+ * the previous one, those in the same file are played with segment seeks */
+static void
+lgm_preroll_segment (LgmVideoPlayer * lvp, guint index)
+{
+  LgmNextPipeline *next;
+  LgmSegment *segment, *previous;
+  GstElement *audio_sink;
+  gint flags;
+
+  if (lvp->priv->next_pipeline != NULL &&
+      lvp->priv->next_pipeline->index == index)
+    return;
+
+  lgm_free_next_pipeline (lvp);
+  if (lvp->priv->use_type != LGM_USE_TYPE_VIDEO || index == 0 ||
+      index >= lvp->priv->segments->len)
+    return;
+
+  segment = g_ptr_array_index (lvp->priv->segments, index);
+  previous = g_ptr_array_index (lvp->priv->segments, index - 1);
+  if (!g_strcmp0 (segment->uri, previous->uri))
+    return;
+
+  next = g_new0 (LgmNextPipeline, 1);
+  next->index = index;
+  next->play = gst_element_factory_make ("playbin2", NULL);
+  if (next->play == NULL) {
+    g_free (next);
+    return;
+  }
+  if (!lgm_create_sinks (lvp, &next->video_sink, &audio_sink,
+          &next->frame_cache)) {
+    gst_object_unref (next->play);
+    g_free (next);
+    return;
+  }
+
+  GST_DEBUG ("Prerolling segment %d from %s", index, segment->uri);
+  g_object_get (next->play, "flags", &flags, NULL);
+  flags |= GST_PLAY_FLAG_DEINTERLACE;
+  g_object_set (next->play, "flags", flags, "video-sink", next->video_sink,
+      "audio-sink", audio_sink, "uri", segment->uri, NULL);
+  g_signal_connect (next->play, "source-setup",
+      G_CALLBACK (lgm_source_setup_cb), lvp);
+
+  next->bus = gst_element_get_bus (next->play);
+  gst_bus_add_signal_watch (next->bus);
+  next->sig_bus_async = g_signal_connect (next->bus, "message",
+      G_CALLBACK (lgm_bus_message_cb), lvp);
+  gst_bus_set_sync_handler (next->bus, gst_bus_sync_signal_handler, lvp);
+  next->sig_bus_sync = g_signal_connect (next->bus, "sync-message::element",
+      G_CALLBACK (lgm_element_msg_sync_cb), lvp);
+
+  g_mutex_lock (&lvp->priv->overlay_lock);
+  lvp->priv->next_pipeline = next;
+  g_mutex_unlock (&lvp->priv->overlay_lock);
+
+  gst_element_set_state (next->play, GST_STATE_PAUSED);
+}
+
+static void
+lgm_next_pipeline_message (LgmVideoPlayer * lvp, GstMessage * message)
+{
+  LgmNextPipeline *next = lvp->priv->next_pipeline;
+
+  switch (GST_MESSAGE_TYPE (message)) {
+    case GST_MESSAGE_ERROR:
+      /* The file is loaded again when its segment starts and the error
+       * reported then */
+      GST_WARNING ("Error prerolling segment %d: %" GST_PTR_FORMAT,
+          next->index, message);
+      lgm_free_next_pipeline (lvp);
+      break;
+    case GST_MESSAGE_STATE_CHANGED:
+    {
+      GstState old_state, new_state;
+
+      gst_message_parse_state_changed (message, &old_state, &new_state, NULL);
+      if (GST_MESSAGE_SRC (message) == GST_OBJECT (next->play)) {
+        if (old_state == GST_STATE_READY && new_state == GST_STATE_PAUSED) {
+          lgm_seek_segment (next->play,
+              g_ptr_array_index (lvp->priv->segments, next->index), TRUE);
+          next->seeking = TRUE;
+        }
+      } else if (old_state == GST_STATE_NULL && new_state == GST_STATE_READY &&
+          lgm_is_video_decoder (GST_ELEMENT (GST_MESSAGE_SRC (message)))) {
+        lgm_configure_video_decoder (lvp,
+            GST_ELEMENT (GST_MESSAGE_SRC (message)));
+      }
+      break;
+    }
+    case GST_MESSAGE_ASYNC_DONE:
+      /* The ASYNC_DONE of the first preroll is posted before its state
+       * change, this one completes the seek to the segment */
+      if (next->seeking &&
+          GST_MESSAGE_SRC (message) == GST_OBJECT (next->play)) {
+        GST_DEBUG ("Segment %d prerolled", next->index);
+        next->ready = TRUE;
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+/* Replaces the pipeline playing with the one prerolled for the segment at
+ * index, returns FALSE if it wasn't prerolled and seeked to the segment */
+static gboolean
+lgm_swap_next_pipeline (LgmVideoPlayer * lvp, guint index)
+{
+  LgmNextPipeline *next = lvp->priv->next_pipeline;
+  LgmSegment *segment;
+  GstXOverlay *xoverlay;
+  gdouble volume;
+  gboolean mute;
+
+  if (next == NULL || next->index != index)
+    return FALSE;
+
+  if (!next->ready) {
+    GST_DEBUG ("Segment %d not prerolled yet, loading it", index);
+    lgm_free_next_pipeline (lvp);
+    return FALSE;
+  }
+
+  GST_DEBUG ("Switching to the pipeline prerolled for segment %d", index);
+  segment = g_ptr_array_index (lvp->priv->segments, index);
+
+  g_object_get (lvp->priv->play, "volume", &volume, "mute", &mute, NULL);
+  g_object_set (next->play, "volume", volume, "mute", mute, NULL);
+
+  lgm_free_bus (lvp->priv->bus, lvp->priv->sig_bus_async,
+      lvp->priv->sig_bus_sync);
+  gst_element_set_state (lvp->priv->play, GST_STATE_NULL);
+  gst_object_unref (lvp->priv->play);
+  lgm_position_probe_free (lvp->priv->position_probe);
+  lvp->priv->position_probe = NULL;
+
+  g_mutex_lock (&lvp->priv->overlay_lock);
+  xoverlay = lvp->priv->xoverlay;
+  lvp->priv->xoverlay = next->xoverlay;
+  lvp->priv->bus = next->bus;
+  lvp->priv->next_pipeline = NULL;
+  g_mutex_unlock (&lvp->priv->overlay_lock);
+  if (xoverlay != NULL)
+    gst_object_unref (xoverlay);
+  if (lvp->priv->xoverlay != NULL)
+    lgm_set_show_preroll_frame (GST_OBJECT (lvp->priv->xoverlay), TRUE);
+
+  lvp->priv->play = next->play;
+  lvp->priv->video_sink = next->video_sink;
+  lvp->priv->frame_cache = next->frame_cache;
+  lvp->priv->sig_bus_async = next->sig_bus_async;
+  lvp->priv->sig_bus_sync = next->sig_bus_sync;
+  g_free (next);
+  lgm_watch_video_sink (lvp);
+
+  g_free (lvp->priv->uri);
+  lvp->priv->uri = g_strdup (segment->uri);
+  lvp->priv->stream_length = 0;
+
+  gst_frame_cache_set_enabled (GST_FRAME_CACHE (lvp->priv->frame_cache),
+      lvp->priv->target_state != GST_STATE_PLAYING);
+  if (lvp->priv->target_state == GST_STATE_PLAYING) {
+    lvp->priv->rate = segment->rate;
+    lgm_update_trick_mode (lvp);
+  } else {
+    /* The prerolled frame wasn't shown, preroll it again */
+    lgm_segment_seek (lvp, TRUE);
+  }
+  gst_element_set_state (lvp->priv->play, lvp->priv->target_state);
+  return TRUE;
+}
+
+static void
+lgm_load_segment (LgmVideoPlayer * lvp, guint index, gboolean flush)
+{
+  LgmSegment *segment;
+
+  segment = g_ptr_array_index (lvp->priv->segments, index);
+  lvp->priv->segment_index = index;
+
+  if (!g_strcmp0 (segment->uri, lvp->priv->uri)) {
+    lgm_segment_seek (lvp, flush);
+  } else if (!lgm_swap_next_pipeline (lvp, index)) {
+    /* Preroll the new file and seek to the segment before showing it */
+    GST_DEBUG ("Loading segment %d from %s", index, segment->uri);
+    gst_element_set_state (lvp->priv->play, GST_STATE_READY);
+    g_free (lvp->priv->uri);
+    lvp->priv->uri = g_strdup (segment->uri);
+    g_object_set (lvp->priv->play, "uri", lvp->priv->uri, NULL);
+    lvp->priv->segment_preroll = TRUE;
+    gst_element_set_state (lvp->priv->play, GST_STATE_PAUSED);
+  }
+  lgm_preroll_segment (lvp, index + 1);
+
+  g_signal_emit (lvp, lgm_signals[SIGNAL_ELEMENT_CHANGED], 0, index);
+}
+
+void
+lgm_video_player_clear_segments (LgmVideoPlayer * lvp)
+{
+  g_return_if_fail (LGM_IS_VIDEO_WIDGET (lvp));
+
+  lvp->priv->segment_index = -1;
+  lvp->priv->segment_preroll = FALSE;
+  lgm_free_next_pipeline (lvp);
+  g_ptr_array_set_size (lvp->priv->segments, 0);
+}
+
+void
+lgm_video_player_add_segment (LgmVideoPlayer * lvp, const gchar * uri,
+    gint64 start, gint64 stop, gdouble rate)
+{
+  LgmSegment *segment;
+
+  g_return_if_fail (LGM_IS_VIDEO_WIDGET (lvp));
+  g_return_if_fail (uri != NULL);
+  g_return_if_fail (rate > 0);
+
+  segment = g_new0 (LgmSegment, 1);
+  segment->uri = lgm_filename_to_uri (uri);
+  segment->start = start;
+  segment->stop = stop;
+  segment->rate = rate;
+  g_ptr_array_add (lvp->priv->segments, segment);
+}
+
+gboolean
+lgm_video_player_play_segments (LgmVideoPlayer * lvp, gboolean playing)
+{
+  g_return_val_if_fail (LGM_IS_VIDEO_WIDGET (lvp), FALSE);
+  g_return_val_if_fail (GST_IS_ELEMENT (lvp->priv->play), FALSE);
+
+  if (lvp->priv->segments->len == 0)
+    return FALSE;
+
+  lgm_free_timeshift (lvp);
+  lvp->priv->target_state = playing ? GST_STATE_PLAYING : GST_STATE_PAUSED;
+  lgm_load_segment (lvp, 0, TRUE);
+  if (!lvp->priv->segment_preroll)
+    gst_element_set_state (lvp->priv->play, lvp->priv->target_state);
+  return TRUE;
+}
+
 gboolean
 lgm_video_player_play (LgmVideoPlayer * lvp, gboolean synchronous)
 {
@@ -523,6 +1050,18 @@ lgm_video_player_play (LgmVideoPlayer * lvp, gboolean synchronous)
     return TRUE;
   }
 
+  /* Cached frames can't be played in sync with the clock, decode again
+   * from the frame displayed */
+  if (lvp->priv->frame_cache != NULL &&
+      !gst_frame_cache_is_live (GST_FRAME_CACHE (lvp->priv->frame_cache))) {
+    lgm_video_player_seek_time (lvp, lgm_video_player_get_current_time (lvp),
+        TRUE, FALSE);
+  }
+  if (lvp->priv->frame_cache != NULL) {
+    gst_frame_cache_set_enabled (GST_FRAME_CACHE (lvp->priv->frame_cache),
+        FALSE);
+  }
+
   gst_element_get_state (lvp->priv->play, &cur_state, NULL, 0);
   gst_element_set_state (lvp->priv->play, GST_STATE_PLAYING);
   if (synchronous) {
@@ -532,6 +1071,41 @@ lgm_video_player_play (LgmVideoPlayer * lvp, gboolean synchronous)
   return TRUE;
 }
 
+/* In trick mode the seeks done while playing land on keyframes and let
+ * the elements skip frames */
+static GstSeekFlags
+lgm_trick_mode_flags (LgmVideoPlayer * lvp, GstSeekFlags flags)
+{
+  if (lvp->priv->trick_mode &&
+      lvp->priv->target_state == GST_STATE_PLAYING) {
+    flags &= ~GST_SEEK_FLAG_ACCURATE;
+    flags |= GST_SEEK_FLAG_KEY_UNIT | GST_SEEK_FLAG_SKIP;
+  }
+  return flags;
+}
+
+static void
+lgm_seek (LgmVideoPlayer * lvp, gint64 time, GstSeekFlags flags)
+{
+  /* Only the trick mode seeks skip the delta units */
+  lgm_set_skip_delta_units (lvp, (flags & GST_SEEK_FLAG_SKIP) != 0);
+
+  if (lvp->priv->segment_index >= 0) {
+    LgmSegment *segment;
+
+    /* Keep the segment boundary to continue with the next one */
+    segment = g_ptr_array_index (lvp->priv->segments,
+        lvp->priv->segment_index);
+    gst_element_seek (lvp->priv->play, lvp->priv->rate,
+        GST_FORMAT_TIME, flags | GST_SEEK_FLAG_SEGMENT, GST_SEEK_TYPE_SET,
+        time, GST_SEEK_TYPE_SET, segment->stop);
+  } else {
+    gst_element_seek (lvp->priv->play, lvp->priv->rate,
+        GST_FORMAT_TIME, flags, GST_SEEK_TYPE_SET, time,
+        GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE);
+  }
+}
+
 gboolean
 lgm_video_player_seek_time (LgmVideoPlayer * lvp, gint64 time,
     gboolean accurate, gboolean synchronous)
@@ -548,12 +1122,14 @@ lgm_video_player_seek_time (LgmVideoPlayer * lvp, gint64 time,
   if (accurate) {
     flags |= GST_SEEK_FLAG_ACCURATE;
   } else {
-    flags |= GST_SEEK_FLAG_KEY_UNIT;
+    flags = lgm_trick_mode_flags (lvp, flags | GST_SEEK_FLAG_KEY_UNIT);
   }
 
-  gst_element_seek (lvp->priv->play, lvp->priv->rate,
-      GST_FORMAT_TIME, flags, GST_SEEK_TYPE_SET, time,
-      GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE);
+  if (lvp->priv->frame_cache != NULL) {
+    gst_frame_cache_fill (GST_FRAME_CACHE (lvp->priv->frame_cache),
+        GST_CLOCK_TIME_NONE);
+  }
+  lgm_seek (lvp, time, flags);
   if (synchronous) {
     gst_element_get_state (lvp->priv->play, NULL, NULL, 5 * GST_SECOND);
   }
@@ -561,6 +1137,111 @@ lgm_video_player_seek_time (LgmVideoPlayer * lvp, gint64 time,
   return TRUE;
 }
 
+static gboolean
+lgm_is_video_decoder (GstElement * element)
+{
+  GstElementFactory *factory;
+  const gchar *klass;
+
+  factory = gst_element_get_factory (element);
+  if (factory == NULL)
+    return FALSE;
+
+  klass = gst_element_factory_get_klass (factory);
+  return strstr (klass, "Decoder") != NULL && strstr (klass, "Video") != NULL;
+}
+
+/* Only the keyframes reach the decoder after a trick mode seek */
+static gboolean
+lgm_trick_mode_probe (GstPad * pad, GstBuffer * buf, LgmVideoPlayer * lvp)
+{
+  if (!lvp->priv->skip_delta_units)
+    return TRUE;
+  return !GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_DELTA_UNIT);
+}
+
+/* Sets the skip-frame property of a video decoder and installs the probe
+ * dropping the delta units after a trick mode seek */
+static void
+lgm_configure_video_decoder (LgmVideoPlayer * lvp, GstElement * decoder)
+{
+  GstPad *pad;
+
+  if (g_object_class_find_property (G_OBJECT_GET_CLASS (decoder),
+          "skip-frame")) {
+    gint skip_frame = lvp->priv->skip_delta_units ?
+        LGM_SKIP_FRAME_BFRAMES : 0;
+
+    GST_DEBUG ("Setting skip-frame=%d in %s", skip_frame,
+        GST_OBJECT_NAME (decoder));
+    g_object_set (decoder, "skip-frame", skip_frame, NULL);
+  }
+
+  if (g_object_get_data (G_OBJECT (decoder), "lgm-trick-mode-probe"))
+    return;
+
+  pad = gst_element_get_static_pad (decoder, "sink");
+  if (pad != NULL) {
+    gst_pad_add_buffer_probe (pad, G_CALLBACK (lgm_trick_mode_probe), lvp);
+    g_object_set_data (G_OBJECT (decoder), "lgm-trick-mode-probe",
+        GINT_TO_POINTER (TRUE));
+    gst_object_unref (pad);
+  }
+}
+
+static void
+lgm_configure_video_decoders (LgmVideoPlayer * lvp)
+{
+  GstIterator *it;
+  gpointer item;
+  gboolean done = FALSE;
+
+  it = gst_bin_iterate_recurse (GST_BIN (lvp->priv->play));
+  while (!done) {
+    switch (gst_iterator_next (it, &item)) {
+      case GST_ITERATOR_OK:
+        if (lgm_is_video_decoder (GST_ELEMENT (item)))
+          lgm_configure_video_decoder (lvp, GST_ELEMENT (item));
+        gst_object_unref (item);
+        break;
+      case GST_ITERATOR_RESYNC:
+        gst_iterator_resync (it);
+        break;
+      default:
+        done = TRUE;
+        break;
+    }
+  }
+  gst_iterator_free (it);
+}
+
+/* Above the trick mode rate the decoders can't keep up with all the
+ * frames, the seeks done while playing decode only the keyframes */
+static void
+lgm_update_trick_mode (LgmVideoPlayer * lvp)
+{
+  gboolean trick_mode;
+
+  trick_mode = ABS (lvp->priv->rate) >= lvp->priv->trick_mode_rate;
+  if (trick_mode == lvp->priv->trick_mode)
+    return;
+
+  GST_INFO ("%s trick mode at rate %f", trick_mode ? "Enabling" :
+      "Disabling", lvp->priv->rate);
+  lvp->priv->trick_mode = trick_mode;
+}
+
+static void
+lgm_set_skip_delta_units (LgmVideoPlayer * lvp, gboolean skip)
+{
+  if (skip == lvp->priv->skip_delta_units)
+    return;
+
+  GST_DEBUG ("%s the delta units", skip ? "Skipping" : "Decoding");
+  lvp->priv->skip_delta_units = skip;
+  lgm_configure_video_decoders (lvp);
+}
+
 gboolean
 lgm_video_player_set_rate (LgmVideoPlayer * lvp, gdouble rate)
 {
@@ -576,11 +1257,28 @@ lgm_video_player_set_rate (LgmVideoPlayer * lvp, gdouble rate)
 
   GST_DEBUG ("Setting rate to %f", rate);
   lvp->priv->rate = rate;
-  lgm_video_player_seek_time (lvp, pos, TRUE, FALSE);
+  lgm_update_trick_mode (lvp);
+  if (lvp->priv->frame_cache != NULL) {
+    gst_frame_cache_fill (GST_FRAME_CACHE (lvp->priv->frame_cache),
+        GST_CLOCK_TIME_NONE);
+  }
+  lgm_seek (lvp, pos, lgm_trick_mode_flags (lvp,
+          GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE));
+  got_time_tick (lvp->priv->play, pos, lvp);
 
   return TRUE;
 }
 
+void
+lgm_video_player_set_trick_mode_rate (LgmVideoPlayer * lvp, gdouble rate)
+{
+  g_return_if_fail (lvp != NULL);
+  g_return_if_fail (LGM_IS_VIDEO_WIDGET (lvp));
+
+  GST_DEBUG ("Setting trick mode rate to %f", rate);
+  lvp->priv->trick_mode_rate = rate;
+}
+
 gboolean
 lgm_video_player_seek_to_next_frame (LgmVideoPlayer * lvp)
 {
@@ -598,6 +1296,10 @@ lgm_video_player_seek_to_next_frame (LgmVideoPlayer * lvp)
   if (pos == 0)
     return FALSE;
 
+  if (lvp->priv->frame_cache != NULL) {
+    gst_frame_cache_step (GST_FRAME_CACHE (lvp->priv->frame_cache), 1);
+  }
+  lgm_set_skip_delta_units (lvp, FALSE);
   gst_element_send_event (lvp->priv->video_sink,
       gst_event_new_step (GST_FORMAT_BUFFERS, 1, 1.0, TRUE, FALSE));
 
@@ -614,7 +1316,7 @@ lgm_video_player_seek_to_previous_frame (LgmVideoPlayer * lvp)
   gint fps;
   gint64 pos;
   gint64 final_pos;
-  gboolean ret;
+  gboolean ret = TRUE;
 
   g_return_val_if_fail (lvp != NULL, FALSE);
   g_return_val_if_fail (LGM_IS_VIDEO_WIDGET (lvp), FALSE);
@@ -631,9 +1333,27 @@ lgm_video_player_seek_to_previous_frame (LgmVideoPlayer * lvp)
     return FALSE;
 
   if (lgm_video_player_is_playing (lvp))
-    lgm_video_player_pause (lvp, FALSE);
+    lgm_video_player_pause (lvp, TRUE);
 
-  lgm_video_player_seek_time (lvp, final_pos, TRUE, FALSE);
+  if (lvp->priv->frame_cache != NULL) {
+    gst_frame_cache_set_enabled (GST_FRAME_CACHE (lvp->priv->frame_cache),
+        TRUE);
+  }
+  if (lvp->priv->frame_cache == NULL) {
+    lgm_video_player_seek_time (lvp, final_pos, TRUE, FALSE);
+  } else if (gst_frame_cache_step (GST_FRAME_CACHE (lvp->priv->frame_cache),
+          -1)) {
+    GST_LOG ("Previous frame served from the frames cache");
+    lgm_set_skip_delta_units (lvp, FALSE);
+    gst_element_send_event (lvp->priv->video_sink,
+        gst_event_new_step (GST_FORMAT_BUFFERS, 1, 1.0, TRUE, FALSE));
+  } else {
+    /* Decode from the previous keyframe once and keep the frames of the
+     * GOP for the next steps */
+    gst_frame_cache_fill (GST_FRAME_CACHE (lvp->priv->frame_cache),
+        final_pos);
+    lgm_seek (lvp, final_pos, GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT);
+  }
   got_time_tick (GST_ELEMENT (lvp->priv->play), pos, lvp);
   lgm_video_player_expose (lvp);
 
@@ -694,6 +1414,10 @@ lgm_video_player_close (LgmVideoPlayer * lvp)
 
   GST_LOG ("Closing");
   lgm_stop_play_pipeline (lvp);
+  lgm_free_timeshift (lvp);
+  lvp->priv->segment_index = -1;
+  lvp->priv->segment_preroll = FALSE;
+  lgm_free_next_pipeline (lvp);
 
   if (lvp->priv->uri != NULL) {
     g_free (lvp->priv->uri);
@@ -716,6 +1440,11 @@ lgm_video_player_pause (LgmVideoPlayer * lvp, gboolean synchronous)
   g_return_if_fail (GST_IS_ELEMENT (lvp->priv->play));
   g_return_if_fail (lvp->priv->uri != NULL);
 
+  /* The frames displayed from now are kept to step among them */
+  if (lvp->priv->frame_cache != NULL) {
+    gst_frame_cache_set_enabled (GST_FRAME_CACHE (lvp->priv->frame_cache),
+        TRUE);
+  }
   gst_element_set_state (lvp->priv->play, GST_STATE_PAUSED);
   lvp->priv->target_state = GST_STATE_PAUSED;
   if (synchronous) {
@@ -824,19 +1553,44 @@ lgm_video_player_unref_pixbuf (GdkPixbuf * pixbuf)
   g_object_unref (pixbuf);
 }
 
-GdkPixbuf *
-lgm_video_player_get_current_frame (LgmVideoPlayer * lvp)
+static GstBuffer *
+lgm_video_player_convert_frame (LgmVideoPlayer * lvp, GstBuffer * buf,
+    LgmFrameFormat format)
 {
-  GstStructure *s;
-  GstBuffer *buf = NULL;
-  GdkPixbuf *pixbuf;
-  GstCaps *to_caps;
-  gint outwidth = 0;
-  gint outheight = 0;
+  BvwFrameConv *conv;
+  GstBuffer *frame;
+  GError *err = NULL;
 
-  g_return_val_if_fail (lvp != NULL, NULL);
-  g_return_val_if_fail (LGM_IS_VIDEO_WIDGET (lvp), NULL);
-  g_return_val_if_fail (GST_IS_ELEMENT (lvp->priv->play), NULL);
+  g_return_val_if_fail (format <= LGM_FRAME_FORMAT_I420, NULL);
+
+  /* The frames are also grabbed from the lgm_video_player_get_frames
+   * thread, the converters lock their own conversions */
+  g_mutex_lock (&lvp->priv->frame_conv_lock);
+  if (lvp->priv->frame_conv[format] == NULL) {
+    lvp->priv->frame_conv[format] = bvw_frame_conv_new (format, &err);
+    if (lvp->priv->frame_conv[format] == NULL) {
+      g_mutex_unlock (&lvp->priv->frame_conv_lock);
+      GST_WARNING ("Could not create frame converter: %s", err->message);
+      g_error_free (err);
+      return NULL;
+    }
+  }
+  conv = lvp->priv->frame_conv[format];
+  g_mutex_unlock (&lvp->priv->frame_conv_lock);
+
+  GST_DEBUG ("frame caps: %" GST_PTR_FORMAT, GST_BUFFER_CAPS (buf));
+
+  frame = bvw_frame_conv_convert (conv, buf);
+  if (!frame) {
+    GST_DEBUG ("Could not take screenshot: %s", "conversion failed");
+  }
+  return frame;
+}
+
+static GstBuffer *
+lgm_video_player_get_frame (LgmVideoPlayer * lvp, LgmFrameFormat format)
+{
+  GstBuffer *buf = NULL, *frame;
 
   gst_element_get_state (lvp->priv->play, NULL, NULL, 1 * GST_SECOND);
 
@@ -850,42 +1604,31 @@ lgm_video_player_get_current_frame (LgmVideoPlayer * lvp)
 
   if (GST_BUFFER_CAPS (buf) == NULL) {
     GST_DEBUG ("Could not take screenshot: %s", "no caps on buffer");
+    gst_buffer_unref (buf);
     return NULL;
   }
 
-  /* convert to our desired format (RGB24) */
-  to_caps = gst_caps_new_simple ("video/x-raw-rgb",
-      "bpp", G_TYPE_INT, 24, "depth", G_TYPE_INT, 24,
-      /* Note: we don't ask for a specific width/height here, so that
-       * videoscale can adjust dimensions from a non-1/1 pixel aspect
-       * ratio to a 1/1 pixel-aspect-ratio */
-      "pixel-aspect-ratio", GST_TYPE_FRACTION, 1,
-      1, "endianness", G_TYPE_INT, G_BIG_ENDIAN,
-      "red_mask", G_TYPE_INT, 0xff0000,
-      "green_mask", G_TYPE_INT, 0x00ff00,
-      "blue_mask", G_TYPE_INT, 0x0000ff, NULL);
-
-  GST_DEBUG ("frame caps: %" GST_PTR_FORMAT, GST_BUFFER_CAPS (buf));
-  GST_DEBUG ("pixbuf caps: %" GST_PTR_FORMAT, to_caps);
-
-  buf = bvw_frame_conv_convert (buf, to_caps);
-
-  gst_caps_unref (to_caps);
-
-  if (!buf) {
-    GST_DEBUG ("Could not take screenshot: %s", "conversion failed");
-    return NULL;
-  }
+  frame = lgm_video_player_convert_frame (lvp, buf, format);
+  gst_buffer_unref (buf);
+  return frame;
+}
 
-  if (!GST_BUFFER_CAPS (buf)) {
-    GST_DEBUG ("Could not take screenshot: %s", "no caps on output buffer");
-    return NULL;
-  }
+/* Creates a pixbuf from an RGB24 frame, taking ownership of the frame */
+static GdkPixbuf *
+lgm_video_player_pixbuf_from_frame (GstBuffer * buf)
+{
+  GstStructure *s;
+  GdkPixbuf *pixbuf;
+  gint outwidth = 0;
+  gint outheight = 0;
 
   s = gst_caps_get_structure (GST_BUFFER_CAPS (buf), 0);
   gst_structure_get_int (s, "width", &outwidth);
   gst_structure_get_int (s, "height", &outheight);
-  g_return_val_if_fail (outwidth > 0 && outheight > 0, NULL);
+  if (outwidth <= 0 || outheight <= 0) {
+    gst_buffer_unref (buf);
+    g_return_val_if_reached (NULL);
+  }
 
   /* create pixbuf from that - use our own destroy function */
   pixbuf = gdk_pixbuf_new_from_data (GST_BUFFER_DATA (buf),
@@ -900,6 +1643,194 @@ lgm_video_player_get_current_frame (LgmVideoPlayer * lvp)
   return pixbuf;
 }
 
+GdkPixbuf *
+lgm_video_player_get_current_frame (LgmVideoPlayer * lvp)
+{
+  GstBuffer *buf = NULL;
+
+  g_return_val_if_fail (lvp != NULL, NULL);
+  g_return_val_if_fail (LGM_IS_VIDEO_WIDGET (lvp), NULL);
+  g_return_val_if_fail (GST_IS_ELEMENT (lvp->priv->play), NULL);
+
+  /* convert to our desired format (RGB24) */
+  buf = lgm_video_player_get_frame (lvp, LGM_FRAME_FORMAT_RGB24);
+  if (!buf) {
+    return NULL;
+  }
+
+  return lgm_video_player_pixbuf_from_frame (buf);
+}
+
+gboolean
+lgm_video_player_grab_frame (LgmVideoPlayer * lvp, LgmFrameFormat format,
+    guint8 * data, gsize * size, gint * width, gint * height)
+{
+  GstBuffer *buf;
+  gboolean ret;
+
+  g_return_val_if_fail (lvp != NULL, FALSE);
+  g_return_val_if_fail (LGM_IS_VIDEO_WIDGET (lvp), FALSE);
+  g_return_val_if_fail (GST_IS_ELEMENT (lvp->priv->play), FALSE);
+  g_return_val_if_fail (size != NULL, FALSE);
+  g_return_val_if_fail (format <= LGM_FRAME_FORMAT_I420, FALSE);
+
+  buf = lgm_video_player_get_frame (lvp, format);
+  if (!buf) {
+    return FALSE;
+  }
+
+  /* The frame is already converted, grabbing it only copies it */
+  ret = bvw_frame_conv_grab (lvp->priv->frame_conv[format], buf, data, size,
+      width, height);
+  gst_buffer_unref (buf);
+  return ret;
+}
+
+static void
+lgm_frames_pad_added_cb (GstElement * uridecodebin, GstPad * pad,
+    GstElement * appsink)
+{
+  GstElement *pipeline, *sink;
+  GstPad *sink_pad;
+
+  sink_pad = gst_element_get_static_pad (appsink, "sink");
+  if (!gst_pad_is_linked (sink_pad) &&
+      gst_pad_link (pad, sink_pad) == GST_PAD_LINK_OK) {
+    gst_object_unref (sink_pad);
+    return;
+  }
+  gst_object_unref (sink_pad);
+
+  /* Discard the other streams */
+  pipeline = GST_ELEMENT (gst_object_get_parent (GST_OBJECT (uridecodebin)));
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (sink, "sync", FALSE, NULL);
+  gst_bin_add (GST_BIN (pipeline), sink);
+  sink_pad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_link (pad, sink_pad);
+  gst_element_sync_state_with_parent (sink);
+  gst_object_unref (sink_pad);
+  gst_object_unref (pipeline);
+}
+
+static gboolean
+lgm_frames_seek (GstElement * pipeline, gint64 time)
+{
+  GST_DEBUG ("Seeking frames decoder to %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (time));
+  return gst_element_seek (pipeline, 1.0, GST_FORMAT_TIME,
+      GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE, GST_SEEK_TYPE_SET, time,
+      GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE);
+}
+
+gboolean
+lgm_video_player_get_frames (LgmVideoPlayer * lvp, const gint64 * times,
+    guint n_times, LgmFrameFunc func, gpointer user_data)
+{
+  GstElement *pipeline, *uridecodebin, *appsink;
+  GstBuffer *buf = NULL, *next = NULL, *frame;
+  GstCaps *caps;
+  GdkPixbuf *pixbuf;
+  guint64 end_ts = GST_CLOCK_TIME_NONE;
+  gboolean ret = TRUE;
+  guint i;
+
+  g_return_val_if_fail (lvp != NULL, FALSE);
+  g_return_val_if_fail (LGM_IS_VIDEO_WIDGET (lvp), FALSE);
+  g_return_val_if_fail (lvp->priv->uri != NULL, FALSE);
+  g_return_val_if_fail (func != NULL, FALSE);
+
+  if (n_times == 0) {
+    return TRUE;
+  }
+
+  /* The frames are decoded in a separate pipeline running as fast as
+   * possible, and only the frames requested are converted */
+  pipeline = gst_pipeline_new ("frames-decoder");
+  uridecodebin = gst_element_factory_make ("uridecodebin", NULL);
+  appsink = gst_element_factory_make ("appsink", NULL);
+  caps = gst_caps_from_string ("video/x-raw-yuv;video/x-raw-rgb");
+  g_object_set (appsink, "sync", FALSE, "max-buffers", 2, "caps", caps, NULL);
+  gst_caps_unref (caps);
+  g_object_set (uridecodebin, "uri", lvp->priv->uri, NULL);
+  g_signal_connect (uridecodebin, "pad-added",
+      G_CALLBACK (lgm_frames_pad_added_cb), appsink);
+  gst_bin_add_many (GST_BIN (pipeline), uridecodebin, appsink, NULL);
+
+  gst_element_set_state (pipeline, GST_STATE_PAUSED);
+  if (gst_element_get_state (pipeline, NULL, NULL, 10 * GST_SECOND) !=
+      GST_STATE_CHANGE_SUCCESS) {
+    GST_WARNING ("Could not pre-roll %s", lvp->priv->uri);
+    ret = FALSE;
+    goto done;
+  }
+  lgm_frames_seek (pipeline, times[0]);
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  for (i = 0; i < n_times; i++) {
+    /* Decode forward unless the next frame is further than a GOP away,
+     * where seeking to the previous keyframe is cheaper */
+    if (buf != NULL && (times[i] < (gint64) GST_BUFFER_TIMESTAMP (buf) ||
+            times[i] - (gint64) end_ts >
+            (gint64) LGM_FRAMES_MAX_DECODE_GAP)) {
+      gst_buffer_unref (buf);
+      buf = NULL;
+      if (next != NULL) {
+        gst_buffer_unref (next);
+        next = NULL;
+      }
+      lgm_frames_seek (pipeline, times[i]);
+    }
+
+    while (buf == NULL || (gint64) end_ts <= times[i]) {
+      if (next == NULL) {
+        next = gst_app_sink_pull_buffer (GST_APP_SINK (appsink));
+        if (next == NULL) {
+          break;
+        }
+      }
+      /* Without a duration a frame lasts until the next one starts */
+      if (buf != NULL && !GST_BUFFER_DURATION_IS_VALID (buf) &&
+          (gint64) GST_BUFFER_TIMESTAMP (next) > times[i]) {
+        end_ts = GST_BUFFER_TIMESTAMP (next);
+        break;
+      }
+      if (buf != NULL) {
+        gst_buffer_unref (buf);
+      }
+      buf = next;
+      next = NULL;
+      end_ts = GST_BUFFER_TIMESTAMP (buf);
+      if (GST_BUFFER_DURATION_IS_VALID (buf)) {
+        end_ts += GST_BUFFER_DURATION (buf);
+      }
+    }
+
+    pixbuf = NULL;
+    if (buf != NULL) {
+      frame = lgm_video_player_convert_frame (lvp, buf, LGM_FRAME_FORMAT_RGB24);
+      if (frame != NULL) {
+        pixbuf = lgm_video_player_pixbuf_from_frame (frame);
+      }
+    }
+    if (!func (pixbuf, times[i], user_data)) {
+      GST_DEBUG ("Frames extraction cancelled");
+      break;
+    }
+  }
+
+done:
+  if (buf != NULL) {
+    gst_buffer_unref (buf);
+  }
+  if (next != NULL) {
+    gst_buffer_unref (next);
+  }
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+  return ret;
+}
+
 void
 lgm_video_player_set_window_handle (LgmVideoPlayer * lvp,
     guintptr window_handle)
@@ -910,15 +1841,107 @@ lgm_video_player_set_window_handle (LgmVideoPlayer * lvp,
     lgm_set_window_handle (lvp->priv->xoverlay, lvp->priv->window_handle);
     lvp->priv->window_set = TRUE;
   }
+  if (lvp->priv->next_pipeline != NULL &&
+      lvp->priv->next_pipeline->xoverlay != NULL) {
+    lgm_set_window_handle (lvp->priv->next_pipeline->xoverlay,
+        lvp->priv->window_handle);
+  }
   g_mutex_unlock (&lvp->priv->overlay_lock);
 }
 
+/* The video sink with a cache of the last decoded frames before it */
+static GstElement *
+lgm_video_player_create_video_sink (LgmVideoPlayer * lvp,
+    GstElement ** frame_cache)
+{
+  GstElement *bin, *sink;
+  GstPad *pad;
+
+  sink = gst_element_factory_make ("autovideosink", "video-output");
+  if (sink == NULL)
+    return NULL;
+
+  bin = gst_bin_new ("video-sink");
+  *frame_cache = gst_frame_cache_new (LGM_FRAME_CACHE_MAX_FRAMES,
+      LGM_FRAME_CACHE_MAX_BYTES);
+  gst_bin_add_many (GST_BIN (bin), *frame_cache, sink, NULL);
+  gst_element_link (*frame_cache, sink);
+  pad = gst_element_get_static_pad (*frame_cache, "sink");
+  gst_element_add_pad (bin, gst_ghost_pad_new ("sink", pad));
+  gst_object_unref (pad);
+  return bin;
+}
+
+static gboolean
+lgm_create_sinks (LgmVideoPlayer * lvp, GstElement ** video_sink,
+    GstElement ** audio_sink, GstElement ** frame_cache)
+{
+  *frame_cache = NULL;
+  if (lvp->priv->use_type == LGM_USE_TYPE_VIDEO) {
+    *video_sink = lgm_video_player_create_video_sink (lvp, frame_cache);
+    *audio_sink = gst_element_factory_make ("autoaudiosink", "audio-sink");
+    if (*audio_sink == NULL || gst_element_set_state (*audio_sink,
+            GST_STATE_READY) != GST_STATE_CHANGE_SUCCESS) {
+      if (*audio_sink != NULL)
+        gst_object_unref (*audio_sink);
+      *audio_sink = gst_element_factory_make ("fakesink", "audio-fake-sink");
+    }
+  } else {
+    *video_sink = gst_element_factory_make ("fakesink", "video-fake-sink");
+    *audio_sink = gst_element_factory_make ("fakesink", "audio-fake-sink");
+    if (*video_sink)
+      g_object_set (*video_sink, "sync", TRUE, NULL);
+    if (*audio_sink)
+      g_object_set (*audio_sink, "sync", TRUE, NULL);
+  }
+
+  if (!*video_sink || !*audio_sink) {
+    if (*video_sink) {
+      gst_element_set_state (*video_sink, GST_STATE_NULL);
+      gst_object_unref (*video_sink);
+      *video_sink = NULL;
+    }
+    if (*audio_sink) {
+      gst_element_set_state (*audio_sink, GST_STATE_NULL);
+      gst_object_unref (*audio_sink);
+      *audio_sink = NULL;
+    }
+    *frame_cache = NULL;
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/* Watches the caps and the frames displayed in the video sink to notify
+ * the position */
+static void
+lgm_watch_video_sink (LgmVideoPlayer * lvp)
+{
+  GstElement *sink;
+  GstPad *pad;
+
+  pad = gst_element_get_static_pad (lvp->priv->video_sink, "sink");
+  g_signal_connect (pad, "notify::caps",
+      G_CALLBACK (lgm_parse_stream_caps), lvp);
+  lgm_parse_stream_caps (pad, NULL, lvp);
+  gst_object_unref (pad);
+
+  if (lvp->priv->frame_cache == NULL)
+    return;
+
+  sink = gst_bin_get_by_name (GST_BIN (lvp->priv->video_sink), "video-output");
+  pad = gst_element_get_static_pad (sink, "sink");
+  lvp->priv->position_probe = lgm_position_probe_new (pad,
+      LGM_POSITION_INTERVAL, (LgmPositionFunc) lgm_position_changed_cb, lvp);
+  gst_object_unref (pad);
+  gst_object_unref (sink);
+}
+
 LgmVideoPlayer *
 lgm_video_player_new (LgmUseType type, GError ** err)
 {
   LgmVideoPlayer *lvp;
-  GstElement *video_sink, *audio_sink;
-  GstPad *pad;
+  GstElement *video_sink, *audio_sink, *frame_cache;
   gint flags;
 
   lvp = (LgmVideoPlayer *) g_object_new (lgm_video_player_get_type (), NULL);
@@ -939,6 +1962,8 @@ lgm_video_player_new (LgmUseType type, GError ** err)
   g_object_get (lvp->priv->play, "flags", &flags, NULL);
   flags |= GST_PLAY_FLAG_DEINTERLACE;
   g_object_set (lvp->priv->play, "flags", flags, NULL);
+  g_signal_connect (lvp->priv->play, "source-setup",
+      G_CALLBACK (lgm_source_setup_cb), lvp);
 
   lvp->priv->bus = gst_element_get_bus (lvp->priv->play);
   gst_bus_add_signal_watch (lvp->priv->bus);
@@ -949,37 +1974,19 @@ lgm_video_player_new (LgmUseType type, GError ** err)
 
   /* we want to catch "prepare-xwindow-id" element messages synchronously */
   gst_bus_set_sync_handler (lvp->priv->bus, gst_bus_sync_signal_handler, lvp);
-  lvp->priv->sig_bus_async =
+  lvp->priv->sig_bus_sync =
       g_signal_connect (lvp->priv->bus, "sync-message::element",
       G_CALLBACK (lgm_element_msg_sync_cb), lvp);
 
-  if (type == LGM_USE_TYPE_VIDEO) {
-    video_sink = gst_element_factory_make ("autovideosink", "video-sink");
-    audio_sink = gst_element_factory_make ("autoaudiosink", "audio-sink");
-    if (gst_element_set_state (audio_sink, GST_STATE_READY) != GST_STATE_CHANGE_SUCCESS) {
-      gst_object_unref (audio_sink);
-      audio_sink = gst_element_factory_make ("fakesink", "audio-fake-sink");
-    }
-  } else {
-    video_sink = gst_element_factory_make ("fakesink", "video-fake-sink");
-    audio_sink = gst_element_factory_make ("fakesink", "audio-fake-sink");
-    if (video_sink)
-      g_object_set (video_sink, "sync", TRUE, NULL);
-    if (audio_sink)
-      g_object_set (audio_sink, "sync", TRUE, NULL);
-  }
-
-  if (!video_sink || !audio_sink) {
+  if (!lgm_create_sinks (lvp, &video_sink, &audio_sink, &frame_cache)) {
     g_set_error (err, LGM_ERROR, GST_ERROR_VIDEO_PLUGIN,
         _("No valid sink found."));
     goto sink_error;
   }
 
   lvp->priv->video_sink = video_sink;
-  pad = gst_element_get_static_pad (video_sink, "sink");
-  g_signal_connect (pad, "notify::caps",
-      G_CALLBACK (lgm_parse_stream_caps), lvp);
-  gst_object_unref (pad);
+  lvp->priv->frame_cache = frame_cache;
+  lgm_watch_video_sink (lvp);
   g_object_set (lvp->priv->play, "video-sink", video_sink, NULL);
   g_object_set (lvp->priv->play, "audio-sink", audio_sink, NULL);
 
@@ -988,15 +1995,6 @@ lgm_video_player_new (LgmUseType type, GError ** err)
   /* errors */
 sink_error:
   {
-    if (video_sink) {
-      gst_element_set_state (video_sink, GST_STATE_NULL);
-      gst_object_unref (video_sink);
-    }
-    if (audio_sink) {
-      gst_element_set_state (audio_sink, GST_STATE_NULL);
-      gst_object_unref (audio_sink);
-    }
-
     g_object_ref (lvp);
     g_object_ref_sink (G_OBJECT (lvp));
     g_object_unref (lvp);
@@ -1048,7 +2046,9 @@ lgm_video_player_finalize (GObject * object)
     lvp->priv->uri = NULL;
   }
 
+  lgm_free_next_pipeline (lvp);
   g_mutex_clear (&lvp->priv->overlay_lock);
+  g_mutex_clear (&lvp->priv->frame_conv_lock);
 
   if (lvp->priv->play != NULL && GST_IS_ELEMENT (lvp->priv->play)) {
     gst_element_set_state (lvp->priv->play, GST_STATE_NULL);
@@ -1056,6 +2056,15 @@ lgm_video_player_finalize (GObject * object)
     lvp->priv->play = NULL;
   }
 
+  lgm_position_probe_free (lvp->priv->position_probe);
+  lvp->priv->position_probe = NULL;
+
+  lgm_free_timeshift (lvp);
+  g_ptr_array_free (lvp->priv->segments, TRUE);
+
+  bvw_frame_conv_free (lvp->priv->frame_conv[LGM_FRAME_FORMAT_RGB24]);
+  bvw_frame_conv_free (lvp->priv->frame_conv[LGM_FRAME_FORMAT_I420]);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -1071,7 +2080,12 @@ lgm_video_player_init (LgmVideoPlayer * lvp)
   priv->uri = NULL;
   priv->video_fps_n = 25;
   priv->video_fps_d = 1;
+  priv->segments = g_ptr_array_new_with_free_func ((GDestroyNotify)
+      lgm_segment_free);
+  priv->segment_index = -1;
+  priv->trick_mode_rate = LGM_TRICK_MODE_RATE;
   g_mutex_init (&lvp->priv->overlay_lock);
+  g_mutex_init (&lvp->priv->frame_conv_lock);
 }
 
 static void
@@ -1131,4 +2145,20 @@ lgm_video_player_class_init (LgmVideoPlayerClass * klass)
       G_STRUCT_OFFSET (LgmVideoPlayerClass, state_change),
       NULL, NULL,
       g_cclosure_marshal_VOID__BOOLEAN, G_TYPE_NONE, 1, G_TYPE_BOOLEAN);
+
+  lgm_signals[SIGNAL_ELEMENT_CHANGED] =
+      g_signal_new ("element_changed",
+      G_TYPE_FROM_CLASS (object_class),
+      G_SIGNAL_RUN_LAST,
+      G_STRUCT_OFFSET (LgmVideoPlayerClass, element_changed),
+      NULL, NULL, g_cclosure_marshal_VOID__INT, G_TYPE_NONE, 1, G_TYPE_INT);
+
+  lgm_signals[SIGNAL_POSITION_CHANGED] =
+      g_signal_new ("position_changed",
+      G_TYPE_FROM_CLASS (object_class),
+      G_SIGNAL_RUN_LAST,
+      G_STRUCT_OFFSET (LgmVideoPlayerClass, position_changed),
+      NULL, NULL,
+      baconvideowidget_marshal_VOID__INT64_INT64,
+      G_TYPE_NONE, 2, G_TYPE_INT64, G_TYPE_INT64);
 }
@@ -27,6 +27,7 @@
 #endif
 
 #include "lgm-utils.h"
+#include "lgm-timeshift.h"
 
 G_BEGIN_DECLS
 #define LGM_TYPE_VIDEO_WIDGET              (lgm_video_player_get_type ())
@@ -53,8 +54,19 @@ typedef struct
       gint64 stream_length, gdouble current_position);
   void (*state_change) (LgmVideoPlayer * lvp, gboolean playing);
   void (*ready_to_seek) (LgmVideoPlayer * lvp);
+  void (*element_changed) (LgmVideoPlayer * lvp, gint index);
+  /* Running and stream time of the frame displayed, emitted from the main
+   * context at most every 20ms while the frames change */
+  void (*position_changed) (LgmVideoPlayer * lvp, gint64 running_time,
+      gint64 stream_time);
 } LgmVideoPlayerClass;
 
+/* Called for each frame extracted with lgm_video_player_get_frames (), with
+ * a NULL frame if it couldn't be extracted. The frame must be released
+ * with lgm_video_player_unref_pixbuf (). Return FALSE to stop. */
+typedef gboolean (*LgmFrameFunc) (GdkPixbuf * frame, gint64 time,
+    gpointer user_data);
+
 
 EXPORT GQuark lgm_video_player_error_quark (void) G_GNUC_CONST;
 EXPORT GType lgm_video_player_get_type (void) G_GNUC_CONST;
@@ -76,9 +88,31 @@ EXPORT void lgm_video_player_set_window_handle           (LgmVideoPlayer *lvp,
 EXPORT gboolean lgm_video_player_open                     (LgmVideoPlayer * lvp,
                                                            const char *mrl, GError ** error);
 
+/* Plays the recording kept in a capturer's timeshift buffer, following it
+ * live when reaching the last frame */
+EXPORT gboolean lgm_video_player_open_timeshift           (LgmVideoPlayer * lvp,
+                                                           LgmTimeshiftBuffer * tsb,
+                                                           GError ** error);
+
 EXPORT gboolean lgm_video_player_play                     (LgmVideoPlayer * lvp,
                                                            gboolean synchronous);
 
+/* Segments queue, played without gaps between them. Segments of the same
+ * file are chained with segment seeks and the file of the next segment is
+ * prerolled in another pipeline while the current one plays.
+ * "element_changed" is emitted with the index of each segment when it
+ * starts */
+EXPORT void lgm_video_player_clear_segments               (LgmVideoPlayer * lvp);
+
+EXPORT void lgm_video_player_add_segment                  (LgmVideoPlayer * lvp,
+                                                           const char *uri,
+                                                           gint64 start,
+                                                           gint64 stop,
+                                                           gdouble rate);
+
+EXPORT gboolean lgm_video_player_play_segments            (LgmVideoPlayer * lvp,
+                                                           gboolean playing);
+
 EXPORT void lgm_video_player_pause                        (LgmVideoPlayer * lvp,
                                                            gboolean synchronous);
 
@@ -110,6 +144,11 @@ EXPORT gint64 lgm_video_player_get_stream_length          (LgmVideoPlayer * lvp)
 EXPORT gboolean lgm_video_player_set_rate                 (LgmVideoPlayer * lvp,
                                                            gdouble rate);
 
+/* Rate from which only keyframes are decoded, applied on the next rate
+ * change */
+EXPORT void lgm_video_player_set_trick_mode_rate          (LgmVideoPlayer * lvp,
+                                                           gdouble rate);
+
 /* Audio volume */
 EXPORT void lgm_video_player_set_volume                   (LgmVideoPlayer * lvp,
                                                            gdouble volume);
@@ -119,6 +158,19 @@ EXPORT double lgm_video_player_get_volume                 (LgmVideoPlayer * lvp)
 /* Screenshot functions */
 EXPORT GdkPixbuf *lgm_video_player_get_current_frame      (LgmVideoPlayer * lvp);
 EXPORT void lgm_video_player_unref_pixbuf                 (GdkPixbuf * pixbuf);
+/* Copies the current frame in data, see bvw_frame_conv_grab () */
+EXPORT gboolean lgm_video_player_grab_frame               (LgmVideoPlayer * lvp,
+                                                           LgmFrameFormat format,
+                                                           guint8 * data,
+                                                           gsize * size,
+                                                           gint * width,
+                                                           gint * height);
+/* Extracts the frames at the sorted list of times in a single decoding pass */
+EXPORT gboolean lgm_video_player_get_frames               (LgmVideoPlayer * lvp,
+                                                           const gint64 * times,
+                                                           guint n_times,
+                                                           LgmFrameFunc func,
+                                                           gpointer user_data);
 
 EXPORT void lgm_video_player_expose                       (LgmVideoPlayer * lvp);
 
@@ -0,0 +1,162 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * test-player.c
+ * Copyright (C) Fluendo S.A. 2016
+ *
+ * test-player.c is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * test-player.c is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Checks that an accurate seek done after playing in trick mode shows the
+ * requested frame and not the previous keyframe.
+ *
+ * Compile with:
+ * gcc -o test-player test-player.c lgm-video-player.c lgm-utils.c ... `pkg-config --cflags --libs gstreamer-0.10 gtk+-2.0` -DOSTYPE_LINUX -O0 -g
+ */
+
+#include <stdlib.h>
+#include <gst/gst.h>
+#include "lgm-video-player.h"
+#include "lgm-utils.h"
+
+/* Playing time at the trick mode rate before the seek */
+#define TRICK_MODE_TIME 2000
+/* Time given to the player to show the frame of the seek */
+#define SHOW_FRAME_TIME 1000
+
+static GMainLoop *loop;
+static gint64 seek_time;
+static gint64 shown_time = -1;
+static gint64 frame_duration = 40 * GST_MSECOND;
+static gint ret = 1;
+
+static void
+position_changed_cb (LgmVideoPlayer * lvp, gint64 running_time,
+    gint64 stream_time, gpointer data)
+{
+  shown_time = stream_time;
+}
+
+static void
+error_cb (LgmVideoPlayer * lvp, gchar * error, gpointer data)
+{
+  g_print ("ERROR: %s\n", error);
+  g_main_loop_quit (loop);
+}
+
+static gboolean
+check_frame_cb (LgmVideoPlayer * lvp)
+{
+  g_print ("Requested frame: %" GST_TIME_FORMAT " shown frame: %"
+      GST_TIME_FORMAT "\n", GST_TIME_ARGS (seek_time),
+      GST_TIME_ARGS (shown_time));
+
+  if (shown_time >= 0 && ABS (shown_time - seek_time) < frame_duration) {
+    g_print ("SUCCESS!\n");
+    ret = 0;
+  } else {
+    g_print ("FAILED: the accurate seek landed on a keyframe\n");
+  }
+  g_main_loop_quit (loop);
+  return FALSE;
+}
+
+static gboolean
+accurate_seek_cb (LgmVideoPlayer * lvp)
+{
+  g_print ("Pausing and seeking accurately to %" GST_TIME_FORMAT "\n",
+      GST_TIME_ARGS (seek_time));
+  lgm_video_player_pause (lvp, TRUE);
+  shown_time = -1;
+  lgm_video_player_seek_time (lvp, seek_time, TRUE, TRUE);
+  g_timeout_add (SHOW_FRAME_TIME, (GSourceFunc) check_frame_cb, lvp);
+  return FALSE;
+}
+
+static gboolean
+trick_mode_cb (LgmVideoPlayer * lvp)
+{
+  g_print ("Playing at 8x\n");
+  lgm_video_player_set_rate (lvp, 8.0);
+  g_timeout_add (TRICK_MODE_TIME, (GSourceFunc) accurate_seek_cb, lvp);
+  return FALSE;
+}
+
+static void
+ready_to_seek_cb (LgmVideoPlayer * lvp, gpointer data)
+{
+  static gboolean started = FALSE;
+
+  if (started)
+    return;
+  started = TRUE;
+  lgm_video_player_play (lvp, FALSE);
+  g_timeout_add (500, (GSourceFunc) trick_mode_cb, lvp);
+}
+
+int
+main (int argc, char *argv[])
+{
+  LgmVideoPlayer *lvp;
+  GError *err = NULL;
+  guint64 duration;
+  guint width, height, fps_n = 0, fps_d = 0, par_n, par_d;
+  gchar *container = NULL, *video_codec = NULL, *audio_codec = NULL;
+
+  lgm_init_backend (0, NULL);
+
+  if (argc < 2 || argc > 3) {
+    g_print ("Usage: test-player file [seek_time_ms]\n");
+    return 1;
+  }
+
+  /* A time in the middle of a GOP, not a keyframe */
+  seek_time = (argc == 3 ? atoi (argv[2]) : 1520) * GST_MSECOND;
+
+  if (lgm_discover_uri (argv[1], &duration, &width, &height, &fps_n, &fps_d,
+          &par_n, &par_d, &container, &video_codec, &audio_codec,
+          &err) != GST_DISCOVERER_OK) {
+    g_print ("ERROR: %s\n",
+        err ? err->message : "could not discover the file");
+    return 1;
+  }
+  if (fps_n > 0 && fps_d > 0)
+    frame_duration = gst_util_uint64_scale (GST_SECOND, fps_d, fps_n);
+  g_free (container);
+  g_free (video_codec);
+  g_free (audio_codec);
+
+  lvp = lgm_video_player_new (LGM_USE_TYPE_VIDEO, &err);
+  if (err != NULL) {
+    g_print ("ERROR: %s\n", err->message);
+    return 1;
+  }
+
+  loop = g_main_loop_new (NULL, FALSE);
+  g_signal_connect (lvp, "ready_to_seek", G_CALLBACK (ready_to_seek_cb),
+      NULL);
+  g_signal_connect (lvp, "position_changed",
+      G_CALLBACK (position_changed_cb), NULL);
+  g_signal_connect (lvp, "error", G_CALLBACK (error_cb), NULL);
+
+  if (!lgm_video_player_open (lvp, argv[1], &err)) {
+    g_print ("ERROR: %s\n", err ? err->message : "could not open the file");
+    return 1;
+  }
+
+  g_main_loop_run (loop);
+  lgm_video_player_close (lvp);
+  gst_object_unref (lvp);
+
+  return ret;
+}